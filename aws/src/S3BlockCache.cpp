@@ -0,0 +1,214 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Process wide, size bounded LRU cache of S3 object blocks shared by all
+// S3StreamBuffer instances, with background read-ahead.
+//
+//---
+// $Id$
+
+#include "S3BlockCache.h"
+#include "S3StreamDefaults.h"
+
+std::shared_ptr<ossim::S3BlockCache> ossim::S3BlockCache::m_instance;
+
+// Caps the number of queued read-ahead requests so a fast reader cannot
+// grow the queue without bound.
+static const std::size_t MAX_QUEUED_JOBS = 256;
+
+ossim::S3BlockCache::S3BlockCache()
+:m_cacheSize(0),
+ m_maxCacheSize(ossim::S3StreamDefaults::m_readCacheSize),
+ m_shutdown(false)
+{
+}
+
+ossim::S3BlockCache::~S3BlockCache()
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_shutdown = true;
+      m_jobs.clear();
+      m_pending.clear();
+      m_inFlight.clear();
+   }
+   m_jobCondition.notify_all();
+   m_pendingCondition.notify_all();
+   for(std::size_t idx = 0; idx < m_threads.size(); ++idx)
+   {
+      if(m_threads[idx].joinable())
+      {
+         m_threads[idx].join();
+      }
+   }
+   m_cache.clear();
+   m_lru.clear();
+}
+
+std::shared_ptr<ossim::S3BlockCache> ossim::S3BlockCache::instance()
+{
+   static std::mutex instanceMutex;
+   std::unique_lock<std::mutex> lock(instanceMutex);
+   if(!m_instance)
+   {
+      m_instance = std::make_shared<S3BlockCache>();
+   }
+
+   return m_instance;
+}
+
+ossim::S3BlockCache::Block_t ossim::S3BlockCache::getBlock(const Key_t& key)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   // Only queued; drop the job and let the caller fetch it now.
+   if(m_pending.erase(key))
+   {
+      for(std::deque<Job_t>::iterator job = m_jobs.begin(); job != m_jobs.end(); ++job)
+      {
+         if(job->first == key)
+         {
+            m_jobs.erase(job);
+            break;
+         }
+      }
+   }
+
+   // Block in flight on a read-ahead thread; wait instead of fetching twice.
+   while(m_inFlight.find(key) != m_inFlight.end())
+   {
+      m_pendingCondition.wait(lock);
+   }
+
+   Block_t result;
+   CacheType::iterator iter = m_cache.find(key);
+   if(iter != m_cache.end())
+   {
+      m_lru.splice(m_lru.begin(), m_lru, iter->second.m_lruIter);
+      result = iter->second.m_block;
+   }
+
+   return result;
+}
+
+void ossim::S3BlockCache::addBlock(const Key_t& key, const Block_t& block)
+{
+   if(!block) return;
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   if(m_maxCacheSize <= 0) return;
+
+   CacheType::iterator iter = m_cache.find(key);
+   if(iter != m_cache.end())
+   {
+      m_cacheSize -= static_cast<ossim_int64>(iter->second.m_block->size());
+      iter->second.m_block = block;
+      m_lru.splice(m_lru.begin(), m_lru, iter->second.m_lruIter);
+   }
+   else
+   {
+      m_lru.push_front(key);
+      Node node;
+      node.m_block   = block;
+      node.m_lruIter = m_lru.begin();
+      m_cache.insert(std::make_pair(key, node));
+   }
+   m_cacheSize += static_cast<ossim_int64>(block->size());
+
+   shrinkEntries();
+}
+
+void ossim::S3BlockCache::readAhead(const Key_t& key, const Loader_t& loader)
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if(m_shutdown || (m_maxCacheSize <= 0) ||
+         (ossim::S3StreamDefaults::m_readAheadThreads <= 0))
+      {
+         return;
+      }
+      if((m_cache.find(key) != m_cache.end()) ||
+         (m_pending.find(key) != m_pending.end()) ||
+         (m_inFlight.find(key) != m_inFlight.end()) ||
+         (m_jobs.size() >= MAX_QUEUED_JOBS))
+      {
+         return;
+      }
+      if(m_threads.empty())
+      {
+         startThreads();
+      }
+      m_pending.insert(key);
+      m_jobs.push_back(std::make_pair(key, loader));
+   }
+   m_jobCondition.notify_one();
+}
+
+void ossim::S3BlockCache::setMaxCacheSize(ossim_int64 maxBytes)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_maxCacheSize = maxBytes;
+   shrinkEntries();
+}
+
+void ossim::S3BlockCache::shrinkEntries()
+{
+   while((m_cacheSize > m_maxCacheSize) && !m_lru.empty())
+   {
+      CacheType::iterator iter = m_cache.find(m_lru.back());
+      if(iter != m_cache.end())
+      {
+         m_cacheSize -= static_cast<ossim_int64>(iter->second.m_block->size());
+         m_cache.erase(iter);
+      }
+      m_lru.pop_back();
+   }
+}
+
+void ossim::S3BlockCache::startThreads()
+{
+   for(ossim_int64 idx = 0; idx < ossim::S3StreamDefaults::m_readAheadThreads; ++idx)
+   {
+      m_threads.push_back(std::thread(&ossim::S3BlockCache::runReadAhead, this));
+   }
+}
+
+void ossim::S3BlockCache::runReadAhead()
+{
+   while(true)
+   {
+      Job_t job;
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         while(m_jobs.empty() && !m_shutdown)
+         {
+            m_jobCondition.wait(lock);
+         }
+         if(m_shutdown) break;
+         job = m_jobs.front();
+         m_jobs.pop_front();
+         m_pending.erase(job.first);
+         m_inFlight.insert(job.first);
+      }
+
+      Block_t block;
+      try
+      {
+         block = job.second();
+      }
+      catch(...)
+      {
+         block.reset();
+      }
+
+      addBlock(job.first, block);
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_inFlight.erase(job.first);
+      }
+      m_pendingCondition.notify_all();
+   }
+}
@@ -0,0 +1,150 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Process wide, size bounded LRU cache of S3 object blocks shared by all
+// S3StreamBuffer instances, with background read-ahead.
+//
+//---
+// $Id$
+
+#ifndef ossimS3BlockCache_HEADER
+#define ossimS3BlockCache_HEADER 1
+
+#include <ossim/base/ossimConstants.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ossim
+{
+   /** Read only bytes of one block. */
+   class S3Block
+   {
+   public:
+      virtual ~S3Block() {}
+      virtual const char* data()const=0;
+      virtual ossim_int64 size()const=0;
+   };
+
+   /** Block held in memory. */
+   class S3MemoryBlock : public S3Block
+   {
+   public:
+      S3MemoryBlock(ossim_int64 size)
+      :m_data(size)
+      {}
+      virtual const char* data()const
+      {
+         return m_data.empty() ? 0 : &m_data.front();
+      }
+      virtual ossim_int64 size()const
+      {
+         return static_cast<ossim_int64>(m_data.size());
+      }
+      /** @return Writable buffer for filling the block. */
+      char* buffer()
+      {
+         return m_data.empty() ? 0 : &m_data.front();
+      }
+   protected:
+      std::vector<char> m_data;
+   };
+
+   class S3BlockCache
+   {
+   public:
+      /** Block data.  size() is the actual number of bytes. */
+      typedef std::shared_ptr<S3Block> Block_t;
+
+      /**
+       * Key is an object id (must include anything that changes block
+       * boundaries, e.g. the block size) plus the block index.
+       */
+      typedef std::pair<std::string, ossim_int64> Key_t;
+
+      /** Loader called on a read-ahead thread.  Returns null on failure. */
+      typedef std::function<Block_t()> Loader_t;
+
+      S3BlockCache();
+      virtual ~S3BlockCache();
+
+      static std::shared_ptr<S3BlockCache> instance();
+
+      /**
+       * @brief Gets a block from the cache.  If the block is currently being
+       * fetched by a read-ahead thread this waits for it to complete.  A
+       * read-ahead of the block that is only queued is cancelled so the
+       * caller fetches it instead of waiting behind the queue.
+       * @return block or null if not cached.
+       */
+      Block_t getBlock(const Key_t& key);
+
+      /** Adds block to the cache evicting least recently used blocks. */
+      void addBlock(const Key_t& key, const Block_t& block);
+
+      /**
+       * @brief Queues a background fetch of a block if not already cached
+       * or pending.
+       */
+      void readAhead(const Key_t& key, const Loader_t& loader);
+
+      void setMaxCacheSize(ossim_int64 maxBytes);
+
+   protected:
+      struct KeyHash
+      {
+         std::size_t operator()(const Key_t& key)const
+         {
+            return std::hash<std::string>()(key.first) ^
+               (std::hash<ossim_int64>()(key.second) << 1);
+         }
+      };
+      typedef std::list<Key_t> LruListType;
+      struct Node
+      {
+         Block_t                m_block;
+         LruListType::iterator  m_lruIter;
+      };
+      typedef std::unordered_map<Key_t, Node, KeyHash> CacheType;
+      typedef std::pair<Key_t, Loader_t> Job_t;
+
+      /** Assumes m_mutex is locked. */
+      void shrinkEntries();
+      void startThreads();
+      void runReadAhead();
+
+      static std::shared_ptr<S3BlockCache> m_instance;
+      mutable std::mutex m_mutex;
+      std::condition_variable m_jobCondition;
+      std::condition_variable m_pendingCondition;
+
+      CacheType m_cache;
+      LruListType m_lru;
+      ossim_int64 m_cacheSize;
+      ossim_int64 m_maxCacheSize;
+
+      std::deque<Job_t> m_jobs;
+
+      /** Keys of m_jobs, queued but not started. */
+      std::set<Key_t> m_pending;
+
+      /** Keys being fetched by a read-ahead thread. */
+      std::set<Key_t> m_inFlight;
+      std::vector<std::thread> m_threads;
+      bool m_shutdown;
+   };
+}
+
+#endif
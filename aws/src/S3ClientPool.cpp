@@ -0,0 +1,138 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Process wide pool of S3 clients shared by all S3 streams.
+//
+//---
+// $Id$
+
+#include "S3ClientPool.h"
+#include "S3StreamDefaults.h"
+
+#include <aws/core/Aws.h>
+#include <aws/core/client/ClientConfiguration.h>
+#include <aws/core/utils/threading/Executor.h>
+
+#include <ossim/base/ossimTrace.h>
+#include <algorithm>
+#include <ostream>
+
+static ossimTrace traceDebug("ossimS3ClientPool:debug");
+
+static const char* ALLOCATION_TAG = "S3ClientPool";
+
+std::shared_ptr<ossim::S3ClientPool> ossim::S3ClientPool::m_instance;
+
+ossim::S3ClientPool::S3ClientPool()
+:m_clientsCreated(0),
+ m_opens(0),
+ m_cachedOpens(0),
+ m_failedOpens(0),
+ m_totalOpenSeconds(0.0),
+ m_maxOpenSeconds(0.0)
+{
+}
+
+ossim::S3ClientPool::~S3ClientPool()
+{
+   m_clients.clear();
+}
+
+std::shared_ptr<ossim::S3ClientPool> ossim::S3ClientPool::instance()
+{
+   static std::mutex instanceMutex;
+   std::unique_lock<std::mutex> lock(instanceMutex);
+   if(!m_instance)
+   {
+      m_instance = std::make_shared<S3ClientPool>();
+   }
+
+   return m_instance;
+}
+
+ossim::S3ClientPool::Client_t ossim::S3ClientPool::getClient(const std::string& region,
+                                                             const std::string& endpoint)
+{
+   std::string clientRegion = region.empty() ? ossim::S3StreamDefaults::m_region : region;
+   std::string clientEndpoint = endpoint.empty() ? ossim::S3StreamDefaults::m_endpoint : endpoint;
+   std::string key = clientRegion + "|" + clientEndpoint;
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   std::map<std::string, Client_t>::const_iterator iter = m_clients.find(key);
+   if(iter != m_clients.end())
+   {
+      return iter->second;
+   }
+
+   Client_t client = createClient(clientRegion, clientEndpoint);
+   m_clients.insert(std::make_pair(key, client));
+   ++m_clientsCreated;
+
+   return client;
+}
+
+ossim::S3ClientPool::Client_t ossim::S3ClientPool::createClient(const std::string& region,
+                                                                const std::string& endpoint)const
+{
+   if(traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossim::S3ClientPool::createClient DEBUG: region=" << region
+         << " endpoint=" << endpoint << std::endl;
+   }
+
+   Aws::Client::ClientConfiguration config;
+   if(!region.empty())
+   {
+      config.region = region.c_str();
+   }
+   if(!endpoint.empty())
+   {
+      config.endpointOverride = endpoint.c_str();
+   }
+
+   //---
+   // Connections are kept alive and reused by the client's connection pool.
+   // Async calls (direct reads, part uploads) run on a pool sized to match so
+   // each task can hold a connection.
+   //---
+   unsigned maxConnections = static_cast<unsigned>(
+      std::max(ossim::S3StreamDefaults::m_maxConnections, static_cast<ossim_int64>(1)));
+   config.maxConnections = maxConnections;
+   config.enableTcpKeepAlive = true;
+   config.executor = Aws::MakeShared<Aws::Utils::Threading::PooledThreadExecutor>(
+      ALLOCATION_TAG, maxConnections);
+
+   return std::make_shared<Aws::S3::S3Client>(config);
+}
+
+void ossim::S3ClientPool::recordOpen(ossim_float64 seconds, bool cached, bool success)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   ++m_opens;
+   if(cached) ++m_cachedOpens;
+   if(!success) ++m_failedOpens;
+   m_totalOpenSeconds += seconds;
+   if(seconds > m_maxOpenSeconds)
+   {
+      m_maxOpenSeconds = seconds;
+   }
+}
+
+std::ostream& ossim::S3ClientPool::print(std::ostream& out)const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   out << "s3_clients_created: " << m_clientsCreated
+       << "\ns3_opens: " << m_opens
+       << "\ns3_cached_opens: " << m_cachedOpens
+       << "\ns3_failed_opens: " << m_failedOpens
+       << "\ns3_total_open_seconds: " << m_totalOpenSeconds
+       << "\ns3_mean_open_seconds: "
+       << (m_opens ? m_totalOpenSeconds/m_opens : 0.0)
+       << "\ns3_max_open_seconds: " << m_maxOpenSeconds
+       << "\n";
+   return out;
+}
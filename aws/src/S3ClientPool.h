@@ -0,0 +1,74 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Process wide pool of S3 clients shared by all S3 streams, one client per
+// region/endpoint.  Sharing a client shares its credential lookup and its
+// keep-alive connection pool.  Also keeps open latency counters.
+//
+//---
+// $Id$
+
+#ifndef ossimS3ClientPool_HEADER
+#define ossimS3ClientPool_HEADER 1
+
+#include <ossim/base/ossimConstants.h>
+#include <aws/s3/S3Client.h>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace ossim
+{
+   class S3ClientPool
+   {
+   public:
+      typedef std::shared_ptr<Aws::S3::S3Client> Client_t;
+
+      S3ClientPool();
+      virtual ~S3ClientPool();
+
+      static std::shared_ptr<S3ClientPool> instance();
+
+      /**
+       * @brief Gets the shared client for a region and endpoint, creating it
+       * on first use.  Empty strings use S3StreamDefaults::m_region and
+       * m_endpoint.
+       */
+      Client_t getClient(const std::string& region="",
+                         const std::string& endpoint="");
+
+      /**
+       * @brief Records one stream open.
+       * @param seconds Time the open took.
+       * @param cached true if the header came from the header cache.
+       * @param success true if the object was opened.
+       */
+      void recordOpen(ossim_float64 seconds, bool cached, bool success);
+
+      /** Prints client and open latency counters. */
+      std::ostream& print(std::ostream& out)const;
+
+   protected:
+      Client_t createClient(const std::string& region,
+                            const std::string& endpoint)const;
+
+      static std::shared_ptr<S3ClientPool> m_instance;
+      mutable std::mutex m_mutex;
+
+      std::map<std::string, Client_t> m_clients;
+
+      ossim_int64   m_clientsCreated;
+      ossim_int64   m_opens;
+      ossim_int64   m_cachedOpens;
+      ossim_int64   m_failedOpens;
+      ossim_float64 m_totalOpenSeconds;
+      ossim_float64 m_maxOpenSeconds;
+   };
+}
+
+#endif
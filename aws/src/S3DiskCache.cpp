@@ -0,0 +1,397 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Persistent, size bounded on-disk tier below S3BlockCache.
+//
+//---
+// $Id$
+
+#include "S3DiskCache.h"
+#include "S3StreamDefaults.h"
+
+#include <ossim/base/ossimDirectory.h>
+#include <ossim/base/ossimTrace.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <ctime>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+#if !defined(_WIN32)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#else
+#  include <process.h>
+#  define getpid _getpid
+#endif
+
+static ossimTrace traceDebug("ossimS3DiskCache:debug");
+
+std::shared_ptr<ossim::S3DiskCache> ossim::S3DiskCache::m_instance;
+
+// Block files start with this magic, the object id so a hash collision
+// can never serve another object's bytes, and the payload length so a
+// truncated file is never served.
+static const char BLOCK_MAGIC[4] = { 'O', 'S', 'B', '2' };
+
+// Temp files older than this are left over from a crashed writer.
+static const time_t STALE_TEMP_SECONDS = 3600;
+
+namespace
+{
+#if !defined(_WIN32)
+   /** Block backed by a read only memory mapped file. */
+   class S3MappedBlock : public ossim::S3Block
+   {
+   public:
+      S3MappedBlock(void* map, std::size_t mapSize, ossim_int64 dataOffset)
+      :m_map(map),
+       m_mapSize(mapSize),
+       m_dataOffset(dataOffset)
+      {}
+      virtual ~S3MappedBlock()
+      {
+         munmap(m_map, m_mapSize);
+      }
+      virtual const char* data()const
+      {
+         return static_cast<const char*>(m_map) + m_dataOffset;
+      }
+      virtual ossim_int64 size()const
+      {
+         return static_cast<ossim_int64>(m_mapSize) - m_dataOffset;
+      }
+   private:
+      void*       m_map;
+      std::size_t m_mapSize;
+      ossim_int64 m_dataOffset;
+   };
+#endif
+
+   ossim_int64 headerSize(const std::string& cacheId)
+   {
+      return static_cast<ossim_int64>(sizeof(BLOCK_MAGIC) + sizeof(ossim_uint32) +
+                                      cacheId.size() + sizeof(ossim_uint64));
+   }
+
+   /**
+    * @param buf Header bytes.
+    * @param fileSize Size of the whole block file.
+    * @return true if the header is for cacheId and the payload is complete.
+    */
+   bool checkHeader(const char* buf, ossim_int64 fileSize, const std::string& cacheId)
+   {
+      if(fileSize < headerSize(cacheId)) return false;
+      if(std::memcmp(buf, BLOCK_MAGIC, sizeof(BLOCK_MAGIC)) != 0) return false;
+      ossim_uint32 idSize = 0;
+      std::memcpy(&idSize, buf + sizeof(BLOCK_MAGIC), sizeof(idSize));
+      if((idSize != cacheId.size()) ||
+         (std::memcmp(buf + sizeof(BLOCK_MAGIC) + sizeof(idSize), cacheId.data(), idSize) != 0))
+      {
+         return false;
+      }
+      ossim_uint64 payloadSize = 0;
+      std::memcpy(&payloadSize, buf + sizeof(BLOCK_MAGIC) + sizeof(idSize) + idSize,
+                  sizeof(payloadSize));
+      return (static_cast<ossim_uint64>(fileSize - headerSize(cacheId)) == payloadSize);
+   }
+}
+
+ossim::S3DiskCache::S3DiskCache()
+:m_directory(ossim::S3StreamDefaults::m_diskCacheDirectory),
+ m_maxCacheSize(ossim::S3StreamDefaults::m_diskCacheSize),
+ m_cacheSize(0),
+ m_enabled(false)
+{
+   if(!m_directory.empty() && (m_maxCacheSize > 0))
+   {
+      if(!m_directory.exists())
+      {
+         m_directory.createDirectory(true);
+      }
+      m_enabled = m_directory.isDir();
+      if(m_enabled)
+      {
+         scanDirectory();
+      }
+      else if(traceDebug())
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossim::S3DiskCache DEBUG: could not create " << m_directory
+            << ", disk cache disabled." << std::endl;
+      }
+   }
+}
+
+ossim::S3DiskCache::~S3DiskCache()
+{
+   m_index.clear();
+   m_lru.clear();
+}
+
+std::shared_ptr<ossim::S3DiskCache> ossim::S3DiskCache::instance()
+{
+   static std::mutex instanceMutex;
+   std::unique_lock<std::mutex> lock(instanceMutex);
+   if(!m_instance)
+   {
+      m_instance = std::make_shared<S3DiskCache>();
+   }
+
+   return m_instance;
+}
+
+bool ossim::S3DiskCache::isEnabled()const
+{
+   return m_enabled;
+}
+
+ossimFilename ossim::S3DiskCache::getBlockFile(const std::string& cacheId,
+                                               ossim_int64 blockIndex)const
+{
+   // One sub directory per object keeps directories small.
+   std::ostringstream objectDir;
+   objectDir << std::hex << std::setw(16) << std::setfill('0')
+             << static_cast<ossim_uint64>(std::hash<std::string>()(cacheId));
+   std::ostringstream blockFile;
+   blockFile << blockIndex << ".blk";
+   return m_directory.dirCat(objectDir.str()).dirCat(blockFile.str());
+}
+
+ossim::S3BlockCache::Block_t ossim::S3DiskCache::getBlock(const std::string& cacheId,
+                                                          ossim_int64 blockIndex)
+{
+   S3BlockCache::Block_t result;
+   if(!m_enabled) return result;
+
+   ossimFilename file = getBlockFile(cacheId, blockIndex);
+   ossim_int64 fileSize = 0;
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      IndexType::iterator iter = m_index.find(file.string());
+      if(iter == m_index.end())
+      {
+         // Another process on this host may have written it.
+         if(!file.exists()) return result;
+         fileSize = file.fileSize();
+         touch(file.string(), fileSize);
+      }
+      else
+      {
+         fileSize = iter->second.m_size;
+         m_lru.splice(m_lru.begin(), m_lru, iter->second.m_lruIter);
+      }
+   }
+
+#if !defined(_WIN32)
+   int fd = ::open(file.c_str(), O_RDONLY);
+   if(fd < 0) return result;
+   struct stat st;
+   if((fstat(fd, &st) == 0) && (st.st_size > headerSize(cacheId)))
+   {
+      void* map = mmap(0, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+      if(map != MAP_FAILED)
+      {
+         if(checkHeader(static_cast<const char*>(map), st.st_size, cacheId))
+         {
+            result = std::make_shared<S3MappedBlock>(map, static_cast<std::size_t>(st.st_size),
+                                                     headerSize(cacheId));
+         }
+         else
+         {
+            munmap(map, static_cast<std::size_t>(st.st_size));
+         }
+      }
+   }
+   ::close(fd);
+#else
+   // Size on disk, not the indexed size, so a truncated file is rejected.
+   fileSize = file.fileSize();
+   std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+   if(in.good() && (fileSize > headerSize(cacheId)))
+   {
+      std::vector<char> header(static_cast<std::size_t>(headerSize(cacheId)));
+      in.read(&header.front(), header.size());
+      if(in.good() && checkHeader(&header.front(), fileSize, cacheId))
+      {
+         std::shared_ptr<S3MemoryBlock> block =
+            std::make_shared<S3MemoryBlock>(fileSize - headerSize(cacheId));
+         in.read(block->buffer(), block->size());
+         if(in.good())
+         {
+            result = block;
+         }
+      }
+   }
+#endif
+
+   return result;
+}
+
+void ossim::S3DiskCache::addBlock(const std::string& cacheId, ossim_int64 blockIndex,
+                                  const S3BlockCache::Block_t& block)
+{
+   if(!m_enabled || !block || (block->size() <= 0)) return;
+
+   ossimFilename file = getBlockFile(cacheId, blockIndex);
+   ossimFilename dir = file.path();
+   if(!dir.exists())
+   {
+      dir.createDirectory(true);
+   }
+
+   // Write to a temp file unique across processes and threads sharing the
+   // directory and rename so readers never see a partial block.
+   std::ostringstream tempName;
+   tempName << file.string() << "." << getpid() << "." << std::this_thread::get_id() << ".tmp";
+   std::string tempFile = tempName.str();
+   {
+      std::ofstream out(tempFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      if(!out.good()) return;
+      ossim_uint32 idSize = static_cast<ossim_uint32>(cacheId.size());
+      ossim_uint64 payloadSize = static_cast<ossim_uint64>(block->size());
+      out.write(BLOCK_MAGIC, sizeof(BLOCK_MAGIC));
+      out.write(reinterpret_cast<const char*>(&idSize), sizeof(idSize));
+      out.write(cacheId.data(), idSize);
+      out.write(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
+      out.write(block->data(), block->size());
+      if(!out.good())
+      {
+         out.close();
+         std::remove(tempFile.c_str());
+         return;
+      }
+   }
+#if defined(_WIN32)
+   std::remove(file.c_str());
+#endif
+   if(std::rename(tempFile.c_str(), file.c_str()) != 0)
+   {
+      std::remove(tempFile.c_str());
+      return;
+   }
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   touch(file.string(), headerSize(cacheId) + block->size());
+   shrinkEntries();
+}
+
+void ossim::S3DiskCache::touch(const std::string& file, ossim_int64 size)
+{
+   IndexType::iterator iter = m_index.find(file);
+   if(iter != m_index.end())
+   {
+      m_cacheSize -= iter->second.m_size;
+      iter->second.m_size = size;
+      m_lru.splice(m_lru.begin(), m_lru, iter->second.m_lruIter);
+   }
+   else
+   {
+      m_lru.push_front(file);
+      Entry entry;
+      entry.m_size = size;
+      entry.m_lruIter = m_lru.begin();
+      m_index.insert(std::make_pair(file, entry));
+   }
+   m_cacheSize += size;
+}
+
+void ossim::S3DiskCache::shrinkEntries()
+{
+   while((m_cacheSize > m_maxCacheSize) && !m_lru.empty())
+   {
+      IndexType::iterator iter = m_index.find(m_lru.back());
+      if(iter != m_index.end())
+      {
+         // Safe on POSIX even if another stream has the file mapped.
+         std::remove(iter->first.c_str());
+         m_cacheSize -= iter->second.m_size;
+         m_index.erase(iter);
+      }
+      m_lru.pop_back();
+   }
+}
+
+void ossim::S3DiskCache::scanDirectory()
+{
+   struct FileInfo
+   {
+      std::string m_file;
+      ossim_int64 m_size;
+      time_t      m_mtime;
+   };
+   std::vector<FileInfo> files;
+   time_t now = std::time(0);
+
+   ossimDirectory objectDirs;
+   if(objectDirs.open(m_directory))
+   {
+      ossimFilename objectDir;
+      bool haveDir = objectDirs.getFirst(objectDir, ossimDirectory::OSSIM_DIR_DIRS);
+      while(haveDir)
+      {
+         ossimDirectory blocks;
+         if(blocks.open(objectDir))
+         {
+            ossimFilename blockFile;
+            bool haveFile = blocks.getFirst(blockFile, ossimDirectory::OSSIM_DIR_FILES);
+            while(haveFile)
+            {
+               struct stat st;
+               if(blockFile.ext() == "blk")
+               {
+                  if(stat(blockFile.c_str(), &st) == 0)
+                  {
+                     FileInfo info;
+                     info.m_file  = blockFile.string();
+                     info.m_size  = static_cast<ossim_int64>(st.st_size);
+                     info.m_mtime = st.st_mtime;
+                     files.push_back(info);
+                  }
+               }
+               else if(blockFile.ext() == "tmp")
+               {
+                  // Left behind by a crashed writer.  Recent ones may still be
+                  // in progress in another process.
+                  if((stat(blockFile.c_str(), &st) == 0) &&
+                     (now - st.st_mtime > STALE_TEMP_SECONDS))
+                  {
+                     std::remove(blockFile.c_str());
+                  }
+               }
+               haveFile = blocks.getNext(blockFile);
+            }
+         }
+         haveDir = objectDirs.getNext(objectDir);
+      }
+   }
+
+   // Oldest first so the newest end up at the front of the LRU.
+   std::sort(files.begin(), files.end(),
+             [](const FileInfo& a, const FileInfo& b) { return a.m_mtime < b.m_mtime; });
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   for(std::size_t idx = 0; idx < files.size(); ++idx)
+   {
+      touch(files[idx].m_file, files[idx].m_size);
+   }
+   shrinkEntries();
+
+   if(traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossim::S3DiskCache::scanDirectory DEBUG: " << m_index.size()
+         << " blocks, " << m_cacheSize << " bytes in " << m_directory << std::endl;
+   }
+}
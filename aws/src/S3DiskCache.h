@@ -0,0 +1,79 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Persistent, size bounded on-disk tier below S3BlockCache.  Each block is a
+// file named from the object id (which includes the ETag) and block index,
+// memory mapped when read.  Blocks survive process restarts and are shared
+// by every process on the host using the same directory.
+//
+//---
+// $Id$
+
+#ifndef ossimS3DiskCache_HEADER
+#define ossimS3DiskCache_HEADER 1
+
+#include "S3BlockCache.h"
+#include <ossim/base/ossimConstants.h>
+#include <ossim/base/ossimFilename.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ossim
+{
+   class S3DiskCache
+   {
+   public:
+      S3DiskCache();
+      virtual ~S3DiskCache();
+
+      static std::shared_ptr<S3DiskCache> instance();
+
+      /** @return true if a cache directory is configured and usable. */
+      bool isEnabled()const;
+
+      /**
+       * @param cacheId Object id.  Must change when the object changes.
+       * @return Mapped block or null if not on disk.
+       */
+      S3BlockCache::Block_t getBlock(const std::string& cacheId, ossim_int64 blockIndex);
+
+      /** Writes a block to disk evicting least recently used files. */
+      void addBlock(const std::string& cacheId, ossim_int64 blockIndex,
+                    const S3BlockCache::Block_t& block);
+
+   protected:
+      typedef std::list<std::string> LruListType;
+      struct Entry
+      {
+         ossim_int64           m_size;
+         LruListType::iterator m_lruIter;
+      };
+      typedef std::unordered_map<std::string, Entry> IndexType;
+
+      /** Builds the index from files already in the directory. */
+      void scanDirectory();
+      ossimFilename getBlockFile(const std::string& cacheId, ossim_int64 blockIndex)const;
+
+      /** Assumes m_mutex is locked. */
+      void touch(const std::string& file, ossim_int64 size);
+      void shrinkEntries();
+
+      static std::shared_ptr<S3DiskCache> m_instance;
+      mutable std::mutex m_mutex;
+
+      ossimFilename m_directory;
+      ossim_int64   m_maxCacheSize;
+      ossim_int64   m_cacheSize;
+      bool          m_enabled;
+      IndexType     m_index;
+      LruListType   m_lru;
+   };
+}
+
+#endif
@@ -5,7 +5,9 @@ std::shared_ptr<ossim::S3HeaderCache> ossim::S3HeaderCache::m_instance;
 
 
 ossim::S3HeaderCache::S3HeaderCache()
-:m_maxCacheEntries(ossim::S3StreamDefaults::m_nReadCacheHeaders)
+:m_maxCacheEntries(ossim::S3StreamDefaults::m_nReadCacheHeaders),
+ m_maxCacheSize(ossim::S3StreamDefaults::m_headerCacheSize),
+ m_cacheSize(0)
 {
 
 }
@@ -13,10 +15,14 @@ ossim::S3HeaderCache::S3HeaderCache()
 ossim::S3HeaderCache::~S3HeaderCache()
 {
    m_cache.clear();
+   m_lru.clear();
+   m_cacheSize = 0;
 }
 
 std::shared_ptr<ossim::S3HeaderCache> ossim::S3HeaderCache::instance()
 {
+   static std::mutex instanceMutex;
+   std::unique_lock<std::mutex> lock(instanceMutex);
    if(!m_instance)
    {
       m_instance = std::make_shared<S3HeaderCache>();
@@ -27,60 +33,120 @@ std::shared_ptr<ossim::S3HeaderCache> ossim::S3HeaderCache::instance()
 
 bool ossim::S3HeaderCache::getCachedFilesize(const Key_t& key, ossim_int64& filesize)const
 {
-   std::unique_lock<std::mutex> lock(m_mutex);
    bool result = false;
-   if(m_maxCacheEntries<=0) return result;
-   CacheType::const_iterator iter = m_cache.find(key);
+   Node_t node = getNode(key);
 
-   if(iter != m_cache.end())
+   if(node && node->m_exists)
    {
-      filesize = iter->second->m_filesize;
+      filesize = node->m_filesize;
       result = true;
    }
 
    return result;
 }
 
+ossim::S3HeaderCache::Node_t ossim::S3HeaderCache::getNode(const Key_t& key)const
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   if(m_maxCacheEntries<=0) return Node_t();
+
+   return findNode(key);
+}
+
+ossim::S3HeaderCache::Node_t ossim::S3HeaderCache::findNode(const Key_t& key)const
+{
+   Node_t result;
+   CacheType::iterator iter = m_cache.find(key);
+
+   if(iter != m_cache.end())
+   {
+      const Node_t& node = iter->second.first;
+      ossim_float64 ttl = node->m_exists ? ossim::S3StreamDefaults::m_headerCacheTtl
+                                         : ossim::S3StreamDefaults::m_notFoundCacheTtl;
+      ossim_float64 age = ossimTimer::instance()->delta_s(node->m_timestamp,
+                                                          ossimTimer::instance()->tick());
+      if((ttl > 0.0) && (age > ttl))
+      {
+         eraseNode(iter);
+      }
+      else
+      {
+         m_lru.splice(m_lru.begin(), m_lru, iter->second.second);
+         result = node;
+      }
+   }
+
+   return result;
+}
+
 void ossim::S3HeaderCache::addHeader(const Key_t& key, Node_t& node)
 {
    std::unique_lock<std::mutex> lock(m_mutex);
    if(m_maxCacheEntries<=0) return;
-   CacheType::const_iterator iter = m_cache.find(key);
+   CacheType::iterator iter = m_cache.find(key);
 
    if(iter != m_cache.end())
    {
-      iter->second->m_filesize = node->m_filesize;
-   }  
+      m_cacheSize -= nodeSize(key, iter->second.first);
+      iter->second.first = node;
+      m_lru.splice(m_lru.begin(), m_lru, iter->second.second);
+   }
    else
    {
-      if(m_cache.size() >= m_maxCacheEntries)
-      {
-         shrinkEntries();
-      }
-      m_cache.insert( std::make_pair(key, node) );
-      m_cacheTime.insert( std::make_pair(node->m_timestamp, key) );
-   } 
+      m_lru.push_front(key);
+      m_cache.insert( std::make_pair(key, std::make_pair(node, m_lru.begin())) );
+   }
+   m_cacheSize += nodeSize(key, node);
+   shrinkEntries();
 }
 
-void ossim::S3HeaderCache::shrinkEntries()
+void ossim::S3HeaderCache::setMaxCacheEntries(ossim_int64 maxEntries)
 {
-   ossim_int64 targetSize = static_cast<ossim_int64>(0.2*m_maxCacheEntries);
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_maxCacheEntries = maxEntries;
+   shrinkEntries();
+}
 
-   if(m_cacheTime.empty()) return;
-   if(targetSize >= m_cache.size())
+void ossim::S3HeaderCache::setMaxCacheSize(ossim_int64 maxBytes)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_maxCacheSize = maxBytes;
+   shrinkEntries();
+}
+
+void ossim::S3HeaderCache::shrinkEntries()
+{
+   ossim_int64 maxEntries = m_maxCacheEntries > 0 ? m_maxCacheEntries : 0;
+   while(!m_lru.empty() &&
+         ((static_cast<ossim_int64>(m_cache.size()) > maxEntries) ||
+          ((m_maxCacheSize > 0) && (m_cacheSize > m_maxCacheSize))))
    {
-      m_cache.clear();
-      m_cacheTime.clear();
-      return;
+      CacheType::iterator iter = m_cache.find(m_lru.back());
+      if(iter != m_cache.end())
+      {
+         eraseNode(iter);
+      }
+      else
+      {
+         m_lru.pop_back();
+      }
    }
+}
 
-   CacheTimeIndexType::iterator iter = m_cacheTime.begin();
+void ossim::S3HeaderCache::eraseNode(CacheType::iterator iter)const
+{
+   m_cacheSize -= nodeSize(iter->first, iter->second.first);
+   m_lru.erase(iter->second.second);
+   m_cache.erase(iter);
+}
 
-   while(targetSize > 0)
+ossim_int64 ossim::S3HeaderCache::nodeSize(const Key_t& key, const Node_t& node)
+{
+   // Key is held twice, in the map and in the LRU list.
+   ossim_int64 result = static_cast<ossim_int64>(2*key.size());
+   if(node)
    {
-      m_cache.erase(iter->second);
-      iter = m_cacheTime.erase(iter);
-      --targetSize;
+      result += node->getMemorySize();
    }
+   return result;
 }
-
@@ -1,27 +1,66 @@
 #ifndef ossimS3HeaderCache_HEADER
 #define ossimS3HeaderCache_HEADER
 #include <ossim/base/ossimTimer.h>
+#include <list>
 #include <memory>
-#include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <mutex>  // For std::unique_lock
 #include <thread>
 
 namespace ossim
 {
+   /**
+    * Cached result of opening an object.  Nodes are immutable once added;
+    * updates replace the node.  A node with m_exists false records an
+    * object that was not found.
+    */
    class S3HeaderCacheNode
    {
    public:
+      typedef std::shared_ptr<const std::vector<char> > Bytes_t;
+
       S3HeaderCacheNode(ossim_int64 filesize)
       :m_timestamp(ossimTimer::instance()->tick()),
-      m_filesize(filesize)
+      m_filesize(filesize),
+      m_exists(true),
+      m_etag(),
+      m_lastModified(),
+      m_headerBytes()
       {
 
       }
 
+      /** @return Not found node. */
+      static std::shared_ptr<S3HeaderCacheNode> notFound()
+      {
+         std::shared_ptr<S3HeaderCacheNode> node = std::make_shared<S3HeaderCacheNode>(0);
+         node->m_exists = false;
+         return node;
+      }
+
       ossimTimer::Timer_t m_timestamp;
       ossim_int64         m_filesize;
+      bool                m_exists;
+      std::string         m_etag;
+      std::string         m_lastModified;
+
+      /** First bytes of the object, possibly empty. */
+      Bytes_t             m_headerBytes;
+
+      /** @return Approximate bytes held by this node. */
+      ossim_int64 getMemorySize()const
+      {
+         ossim_int64 result = static_cast<ossim_int64>(sizeof(S3HeaderCacheNode) +
+                                                       m_etag.size() + m_lastModified.size());
+         if(m_headerBytes)
+         {
+            result += static_cast<ossim_int64>(m_headerBytes->size());
+         }
+         return result;
+      }
    };
 
    class S3HeaderCache
@@ -29,26 +68,43 @@ namespace ossim
    public:
       typedef std::shared_ptr<S3HeaderCacheNode> Node_t;
       typedef std::string Key_t;
-      typedef ossim_int64 TimeIndex_t;
-      typedef std::map<Key_t, Node_t > CacheType;
-      typedef std::map<TimeIndex_t, Key_t > CacheTimeIndexType;
+      typedef std::list<Key_t> LruListType;
+      typedef std::unordered_map<Key_t, std::pair<Node_t, LruListType::iterator> > CacheType;
 
       S3HeaderCache();
       virtual ~S3HeaderCache();
       bool getCachedFilesize(const Key_t& key, ossim_int64& filesize)const;
+
+      /**
+       * @return Unexpired node for key, including not found nodes, or null.
+       */
+      Node_t getNode(const Key_t& key)const;
+
       void addHeader(const Key_t& key, Node_t& node);
       void setMaxCacheEntries(ossim_int64 maxEntries);
+
+      /** @param maxBytes Total bytes held by all nodes.  0 disables the limit. */
+      void setMaxCacheSize(ossim_int64 maxBytes);
       static std::shared_ptr<S3HeaderCache> instance();
 
    protected:
+      /** Assumes m_mutex is locked.  Returns null and drops expired nodes. */
+      Node_t findNode(const Key_t& key)const;
       void shrinkEntries();
 
+      /** Assumes m_mutex is locked.  Drops key and its bytes. */
+      void eraseNode(CacheType::iterator iter)const;
+
+      static ossim_int64 nodeSize(const Key_t& key, const Node_t& node);
+
       static std::shared_ptr<S3HeaderCache> m_instance;
       mutable std::mutex m_mutex;
 
-      CacheType m_cache;
-      CacheTimeIndexType m_cacheTime;
+      mutable CacheType m_cache;
+      mutable LruListType m_lru;
       ossim_int64 m_maxCacheEntries;
+      ossim_int64 m_maxCacheSize;
+      mutable ossim_int64 m_cacheSize;
 
    };
 }
@@ -1,70 +1,247 @@
 #include "S3StreamDefaults.h"
 #include <ossim/base/ossimPreferences.h>
 #include <ossim/base/ossimEnvironmentUtility.h>
+#include <ossim/base/ossimFilename.h>
 #include <ossim/base/ossimTrace.h>
 
 // defaults to a 1 megabyte block size
 //
 ossim_int64 ossim::S3StreamDefaults::m_readBlocksize = 32768;
 ossim_int64 ossim::S3StreamDefaults::m_nReadCacheHeaders = 10000;
+ossim_int64 ossim::S3StreamDefaults::m_headerCacheBytes = 65536;
+ossim_int64 ossim::S3StreamDefaults::m_headerCacheSize = 67108864;
+ossim_float64 ossim::S3StreamDefaults::m_headerCacheTtl = 300.0;
+ossim_float64 ossim::S3StreamDefaults::m_notFoundCacheTtl = 30.0;
+ossim_int64 ossim::S3StreamDefaults::m_readCacheSize = 67108864;
+ossim_int64 ossim::S3StreamDefaults::m_readAheadBlocks = 4;
+ossim_int64 ossim::S3StreamDefaults::m_readAheadThreads = 2;
+ossim_int64 ossim::S3StreamDefaults::m_directReadThreshold = 262144;
+ossim_int64 ossim::S3StreamDefaults::m_directReadParts = 4;
+ossim_int64 ossim::S3StreamDefaults::m_writePartSize = 8388608;
+ossim_int64 ossim::S3StreamDefaults::m_writeThreads = 4;
+std::string ossim::S3StreamDefaults::m_region = "";
+std::string ossim::S3StreamDefaults::m_endpoint = "";
+ossim_int64 ossim::S3StreamDefaults::m_maxConnections = 25;
+std::string ossim::S3StreamDefaults::m_diskCacheDirectory = "";
+ossim_int64 ossim::S3StreamDefaults::m_diskCacheSize = 1073741824;
 static ossimTrace traceDebug("ossimS3StreamDefaults:debug");
 
-void ossim::S3StreamDefaults::loadDefaults()
+//---
+// Looks up the environment variable first and then the preference.
+//---
+static ossimString findSetting(const char* envName, const char* prefName)
 {
-   if(traceDebug())
+   ossimString result = ossimEnvironmentUtility::instance()->getEnvironmentVariable(envName);
+   if(result.empty())
    {
-      ossimNotify(ossimNotifyLevel_DEBUG)
-         << "ossim::S3StreamDefaults::loadDefaults() DEBUG: entered.....\n";
+      result = ossimPreferences::instance()->findPreference(prefName);
    }
-   ossimString s3ReadBlocksize = ossimEnvironmentUtility::instance()->getEnvironmentVariable("OSSIM_PLUGINS_AWS_S3_READBLOCKSIZE");
-
-   ossimString  nReadCacheHeaders = ossimPreferences::instance()->findPreference("OSSIM_PLUGINS_AWS_S3_NREADCACHEHEADERS");
+   return result;
+}
 
-   
-   if(s3ReadBlocksize.empty())
-   {
-       s3ReadBlocksize = ossimPreferences::instance()->findPreference("ossim.plugins.aws.s3.readBlocksize");
-   }
-   if(!s3ReadBlocksize.empty())
+//---
+// Converts a size string with an optional K, M or G suffix to bytes.
+// Returns false if the value is not greater than zero.
+//---
+static bool toByteSize(const ossimString& value, ossim_int64& bytes)
+{
+   bool result = false;
+   if(!value.empty())
    {
-     ossim_int64 blockSize = s3ReadBlocksize.toInt64();
-     if(blockSize > 0)
-     {
-         ossimString byteType(s3ReadBlocksize.begin()+(s3ReadBlocksize.size()-1), s3ReadBlocksize.end());
+      ossim_int64 size = value.toInt64();
+      if(size > 0)
+      {
+         ossimString byteType(value.begin()+(value.size()-1), value.end());
          byteType.upcase();
-         m_readBlocksize = blockSize;
+         bytes = size;
          if ( byteType == "K")
          {
-            m_readBlocksize *=static_cast<ossim_int64>(1024);
+            bytes *=static_cast<ossim_int64>(1024);
          }
          else if ( byteType == "M")
          {
-            m_readBlocksize *=static_cast<ossim_int64>(1048576);
+            bytes *=static_cast<ossim_int64>(1048576);
          }
          else if ( byteType == "G")
          {
-            m_readBlocksize *=static_cast<ossim_int64>(1073741824);
+            bytes *=static_cast<ossim_int64>(1073741824);
          }
-     }
+         result = true;
+      }
    }
-   if(nReadCacheHeaders.empty())
+   return result;
+}
+
+void ossim::S3StreamDefaults::loadDefaults()
+{
+   if(traceDebug())
    {
-     nReadCacheHeaders = ossimPreferences::instance()->findPreference("ossim.plugins.aws.s3.nReadCacheHeaders");
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossim::S3StreamDefaults::loadDefaults() DEBUG: entered.....\n";
    }
+   ossimString s3ReadBlocksize = findSetting("OSSIM_PLUGINS_AWS_S3_READBLOCKSIZE",
+                                             "ossim.plugins.aws.s3.readBlocksize");
+
+   ossimString  nReadCacheHeaders = findSetting("OSSIM_PLUGINS_AWS_S3_NREADCACHEHEADERS",
+                                                "ossim.plugins.aws.s3.nReadCacheHeaders");
+
+   toByteSize(s3ReadBlocksize, m_readBlocksize);
+
    if(!nReadCacheHeaders.empty())
    {
       m_nReadCacheHeaders =  nReadCacheHeaders.toInt64();
       if(m_nReadCacheHeaders < 0)
       {
         m_nReadCacheHeaders = 10000;
-      }     
+      }
+   }
+
+   ossimString headerCacheBytes = findSetting("OSSIM_PLUGINS_AWS_S3_HEADERCACHEBYTES",
+                                              "ossim.plugins.aws.s3.headerCacheBytes");
+   if(!headerCacheBytes.empty() && !toByteSize(headerCacheBytes, m_headerCacheBytes))
+   {
+      m_headerCacheBytes = 0;
+   }
+
+   ossimString headerCacheSize = findSetting("OSSIM_PLUGINS_AWS_S3_HEADERCACHESIZE",
+                                             "ossim.plugins.aws.s3.headerCacheSize");
+   if(!headerCacheSize.empty() && !toByteSize(headerCacheSize, m_headerCacheSize))
+   {
+      // Zero or negative leaves the cache bounded by entry count only.
+      m_headerCacheSize = 0;
+   }
+
+   ossimString headerCacheTtl = findSetting("OSSIM_PLUGINS_AWS_S3_HEADERCACHETTL",
+                                            "ossim.plugins.aws.s3.headerCacheTtl");
+   if(!headerCacheTtl.empty())
+   {
+      m_headerCacheTtl = headerCacheTtl.toFloat64();
+   }
+
+   ossimString notFoundCacheTtl = findSetting("OSSIM_PLUGINS_AWS_S3_NOTFOUNDCACHETTL",
+                                              "ossim.plugins.aws.s3.notFoundCacheTtl");
+   if(!notFoundCacheTtl.empty())
+   {
+      m_notFoundCacheTtl = notFoundCacheTtl.toFloat64();
+   }
+
+   ossimString readCacheSize = findSetting("OSSIM_PLUGINS_AWS_S3_READCACHESIZE",
+                                           "ossim.plugins.aws.s3.readCacheSize");
+   if(!readCacheSize.empty() && !toByteSize(readCacheSize, m_readCacheSize))
+   {
+      // Zero or negative disables the block cache.
+      m_readCacheSize = 0;
+   }
+
+   ossimString readAheadBlocks = findSetting("OSSIM_PLUGINS_AWS_S3_READAHEADBLOCKS",
+                                             "ossim.plugins.aws.s3.readAheadBlocks");
+   if(!readAheadBlocks.empty())
+   {
+      m_readAheadBlocks = readAheadBlocks.toInt64();
+      if(m_readAheadBlocks < 0)
+      {
+         m_readAheadBlocks = 0;
+      }
+   }
+
+   ossimString readAheadThreads = findSetting("OSSIM_PLUGINS_AWS_S3_READAHEADTHREADS",
+                                              "ossim.plugins.aws.s3.readAheadThreads");
+   if(!readAheadThreads.empty())
+   {
+      m_readAheadThreads = readAheadThreads.toInt64();
+      if(m_readAheadThreads < 0)
+      {
+         m_readAheadThreads = 0;
+      }
+   }
+
+   ossimString directReadThreshold = findSetting("OSSIM_PLUGINS_AWS_S3_DIRECTREADTHRESHOLD",
+                                                 "ossim.plugins.aws.s3.directReadThreshold");
+   if(!directReadThreshold.empty() && !toByteSize(directReadThreshold, m_directReadThreshold))
+   {
+      m_directReadThreshold = 0;
+   }
+
+   ossimString directReadParts = findSetting("OSSIM_PLUGINS_AWS_S3_DIRECTREADPARTS",
+                                             "ossim.plugins.aws.s3.directReadParts");
+   if(!directReadParts.empty())
+   {
+      m_directReadParts = directReadParts.toInt64();
+      if(m_directReadParts < 1)
+      {
+         m_directReadParts = 1;
+      }
+   }
+
+   ossimString writePartSize = findSetting("OSSIM_PLUGINS_AWS_S3_WRITEPARTSIZE",
+                                           "ossim.plugins.aws.s3.writePartSize");
+   toByteSize(writePartSize, m_writePartSize);
+   if(m_writePartSize < 5242880)
+   {
+      m_writePartSize = 5242880;
    }
+
+   ossimString writeThreads = findSetting("OSSIM_PLUGINS_AWS_S3_WRITETHREADS",
+                                          "ossim.plugins.aws.s3.writeThreads");
+   if(!writeThreads.empty())
+   {
+      m_writeThreads = writeThreads.toInt64();
+      if(m_writeThreads < 1)
+      {
+         m_writeThreads = 1;
+      }
+   }
+
+   m_region = findSetting("OSSIM_PLUGINS_AWS_S3_REGION",
+                          "ossim.plugins.aws.s3.region").string();
+   m_endpoint = findSetting("OSSIM_PLUGINS_AWS_S3_ENDPOINT",
+                            "ossim.plugins.aws.s3.endpoint").string();
+
+   ossimString maxConnections = findSetting("OSSIM_PLUGINS_AWS_S3_MAXCONNECTIONS",
+                                            "ossim.plugins.aws.s3.maxConnections");
+   if(!maxConnections.empty())
+   {
+      m_maxConnections = maxConnections.toInt64();
+      if(m_maxConnections < 1)
+      {
+         m_maxConnections = 25;
+      }
+   }
+
+   ossimFilename diskCacheDirectory = findSetting("OSSIM_PLUGINS_AWS_S3_DISKCACHEDIRECTORY",
+                                                  "ossim.plugins.aws.s3.diskCacheDirectory");
+   m_diskCacheDirectory = diskCacheDirectory.expand().string();
+
+   ossimString diskCacheSize = findSetting("OSSIM_PLUGINS_AWS_S3_DISKCACHESIZE",
+                                           "ossim.plugins.aws.s3.diskCacheSize");
+   if(!diskCacheSize.empty() && !toByteSize(diskCacheSize, m_diskCacheSize))
+   {
+      m_diskCacheSize = 0;
+   }
+
    if(traceDebug())
    {
       ossimNotify(ossimNotifyLevel_DEBUG)
          << "m_readBlocksize: " << m_readBlocksize << "\n";
       ossimNotify(ossimNotifyLevel_DEBUG)
-         << "m_nReadCacheHeaders: " << m_nReadCacheHeaders << "\n";
+         << "m_nReadCacheHeaders: " << m_nReadCacheHeaders << "\n"
+         << "m_headerCacheBytes: " << m_headerCacheBytes << "\n"
+         << "m_headerCacheSize: " << m_headerCacheSize << "\n"
+         << "m_headerCacheTtl: " << m_headerCacheTtl << "\n"
+         << "m_notFoundCacheTtl: " << m_notFoundCacheTtl << "\n";
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "m_readCacheSize: " << m_readCacheSize << "\n"
+         << "m_readAheadBlocks: " << m_readAheadBlocks << "\n"
+         << "m_readAheadThreads: " << m_readAheadThreads << "\n"
+         << "m_directReadThreshold: " << m_directReadThreshold << "\n"
+         << "m_directReadParts: " << m_directReadParts << "\n"
+         << "m_writePartSize: " << m_writePartSize << "\n"
+         << "m_writeThreads: " << m_writeThreads << "\n"
+         << "m_region: " << m_region << "\n"
+         << "m_endpoint: " << m_endpoint << "\n"
+         << "m_maxConnections: " << m_maxConnections << "\n"
+         << "m_diskCacheDirectory: " << m_diskCacheDirectory << "\n"
+         << "m_diskCacheSize: " << m_diskCacheSize << "\n";
       ossimNotify(ossimNotifyLevel_DEBUG)
          << "ossim::S3StreamDefaults::loadDefaults() DEBUG: leaving.....\n";
    }
@@ -1,6 +1,7 @@
 #ifndef S3StreamDefaults_HEADER
 #define S3StreamDefaults_HEADER 1
 #include <ossim/base/ossimConstants.h>
+#include <string>
 
 namespace ossim{
    
@@ -13,6 +14,55 @@ namespace ossim{
          static ossim_int64 m_readBlocksize;
          static ossim_int64 m_nReadCacheHeaders;
 
+         /** Bytes from the start of each object kept in the header cache. */
+         static ossim_int64 m_headerCacheBytes;
+
+         /** Total bytes held by the header cache.  0 disables the limit. */
+         static ossim_int64 m_headerCacheSize;
+
+         /** Seconds header cache entries live.  0 never expires. */
+         static ossim_float64 m_headerCacheTtl;
+
+         /** Seconds "object not found" entries live.  0 never expires. */
+         static ossim_float64 m_notFoundCacheTtl;
+
+         /** Size in bytes of the block cache shared by all S3 streams. */
+         static ossim_int64 m_readCacheSize;
+
+         /** Number of blocks to fetch ahead once sequential reads are seen. */
+         static ossim_int64 m_readAheadBlocks;
+
+         /** Number of background threads servicing read-ahead requests. */
+         static ossim_int64 m_readAheadThreads;
+
+         /**
+          * Reads of at least this many bytes bypass the block buffer and go
+          * straight into the caller's buffer.  0 disables.
+          */
+         static ossim_int64 m_directReadThreshold;
+
+         /** Maximum number of parallel ranged GETs for one direct read. */
+         static ossim_int64 m_directReadParts;
+
+         /** Size of each multipart upload part.  S3 minimum is 5M. */
+         static ossim_int64 m_writePartSize;
+
+         /** Maximum parts uploading at once per output stream. */
+         static ossim_int64 m_writeThreads;
+
+         /** Region and endpoint override of the shared client.  Empty uses the SDK default. */
+         static std::string m_region;
+         static std::string m_endpoint;
+
+         /** Maximum keep-alive connections per shared client. */
+         static ossim_int64 m_maxConnections;
+
+         /** Directory of the persistent block cache.  Empty disables it. */
+         static std::string m_diskCacheDirectory;
+
+         /** Size limit in bytes of the persistent block cache. */
+         static ossim_int64 m_diskCacheSize;
+
    };
 
 }
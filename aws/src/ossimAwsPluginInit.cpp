@@ -14,6 +14,10 @@
 #include <ossim/base/ossimStreamFactoryRegistry.h>
 #include <aws/core/Aws.h>
 #include "S3StreamDefaults.h"
+#include "S3ClientPool.h"
+#include <ossim/base/ossimTrace.h>
+
+static ossimTrace traceDebug("ossimAwsPluginInit:debug");
 
 static void setDescription(ossimString& description)
 {
@@ -70,6 +74,10 @@ extern "C"
    /* Note symbols need to be exported on windoze... */ 
   OSSIM_PLUGINS_DLL void ossimSharedLibraryFinalize()
   {
+     if(traceDebug())
+     {
+        ossim::S3ClientPool::instance()->print(ossimNotify(ossimNotifyLevel_DEBUG));
+     }
      ossim::StreamFactoryRegistry::instance()->
         unregisterFactory( ossim::AwsStreamFactory::instance() );
   }
@@ -10,6 +10,7 @@
 
 #include "ossimAwsStreamFactory.h"
 #include "ossimS3IStream.h"
+#include "ossimS3OStream.h"
 #include <ossim/base/ossimFilename.h>
 #include <ossim/base/ossimTrace.h>
 
@@ -64,11 +65,37 @@ std::shared_ptr<ossim::istream> ossim::AwsStreamFactory::createIstream(
 }
       
 std::shared_ptr<ossim::ostream> ossim::AwsStreamFactory::createOstream(
-   const std::string& /*connectionString*/, std::ios_base::openmode /*openMode*/) const
+   const std::string& connectionString, std::ios_base::openmode openMode) const
 {
-   return std::shared_ptr<ossim::ostream>(0);
+   std::shared_ptr<ossim::S3OStream> result = std::make_shared<ossim::S3OStream>();
+   if(traceDebug())
+   {
+     ossimNotify(ossimNotifyLevel_WARN) << "ossim::AwsStreamFactory::createOstream: Entered...............\n";
+   }
+#if defined(_WIN32)
+   ossimFilename f = connectionString;
+   f.convertBackToForwardSlashes();
+   result->open( f.string(), openMode) ;
+#else
+   result->open( connectionString, openMode );
+#endif
+
+  if(!result->good())
+  {
+    result.reset();
+  }
+   if(traceDebug())
+   {
+     ossimNotify(ossimNotifyLevel_WARN) << "ossim::AwsStreamFactory::createOstream: Leaving...............\n";
+   }
+
+  return result;
 }
 
+//---
+// S3 objects cannot be updated in place so read/write streams are not
+// supported.
+//---
 std::shared_ptr<ossim::iostream> ossim::AwsStreamFactory::createIOstream(
    const std::string& /*connectionString*/, std::ios_base::openmode /*openMode*/) const
 {
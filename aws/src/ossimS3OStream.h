@@ -0,0 +1,51 @@
+#ifndef ossimS3OStream_HEADER
+#define ossimS3OStream_HEADER
+#include <ossim/base/ossimIoStream.h>
+#include "ossimS3OStreamBuffer.h"
+
+namespace ossim{
+
+   class S3OStream : public ossim::ostream
+   {
+   public:
+      S3OStream():std::ostream(&m_s3membuf)
+      {}
+
+      virtual ~S3OStream()
+      {
+         close();
+      }
+
+      void open (const char* connectionString,  
+                 std::ios_base::openmode mode)
+      {
+         open(std::string(connectionString), mode);
+      }
+      void open (const std::string& connectionString, 
+                 std::ios_base::openmode mode)
+      {
+        if(m_s3membuf.open(connectionString, mode))
+        {
+            clear();
+        }
+        else
+        {
+            setstate(std::ios::failbit);
+        }
+      }
+
+      /** Completes the upload.  Sets failbit if the object was not written. */
+      void close()
+      {
+        if(m_s3membuf.is_open() && !m_s3membuf.close())
+        {
+            setstate(std::ios::failbit);
+        }
+      }
+   protected:
+     S3OStreamBuffer m_s3membuf;
+
+   };
+}
+
+#endif
@@ -0,0 +1,422 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// OSSIM Amazon Web Services (AWS) S3 output streambuf definition.
+//
+//---
+// $Id$
+
+#include "ossimS3OStreamBuffer.h"
+#include "S3ClientPool.h"
+
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/CompletedMultipartUpload.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
+#include <aws/s3/model/PutObjectRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
+#include <aws/core/Aws.h>
+
+#include <ossim/base/ossimUrl.h>
+#include <ossim/base/ossimTrace.h>
+
+#include <algorithm>
+#include <cstring> /* for memcpy */
+
+using namespace Aws::S3;
+using namespace Aws::S3::Model;
+static ossimTrace traceDebug("ossimS3OStreamBuffer:debug");
+
+static const char* ALLOCATION_TAG = "S3OStreamBuffer";
+
+// S3 requires every part but the last to be at least 5 MiB.
+static const ossim_int64 MIN_PART_SIZE = 5242880;
+
+namespace
+{
+   //---
+   // Seekable read only streambuf over a part.  The SDK seeks the body to
+   // compute the content length and MD5 so a plain get area is not enough.
+   //---
+   class PartStreamBuf : public std::streambuf
+   {
+   public:
+      PartStreamBuf(std::shared_ptr<std::vector<char> > part, ossim_int64 size)
+         :m_part(part)
+      {
+         char* begin = size ? &m_part->front() : 0;
+         setg(begin, begin, begin+size);
+      }
+   protected:
+      virtual pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+                               std::ios_base::openmode mode)
+      {
+         pos_type result = pos_type(off_type(-1));
+         if(mode & std::ios_base::in)
+         {
+            off_type base = 0;
+            if(dir == std::ios_base::cur)
+            {
+               base = gptr()-eback();
+            }
+            else if(dir == std::ios_base::end)
+            {
+               base = egptr()-eback();
+            }
+            off_type pos = base + offset;
+            if((pos >= 0) && (pos <= (egptr()-eback())))
+            {
+               setg(eback(), eback()+pos, egptr());
+               result = pos_type(pos);
+            }
+         }
+         return result;
+      }
+      virtual pos_type seekpos(pos_type pos, std::ios_base::openmode mode)
+      {
+         return seekoff(off_type(pos), std::ios_base::beg, mode);
+      }
+   private:
+      std::shared_ptr<std::vector<char> > m_part;
+   };
+
+   class PartStream : public Aws::IOStream
+   {
+   public:
+      PartStream(std::shared_ptr<std::vector<char> > part, ossim_int64 size)
+         :Aws::IOStream(0),
+          m_buf(part, size)
+      {
+         rdbuf(&m_buf);
+      }
+   private:
+      PartStreamBuf m_buf;
+   };
+}
+
+ossim::S3OStreamBuffer::S3OStreamBuffer(ossim_int64 partSize)
+   :
+   m_client(ossim::S3ClientPool::instance()->getClient()),
+   m_bucket(""),
+   m_key(""),
+   m_partSize(std::max(partSize, MIN_PART_SIZE)),
+   m_part(),
+   m_bytesUploaded(0),
+   m_uploadId(""),
+   m_nextPartNumber(1),
+   m_pending(),
+   m_completedParts(),
+   m_opened(false),
+   m_failed(false)
+{
+   setp(0, 0);
+}
+
+ossim::S3OStreamBuffer::~S3OStreamBuffer()
+{
+   close();
+}
+
+ossim::S3OStreamBuffer* ossim::S3OStreamBuffer::open(const char* connectionString,
+                                                     std::ios_base::openmode m)
+{
+   std::string temp(connectionString);
+   return open(temp, m);
+}
+
+ossim::S3OStreamBuffer* ossim::S3OStreamBuffer::open(const std::string& connectionString,
+                                                     std::ios_base::openmode /* mode */)
+{
+   if(traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossim::S3OStreamBuffer::open DEBUG: entered..... with connection "
+         << connectionString << std::endl;
+   }
+
+   close();
+   clearAll();
+
+   ossimUrl url(connectionString);
+
+   // AWS server is case insensitive:
+   if( (url.getProtocol() == "s3") || (url.getProtocol() == "S3") )
+   {
+      m_bucket = url.getIp().c_str();
+      m_key = url.getPath().c_str();
+      if(!m_bucket.empty() && !m_key.empty())
+      {
+         newPart();
+         m_opened = true;
+      }
+   }
+
+   if(m_opened) return this;
+
+   return 0;
+}
+
+ossim::S3OStreamBuffer* ossim::S3OStreamBuffer::close()
+{
+   if(!m_opened) return 0;
+
+   ossim_int64 partBytes = pptr()-pbase();
+   if(!m_failed)
+   {
+      if(m_uploadId.empty())
+      {
+         // Everything fit in one part so skip the multipart handshake.
+         PutObjectRequest putObjectRequest;
+         putObjectRequest.WithBucket(m_bucket.c_str()).WithKey(m_key.c_str())
+            .WithContentLength(partBytes);
+         putObjectRequest.SetBody(Aws::MakeShared<PartStream>(ALLOCATION_TAG, m_part, partBytes));
+         auto putObjectOutcome = m_client->PutObject(putObjectRequest);
+         if(!putObjectOutcome.IsSuccess())
+         {
+            m_failed = true;
+            if(traceDebug())
+            {
+               ossimNotify(ossimNotifyLevel_DEBUG)
+                  << "ossim::S3OStreamBuffer::close DEBUG: PutObject failed: "
+                  << putObjectOutcome.GetError().GetMessage() << std::endl;
+            }
+         }
+      }
+      else
+      {
+         if(partBytes > 0)
+         {
+            uploadPart();
+         }
+         while(!m_pending.empty())
+         {
+            waitForPart();
+         }
+         if(!m_failed)
+         {
+            CompletedMultipartUpload completedUpload;
+            completedUpload.SetParts(Aws::Vector<CompletedPart>(m_completedParts.begin(),
+                                                                m_completedParts.end()));
+            CompleteMultipartUploadRequest completeRequest;
+            completeRequest.WithBucket(m_bucket.c_str()).WithKey(m_key.c_str())
+               .WithUploadId(m_uploadId.c_str()).WithMultipartUpload(completedUpload);
+            auto completeOutcome = m_client->CompleteMultipartUpload(completeRequest);
+            if(!completeOutcome.IsSuccess())
+            {
+               m_failed = true;
+               if(traceDebug())
+               {
+                  ossimNotify(ossimNotifyLevel_DEBUG)
+                     << "ossim::S3OStreamBuffer::close DEBUG: CompleteMultipartUpload failed: "
+                     << completeOutcome.GetError().GetMessage() << std::endl;
+               }
+            }
+         }
+      }
+   }
+
+   if(m_failed)
+   {
+      abort();
+   }
+
+   bool result = !m_failed;
+   clearAll();
+
+   return result ? this : 0;
+}
+
+ossim::S3OStreamBuffer::int_type ossim::S3OStreamBuffer::overflow(int_type c)
+{
+   if(!m_opened || m_failed)
+   {
+      return traits_type::eof();
+   }
+   if(pptr() == epptr())
+   {
+      if(!uploadPart())
+      {
+         return traits_type::eof();
+      }
+   }
+   if(!traits_type::eq_int_type(c, traits_type::eof()))
+   {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+      return c;
+   }
+   return traits_type::not_eof(c);
+}
+
+std::streamsize ossim::S3OStreamBuffer::xsputn(const char_type* s, std::streamsize n)
+{
+   if(!m_opened || m_failed) return 0;
+
+   std::streamsize bytesWritten = 0;
+   while(bytesWritten < n)
+   {
+      if(pptr() == epptr())
+      {
+         if(!uploadPart())
+         {
+            break;
+         }
+      }
+      std::streamsize delta = std::min(static_cast<std::streamsize>(epptr()-pptr()),
+                                       n-bytesWritten);
+      std::memcpy(pptr(), s+bytesWritten, delta);
+      pbump(static_cast<int>(delta));
+      bytesWritten += delta;
+   }
+
+   return bytesWritten;
+}
+
+ossim::S3OStreamBuffer::pos_type ossim::S3OStreamBuffer::seekoff(off_type offset,
+                                                                 std::ios_base::seekdir dir,
+                                                                 std::ios_base::openmode mode)
+{
+   pos_type result = pos_type(off_type(-1));
+
+   // Data already uploaded cannot be revisited; only report the position.
+   if(m_opened && (mode & std::ios_base::out) && (dir == std::ios_base::cur) && (offset == 0))
+   {
+      result = pos_type(m_bytesUploaded + (pptr()-pbase()));
+   }
+
+   return result;
+}
+
+ossim::S3OStreamBuffer::pos_type ossim::S3OStreamBuffer::seekpos(pos_type pos,
+                                                                 std::ios_base::openmode mode)
+{
+   pos_type result = pos_type(off_type(-1));
+   if(m_opened && (mode & std::ios_base::out) &&
+      (static_cast<ossim_int64>(pos) == m_bytesUploaded + (pptr()-pbase())))
+   {
+      result = pos;
+   }
+   return result;
+}
+
+void ossim::S3OStreamBuffer::newPart()
+{
+   m_part = std::make_shared<std::vector<char> >(m_partSize);
+   setp(&m_part->front(), &m_part->front() + m_part->size());
+}
+
+bool ossim::S3OStreamBuffer::uploadPart()
+{
+   if(m_failed) return false;
+   if(m_uploadId.empty() && !createMultipartUpload())
+   {
+      m_failed = true;
+      return false;
+   }
+
+   // Bound memory: part size times number of parts in flight.
+   while(static_cast<ossim_int64>(m_pending.size()) >=
+         std::max(ossim::S3StreamDefaults::m_writeThreads, static_cast<ossim_int64>(1)))
+   {
+      if(!waitForPart())
+      {
+         return false;
+      }
+   }
+
+   ossim_int64 partBytes = pptr()-pbase();
+   UploadPartRequest uploadPartRequest;
+   uploadPartRequest.WithBucket(m_bucket.c_str()).WithKey(m_key.c_str())
+      .WithUploadId(m_uploadId.c_str()).WithPartNumber(m_nextPartNumber)
+      .WithContentLength(partBytes);
+   uploadPartRequest.SetBody(Aws::MakeShared<PartStream>(ALLOCATION_TAG, m_part, partBytes));
+   m_pending.push_back(std::make_pair(m_nextPartNumber,
+                                      m_client->UploadPartCallable(uploadPartRequest)));
+   ++m_nextPartNumber;
+   m_bytesUploaded += partBytes;
+
+   // The request body holds the old part; start filling a new one.
+   newPart();
+
+   return true;
+}
+
+bool ossim::S3OStreamBuffer::waitForPart()
+{
+   if(m_pending.empty()) return !m_failed;
+
+   PendingPart_t pending = std::move(m_pending.front());
+   m_pending.pop_front();
+   UploadPartOutcome outcome = pending.second.get();
+   if(outcome.IsSuccess())
+   {
+      m_completedParts.push_back(CompletedPart().WithPartNumber(pending.first)
+                                 .WithETag(outcome.GetResult().GetETag()));
+   }
+   else
+   {
+      m_failed = true;
+      if(traceDebug())
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossim::S3OStreamBuffer::waitForPart DEBUG: part " << pending.first
+            << " failed: " << outcome.GetError().GetMessage() << std::endl;
+      }
+   }
+
+   return !m_failed;
+}
+
+bool ossim::S3OStreamBuffer::createMultipartUpload()
+{
+   CreateMultipartUploadRequest createRequest;
+   createRequest.WithBucket(m_bucket.c_str()).WithKey(m_key.c_str());
+   auto createOutcome = m_client->CreateMultipartUpload(createRequest);
+   if(createOutcome.IsSuccess())
+   {
+      m_uploadId = createOutcome.GetResult().GetUploadId().c_str();
+   }
+   else if(traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossim::S3OStreamBuffer::createMultipartUpload DEBUG: failed: "
+         << createOutcome.GetError().GetMessage() << std::endl;
+   }
+
+   return !m_uploadId.empty();
+}
+
+void ossim::S3OStreamBuffer::abort()
+{
+   // Drain so no part lands after the abort.
+   while(!m_pending.empty())
+   {
+      m_pending.front().second.wait();
+      m_pending.pop_front();
+   }
+   if(!m_uploadId.empty())
+   {
+      AbortMultipartUploadRequest abortRequest;
+      abortRequest.WithBucket(m_bucket.c_str()).WithKey(m_key.c_str())
+         .WithUploadId(m_uploadId.c_str());
+      m_client->AbortMultipartUpload(abortRequest);
+   }
+}
+
+void ossim::S3OStreamBuffer::clearAll()
+{
+   m_bucket = "";
+   m_key = "";
+   m_part.reset();
+   setp(0, 0);
+   m_bytesUploaded = 0;
+   m_uploadId = "";
+   m_nextPartNumber = 1;
+   m_pending.clear();
+   m_completedParts.clear();
+   m_opened = false;
+   m_failed = false;
+}
@@ -0,0 +1,94 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// OSSIM Amazon Web Services (AWS) S3 output streambuf declaration.
+//
+// Data is buffered into parts that are uploaded with concurrent multipart
+// UploadPart calls.  Memory use is bounded by part size times the number of
+// parts in flight.  Objects smaller than one part are written with a single
+// PutObject on close.  The stream is sequential; only tellp style seeks
+// (zero offset from current) are supported.
+//
+//---
+// $Id$
+
+#ifndef ossimS3OStreamBuffer_HEADER
+#define ossimS3OStreamBuffer_HEADER 1
+
+#include <ossim/base/ossimConstants.h>
+#include <aws/s3/S3Client.h>
+#include <aws/s3/model/CompletedPart.h>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "S3StreamDefaults.h"
+
+namespace ossim{
+class S3OStreamBuffer : public std::streambuf
+{
+public:
+   S3OStreamBuffer(ossim_int64 partSize=ossim::S3StreamDefaults::m_writePartSize);
+
+   virtual ~S3OStreamBuffer();
+
+   S3OStreamBuffer* open (const char* connectionString,  std::ios_base::openmode mode);
+   S3OStreamBuffer* open (const std::string& connectionString, std::ios_base::openmode mode);
+
+   /**
+    * @brief Uploads any remaining data and completes the object.
+    * @return this on success, 0 on failure.
+    */
+   S3OStreamBuffer* close();
+
+   bool is_open() const
+   {
+      return m_opened;
+   }
+
+protected:
+   typedef std::shared_ptr<std::vector<char> > Part_t;
+   typedef std::pair<int, Aws::S3::Model::UploadPartOutcomeCallable> PendingPart_t;
+
+   virtual int_type overflow(int_type c = traits_type::eof());
+   virtual std::streamsize xsputn(const char_type* s, std::streamsize n);
+   virtual pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+                            std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out);
+   virtual pos_type seekpos(pos_type pos,
+                            std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out);
+
+   /** Starts a new empty part and points the put area at it. */
+   void newPart();
+
+   /** Queues the current part for upload.  Blocks while too many are in flight. */
+   bool uploadPart();
+
+   /** Waits for the oldest in flight part. */
+   bool waitForPart();
+
+   bool createMultipartUpload();
+   void abort();
+   void clearAll();
+
+   std::shared_ptr<Aws::S3::S3Client> m_client;
+   std::string m_bucket;
+   std::string m_key;
+   ossim_int64 m_partSize;
+   Part_t m_part;
+   ossim_int64 m_bytesUploaded;
+   std::string m_uploadId;
+   int m_nextPartNumber;
+   std::deque<PendingPart_t> m_pending;
+   std::vector<Aws::S3::Model::CompletedPart> m_completedParts;
+   bool m_opened;
+   bool m_failed;
+};
+
+}
+
+#endif
@@ -13,6 +13,8 @@
 
 #include "ossimS3StreamBuffer.h"
 #include "S3HeaderCache.h"
+#include "S3ClientPool.h"
+#include "S3DiskCache.h"
 
 #include <aws/s3/model/PutObjectRequest.h>
 #include <aws/s3/model/GetObjectRequest.h>
@@ -20,6 +22,8 @@
 #include <aws/s3/model/HeadObjectRequest.h>
 #include <aws/core/Aws.h>
 #include <aws/core/http/HttpRequest.h>
+#include <aws/core/http/HttpResponse.h>
+#include <aws/core/utils/DateTime.h>
 #include <aws/core/utils/memory/stl/AWSStringStream.h>
 
 #include <ossim/base/ossimUrl.h>
@@ -29,6 +33,8 @@
 
 #include <cstdio> /* for EOF */
 #include <cstring> /* for memcpy */
+#include <algorithm>
+#include <future>
 #include <ios>
 #include <iostream>
 #include <streambuf>
@@ -44,9 +50,15 @@ static ossimTrace traceDebug("ossimS3StreamBuffer:debug");
 
 ossim::S3StreamBuffer::S3StreamBuffer(ossim_int64 blockSize)
    :
+   m_client(ossim::S3ClientPool::instance()->getClient()),
    m_bucket(""),
    m_key(""),
-   m_buffer(blockSize),
+   m_cacheId(""),
+   m_useDiskCache(false),
+   m_blockSize(blockSize),
+   m_block(),
+   m_lastBlockIndex(-1),
+   m_positionMarker(0),
    m_bufferActualDataSize(0),
    m_currentBlockPosition(-1),
    m_bufferPtr(0),
@@ -65,9 +77,9 @@ ossim_int64 ossim::S3StreamBuffer::getBlockIndex(ossim_int64 byteOffset)const
   
    if(byteOffset < (ossim_int64)m_fileSize)
    {
-      if(m_buffer.size()>0)
+      if(m_blockSize>0)
       {
-         blockNumber = byteOffset/m_buffer.size();
+         blockNumber = byteOffset/m_blockSize;
       }    
    }
 
@@ -78,9 +90,9 @@ ossim_int64 ossim::S3StreamBuffer::getBlockOffset(ossim_int64 byteOffset)const
 {
    ossim_int64 blockOffset = -1;
   
-   if(m_buffer.size()>0)
+   if(m_blockSize>0)
    {
-      blockOffset = byteOffset%m_buffer.size();
+      blockOffset = byteOffset%m_blockSize;
    }    
 
    return blockOffset;
@@ -94,8 +106,8 @@ bool ossim::S3StreamBuffer::getBlockRangeInBytes(ossim_int64 blockIndex,
 
    if(blockIndex >= 0)
    {
-      startRange = blockIndex*m_buffer.size();
-      endRange = startRange + m_buffer.size()-1;
+      startRange = blockIndex*m_blockSize;
+      endRange = startRange + m_blockSize-1;
 
       result = true;    
    }
@@ -103,42 +115,129 @@ bool ossim::S3StreamBuffer::getBlockRangeInBytes(ossim_int64 blockIndex,
    return result;
 }
 
+//---
+// Fetches bytes [startRange, endRange] of an object.  Shared by the foreground
+// reader and the read-ahead threads so must not touch stream state.
+//---
+static ossim::S3BlockCache::Block_t getObjectRange(const Aws::S3::S3Client& client,
+                                                   const std::string& bucket,
+                                                   const std::string& key,
+                                                   ossim_int64 startRange,
+                                                   ossim_int64 endRange)
+{
+   ossim::S3BlockCache::Block_t result;
+   GetObjectRequest getObjectRequest;
+   std::stringstream stringStream;
+   stringStream << "bytes=" << startRange << "-" << endRange;
+   getObjectRequest.WithBucket(bucket.c_str())
+      .WithKey(key.c_str()).WithRange(stringStream.str().c_str());
+   auto getObjectOutcome = client.GetObject(getObjectRequest);
+
+   if(getObjectOutcome.IsSuccess())
+   {
+      Aws::IOStream& bodyStream = getObjectOutcome.GetResult().GetBody();
+      ossim_int64 bufSize = getObjectOutcome.GetResult().GetContentLength();
+      std::shared_ptr<ossim::S3MemoryBlock> block = std::make_shared<ossim::S3MemoryBlock>(bufSize);
+      if(bufSize > 0)
+      {
+         bodyStream.read(block->buffer(), bufSize);
+      }
+      result = block;
+   }
+
+   return result;
+}
+
+//---
+// Gets a block from the persistent disk cache, else from S3 storing it on
+// disk.  Disk blocks are keyed by the cache id which includes the ETag so
+// nothing is stored for objects without one.
+//---
+static ossim::S3BlockCache::Block_t getRemoteBlock(const Aws::S3::S3Client& client,
+                                                   const std::string& bucket,
+                                                   const std::string& key,
+                                                   const std::string& cacheId,
+                                                   bool useDiskCache,
+                                                   ossim_int64 blockIndex,
+                                                   ossim_int64 startRange,
+                                                   ossim_int64 endRange)
+{
+   ossim::S3BlockCache::Block_t result;
+   std::shared_ptr<ossim::S3DiskCache> diskCache;
+   if(useDiskCache)
+   {
+      diskCache = ossim::S3DiskCache::instance();
+      if(diskCache->isEnabled())
+      {
+         result = diskCache->getBlock(cacheId, blockIndex);
+      }
+      else
+      {
+         diskCache.reset();
+      }
+   }
+   if(!result)
+   {
+      result = getObjectRange(client, bucket, key, startRange, endRange);
+      if(result && diskCache)
+      {
+         diskCache->addBlock(cacheId, blockIndex, result);
+      }
+   }
+   return result;
+}
+
 bool ossim::S3StreamBuffer::loadBlock(ossim_int64 absolutePosition)
 {
    bool result = false;
    m_bufferPtr = 0;
-   GetObjectRequest getObjectRequest;
-   std::stringstream stringStream;
    ossim_int64 startRange, endRange;
    ossim_int64 blockIndex = getBlockIndex(absolutePosition);
    if((absolutePosition < 0) || (absolutePosition > (ossim_int64)m_fileSize)) return false;
    //std::cout << "CURRENT BYTE LOCATION = " << absoluteLocation << std::endl;
    if(getBlockRangeInBytes(blockIndex, startRange, endRange))
    {
-      stringStream << "bytes=" << startRange << "-" << endRange;
-      getObjectRequest.WithBucket(m_bucket.c_str())
-         .WithKey(m_key.c_str()).WithRange(stringStream.str().c_str());
-      auto getObjectOutcome = m_client.GetObject(getObjectRequest);
+      ossim::S3BlockCache::Key_t cacheKey(m_cacheId, blockIndex);
+      ossim::S3BlockCache::Block_t block = ossim::S3BlockCache::instance()->getBlock(cacheKey);
+      if(!block)
+      {
+         ossim_int64 lastByte = std::min(endRange, m_fileSize-1);
+         if(m_headerBytes && (lastByte < (ossim_int64)m_headerBytes->size()))
+         {
+            // Opening already fetched these bytes.
+            std::shared_ptr<ossim::S3MemoryBlock> headerBlock =
+               std::make_shared<ossim::S3MemoryBlock>(lastByte-startRange+1);
+            std::memcpy(headerBlock->buffer(), &m_headerBytes->front()+startRange,
+                        headerBlock->size());
+            block = headerBlock;
+         }
+         else
+         {
+            block = getRemoteBlock(*m_client, m_bucket, m_key, m_cacheId, m_useDiskCache,
+                                   blockIndex, startRange, endRange);
+         }
+         ossim::S3BlockCache::instance()->addBlock(cacheKey, block);
+      }
 
-      if(getObjectOutcome.IsSuccess())
+      if(block && (block->size() > 0))
       {
-//        std::cout << "GOOD CALL!!!!!!!!!!!!\n";
-         Aws::IOStream& bodyStream = getObjectOutcome.GetResult().GetBody();
-         ossim_int64 bufSize = getObjectOutcome.GetResult().GetContentLength();
-//        std::cout << "SIZE OF RESULT ======== " << bufSize << std::endl;
-         m_bufferActualDataSize = bufSize;
-         bodyStream.read(&m_buffer.front(), bufSize);
-         m_bufferPtr = &m_buffer.front();
+         // Hold a reference so eviction from the shared cache cannot free
+         // the get area out from under us.
+         m_block = block;
+         m_bufferActualDataSize = m_block->size();
+         // Get area is never written so the const cast is safe.
+         m_bufferPtr = const_cast<char*>(m_block->data());
 
          ossim_int64 delta = absolutePosition-startRange;
          setg(m_bufferPtr, m_bufferPtr + delta, m_bufferPtr+m_bufferActualDataSize);
          m_currentBlockPosition = startRange;
          result = true;
-         //std::cout << "Successfully retrieved object from s3 with value: " << std::endl;
-         //std::cout << getObjectOutcome.GetResult().GetBody().rdbuf() << std::endl << std::endl;;  
+
+         readAhead(blockIndex);
       }
       else
       {
+         m_block.reset();
          m_bufferActualDataSize = 0;
       }
    }
@@ -146,6 +245,198 @@ bool ossim::S3StreamBuffer::loadBlock(ossim_int64 absolutePosition)
    return result;
 }
 
+void ossim::S3StreamBuffer::readAhead(ossim_int64 blockIndex)
+{
+   bool sequential = (m_lastBlockIndex >= 0) && (blockIndex == m_lastBlockIndex + 1);
+   m_lastBlockIndex = blockIndex;
+
+   if(!sequential || (ossim::S3StreamDefaults::m_readAheadBlocks <= 0)) return;
+
+   std::shared_ptr<ossim::S3BlockCache> cache = ossim::S3BlockCache::instance();
+   for(ossim_int64 idx = 1; idx <= ossim::S3StreamDefaults::m_readAheadBlocks; ++idx)
+   {
+      ossim_int64 nextBlock = blockIndex + idx;
+      ossim_int64 startRange, endRange;
+      if(!getBlockRangeInBytes(nextBlock, startRange, endRange) ||
+         (startRange >= m_fileSize))
+      {
+         break;
+      }
+      std::shared_ptr<Aws::S3::S3Client> client = m_client;
+      std::string bucket = m_bucket;
+      std::string key = m_key;
+      std::string cacheId = m_cacheId;
+      bool useDiskCache = m_useDiskCache;
+      cache->readAhead(ossim::S3BlockCache::Key_t(m_cacheId, nextBlock),
+                       [client, bucket, key, cacheId, useDiskCache, nextBlock, startRange, endRange]()
+                       {
+                          return getRemoteBlock(*client, bucket, key, cacheId, useDiskCache,
+                                                nextBlock, startRange, endRange);
+                       });
+   }
+}
+
+//---
+// Gets size, ETag, Last-Modified and the first headerCacheBytes of an object.
+// A ranged GET returns all of these in one round trip; HEAD is the fallback
+// for objects the range cannot be satisfied on (e.g. empty objects).
+// Returns a not found node on 404 and null on any other failure so transient
+// errors are not cached.
+//---
+static ossim::S3HeaderCache::Node_t fetchHeader(const Aws::S3::S3Client& client,
+                                                const std::string& bucket,
+                                                const std::string& key)
+{
+   ossim::S3HeaderCache::Node_t result;
+   if(ossim::S3StreamDefaults::m_headerCacheBytes > 0)
+   {
+      GetObjectRequest getObjectRequest;
+      std::stringstream range;
+      range << "bytes=0-" << (ossim::S3StreamDefaults::m_headerCacheBytes-1);
+      getObjectRequest.WithBucket(bucket.c_str())
+         .WithKey(key.c_str()).WithRange(range.str().c_str());
+      auto getObjectOutcome = client.GetObject(getObjectRequest);
+      if(getObjectOutcome.IsSuccess())
+      {
+         // Content-Range: bytes 0-65535/123456
+         std::string contentRange = getObjectOutcome.GetResult().GetContentRange().c_str();
+         std::string::size_type slash = contentRange.rfind('/');
+         if((slash != std::string::npos) && (contentRange.substr(slash+1) != "*"))
+         {
+            ossim_int64 bufSize = getObjectOutcome.GetResult().GetContentLength();
+            std::shared_ptr<std::vector<char> > bytes = std::make_shared<std::vector<char> >(bufSize);
+            if(bufSize > 0)
+            {
+               getObjectOutcome.GetResult().GetBody().read(&bytes->front(), bufSize);
+            }
+            result = std::make_shared<ossim::S3HeaderCacheNode>(
+               ossimString(contentRange.substr(slash+1)).toInt64());
+            result->m_etag = getObjectOutcome.GetResult().GetETag().c_str();
+            result->m_lastModified = getObjectOutcome.GetResult().GetLastModified()
+               .ToGmtString(Aws::Utils::DateFormat::RFC822).c_str();
+            result->m_headerBytes = bytes;
+            return result;
+         }
+      }
+      else if(getObjectOutcome.GetError().GetResponseCode() ==
+              Aws::Http::HttpResponseCode::NOT_FOUND)
+      {
+         return ossim::S3HeaderCacheNode::notFound();
+      }
+   }
+
+   HeadObjectRequest headObjectRequest;
+   headObjectRequest.WithBucket(bucket.c_str())
+      .WithKey(key.c_str());
+   auto headObject = client.HeadObject(headObjectRequest);
+   if(headObject.IsSuccess())
+   {
+      result = std::make_shared<ossim::S3HeaderCacheNode>(headObject.GetResult().GetContentLength());
+      result->m_etag = headObject.GetResult().GetETag().c_str();
+      result->m_lastModified = headObject.GetResult().GetLastModified()
+         .ToGmtString(Aws::Utils::DateFormat::RFC822).c_str();
+   }
+   else if(headObject.GetError().GetResponseCode() ==
+           Aws::Http::HttpResponseCode::NOT_FOUND)
+   {
+      result = ossim::S3HeaderCacheNode::notFound();
+   }
+
+   return result;
+}
+
+namespace
+{
+   //---
+   // Write only streambuf over caller memory so a GetObject body is
+   // deserialized straight into the destination.
+   //---
+   class DirectReadBuf : public std::streambuf
+   {
+   public:
+      DirectReadBuf(char* buf, ossim_int64 size)
+      {
+         setp(buf, buf+size);
+      }
+      ossim_int64 bytesWritten()const
+      {
+         return pptr()-pbase();
+      }
+   };
+}
+
+bool ossim::S3StreamBuffer::directRead(char* buf,
+                                       ossim_int64 absolutePosition,
+                                       ossim_int64 size)
+{
+   if((size <= 0) || (absolutePosition < 0) ||
+      ((absolutePosition + size) > (ossim_int64)m_fileSize))
+   {
+      return false;
+   }
+
+   ossim_int64 nParts = ossim::S3StreamDefaults::m_directReadParts;
+   if(nParts < 1) nParts = 1;
+   ossim_int64 partSize = (size + nParts - 1)/nParts;
+   if(partSize < m_blockSize)
+   {
+      partSize = m_blockSize;
+   }
+
+   std::vector<std::shared_ptr<DirectReadBuf> > partBufs;
+   std::vector<std::future<GetObjectOutcome> > outcomes;
+   std::vector<ossim_int64> partSizes;
+   for(ossim_int64 offset = 0; offset < size; offset += partSize)
+   {
+      ossim_int64 bytes = std::min(partSize, size - offset);
+      std::shared_ptr<DirectReadBuf> partBuf = std::make_shared<DirectReadBuf>(buf + offset, bytes);
+      std::stringstream range;
+      range << "bytes=" << (absolutePosition + offset) << "-"
+            << (absolutePosition + offset + bytes - 1);
+      GetObjectRequest getObjectRequest;
+      getObjectRequest.WithBucket(m_bucket.c_str())
+         .WithKey(m_key.c_str()).WithRange(range.str().c_str());
+      DirectReadBuf* rawBuf = partBuf.get();
+      getObjectRequest.SetResponseStreamFactory(
+         [rawBuf]() { return Aws::New<Aws::IOStream>("S3StreamBuffer", rawBuf); });
+      outcomes.push_back(m_client->GetObjectCallable(getObjectRequest));
+      partBufs.push_back(partBuf);
+      partSizes.push_back(bytes);
+   }
+
+   // Wait for every part before returning; the buffers reference caller memory.
+   bool result = true;
+   for(std::size_t idx = 0; idx < outcomes.size(); ++idx)
+   {
+      GetObjectOutcome outcome = outcomes[idx].get();
+      if(!outcome.IsSuccess() ||
+         (outcome.GetResult().GetContentLength() != partSizes[idx]) ||
+         (partBufs[idx]->bytesWritten() != partSizes[idx]))
+      {
+         result = false;
+      }
+   }
+
+   if(traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossim::S3StreamBuffer::directRead DEBUG: " << size << " bytes at "
+         << absolutePosition << " in " << outcomes.size() << " part(s), "
+         << (result ? "succeeded" : "failed") << std::endl;
+   }
+
+   return result;
+}
+
+void ossim::S3StreamBuffer::setPosition(ossim_int64 absolutePosition)
+{
+   m_block.reset();
+   m_bufferActualDataSize = 0;
+   m_bufferPtr = &m_positionMarker;
+   m_currentBlockPosition = absolutePosition;
+   setg(m_bufferPtr, m_bufferPtr, m_bufferPtr);
+}
+
 ossim::S3StreamBuffer* ossim::S3StreamBuffer::open (const char* connectionString,  
                                                     std::ios_base::openmode m)
 {
@@ -167,43 +458,46 @@ ossim::S3StreamBuffer* ossim::S3StreamBuffer::open (const std::string& connectio
    // m_mode = mode;
    ossimTimer::Timer_t startTimer = ossimTimer::instance()->tick();
 
+   bool cachedHeader = false;
+
    // AWS server is case insensitive:
    if( (url.getProtocol() == "s3") || (url.getProtocol() == "S3") )
    {
-      ossim_int64 filesize;
       m_bucket = url.getIp().c_str();
       m_key = url.getPath().c_str();
-      if(ossim::S3HeaderCache::instance()->getCachedFilesize(connectionString, filesize))
+      ossim::S3HeaderCache::Node_t node = ossim::S3HeaderCache::instance()->getNode(connectionString);
+      if(node)
       {
-         m_fileSize = filesize;
-         m_opened = true;
-         m_currentBlockPosition = 0;
+         cachedHeader = true;
       }
-      else
+      else if(!m_bucket.empty() && !m_key.empty())
       {
-         if(!m_bucket.empty() && !m_key.empty())
+         node = fetchHeader(*m_client, m_bucket, m_key);
+         if(node)
          {
-            HeadObjectRequest headObjectRequest;
-            headObjectRequest.WithBucket(m_bucket.c_str())
-               .WithKey(m_key.c_str());
-            auto headObject = m_client.HeadObject(headObjectRequest);
-            if(headObject.IsSuccess())
-            {
-               m_fileSize = headObject.GetResult().GetContentLength();
-               m_opened = true;
-               m_currentBlockPosition = 0;
-               ossim::S3HeaderCache::Node_t nodePtr = std::make_shared<ossim::S3HeaderCacheNode>(m_fileSize);
-               ossim::S3HeaderCache::instance()->addHeader(connectionString, nodePtr);
-            }
+            ossim::S3HeaderCache::instance()->addHeader(connectionString, node);
          }
       }
+      if(node && node->m_exists)
+      {
+         m_fileSize = node->m_filesize;
+         m_headerBytes = node->m_headerBytes;
+         m_opened = true;
+         m_currentBlockPosition = 0;
+
+         // ETag keeps blocks of a replaced object from being served.
+         std::ostringstream cacheId;
+         cacheId << m_bucket << "/" << m_key << "#" << m_blockSize << "@" << node->m_etag;
+         m_cacheId = cacheId.str();
+         m_useDiskCache = !node->m_etag.empty();
+      }
    }
   ossimTimer::Timer_t endTimer = ossimTimer::instance()->tick();
+   ossim_float64 delta = ossimTimer::instance()->delta_s(startTimer, endTimer);
+   ossim::S3ClientPool::instance()->recordOpen(delta, cachedHeader, m_opened);
 
    if(traceDebug())
    {
-      ossim_float64 delta = ossimTimer::instance()->delta_s(startTimer, endTimer);
-
       ossimNotify(ossimNotifyLevel_DEBUG)
          << "ossim::S3StreamBuffer::open DEBUG: Took " << delta << " seconds to open" << std::endl;
       ossimNotify(ossimNotifyLevel_DEBUG)
@@ -221,6 +515,13 @@ void ossim::S3StreamBuffer::clearAll()
 {
    m_bucket = "";
    m_key    = "";
+   m_cacheId = "";
+   m_useDiskCache = false;
+   m_headerBytes.reset();
+   m_bufferPtr = 0;
+   setg(m_bufferPtr, m_bufferPtr, m_bufferPtr);
+   m_block.reset();
+   m_lastBlockIndex = -1;
    m_fileSize = 0;
    m_opened = false;
    m_currentBlockPosition = 0;
@@ -282,10 +583,11 @@ ossim::S3StreamBuffer::pos_type ossim::S3StreamBuffer::seekoff(off_type offset,
          //
          if(!gptr())
          {
-            if(!loadBlock(offset))
+            if((offset < 0) || (offset > (ossim_int64)m_fileSize))
             {
                return result;
             }
+            setPosition(offset);
          }
          if((offset <= (ossim_int64)m_fileSize)&&
             (offset >=0))
@@ -313,11 +615,7 @@ ossim::S3StreamBuffer::pos_type ossim::S3StreamBuffer::seekoff(off_type offset,
       {
          if(!gptr())
          {
-            // std::cout << "LOADING BLOCK!!!!!!!!!!!!!!\n" << std::endl;
-            if(!loadBlock(0))
-            {
-               return result;
-            }
+            setPosition(0);
          }
          result = getAbsoluteByteOffset();
          // std::cout << "INITIAL ABSOLUTE BYTE OFFSET ==== " << result << "\n";
@@ -341,20 +639,11 @@ ossim::S3StreamBuffer::pos_type ossim::S3StreamBuffer::seekoff(off_type offset,
          ossim_int64 absolutePosition  = m_fileSize + offset;
          if(!gptr())
          {
-            // if(absolutePosition==m_fileSize)
-            // {
-            //    if(!loadBlock(absolutePosition))
-            //    {
-            //       return result;
-            //    }
-            // }
-            // else
-            // {
-               if(!loadBlock(absolutePosition))
-               {
-                  return result;
-               }               
-//            }
+            if((absolutePosition < 0) || (absolutePosition > (ossim_int64)m_fileSize))
+            {
+               return result;
+            }
+            setPosition(absolutePosition);
          }
          ossim_int64 currentAbsolutePosition = getAbsoluteByteOffset();
          ossim_int64 delta = absolutePosition-currentAbsolutePosition;
@@ -385,13 +674,13 @@ ossim::S3StreamBuffer::pos_type ossim::S3StreamBuffer::seekpos(pos_type pos, std
    // std::cout << "ossim::S3StreamBuffer::seekpos: " << pos << std::endl;
    pos_type result = pos_type(off_type(-1));
    ossim_int64 tempPos = static_cast<ossim_int64>(pos);
-   // Currently we must initialize to a block
    if(!gptr())
    {
-      if(!loadBlock(tempPos))
+      if((tempPos < 0) || (tempPos > (ossim_int64)m_fileSize))
       {
          return result;
       }
+      setPosition(tempPos);
    }
    ossim_int64 absoluteLocation = getAbsoluteByteOffset();
    if(mode & std::ios_base::in)
@@ -415,28 +704,14 @@ std::streamsize ossim::S3StreamBuffer::xsgetn(char_type* s, std::streamsize n)
   // std::cout << "ossim::S3StreamBuffer::xsgetn" << std::endl;
 
    if(!is_open()) return EOF;
-   // unsigned long int bytesLeftToRead = egptr()-gptr();
-   // initialize if we need to to load the block at current position
-   if((!withinWindow())&&is_open())
+   if(!gptr())
    {
-      if(!gptr())
-      {
-         if(!loadBlock(0))
-         {
-            return EOF;
-         }
-      }
-      else if(!loadBlock(getAbsoluteByteOffset()))
-      {
-         return EOF;
-      }
+      setPosition(0);
    }
    ossim_int64 bytesNeedToRead = n;
-   // ossim_int64 bytesToRead = 0;
    ossim_int64 bytesRead = 0;
    ossim_int64 currentAbsolutePosition = getAbsoluteByteOffset();
-   // ossim_int64 startOffset, endOffset;
-   if(currentAbsolutePosition >= (ossim_int64)m_fileSize)
+   if((currentAbsolutePosition < 0) || (currentAbsolutePosition >= (ossim_int64)m_fileSize))
    {
       return EOF;
    }
@@ -450,45 +725,36 @@ std::streamsize ossim::S3StreamBuffer::xsgetn(char_type* s, std::streamsize n)
       currentAbsolutePosition = getAbsoluteByteOffset();
       if(!withinWindow())
       {
-         if(!loadBlock(currentAbsolutePosition))
-         {
-            return bytesRead;
-         }
-         currentAbsolutePosition = getAbsoluteByteOffset();
-      }
-
-      // get each bloc  
-      if(currentAbsolutePosition>=0)
-      {
-         //getBlockRangeInBytes(getBlockIndex(m_currentBlockPosition), startOffset, endOffset);      
-    
-         ossim_int64 delta = (egptr()-gptr());//(endOffset - m_currentBlockPosition)+1;
-
-         if(delta <= bytesNeedToRead)
+         //---
+         // Large remainder goes straight from S3 into the caller's buffer
+         // leaving the block window alone.
+         //---
+         if((ossim::S3StreamDefaults::m_directReadThreshold > 0) &&
+            (bytesNeedToRead >= ossim::S3StreamDefaults::m_directReadThreshold))
          {
-            std::memcpy(s+bytesRead, gptr(), delta);
-            //m_currentBlockPosition += delta;
-            //setg(eback(), egptr(), egptr());
-            bytesRead+=delta;
-            bytesNeedToRead-=delta;
-            //gbump(delta);
-            setg(eback(), gptr()+delta, egptr());
-
+            if(directRead(s+bytesRead, currentAbsolutePosition, bytesNeedToRead))
+            {
+               bytesRead += bytesNeedToRead;
+               setPosition(currentAbsolutePosition + bytesNeedToRead);
+               bytesNeedToRead = 0;
+               break;
+            }
          }
-         else
+         if(!loadBlock(currentAbsolutePosition))
          {
-            std::memcpy(s+bytesRead, gptr(), bytesNeedToRead);
-            setg(eback(), gptr()+bytesNeedToRead, egptr());
-            //gbump(bytesNeedToRead);
-//            std::cout << "gbump 2 DELTA ========= " << bytesNeedToRead << std::endl;
-            bytesRead+=bytesNeedToRead;
-            bytesNeedToRead=0;
+            return bytesRead ? std::streamsize(bytesRead) : std::streamsize(EOF);
          }
       }
-      else
+
+      ossim_int64 delta = (egptr()-gptr());
+      if(delta > bytesNeedToRead)
       {
-         break;
+         delta = bytesNeedToRead;
       }
+      std::memcpy(s+bytesRead, gptr(), delta);
+      setg(eback(), gptr()+delta, egptr());
+      bytesRead+=delta;
+      bytesNeedToRead-=delta;
    }
    return std::streamsize(bytesRead);
 }
@@ -523,5 +789,5 @@ ossim_uint64 ossim::S3StreamBuffer::getFileSize() const
 
 ossim_uint64 ossim::S3StreamBuffer::getBlockSize() const
 {
-   return m_buffer.size();
+   return m_blockSize;
 }
@@ -17,7 +17,9 @@
 #include <ossim/base/ossimConstants.h>
 #include <aws/s3/S3Client.h>
 #include <iostream>
+#include <memory>
 #include "S3StreamDefaults.h"
+#include "S3BlockCache.h"
 
 namespace ossim{
 class  S3StreamBuffer : public std::streambuf
@@ -66,15 +68,48 @@ protected:
                              ossim_int64& endRange)const;
    
    bool loadBlock(ossim_int64 absolutePosition);
+
+   /**
+    * @brief Queues background fetches of the blocks following blockIndex
+    * when the last two block loads were sequential.
+    */
+   void readAhead(ossim_int64 blockIndex);
    
+   /**
+    * @brief Reads size bytes at absolutePosition directly into buf with one
+    * or more parallel ranged GETs, bypassing the block buffer.
+    * @return true if every byte was read.
+    */
+   bool directRead(char* buf, ossim_int64 absolutePosition, ossim_int64 size);
+
+   /**
+    * @brief Sets the stream position without loading a block.  The get area
+    * is left empty so the next read loads (or directly reads) from there.
+    */
+   void setPosition(ossim_int64 absolutePosition);
+
    //void adjustForSeekgPosition(ossim_int64 seekPosition);
    ossim_int64 getAbsoluteByteOffset()const;
    bool withinWindow()const;
 
-   Aws::S3::S3Client m_client;
+   std::shared_ptr<Aws::S3::S3Client> m_client;
    std::string m_bucket;
    std::string m_key;
-   std::vector<char> m_buffer;
+
+   /** Id of the object in the shared block cache. */
+   std::string m_cacheId;
+
+   /** true if blocks may go to the persistent disk cache (object has an ETag). */
+   bool m_useDiskCache;
+   ossim_int64 m_blockSize;
+   ossim::S3BlockCache::Block_t m_block;
+
+   /** First bytes of the object from the header cache, possibly null. */
+   std::shared_ptr<const std::vector<char> > m_headerBytes;
+   ossim_int64 m_lastBlockIndex;
+
+   /** Valid address for an empty get area when no block is loaded. */
+   char m_positionMarker;
    ossim_int64 m_bufferActualDataSize;
    ossim_int64 m_currentBlockPosition;
    char* m_bufferPtr;
@@ -26,6 +26,7 @@ using namespace std;
 #include <ossim/base/ossimKeywordNames.h>
 #include <ossim/base/ossimTrace.h>
 #include <ossim/base/ossimNotifyContext.h>
+#include <ossim/base/ossimPreferences.h>
 #include <ossim/base/ossimFilename.h>
 #include <ossim/base/ossimGeoPolygon.h>
 #include <ossim/base/ossimUnitConversionTool.h>
@@ -41,6 +42,8 @@ RTTI_DEF2(ossimEsriShapeFileFilter,
 
 static const ossimTrace traceDebug("ossimEsriShapeFileFilter:debug");
 
+static const char CACHE_SIZE_KW[] = "ossim.plugins.gdal.shapefile.cacheSize";
+
 ossimEsriShapeFileFilter::ossimEsriShapeFileFilter(ossimImageSource* inputSource)
    :ossimAnnotationSource(inputSource),
     ossimViewInterface(),
@@ -54,9 +57,15 @@ ossimEsriShapeFileFilter::ossimEsriShapeFileFilter(ossimImageSource* inputSource
     theThickness(1),
     thePointWidthHeight(1, 1),
     theBorderSize(0.0),
-    theBorderSizeUnits(OSSIM_DEGREES)
+    theBorderSizeUnits(OSSIM_DEGREES),
+    theMaxCachedShapes(50000)
 {
    ossimViewInterface::theObject = this;
+   const char* lookup = ossimPreferences::instance()->findPreference(CACHE_SIZE_KW);
+   if(lookup)
+   {
+      theMaxCachedShapes = ossimString(lookup).toUInt32();
+   }
    ossimAnnotationSource::setNumberOfBands(3);
    theBoundingRect.makeNan();
    theMinArray[0] = theMinArray[1] = theMinArray[2] = theMinArray[3] = ossim::nan();
@@ -125,27 +134,45 @@ bool ossimEsriShapeFileFilter::addObject(ossimAnnotationObject* /*anObject*/)
 
 void ossimEsriShapeFileFilter::computeBoundingRect()
 {
-//   ossimAnnotationSource::computeBoundingRect();
-   
-   std::multimap<int, ossimAnnotationObject*>::iterator iter = theShapeCache.begin();
-   
+   //---
+   // Shapes are loaded lazily so the rect comes from the file bounds rather
+   // than the objects.  Edges are sampled since the view need not be linear
+   // in lat/lon.
+   //---
    theBoundingRect.makeNan();
-   while(iter != theShapeCache.end())
+   if(!theImageGeometry.valid() || ossim::isnan(theMinArray[0]) ||
+      ossim::isnan(theMaxArray[0]))
    {
-       ossimDrect rect = (*iter).second->getBoundingRect();
-      if(theBoundingRect.hasNans())
-      {
-         theBoundingRect = rect;
-      }
-      else
+      return;
+   }
+
+   double minLon = ossim::max(theMinArray[0] - theBorderSize, -180.0);
+   double minLat = ossim::max(theMinArray[1] - theBorderSize, -90.0);
+   double maxLon = ossim::min(theMaxArray[0] + theBorderSize, 180.0);
+   double maxLat = ossim::min(theMaxArray[1] + theBorderSize, 90.0);
+
+   const int STEPS = 8;
+   for(int i = 0; i <= STEPS; ++i)
+   {
+      double t = (double)i/STEPS;
+      double lon = minLon + t*(maxLon - minLon);
+      double lat = minLat + t*(maxLat - minLat);
+      ossimGpt edges[4] = { ossimGpt(minLat, lon), ossimGpt(maxLat, lon),
+                            ossimGpt(lat, minLon), ossimGpt(lat, maxLon) };
+      for(int e = 0; e < 4; ++e)
       {
-         if(!rect.hasNans())
+         ossimDpt pt;
+         theImageGeometry->worldToLocal(edges[e], pt);
+         if(pt.hasNans()) continue;
+         if(theBoundingRect.hasNans())
+         {
+            theBoundingRect = ossimDrect(pt, pt);
+         }
+         else
          {
-            theBoundingRect = theBoundingRect.combine(rect);
+            theBoundingRect = theBoundingRect.combine(ossimDrect(pt, pt));
          }
       }
-      
-      ++iter;
    }
 }
 
@@ -223,45 +250,128 @@ void ossimEsriShapeFileFilter::drawAnnotations(ossimRefPtr<ossimImageData> tile)
       theImage->setCurrentImageData(tile);
       if(n&&array)
       {
+         ossimDrect tileRect(rect);
          for(int i = 0; i < n; ++i)
          {
+            cacheShape(array[i]);
             std::multimap<int, ossimAnnotationObject*>::iterator iter = theShapeCache.find(array[i]);
-            while( ((*iter).first == array[i]) && (iter != theShapeCache.end()) )
+            while( (iter != theShapeCache.end()) && ((*iter).first == array[i]) )
             {
-               (*iter).second->draw(*theImage);
+               // The quad tree is coarse; skip parts outside the tile.
+               if((*iter).second->intersects(tileRect))
+               {
+                  (*iter).second->draw(*theImage);
+               }
                ++iter;
             }
          }
          
          free(array);
+
+         // Never evict the shapes of the tile just drawn.
+         shrinkCache(ossim::max((std::size_t)theMaxCachedShapes, (std::size_t)n));
       }
    }
 }
 
-void ossimEsriShapeFileFilter::transformObjects(ossimImageGeometry* geom)
+void ossimEsriShapeFileFilter::cacheShape(int shapeId)
 {
-   std::multimap<int, ossimAnnotationObject*>::iterator iter = theShapeCache.begin();
-
+   std::map<int, std::list<int>::iterator>::iterator lruIter = theShapeLruMap.find(shapeId);
+   if(lruIter != theShapeLruMap.end())
+   {
+      theShapeLru.splice(theShapeLru.begin(), theShapeLru, lruIter->second);
+      return;
+   }
 
-   ossimImageGeometry* tempGeom = theImageGeometry.get();
-   if(geom)
+   ossimShapeObject obj;
+   obj.loadShape(theShapeFile, shapeId);
+   if(obj.isLoaded())
    {
-      tempGeom = geom;
+      switch(obj.getType())
+      {
+         case SHPT_POLYGON:
+         case SHPT_POLYGONZ:
+         {
+            loadPolygon(obj);
+            break;
+         }
+         case SHPT_POINT:
+         case SHPT_POINTZ:
+         {
+            loadPoint(obj);
+            break;
+         }
+         case SHPT_ARC:
+         case SHPT_ARCZ:
+         {
+            loadArc(obj);
+            break;
+         }
+         case SHPT_NULL:
+         {
+            break;
+         }
+         default:
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << "ossimEsriShapeFileFilter::cacheShape\n"
+               << "SHAPE " << obj.getTypeByName()
+               << " Not supported" <<  endl;
+            break;
+         }
+      }
    }
 
-   if(!tempGeom) return;
-   
-   while(iter != theShapeCache.end())
+   std::multimap<int, ossimAnnotationObject*>::iterator iter = theShapeCache.find(shapeId);
+   while( (iter != theShapeCache.end()) && ((*iter).first == shapeId) )
    {
-      ossimGeoAnnotationObject* obj = PTR_CAST(ossimGeoAnnotationObject,
-                                               (*iter).second);
-      if(obj)
+      ossimGeoAnnotationObject* geoObj = PTR_CAST(ossimGeoAnnotationObject,
+                                                  (*iter).second);
+      if(geoObj)
       {
-         obj->transform(tempGeom);
+         geoObj->transform(theImageGeometry.get());
       }
       ++iter;
    }
 
+   theShapeLru.push_front(shapeId);
+   theShapeLruMap.insert(make_pair(shapeId, theShapeLru.begin()));
+}
+
+void ossimEsriShapeFileFilter::shrinkCache(std::size_t maxShapes)
+{
+   while(theShapeLru.size() > maxShapes)
+   {
+      int shapeId = theShapeLru.back();
+      theShapeLru.pop_back();
+      theShapeLruMap.erase(shapeId);
+
+      std::multimap<int, ossimAnnotationObject*>::iterator iter = theShapeCache.find(shapeId);
+      while( (iter != theShapeCache.end()) && ((*iter).first == shapeId) )
+      {
+         if ((*iter).second)
+         {
+            (*iter).second->unref();
+         }
+         theShapeCache.erase(iter++);
+      }
+   }
+   theCurrentObject = theShapeCache.begin();
+}
+
+void ossimEsriShapeFileFilter::transformObjects(ossimImageGeometry* geom)
+{
+   //---
+   // Cached objects are projected for the old view.  Dropping them is far
+   // cheaper than reprojecting every vertex; visible shapes are projected
+   // again as their tiles are drawn.
+   //---
+   if(geom)
+   {
+      theImageGeometry = geom;
+   }
+
+   deleteCache();
    computeBoundingRect();
 }
 
@@ -304,6 +414,9 @@ void ossimEsriShapeFileFilter::deleteCache()
    }
 
    theShapeCache.clear();
+   theShapeLru.clear();
+   theShapeLruMap.clear();
+   theCurrentObject = theShapeCache.begin();
 }
 
 void ossimEsriShapeFileFilter::checkAndSetDefaultView()
@@ -340,51 +453,8 @@ bool ossimEsriShapeFileFilter::loadShapeFile(const ossimFilename& shapeFile)
                               theMinArray,
                               theMaxArray);  
       
-      ossimShapeObject obj;
-      for(int index = 0 ; index < theShapeFile.getNumberOfShapes(); ++index)
-      {
-         obj.loadShape(theShapeFile,
-                       index);
-         
-         if(obj.isLoaded())
-         {
-            switch(obj.getType())
-            {
-               case SHPT_POLYGON:
-               case SHPT_POLYGONZ:
-               {
-                  loadPolygon(obj);
-                  break;
-               }
-               case SHPT_POINT:
-               case SHPT_POINTZ:
-               {
-                  loadPoint(obj);
-                  break;
-               }
-               case SHPT_ARC:
-               case SHPT_ARCZ:
-               {
-                  loadArc(obj);
-                  break;
-               }
-               case SHPT_NULL:
-               {
-                  break;
-               }
-               default:
-               {
-                  ossimNotify(ossimNotifyLevel_WARN)
-                     << "ossimEsriShapeFileFilter::loadShapeFile\n"
-                     << "SHAPE " << obj.getTypeByName()
-                     << " Not supported" <<  endl;
-                  break;
-               }
-            }
-         }
-      }
-      
-      theCurrentObject = theShapeCache .begin();
+      // Shapes are read and projected on demand in drawAnnotations.
+      theCurrentObject = theShapeCache.begin();
       if(theImageGeometry.valid())
       {
          transformObjects();
@@ -12,6 +12,7 @@
 #ifndef ossimEsriShapeFileFilter_HEADER
 #define ossimEsriShapeFileFilter_HEADER
 
+#include <list>
 #include <map>
 #include <shapefil.h>
 #include <ossimShapeFile.h>
@@ -32,6 +33,11 @@ class ossimProjection;
  * an input connection to an ossimImageSourceInterface then it will
  * draw any vectors over the input tile.  If it is not connected
  * it will just render its vector data to a tile and return it.
+ *
+ * Shapes are read and projected on demand for the tiles requested.  The
+ * projected objects of the most recently drawn shapes are cached; the
+ * cache size in shapes comes from the preference
+ * ossim.plugins.gdal.shapefile.cacheSize and defaults to 50000.
  * <pre>
  * supported keywords:
  *
@@ -95,6 +101,11 @@ public:
    virtual const ossimObject* getView()const;
 
    virtual bool addObject(ossimAnnotationObject* anObject);
+
+   /*!
+    * Sets the geometry if one is passed and drops the cached objects so
+    * shapes are projected again as tiles request them.
+    */
    virtual void transformObjects(ossimImageGeometry* geom=0);
    virtual void setImageGeometry(ossimImageGeometry* projection);
 
@@ -107,8 +118,8 @@ public:
 
    virtual void drawAnnotations(ossimRefPtr<ossimImageData> tile);
    /*!
-    * Will delete the current objects within the layer and add all
-    * objects in the passed in file.
+    * Will delete the current objects within the layer and index the
+    * shapes in the passed in file.  Shapes are loaded when drawn.
     */
    virtual bool loadShapeFile(const ossimFilename& shapeFile);
 
@@ -254,13 +265,37 @@ protected:
 
    mutable std::multimap<int, ossimAnnotationObject*>::iterator theCurrentObject;
 
+   /*!
+    * Projected objects of the cached shapes keyed by shape id.  Only holds
+    * the shapes drawn most recently, so first/next object walk that subset.
+    */
    std::multimap<int, ossimAnnotationObject*> theShapeCache;
+
+   /*!
+    * Cached shape ids, most recently drawn first.  Shapes that produced no
+    * objects are kept too so they are not read again.
+    */
+   std::list<int> theShapeLru;
+   std::map<int, std::list<int>::iterator> theShapeLruMap;
+   ossim_uint32 theMaxCachedShapes;
+
    ossimDrect theBoundingRect;
 
    void removeViewProjection();
    void deleteCache();
    void checkAndSetDefaultView();
 
+   /*!
+    * Reads shapeId from the file, projects its objects and adds them to the
+    * cache.  Moves it to the front of the lru if already cached.
+    */
+   void cacheShape(int shapeId);
+
+   /*!
+    * Evicts least recently drawn shapes until at most maxShapes remain.
+    */
+   void shrinkCache(std::size_t maxShapes);
+
    virtual void loadPolygon(ossimShapeObject& obj);
    virtual void loadPoint(ossimShapeObject& obj);
    virtual void loadArc(ossimShapeObject& obj);
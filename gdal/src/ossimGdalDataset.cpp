@@ -256,15 +256,66 @@ CPLErr ossimGdalDatasetRasterBand::IReadBlock(int nBlockXOff,
           (id->getDataObjectStatus() == OSSIM_PARTIAL) )
       {
          id->unloadBand(pImage, rect, nBand-1);
+
+         //---
+         // The tile holds every band so hand the other bands their block now.
+         // Otherwise a read across all bands calls getTile (and decodes the
+         // same tile) once per band.
+         //---
+         loadSiblingBlocks(id.get(), rect, nBlockXOff, nBlockYOff);
          return CE_None;
       }
    }
 
-   memset(pImage, 0, nBlockXSize * nBlockYSize);      
+   memset(pImage, 0, nBlockXSize * nBlockYSize * (GDALGetDataTypeSize(eDataType)/8));
 
    return CE_None;
 }
 
+void ossimGdalDatasetRasterBand::loadSiblingBlocks(ossimImageData* id,
+                                                   const ossimIrect& rect,
+                                                   int nBlockXOff,
+                                                   int nBlockYOff)
+{
+   if ( !poDS )
+   {
+      return;
+   }
+   
+   for( int iBand = 1; iBand <= poDS->GetRasterCount(); ++iBand )
+   {
+      if ( iBand == nBand )
+      {
+         continue;
+      }
+      
+      GDALRasterBand* band = poDS->GetRasterBand(iBand);
+      if ( !band )
+      {
+         continue;
+      }
+
+      // Already cached, e.g. the caller read that band first.
+      GDALRasterBlock* block = band->TryGetLockedBlockRef(nBlockXOff, nBlockYOff);
+      if ( block )
+      {
+         block->DropLock();
+         continue;
+      }
+
+      // bJustInitialize so this does not recurse into IReadBlock.
+      block = band->GetLockedBlockRef(nBlockXOff, nBlockYOff, TRUE);
+      if ( block )
+      {
+         if ( block->GetDataRef() )
+         {
+            id->unloadBand(block->GetDataRef(), rect, iBand-1);
+         }
+         block->DropLock();
+      }
+   }
+}
+
 double ossimGdalDatasetRasterBand::GetNoDataValue( int * /* pbSuccess */)
 
 {
@@ -135,6 +135,20 @@ protected:
                              void* pImage);
 
 private:
+
+   /**
+    * @brief Copies the other bands of a tile just read into their gdal block
+    * caches, skipping bands that already have the block.
+    * @param id Tile returned by the image handler.
+    * @param rect Image rectangle of the block.
+    * @param nBlockXOff X Block offset.
+    * @param nBlockYOff Y Block offset.
+    */
+   void loadSiblingBlocks(ossimImageData* id,
+                          const ossimIrect& rect,
+                          int nBlockXOff,
+                          int nBlockYOff);
+   
    ossimRefPtr<ossimImageHandler> theImageHandler;
 };
 
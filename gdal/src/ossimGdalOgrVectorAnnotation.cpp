@@ -44,6 +44,8 @@
 #include <ossim/base/ossimUnitConversionTool.h>
 #include <ossim/support_data/ossimFgdcXmlDoc.h>
 #include <ogr_api.h>
+#include <algorithm>
+#include <cmath>
 #include <sstream>
 
 RTTI_DEF2(ossimGdalOgrVectorAnnotation,
@@ -66,6 +68,12 @@ static const char NORMALIZED_RGB_PEN_COLOR_KW[] =
 static const char POINT_SIZE_KW[] =
    "shapefile_point_size";
 
+static const char STREAMING_FEATURE_COUNT_KW[] =
+   "ossim.plugins.gdal.ogr.streamingFeatureCount";
+
+static const char FEATURE_CACHE_SIZE_KW[] =
+   "ossim.plugins.gdal.ogr.featureCacheSize";
+
 
 bool doubleLess(double first, double second, double epsilon, bool orequal = false) 
 {
@@ -150,7 +158,9 @@ class ossimOgrGdalLayerNode
 {
 public:
    ossimOgrGdalLayerNode(const ossimDrect& bounds)
-      : theBoundingRect(bounds)
+      : theBoundingRect(bounds),
+        theLayer(0),
+        theProjection(0)
       {
       }
    bool intersects(const ossimDrect& rect)const
@@ -164,10 +174,152 @@ public:
       }
    void getIdList(std::list<long>& idList,
                   const ossimDrect& aoi)const;
+
+   /**
+    * Bulk loads a packed R-tree (sort tile recursive) over theFeatureList.
+    * Call once the feature list is complete.
+    */
+   void buildIndex();
+   
    std::vector<ossimOgrGdalFeatureNode> theFeatureList;
 
    ossimDrect theBoundingRect;
+
+   /**
+    * Layer geometry is read from on demand; null unless the layer is
+    * streamed.
+    */
+   OGRLayer* theLayer;
+
+   /** Projection of the layer's coordinates; null for geographic. */
+   ossimRefPtr<ossimProjection> theProjection;
+
+private:
+   /** Children per index node. */
+   static const ossim_uint32 NODE_SIZE = 16;
+
+   struct IndexBounds
+   {
+      double theMinX;
+      double theMinY;
+      double theMaxX;
+      double theMaxY;
+
+      bool intersects(const IndexBounds& b)const
+      {
+         return ( (theMinX <= b.theMaxX) && (theMaxX >= b.theMinX) &&
+                  (theMinY <= b.theMaxY) && (theMaxY >= b.theMinY) );
+      }
+      void expand(const IndexBounds& b)
+      {
+         theMinX = std::min(theMinX, b.theMinX);
+         theMinY = std::min(theMinY, b.theMinY);
+         theMaxX = std::max(theMaxX, b.theMaxX);
+         theMaxY = std::max(theMaxY, b.theMaxY);
+      }
+   };
+
+   static IndexBounds toIndexBounds(const ossimDrect& rect);
+
+   /**
+    * Node bounds of every level stored contiguously, leaves first.  Node j
+    * of a level covers children [j*NODE_SIZE, (j+1)*NODE_SIZE) of the level
+    * below.
+    */
+   std::vector<IndexBounds>  theIndexBounds;
+
+   /** Start of each level in theIndexBounds plus the end of the last. */
+   std::vector<ossim_uint32> theLevelStarts;
+
+   /** Leaf slot to theFeatureList index. */
+   std::vector<ossim_uint32> theLeafFeatures;
 };
+
+ossimOgrGdalLayerNode::IndexBounds ossimOgrGdalLayerNode::toIndexBounds(const ossimDrect& rect)
+{
+   // Orientation independent; geographic rects are built from corner points.
+   IndexBounds result;
+   result.theMinX = std::min(rect.ul().x, rect.lr().x);
+   result.theMinY = std::min(rect.ul().y, rect.lr().y);
+   result.theMaxX = std::max(rect.ul().x, rect.lr().x);
+   result.theMaxY = std::max(rect.ul().y, rect.lr().y);
+   return result;
+}
+
+void ossimOgrGdalLayerNode::buildIndex()
+{
+   theIndexBounds.clear();
+   theLevelStarts.clear();
+   theLeafFeatures.clear();
+
+   const ossim_uint32 count = (ossim_uint32)theFeatureList.size();
+   if ( count == 0 )
+   {
+      return;
+   }
+
+   std::vector<IndexBounds> featureBounds(count);
+   std::vector<double> centerX(count);
+   std::vector<double> centerY(count);
+   theLeafFeatures.resize(count);
+   for ( ossim_uint32 i = 0; i < count; ++i )
+   {
+      featureBounds[i] = toIndexBounds(theFeatureList[i].theBoundingRect);
+      centerX[i] = (featureBounds[i].theMinX + featureBounds[i].theMaxX) * 0.5;
+      centerY[i] = (featureBounds[i].theMinY + featureBounds[i].theMaxY) * 0.5;
+      theLeafFeatures[i] = i;
+   }
+
+   //---
+   // Sort tile recursive: sort on x, cut into vertical slices of
+   // sqrt(leaves) leaves each, then sort each slice on y so consecutive runs
+   // of NODE_SIZE features are spatially compact.
+   //---
+   ossim_uint32 leafNodes   = (count + NODE_SIZE - 1) / NODE_SIZE;
+   ossim_uint32 slices      = (ossim_uint32)std::ceil( std::sqrt( (double)leafNodes ) );
+   ossim_uint32 sliceLength = slices * NODE_SIZE;
+
+   std::sort( theLeafFeatures.begin(), theLeafFeatures.end(),
+              [&centerX](ossim_uint32 a, ossim_uint32 b)
+              { return centerX[a] < centerX[b]; } );
+   for ( ossim_uint32 start = 0; start < count; start += sliceLength )
+   {
+      ossim_uint32 end = std::min( start + sliceLength, count );
+      std::sort( theLeafFeatures.begin() + start, theLeafFeatures.begin() + end,
+                 [&centerY](ossim_uint32 a, ossim_uint32 b)
+                 { return centerY[a] < centerY[b]; } );
+   }
+
+   theIndexBounds.reserve( count + count / (NODE_SIZE - 1) + 1 );
+   for ( ossim_uint32 i = 0; i < count; ++i )
+   {
+      theIndexBounds.push_back( featureBounds[ theLeafFeatures[i] ] );
+   }
+   theLevelStarts.push_back( 0 );
+
+   // Build parents until a level fits in one node.
+   ossim_uint32 levelStart = 0;
+   ossim_uint32 levelSize  = count;
+   while ( levelSize > 1 )
+   {
+      ossim_uint32 parentStart = (ossim_uint32)theIndexBounds.size();
+      for ( ossim_uint32 child = 0; child < levelSize; child += NODE_SIZE )
+      {
+         IndexBounds bounds = theIndexBounds[ levelStart + child ];
+         ossim_uint32 childEnd = std::min( child + NODE_SIZE, levelSize );
+         for ( ossim_uint32 c = child + 1; c < childEnd; ++c )
+         {
+            bounds.expand( theIndexBounds[ levelStart + c ] );
+         }
+         theIndexBounds.push_back( bounds );
+      }
+      theLevelStarts.push_back( parentStart );
+      levelStart = parentStart;
+      levelSize  = (ossim_uint32)theIndexBounds.size() - parentStart;
+   }
+   theLevelStarts.push_back( (ossim_uint32)theIndexBounds.size() );
+}
+
 void ossimOgrGdalLayerNode::getIdList(std::list<long>& idList,
                                       const ossimDrect& aoi)const
 {
@@ -182,8 +334,9 @@ void ossimOgrGdalLayerNode::getIdList(std::list<long>& idList,
          idList.push_back(theFeatureList[i].theId);
       }
    }
-   else
+   else if ( theLevelStarts.size() < 2 )
    {
+      // No index built.
       for(ossim_uint32 i = 0; i < theFeatureList.size(); ++i)
       {
          if(theFeatureList[i].intersects(aoi))
@@ -192,6 +345,52 @@ void ossimOgrGdalLayerNode::getIdList(std::list<long>& idList,
          }
       }
    }
+   else
+   {
+      const IndexBounds query = toIndexBounds(aoi);
+
+      // Stack of (level, node index within level) pairs, root level first.
+      std::vector< std::pair<ossim_uint32, ossim_uint32> > stack;
+      ossim_uint32 topLevel = (ossim_uint32)theLevelStarts.size() - 2;
+      ossim_uint32 topSize  = theLevelStarts[topLevel+1] - theLevelStarts[topLevel];
+      for ( ossim_uint32 i = 0; i < topSize; ++i )
+      {
+         stack.push_back( std::make_pair( topLevel, i ) );
+      }
+
+      std::vector<ossim_uint32> hits;
+      while ( !stack.empty() )
+      {
+         ossim_uint32 level = stack.back().first;
+         ossim_uint32 node  = stack.back().second;
+         stack.pop_back();
+
+         if ( !theIndexBounds[ theLevelStarts[level] + node ].intersects( query ) )
+         {
+            continue;
+         }
+         if ( level == 0 )
+         {
+            hits.push_back( theLeafFeatures[node] );
+         }
+         else
+         {
+            ossim_uint32 childSize = theLevelStarts[level] - theLevelStarts[level-1];
+            ossim_uint32 childEnd  = std::min( (node + 1) * NODE_SIZE, childSize );
+            for ( ossim_uint32 child = node * NODE_SIZE; child < childEnd; ++child )
+            {
+               stack.push_back( std::make_pair( level - 1, child ) );
+            }
+         }
+      }
+
+      // Keep the layer's draw order.
+      std::sort( hits.begin(), hits.end() );
+      for ( ossim_uint32 i = 0; i < hits.size(); ++i )
+      {
+         idList.push_back( theFeatureList[ hits[i] ].theId );
+      }
+   }
 }
 
 ossimGdalOgrVectorAnnotation::ossimGdalOgrVectorAnnotation(ossimImageSource* inputSource)
@@ -216,7 +415,13 @@ ossimGdalOgrVectorAnnotation::ossimGdalOgrVectorAnnotation(ossimImageSource* inp
     m_needPenColor(false),
     m_geometryDistance(0.0),
     m_geometryDistanceType(OSSIM_UNIT_UNKNOWN),
-    m_layerName("")
+    m_layerName(""),
+    m_streaming(false),
+    m_streamingFeatureCount(250000),
+    m_featureCacheMaxBytes(256*1024*1024),
+    m_featureCacheBytes(0),
+    m_featureLru(),
+    m_featureLruMap()
 {
    // Pick up colors from preference file if set.
    getDefaults();
@@ -536,6 +741,13 @@ bool ossimGdalOgrVectorAnnotation::open(const ossimFilename& file)
                }
             }
 
+            theLayerTable[i]->buildIndex();
+            if ( streamLayer )
+            {
+               // Attributes stay ignored; drawing only needs geometry.
+               layer->ResetReading();
+            }
+
             //if an OGRLayer pointer representing a results set from the query, this layer is 
             //in addition to the layers in the data store and must be destroyed with 
             //OGRDataSource::ReleaseResultSet() before the data source is closed (destroyed).
@@ -725,6 +937,35 @@ ossimIrect ossimGdalOgrVectorAnnotation::getBoundingRect(ossim_uint32 /* resLeve
 
 void ossimGdalOgrVectorAnnotation::computeBoundingRect()
 {
+   if ( m_streaming )
+   {
+      // Only part of the features are in the cache so use the layer bounds.
+      theImageBound.makeNan();
+      for ( ossim_uint32 i = 0; theImageGeometry.valid() && ( i < theLayerTable.size() ); ++i )
+      {
+         if ( theLayerTable[i] )
+         {
+            const ossimDrect& bounds = theLayerTable[i]->theBoundingRect;
+            ossimDpt pts[4];
+            theImageGeometry->worldToLocal( ossimGpt(bounds.ul().y, bounds.ul().x), pts[0] );
+            theImageGeometry->worldToLocal( ossimGpt(bounds.ur().y, bounds.ur().x), pts[1] );
+            theImageGeometry->worldToLocal( ossimGpt(bounds.lr().y, bounds.lr().x), pts[2] );
+            theImageGeometry->worldToLocal( ossimGpt(bounds.ll().y, bounds.ll().x), pts[3] );
+            ossimDrect rect( pts[0], pts[1], pts[2], pts[3] );
+            if ( theImageBound.hasNans() )
+            {
+               theImageBound = rect;
+            }
+            else if ( !rect.hasNans() )
+            {
+               theImageBound = theImageBound.combine(rect);
+            }
+         }
+      }
+      theImageBound.stretchOut();
+      return;
+   }
+   
    std::multimap<long, ossimAnnotationObject*>::iterator iter = theFeatureCacheTable.begin();
    
    theImageBound.makeNan();
@@ -760,7 +1001,7 @@ void ossimGdalOgrVectorAnnotation::computeBoundingRect()
 void ossimGdalOgrVectorAnnotation::drawAnnotations(
    ossimRefPtr<ossimImageData> tile)
 {
-   if (theFeatureCacheTable.size() == 0)
+   if (theLayerTable.empty())
    {
       initializeTables();
    }
@@ -771,6 +1012,11 @@ void ossimGdalOgrVectorAnnotation::drawAnnotations(
       ossimIrect tileRect = tile->getImageRectangle();
       
       getFeatures(featuresToRender, tileRect);
+
+      if ( m_streaming && featuresToRender.size() )
+      {
+         loadVisibleFeatures(tileRect);
+      }
       
       list<long>::iterator current = featuresToRender.begin();
       
@@ -805,6 +1051,11 @@ void ossimGdalOgrVectorAnnotation::drawAnnotations(
       }
       
       tile->validate();
+
+      if ( m_streaming )
+      {
+         shrinkFeatureCache();
+      }
    }
 }
 
@@ -814,39 +1065,44 @@ void ossimGdalOgrVectorAnnotation::updateAnnotationSettings()
 
    while(iter != theFeatureCacheTable.end())
    {
-      iter->second->setThickness(theThickness);
+      updateAnnotationSettings(iter->second);
+      ++iter;
+   }
+}
 
-      iter->second->setColor(thePenColor.getR(),
-                             thePenColor.getG(),
-                             thePenColor.getB());
-      
-      if(PTR_CAST(ossimGeoAnnotationPolyObject, iter->second))
-      {
-         ossimGeoAnnotationPolyObject* poly =
-            (ossimGeoAnnotationPolyObject*)(iter->second);
-         poly->setFillFlag(theFillFlag);
-      }
-      else if(PTR_CAST(ossimGeoAnnotationMultiPolyObject, iter->second))
-      {
-         ossimGeoAnnotationMultiPolyObject* poly =
-            (ossimGeoAnnotationMultiPolyObject*)(iter->second);
-         poly->setFillFlag(theFillFlag);
-      }
-      else if(PTR_CAST(ossimGeoAnnotationEllipseObject, iter->second))
-      {
-         ossimGeoAnnotationEllipseObject* ell = (ossimGeoAnnotationEllipseObject*)(iter->second);
+void ossimGdalOgrVectorAnnotation::updateAnnotationSettings(ossimAnnotationObject* obj)
+{
+   obj->setThickness(theThickness);
 
-         ell->setWidthHeight(thePointWidthHeight);
-         ell->setFillFlag(theFillFlag);
-         ell->transform(theImageGeometry.get());
-      }
-      if(theFillFlag)
-      {
-         iter->second->setColor(theBrushColor.getR(),
-                                theBrushColor.getG(),
-                                theBrushColor.getB());
-      }
-      ++iter;
+   obj->setColor(thePenColor.getR(),
+                 thePenColor.getG(),
+                 thePenColor.getB());
+   
+   if(PTR_CAST(ossimGeoAnnotationPolyObject, obj))
+   {
+      ossimGeoAnnotationPolyObject* poly =
+         (ossimGeoAnnotationPolyObject*)(obj);
+      poly->setFillFlag(theFillFlag);
+   }
+   else if(PTR_CAST(ossimGeoAnnotationMultiPolyObject, obj))
+   {
+      ossimGeoAnnotationMultiPolyObject* poly =
+         (ossimGeoAnnotationMultiPolyObject*)(obj);
+      poly->setFillFlag(theFillFlag);
+   }
+   else if(PTR_CAST(ossimGeoAnnotationEllipseObject, obj))
+   {
+      ossimGeoAnnotationEllipseObject* ell = (ossimGeoAnnotationEllipseObject*)(obj);
+
+      ell->setWidthHeight(thePointWidthHeight);
+      ell->setFillFlag(theFillFlag);
+      ell->transform(theImageGeometry.get());
+   }
+   if(theFillFlag)
+   {
+      obj->setColor(theBrushColor.getR(),
+                    theBrushColor.getG(),
+                    theBrushColor.getB());
    }
 }
 
@@ -1196,7 +1452,7 @@ void ossimGdalOgrVectorAnnotation::transformObjectsFromView()
 {
    if (theImageGeometry.valid())
    {
-      if (theFeatureCacheTable.size() == 0)
+      if (theLayerTable.empty())
       {
          initializeTables();
       }
@@ -1218,10 +1474,11 @@ void ossimGdalOgrVectorAnnotation::transformObjectsFromView()
    }
 }
 
-void ossimGdalOgrVectorAnnotation::getFeatures(std::list<long>& result,
-                                               const ossimIrect& rect)
+bool ossimGdalOgrVectorAnnotation::getGroundBounds(const ossimIrect& rect,
+                                                   ossimDrect& bounds) const
 {
-   if (isOpen())
+   bool result = false;
+   if (theImageGeometry.valid())
    {
       ossimGpt gp1;
       ossimGpt gp2;
@@ -1232,20 +1489,30 @@ void ossimGdalOgrVectorAnnotation::getFeatures(std::list<long>& result,
       ossimDpt dp3 = rect.lr();
       ossimDpt dp4 = rect.ll();
       
-      if (theImageGeometry.valid())
-      {
-         theImageGeometry->localToWorld(dp1, gp1);
-         theImageGeometry->localToWorld(dp2, gp2);
-         theImageGeometry->localToWorld(dp3, gp3);
-         theImageGeometry->localToWorld(dp4, gp4);
+      theImageGeometry->localToWorld(dp1, gp1);
+      theImageGeometry->localToWorld(dp2, gp2);
+      theImageGeometry->localToWorld(dp3, gp3);
+      theImageGeometry->localToWorld(dp4, gp4);
+
+      double maxX = std::max( gp1.lond(), std::max( gp2.lond(), std::max(gp3.lond(), gp4.lond())));
+      double minX = std::min( gp1.lond(), std::min( gp2.lond(), std::min(gp3.lond(), gp4.lond())));
+      double maxY = std::max( gp1.latd(), std::max( gp2.latd(), std::max(gp3.latd(), gp4.latd())));
+      double minY = std::min( gp1.latd(), std::min( gp2.latd(), std::min(gp3.latd(), gp4.latd())));
+      
+      bounds = ossimDrect(minX, minY, maxX, maxY);
+      result = true;
+   }
+   return result;
+}
 
-         double maxX = std::max( gp1.lond(), std::max( gp2.lond(), std::max(gp3.lond(), gp4.lond())));
-         double minX = std::min( gp1.lond(), std::min( gp2.lond(), std::min(gp3.lond(), gp4.lond())));
-         double maxY = std::max( gp1.latd(), std::max( gp2.latd(), std::max(gp3.latd(), gp4.latd())));
-         double minY = std::min( gp1.latd(), std::min( gp2.latd(), std::min(gp3.latd(), gp4.latd())));
-         
-         ossimDrect bounds(minX, minY, maxX, maxY);
-         
+void ossimGdalOgrVectorAnnotation::getFeatures(std::list<long>& result,
+                                               const ossimIrect& rect)
+{
+   if (isOpen())
+   {
+      ossimDrect bounds;
+      if (getGroundBounds(rect, bounds))
+      {
          for(ossim_uint32 layerI = 0;
              layerI < theLayersToRenderFlagList.size();
              ++layerI)
@@ -1339,6 +1606,38 @@ void ossimGdalOgrVectorAnnotation::initializeTables()
                                                                        extent.MaxX,
                                                                        extent.MaxY));
             }
+
+            //---
+            // Large layers are streamed: only fid and bounds are kept here and
+            // geometry is read per tile in loadVisibleFeatures.  Query result
+            // sets are released below so they are always loaded up front.
+            //---
+            bool streamLayer = ( m_query.empty() && ( m_streamingFeatureCount > 0 ) &&
+                                 ( layer->GetFeatureCount(TRUE) >= m_streamingFeatureCount ) );
+            if ( streamLayer )
+            {
+               theLayerTable[i]->theLayer      = layer;
+               theLayerTable[i]->theProjection = proj;
+               m_streaming = true;
+
+               // Attributes are not needed for bounds or drawing.
+               std::vector<const char*> ignored;
+               OGRFeatureDefn* defn = layer->GetLayerDefn();
+               for ( int field = 0; defn && ( field < defn->GetFieldCount() ); ++field )
+               {
+                  ignored.push_back( defn->GetFieldDefn(field)->GetNameRef() );
+               }
+               ignored.push_back( "OGR_STYLE" );
+               ignored.push_back( 0 );
+               layer->SetIgnoredFields( &ignored.front() );
+
+               if ( traceDebug() )
+               {
+                  ossimNotify(ossimNotifyLevel_DEBUG)
+                     << "ossimGdalOgrVectorAnnotation::initializeTables DEBUG: streaming layer "
+                     << i << std::endl;
+               }
+            }
            
             while( (feature = layer->GetNextFeature()) != NULL)
             {
@@ -1348,117 +1647,9 @@ void ossimGdalOgrVectorAnnotation::initializeTables()
                      
                      if(geom)
                      {
-                        switch(geom->getGeometryType())
+                        if ( !streamLayer )
                         {
-                           case wkbMultiPoint:
-                           case wkbMultiPoint25D:
-                           {
-                              if(traceDebug())
-                              {
-                                 ossimNotify(ossimNotifyLevel_DEBUG) << "Loading multi point" << std::endl;
-                              }
-                              loadMultiPoint(feature->GetFID(),
-                                             (OGRMultiPoint*)geom,
-                                             mapProj);
-                              break;
-                           }
-                           case wkbPolygon25D:
-                           case wkbPolygon:
-                           {
-                              if(traceDebug())
-                              {
-                                 ossimNotify(ossimNotifyLevel_DEBUG) << "Loading polygon" << std::endl;
-                              }
-                              if (m_geometryDistance > 0.0)
-                              {
-                                 OGRPolygon* poly = (OGRPolygon*)geom;
-                                 OGRLinearRing* ring = poly->getExteriorRing();
-                                 int numPoints = ring->getNumPoints();
-                                 OGRGeometry* bufferGeom = geom->Buffer(m_geometryDistance, numPoints);
-                                 loadPolygon(feature->GetFID(),
-                                    (OGRPolygon*)bufferGeom,
-                                    mapProj);
-                              }
-                              else
-                              {
-                                 loadPolygon(feature->GetFID(),
-                                    (OGRPolygon*)geom,
-                                    mapProj);
-                              }
-
-                              break;
-                           }
-                           case wkbLineString25D:
-                           case wkbLineString:
-                           {
-                              if(traceDebug())
-                              {
-                                 ossimNotify(ossimNotifyLevel_DEBUG) << "Loading line string" << std::endl;
-                              }
-                              loadLineString(feature->GetFID(),
-                                             (OGRLineString*)geom,
-                                             mapProj);
-                              break;
-                           }
-                           case wkbPoint:
-                           case wkbPoint25D:
-                           {
-                              if(traceDebug())
-                              {
-                                 ossimNotify(ossimNotifyLevel_DEBUG) << "Loading point" << std::endl;
-                              }
-                              loadPoint(feature->GetFID(),
-                                        (OGRPoint*)geom,
-                                        mapProj);
-                              break;
-                           }
-                           case wkbMultiPolygon25D:
-                           case wkbMultiPolygon:
-                           {
-                              if(traceDebug())
-                              {
-                                 ossimNotify(ossimNotifyLevel_DEBUG) << "Loading multi polygon" << std::endl;
-                              }
-                              if (m_geometryDistance > 0.0)
-                              {
-                                 OGRGeometry* bufferGeom = geom->Buffer(m_geometryDistance);
-                                 loadMultiPolygon(feature->GetFID(),
-                                    (OGRMultiPolygon*)bufferGeom,
-                                    mapProj);
-                              }
-                              else
-                              {
-                                 loadMultiPolygon(feature->GetFID(),
-                                    (OGRMultiPolygon*)geom,
-                                    mapProj);
-                              }
-                              break;
-                                               
-                           }
-                           case wkbMultiLineString:
-                           {
-                              if(traceDebug())
-                              {
-                                 ossimNotify(ossimNotifyLevel_DEBUG) << "Loading line string" << std::endl;
-                              }
-                              loadMultiLineString(feature->GetFID(),
-                                    (OGRMultiLineString*)geom,
-                                    mapProj);
-                                 break;
-                              }
-                           default:
-                           {
-                              if(traceDebug())
-                              {
-                                 ossimNotify(ossimNotifyLevel_WARN)
-                                    << "ossimGdalOgrVectorAnnotation::initializeTables WARNING\n"
-                                    
-                                    << OGRGeometryTypeToName(geom->getGeometryType())
-                                    <<" NOT SUPPORTED!"
-                                    << endl;
-                              }
-                              break;
-                           }
+                           loadFeature(feature, mapProj);
                         }
                         geom->getEnvelope(&extent);
                         if(mapProj)
@@ -1517,6 +1708,129 @@ void ossimGdalOgrVectorAnnotation::initializeTables()
    }
 }
 
+void ossimGdalOgrVectorAnnotation::loadFeature(OGRFeature* feature,
+                                               ossimMapProjection* mapProj)
+{
+   OGRGeometry* geom = feature->GetGeometryRef();
+   if(!geom)
+   {
+      return;
+   }
+   
+   switch(geom->getGeometryType())
+   {
+      case wkbMultiPoint:
+      case wkbMultiPoint25D:
+      {
+         if(traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG) << "Loading multi point" << std::endl;
+         }
+         loadMultiPoint(feature->GetFID(),
+                        (OGRMultiPoint*)geom,
+                        mapProj);
+         break;
+      }
+      case wkbPolygon25D:
+      case wkbPolygon:
+      {
+         if(traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG) << "Loading polygon" << std::endl;
+         }
+         if (m_geometryDistance > 0.0)
+         {
+            OGRPolygon* poly = (OGRPolygon*)geom;
+            OGRLinearRing* ring = poly->getExteriorRing();
+            int numPoints = ring->getNumPoints();
+            OGRGeometry* bufferGeom = geom->Buffer(m_geometryDistance, numPoints);
+            loadPolygon(feature->GetFID(),
+               (OGRPolygon*)bufferGeom,
+               mapProj);
+         }
+         else
+         {
+            loadPolygon(feature->GetFID(),
+               (OGRPolygon*)geom,
+               mapProj);
+         }
+
+         break;
+      }
+      case wkbLineString25D:
+      case wkbLineString:
+      {
+         if(traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG) << "Loading line string" << std::endl;
+         }
+         loadLineString(feature->GetFID(),
+                        (OGRLineString*)geom,
+                        mapProj);
+         break;
+      }
+      case wkbPoint:
+      case wkbPoint25D:
+      {
+         if(traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG) << "Loading point" << std::endl;
+         }
+         loadPoint(feature->GetFID(),
+                   (OGRPoint*)geom,
+                   mapProj);
+         break;
+      }
+      case wkbMultiPolygon25D:
+      case wkbMultiPolygon:
+      {
+         if(traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG) << "Loading multi polygon" << std::endl;
+         }
+         if (m_geometryDistance > 0.0)
+         {
+            OGRGeometry* bufferGeom = geom->Buffer(m_geometryDistance);
+            loadMultiPolygon(feature->GetFID(),
+               (OGRMultiPolygon*)bufferGeom,
+               mapProj);
+         }
+         else
+         {
+            loadMultiPolygon(feature->GetFID(),
+               (OGRMultiPolygon*)geom,
+               mapProj);
+         }
+         break;
+                          
+      }
+      case wkbMultiLineString:
+      {
+         if(traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG) << "Loading line string" << std::endl;
+         }
+         loadMultiLineString(feature->GetFID(),
+               (OGRMultiLineString*)geom,
+               mapProj);
+         break;
+      }
+      default:
+      {
+         if(traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << "ossimGdalOgrVectorAnnotation::loadFeature WARNING\n"
+               
+               << OGRGeometryTypeToName(geom->getGeometryType())
+               <<" NOT SUPPORTED!"
+               << endl;
+         }
+         break;
+      }
+   }
+}
+
 void ossimGdalOgrVectorAnnotation::deleteTables()
 {
    for(ossim_uint32 i = 0; i < theLayerTable.size(); ++i)
@@ -1537,6 +1851,150 @@ void ossimGdalOgrVectorAnnotation::deleteTables()
    }
    
    theFeatureCacheTable.clear();
+   m_featureLru.clear();
+   m_featureLruMap.clear();
+   m_featureCacheBytes = 0;
+   m_streaming = false;
+}
+
+void ossimGdalOgrVectorAnnotation::loadVisibleFeatures(const ossimIrect& rect)
+{
+   ossimDrect bounds;
+   if ( !getGroundBounds(rect, bounds) )
+   {
+      return;
+   }
+   
+   for ( ossim_uint32 i = 0; i < theLayerTable.size(); ++i )
+   {
+      ossimOgrGdalLayerNode* node = theLayerTable[i];
+      if ( !node || !node->theLayer || !node->intersects(bounds) )
+      {
+         continue;
+      }
+
+      // Tile bounds in the layer's own coordinates for the spatial filter.
+      ossimMapProjection* mapProj = PTR_CAST(ossimMapProjection, node->theProjection.get());
+      double minX = bounds.ul().x;
+      double maxX = bounds.lr().x;
+      double minY = std::min(bounds.ul().y, bounds.lr().y);
+      double maxY = std::max(bounds.ul().y, bounds.lr().y);
+      if ( mapProj )
+      {
+         ossimDpt pts[4];
+         pts[0] = mapProj->forward( ossimGpt(minY, minX) );
+         pts[1] = mapProj->forward( ossimGpt(minY, maxX) );
+         pts[2] = mapProj->forward( ossimGpt(maxY, maxX) );
+         pts[3] = mapProj->forward( ossimGpt(maxY, minX) );
+         minX = maxX = pts[0].x;
+         minY = maxY = pts[0].y;
+         for ( int p = 1; p < 4; ++p )
+         {
+            minX = std::min(minX, pts[p].x);
+            maxX = std::max(maxX, pts[p].x);
+            minY = std::min(minY, pts[p].y);
+            maxY = std::max(maxY, pts[p].y);
+         }
+      }
+
+      OGRLayer* layer = node->theLayer;
+      layer->SetSpatialFilterRect(minX, minY, maxX, maxY);
+      layer->ResetReading();
+      
+      OGRFeature* feature = 0;
+      ossim_uint32 loaded = 0;
+      while ( (feature = layer->GetNextFeature()) != 0 )
+      {
+         long id = feature->GetFID();
+         FeatureKey key(i, id);
+         std::map<FeatureKey, FeatureLruEntry>::iterator iter = m_featureLruMap.find(key);
+         if ( iter != m_featureLruMap.end() )
+         {
+            m_featureLru.splice(m_featureLru.begin(), m_featureLru, iter->second.m_lruIter);
+         }
+         else
+         {
+            OGRGeometry* geom = feature->GetGeometryRef();
+            if ( geom )
+            {
+               //---
+               // theFeatureCacheTable is keyed by FID alone and another layer
+               // may use the same FID.  Equal keys are inserted at the end of
+               // their range so the objects past the old count are this
+               // feature's.
+               //---
+               std::size_t oldCount = theFeatureCacheTable.count(id);
+               loadFeature(feature, mapProj);
+
+               FeatureLruEntry entry;
+               std::pair< std::multimap<long, ossimAnnotationObject*>::iterator,
+                          std::multimap<long, ossimAnnotationObject*>::iterator > range =
+                  theFeatureCacheTable.equal_range(id);
+               for ( std::size_t idx = 0; range.first != range.second; ++range.first, ++idx )
+               {
+                  if ( idx >= oldCount )
+                  {
+                     updateAnnotationSettings(range.first->second);
+                     entry.m_objects.push_back(range.first->second);
+                  }
+               }
+
+               // Projected ground and image points cost roughly three times
+               // the wkb size.
+               m_featureLru.push_front(key);
+               entry.m_lruIter = m_featureLru.begin();
+               entry.m_bytes   = (ossim_int64)geom->WkbSize() * 3 + 256;
+               m_featureLruMap.insert( std::make_pair(key, entry) );
+               m_featureCacheBytes += entry.m_bytes;
+               ++loaded;
+            }
+         }
+         OGRFeature::DestroyFeature(feature);
+      }
+      layer->SetSpatialFilter(0);
+
+      if ( traceDebug() && loaded )
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossimGdalOgrVectorAnnotation::loadVisibleFeatures DEBUG: layer " << i
+            << " loaded " << loaded << " features, cache bytes: "
+            << m_featureCacheBytes << std::endl;
+      }
+   }
+}
+
+void ossimGdalOgrVectorAnnotation::shrinkFeatureCache()
+{
+   while ( ( m_featureCacheBytes > m_featureCacheMaxBytes ) && !m_featureLru.empty() )
+   {
+      FeatureKey key = m_featureLru.back();
+      m_featureLru.pop_back();
+
+      std::map<FeatureKey, FeatureLruEntry>::iterator iter = m_featureLruMap.find(key);
+      if ( iter == m_featureLruMap.end() )
+      {
+         continue;
+      }
+      m_featureCacheBytes -= iter->second.m_bytes;
+
+      // Only this layer's objects; other layers may share the FID.
+      const std::vector<ossimAnnotationObject*>& objects = iter->second.m_objects;
+      std::multimap<long, ossimAnnotationObject*>::iterator obj =
+         theFeatureCacheTable.lower_bound(key.second);
+      while ( ( obj != theFeatureCacheTable.end() ) && ( obj->first == key.second ) )
+      {
+         if ( std::find(objects.begin(), objects.end(), obj->second) != objects.end() )
+         {
+            obj->second->unref();
+            theFeatureCacheTable.erase(obj++);
+         }
+         else
+         {
+            ++obj;
+         }
+      }
+      m_featureLruMap.erase(iter);
+   }
 }
 
 
@@ -2375,6 +2833,31 @@ void ossimGdalOgrVectorAnnotation::getDefaults()
 {
    const char* lookup;
 
+   lookup = ossimPreferences::instance()->findPreference(STREAMING_FEATURE_COUNT_KW);
+   if (lookup)
+   {
+      m_streamingFeatureCount = ossimString(lookup).toInt64();
+   }
+   lookup = ossimPreferences::instance()->findPreference(FEATURE_CACHE_SIZE_KW);
+   if (lookup)
+   {
+      // Accepts a K, M or G suffix.
+      ossimString value = ossimString(lookup).trim().upcase();
+      ossim_int64 multiplier = 1;
+      if (value.size())
+      {
+         char suffix = value[value.size()-1];
+         if (suffix == 'K') multiplier = 1024;
+         else if (suffix == 'M') multiplier = 1024*1024;
+         else if (suffix == 'G') multiplier = 1024*1024*1024;
+         if (multiplier > 1)
+         {
+            value = value.substr(0, value.size()-1);
+         }
+      }
+      m_featureCacheMaxBytes = value.toInt64() * multiplier;
+   }
+
    // Look for auto color flag:
    bool autocolors = false;
    lookup = ossimPreferences::instance()->
@@ -2524,9 +3007,9 @@ void ossimGdalOgrVectorAnnotation::verifyViewParams()
    }
 }
 
-std::multimap<long, ossimAnnotationObject*> ossimGdalOgrVectorAnnotation::getFeatureTable()
+const std::multimap<long, ossimAnnotationObject*>& ossimGdalOgrVectorAnnotation::getFeatureTable()
 {
-   if (theFeatureCacheTable.size() == 0)
+   if (theLayerTable.empty())
    {
       initializeTables();
    }
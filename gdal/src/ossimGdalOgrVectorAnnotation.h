@@ -83,7 +83,11 @@ public:
 
    virtual std::ostream& print(std::ostream& out) const;
 
-   std::multimap<long, ossimAnnotationObject*> getFeatureTable();
+   /**
+    * @return Annotation objects by feature id.  For streamed layers this is
+    * only the features currently cached.
+    */
+   const std::multimap<long, ossimAnnotationObject*>& getFeatureTable();
 
    void setQuery(const ossimString& query);
 
@@ -122,6 +126,32 @@ protected:
    ossimUnitType                               m_geometryDistanceType;
    ossimString                                 m_layerName;
    std::vector<ossimString>                    m_layerNames;
+
+   /**
+    * Streamed features are keyed by layer index and FID since FIDs are only
+    * unique within a layer.
+    */
+   typedef std::pair<ossim_uint32, long> FeatureKey;
+
+   /** LRU bookkeeping for features of streamed layers. */
+   struct FeatureLruEntry
+   {
+      std::list<FeatureKey>::iterator     m_lruIter;
+      ossim_int64                         m_bytes;
+
+      /** Objects the feature added to theFeatureCacheTable. */
+      std::vector<ossimAnnotationObject*> m_objects;
+   };
+
+   /** True if any layer is streamed rather than loaded up front. */
+   bool                                        m_streaming;
+
+   /** Layers with at least this many features are streamed; 0 disables. */
+   ossim_int64                                 m_streamingFeatureCount;
+   ossim_int64                                 m_featureCacheMaxBytes;
+   ossim_int64                                 m_featureCacheBytes;
+   std::list<FeatureKey>                       m_featureLru;
+   std::map<FeatureKey, FeatureLruEntry>       m_featureLruMap;
    
    void computeDefaultView();
 
@@ -134,6 +164,24 @@ protected:
    void loadPolygon(long id, OGRPolygon* polygon, ossimMapProjection* mapProj);
    void loadLineString(long id, OGRLineString* lineString, ossimMapProjection* mapProj);
    void loadMultiLineString(long id, OGRMultiLineString* multiLineString, ossimMapProjection* mapProj);
+
+   /** Adds the annotation objects for feature's geometry to the cache. */
+   void loadFeature(OGRFeature* feature, ossimMapProjection* mapProj);
+
+   /**
+    * Reads the features of streamed layers that fall in rect (image space)
+    * through an OGR spatial filter, skipping those already cached.
+    */
+   void loadVisibleFeatures(const ossimIrect& rect);
+
+   /** Evicts least recently drawn streamed features down to the budget. */
+   void shrinkFeatureCache();
+
+   /**
+    * @brief Computes the geographic bounds of an image space rect.
+    * @return false if there is no image geometry.
+    */
+   bool getGroundBounds(const ossimIrect& rect, ossimDrect& bounds) const;
    
    void getFeatures(std::list<long>& result,
                     const ossimIrect& rect);
@@ -143,6 +191,7 @@ protected:
    void initializeTables();
    void deleteTables();
    void updateAnnotationSettings();
+   void updateAnnotationSettings(ossimAnnotationObject* obj);
 
    /**
     * Will set theViewProjection if geometry file is present with projection.
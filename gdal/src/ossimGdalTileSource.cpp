@@ -77,7 +77,10 @@ ossimGdalTileSource::ossimGdalTileSource()
       theAlphaChannelFlag(false),
       m_preservePaletteIndexesFlag(false),
       m_outputBandList(0),
-      m_isBlocked(false)
+      m_isBlocked(false),
+      m_readContexts(std::make_shared<ReadContextSet>()),
+      m_openThreadId(),
+      m_overviewMutex()
 {
    // Pick up any default settings from preference file if set.
    getDefaults();
@@ -93,6 +96,8 @@ ossimGdalTileSource::~ossimGdalTileSource()
 
 void ossimGdalTileSource::close()
 {
+   clearReadContexts();
+
    if(theDataset)
    {
       GDALClose(theDataset);
@@ -141,6 +146,7 @@ bool ossimGdalTileSource::open()
    {
       close();
    }
+   m_openThreadId = std::this_thread::get_id();
    ossimString driverNameTmp;
 
    if (theSubDatasets.size() == 0)
@@ -419,12 +425,6 @@ bool ossimGdalTileSource::open()
    theTile->initialize();
    theSingleBandTile->initialize();
 
-   theGdalBuffer.resize(0);
-   if(theIsComplexFlag)
-   {
-      theGdalBuffer.resize(theSingleBandTile->getSizePerBandInBytes()*2);
-   }
-   
    theImageBound = ossimIrect(0
                               ,0
                               ,GDALGetRasterXSize(theDataset)-1
@@ -483,18 +483,26 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
       return ossimRefPtr<ossimImageData>();
    }
 
+   // Dataset handle and tiles owned by the calling thread.
+   std::shared_ptr<ossimGdalTileSource::ReadContext> readContext = getReadContext();
+   if ( !readContext )
+   {
+      return ossimRefPtr<ossimImageData>();
+   }
+   ossimGdalTileSource::ReadContext& ctx = *readContext;
+
    // Check for intersect.
    ossimIrect imageBound = getBoundingRect(resLevel);
    if(!tileRect.intersects(imageBound))
    {
-      theTile->setImageRectangle(tileRect);
-      theTile->makeBlank();
-      return theTile;
+      ctx.m_tile->setImageRectangle(tileRect);
+      ctx.m_tile->makeBlank();
+      return ctx.m_tile;
    }
 
    if(m_isBlocked)
    {
-      return getTileBlockRead(tileRect, resLevel);
+      return getTileBlockRead(ctx, tileRect, resLevel);
    }
   // Check for overview.
    if(resLevel)
@@ -507,9 +515,20 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
          
       if(theOverview.valid() && theOverview->isValidRLevel(resLevel))
       {
+         //---
+         // The overview reader is shared by all threads and reuses its tile,
+         // so read it under lock and copy into this thread's tile.
+         //---
+         std::unique_lock<std::mutex> lock(m_overviewMutex);
          ossimRefPtr<ossimImageData> tileData = theOverview->getTile(tileRect, resLevel);
-         tileData->setScalarType(getOutputScalarType());
-         return tileData;
+         if ( !tileData.valid() )
+         {
+            return tileData;
+         }
+         ctx.m_tile->setImageRectangle(tileRect);
+         ctx.m_tile->loadTile(tileData.get());
+         ctx.m_tile->setDataObjectStatus(tileData->getDataObjectStatus());
+         return ctx.m_tile;
       }
       
 #if 1
@@ -518,9 +537,9 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
       // ossimGdalTileSource::getNumberOfDecimationLevels has been fixed accordingly.
       // drb - 20110503
       //---
-      else if(GDALGetRasterCount(theDataset))
+      else if(GDALGetRasterCount(ctx.m_dataset))
       {
-         GDALRasterBandH band = GDALGetRasterBand(theDataset, 1);
+         GDALRasterBandH band = GDALGetRasterBand(ctx.m_dataset, 1);
          if(static_cast<int>(resLevel) > GDALGetOverviewCount(band))
          {
             return ossimRefPtr<ossimImageData>();
@@ -530,26 +549,37 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
    }
 
    // Set the rectangle of the tile.
-   theTile->setImageRectangle(tileRect);
+   ctx.m_tile->setImageRectangle(tileRect);
 
    // Compute clip rectangle with respect to the image bounds.
    ossimIrect clipRect   = tileRect.clipToRect(imageBound);
 
-   theSingleBandTile->setImageRectangle(clipRect);
+   ctx.m_singleBandTile->setImageRectangle(clipRect);
 
    if (tileRect.completely_within(clipRect) == false)
    {
       // Not filling whole tile so blank it out first.
-      theTile->makeBlank();
+      ctx.m_tile->makeBlank();
+   }
+
+   //---
+   // Try a single dataset read of all bands straight into the tile buffer.
+   // Pixel interleaved sources then decode each block once instead of once
+   // per band.
+   //---
+   if ( loadTileInterleaved( ctx, clipRect, resLevel ) )
+   {
+      ctx.m_tile->validate();
+      return ctx.m_tile;
    }
 
    // Always blank the single band tile.
-   theSingleBandTile->makeBlank();
+   ctx.m_singleBandTile->makeBlank();
    
    ossim_uint32 anOssimBandIndex = 0;
    ossim_uint32 aGdalBandIndex   = 1;
 
-   ossim_uint32 rasterCount = GDALGetRasterCount(theDataset);
+   ossim_uint32 rasterCount = GDALGetRasterCount(ctx.m_dataset);
    if (m_outputBandList.size() > 0)
    {
       rasterCount = (ossim_uint32) m_outputBandList.size();
@@ -567,7 +597,7 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
       {
          aGdalBandIndex = aBandIndex;
       }
-      GDALRasterBandH aBand = resolveRasterBand( resLevel, aGdalBandIndex );
+      GDALRasterBandH aBand = resolveRasterBand( ctx.m_dataset, resLevel, aGdalBandIndex );
       if ( aBand )
       {
          bool bReadSuccess;
@@ -579,7 +609,7 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
                                          , clipRect.ul().y
                                          , clipRect.width()
                                          , clipRect.height()
-                                         , theSingleBandTile->getBuf()
+                                         , ctx.m_singleBandTile->getBuf()
                                          , clipRect.width()
                                          , clipRect.height()
                                          , theOutputGdtType
@@ -594,13 +624,13 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
                   {
                      if ( m_preservePaletteIndexesFlag )
                      {
-                        theTile->loadBand((void*)theSingleBandTile->getBuf(),
-                                          clipRect, anOssimBandIndex);
+                        ctx.m_tile->loadBand((void*)ctx.m_singleBandTile->getBuf(),
+                                             clipRect, anOssimBandIndex);
                         anOssimBandIndex += 1;
                      }
                      else
                      {
-                        loadIndexTo3BandTile(clipRect, aGdalBandIndex, anOssimBandIndex);
+                        loadIndexTo3BandTile(ctx, clipRect, aGdalBandIndex, anOssimBandIndex);
                         anOssimBandIndex+=3;
                      }
                   }
@@ -614,17 +644,17 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
                {
                   if(theAlphaChannelFlag&&(aGdalBandIndex==rasterCount))
                   {
-                     theTile->nullTileAlpha((ossim_uint8*)theSingleBandTile->getBuf(),
-                                            theSingleBandTile->getImageRectangle(),
-                                            clipRect,
-                                            false);
+                     ctx.m_tile->nullTileAlpha((ossim_uint8*)ctx.m_singleBandTile->getBuf(),
+                                               ctx.m_singleBandTile->getImageRectangle(),
+                                               clipRect,
+                                               false);
                   }
                   else
                   {
                      // Note fix rectangle to represent theBuffer's rect in image space.
-                     theTile->loadBand((void*)theSingleBandTile->getBuf()
-                                       , clipRect
-                                       , anOssimBandIndex);
+                     ctx.m_tile->loadBand((void*)ctx.m_singleBandTile->getBuf()
+                                          , clipRect
+                                          , anOssimBandIndex);
                      ++anOssimBandIndex;
                   }
                }
@@ -642,7 +672,7 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
                                          , clipRect.ul().y
                                          , clipRect.width()
                                          , clipRect.height()
-                                         , &theGdalBuffer.front()
+                                         , &ctx.m_gdalBuffer.front()
                                          , clipRect.width()
                                          , clipRect.height()
                                          , theOutputGdtType
@@ -650,11 +680,11 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
                                          , 0 ) == CE_None) ? true : false;
             if (  bReadSuccess == true )
             {
-               ossim_uint32 byteSize = ossim::scalarSizeInBytes(theSingleBandTile->getScalarType());
+               ossim_uint32 byteSize = ossim::scalarSizeInBytes(ctx.m_singleBandTile->getScalarType());
                ossim_uint32 byteSize2 = byteSize*2;
-               ossim_uint8* complexBufPtr = (ossim_uint8*)(&theGdalBuffer.front()); // start at first real part
-               ossim_uint8* outBufPtr  = (ossim_uint8*)(theSingleBandTile->getBuf());
-               ossim_uint32 idxMax = theSingleBandTile->getWidth()*theSingleBandTile->getHeight();
+               ossim_uint8* complexBufPtr = (ossim_uint8*)(&ctx.m_gdalBuffer.front()); // start at first real part
+               ossim_uint8* outBufPtr  = (ossim_uint8*)(ctx.m_singleBandTile->getBuf());
+               ossim_uint32 idxMax = ctx.m_singleBandTile->getWidth()*ctx.m_singleBandTile->getHeight();
                ossim_uint32 idx = 0;
                for(idx = 0; idx < idxMax; ++idx)
                {
@@ -662,21 +692,21 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
                   complexBufPtr += byteSize2;
                   outBufPtr     += byteSize;
                }
-               theTile->loadBand((void*)theSingleBandTile->getBuf()
-                                 , clipRect
-                                 , anOssimBandIndex);
+               ctx.m_tile->loadBand((void*)ctx.m_singleBandTile->getBuf()
+                                    , clipRect
+                                    , anOssimBandIndex);
                ++anOssimBandIndex;
-               complexBufPtr = (ossim_uint8*)(&theGdalBuffer.front()) + byteSize; // start at first imaginary part
-               outBufPtr  = (ossim_uint8*)(theSingleBandTile->getBuf());
+               complexBufPtr = (ossim_uint8*)(&ctx.m_gdalBuffer.front()) + byteSize; // start at first imaginary part
+               outBufPtr  = (ossim_uint8*)(ctx.m_singleBandTile->getBuf());
                for(idx = 0; idx < idxMax; ++idx)
                {
                   memcpy(outBufPtr, complexBufPtr, byteSize);
                   complexBufPtr += byteSize2;
                   outBufPtr     += byteSize;
                }
-               theTile->loadBand((void*)theSingleBandTile->getBuf()
-                                 , clipRect
-                                 , anOssimBandIndex);
+               ctx.m_tile->loadBand((void*)ctx.m_singleBandTile->getBuf()
+                                    , clipRect
+                                    , anOssimBandIndex);
                ++anOssimBandIndex;
             }
             else
@@ -687,16 +717,100 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTile(const  ossimIrect& tile
       }
    }
 
-   theTile->validate();
-   return theTile;
+   ctx.m_tile->validate();
+   return ctx.m_tile;
 }
 
-ossimRefPtr<ossimImageData> ossimGdalTileSource::getTileBlockRead(const ossimIrect& tileRect,
+bool ossimGdalTileSource::loadTileInterleaved(ReadContext& ctx,
+                                              const ossimIrect& clipRect,
+                                              ossim_uint32 resLevel)
+{
+   //---
+   // Only straight band to band copies qualify.  Complex, palette and alpha
+   // handling as well as gdal overviews (no dataset handle) take the per
+   // band path.
+   //---
+   if ( resLevel || theIsComplexFlag || theAlphaChannelFlag || !ctx.m_tile.valid() )
+   {
+      return false;
+   }
+
+   std::vector<int> bandMap;
+   if (m_outputBandList.size() > 0)
+   {
+      for (ossim_uint32 i = 0; i < m_outputBandList.size(); ++i)
+      {
+         bandMap.push_back( (int)m_outputBandList[i] + 1 );
+      }
+   }
+   else
+   {
+      int rasterCount = GDALGetRasterCount(ctx.m_dataset);
+      for (int i = 1; i <= rasterCount; ++i)
+      {
+         bandMap.push_back( i );
+      }
+   }
+
+   if ( bandMap.empty() || bandMap.size() != ctx.m_tile->getNumberOfBands() )
+   {
+      return false;
+   }
+   for (ossim_uint32 i = 0; i < bandMap.size(); ++i)
+   {
+      if ( isIndexed( bandMap[i] ) )
+      {
+         return false;
+      }
+   }
+
+   int typeSize = GDALGetDataTypeSize(theOutputGdtType) / 8;
+   if ( typeSize != (int)ossim::scalarSizeInBytes( ctx.m_tile->getScalarType() ) )
+   {
+      return false;
+   }
+
+   //---
+   // Point at the clip rectangle's origin inside the tile and let the
+   // spacing arguments lay the bands out BSQ in the tile's own buffer.
+   //---
+   ossimIrect tileRect = ctx.m_tile->getImageRectangle();
+   int tileWidth  = (int)tileRect.width();
+   int tileHeight = (int)tileRect.height();
+   ossim_uint8* buf = (ossim_uint8*)ctx.m_tile->getBuf();
+   if ( !buf )
+   {
+      return false;
+   }
+   buf += ( (ossim_int64)(clipRect.ul().y - tileRect.ul().y) * tileWidth +
+            (clipRect.ul().x - tileRect.ul().x) ) * typeSize;
+
+   CPLErr err = GDALDatasetRasterIO( ctx.m_dataset,
+                                     GF_Read,
+                                     clipRect.ul().x,
+                                     clipRect.ul().y,
+                                     clipRect.width(),
+                                     clipRect.height(),
+                                     buf,
+                                     clipRect.width(),
+                                     clipRect.height(),
+                                     theOutputGdtType,
+                                     (int)bandMap.size(),
+                                     &bandMap.front(),
+                                     typeSize,
+                                     tileWidth * typeSize,
+                                     tileWidth * tileHeight * typeSize );
+
+   return ( err == CE_None );
+}
+
+ossimRefPtr<ossimImageData> ossimGdalTileSource::getTileBlockRead(ReadContext& ctx,
+                                                                  const ossimIrect& tileRect,
                                                                   ossim_uint32 resLevel)
 {
    ossimRefPtr<ossimImageData> result;
    ossimIrect imageBound = getBoundingRect(resLevel);
-   theTile->setImageRectangle(tileRect);
+   ctx.m_tile->setImageRectangle(tileRect);
    
    // Compute clip rectangle with respect to the image bounds.
    ossimIrect clipRect   = tileRect.clipToRect(imageBound);
@@ -704,12 +818,12 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTileBlockRead(const ossimIre
    if (tileRect.completely_within(clipRect) == false)
    {
       // Not filling whole tile so blank it out first.
-      theTile->makeBlank();
+      ctx.m_tile->makeBlank();
    }
    if(m_isBlocked)
    {
       int xSize=0, ySize=0;
-      GDALGetBlockSize(resolveRasterBand( resLevel, 1 ),
+      GDALGetBlockSize(resolveRasterBand( ctx.m_dataset, resLevel, 1 ),
                        &xSize,
                        &ySize);
       ossimIrect blockRect = clipRect;
@@ -723,7 +837,7 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTileBlockRead(const ossimIre
       ossim_int64 maxx = blockRect.lr().x;
       ossim_int64 maxy = blockRect.lr().y;
       ossim_uint32 aGdalBandIndex   = 1;
-      ossim_uint32 rasterCount = GDALGetRasterCount(theDataset);
+      ossim_uint32 rasterCount = GDALGetRasterCount(ctx.m_dataset);
       if (m_outputBandList.size() > 0)
       {
          rasterCount = m_outputBandList.size();
@@ -741,7 +855,7 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTileBlockRead(const ossimIre
             if(!cacheTile.valid())
             {
                ossimIrect rect(origin.x,origin.y,origin.x+xSize-1, origin.y+ySize-1);
-               theSingleBandTile->setImageRectangle(rect);
+               ctx.m_singleBandTile->setImageRectangle(rect);
                ossimIrect validRect = rect.clipToRect(imageBound);
                cacheTile = ossimImageDataFactory::instance()->create(this, this);
                cacheTile->setImageRectangle(validRect);
@@ -757,15 +871,15 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTileBlockRead(const ossimIre
                   {
                      aGdalBandIndex = aBandIndex;
                   }
-                  GDALRasterBandH aBand = resolveRasterBand( resLevel, aGdalBandIndex );
+                  GDALRasterBandH aBand = resolveRasterBand( ctx.m_dataset, resLevel, aGdalBandIndex );
                   if ( aBand )
                   {
                      try{
                         
-                       bool bReadSuccess =  (GDALReadBlock(aBand, x/xSize, y/ySize, theSingleBandTile->getBuf() )== CE_None) ? true : false;
+                       bool bReadSuccess =  (GDALReadBlock(aBand, x/xSize, y/ySize, ctx.m_singleBandTile->getBuf() )== CE_None) ? true : false;
                         if(bReadSuccess)
                         {
-                           cacheTile->loadBand(theSingleBandTile->getBuf(), theSingleBandTile->getImageRectangle(), aBandIndex-1);
+                           cacheTile->loadBand(ctx.m_singleBandTile->getBuf(), ctx.m_singleBandTile->getImageRectangle(), aBandIndex-1);
                         }
                      }
                      catch(...)
@@ -776,8 +890,8 @@ ossimRefPtr<ossimImageData> ossimGdalTileSource::getTileBlockRead(const ossimIre
                cacheTile->validate();
                ossimAppFixedTileCache::instance()->addTile(m_rlevelBlockCache[resLevel], cacheTile.get(), false);
             }
-            theTile->loadTile(cacheTile->getBuf(), cacheTile->getImageRectangle(), OSSIM_BSQ);
-            result = theTile;
+            ctx.m_tile->loadTile(cacheTile->getBuf(), cacheTile->getImageRectangle(), OSSIM_BSQ);
+            result = ctx.m_tile;
          }
       }
    }
@@ -1757,7 +1871,8 @@ ossim_uint32 ossimGdalTileSource::getNumberOfDecimationLevels() const
    return result;
 }
 
-void ossimGdalTileSource::loadIndexTo3BandTile(const ossimIrect& clipRect,
+void ossimGdalTileSource::loadIndexTo3BandTile(ReadContext& ctx,
+                                               const ossimIrect& clipRect,
                                                ossim_uint32 aGdalBandStart,
                                                ossim_uint32 anOssimBandStart)
 {
@@ -1767,7 +1882,7 @@ void ossimGdalTileSource::loadIndexTo3BandTile(const ossimIrect& clipRect,
 
    if ( ( inScalar == OSSIM_UINT8 ) && ( outScalar == OSSIM_UINT8 ) )
    {
-      loadIndexTo3BandTileTemplate(ossim_uint8(0), // input type
+      loadIndexTo3BandTileTemplate(ctx, ossim_uint8(0), // input type
                                    ossim_uint8(0), // output type
                                    clipRect,
                                    aGdalBandStart,
@@ -1775,7 +1890,7 @@ void ossimGdalTileSource::loadIndexTo3BandTile(const ossimIrect& clipRect,
    }
    else if ( ( inScalar == OSSIM_UINT16 ) && ( outScalar == OSSIM_UINT8 ) )
    {
-      loadIndexTo3BandTileTemplate(ossim_uint16(0), // input type
+      loadIndexTo3BandTileTemplate(ctx, ossim_uint16(0), // input type
                                    ossim_uint8(0),  // output type
                                    clipRect,
                                    aGdalBandStart,
@@ -1784,7 +1899,7 @@ void ossimGdalTileSource::loadIndexTo3BandTile(const ossimIrect& clipRect,
 
    else if ( ( inScalar == OSSIM_UINT16 ) && ( outScalar == OSSIM_UINT16 ) )
    {
-      loadIndexTo3BandTileTemplate(ossim_uint16(0), // input type
+      loadIndexTo3BandTileTemplate(ctx, ossim_uint16(0), // input type
                                    ossim_uint16(0),  // output type
                                    clipRect,
                                    aGdalBandStart,
@@ -1792,7 +1907,7 @@ void ossimGdalTileSource::loadIndexTo3BandTile(const ossimIrect& clipRect,
    }
    else if ( ( inScalar == OSSIM_SINT16 ) && ( outScalar == OSSIM_SINT16 ) )
    {
-      loadIndexTo3BandTileTemplate(ossim_sint16(0), // input type
+      loadIndexTo3BandTileTemplate(ctx, ossim_sint16(0), // input type
                                    ossim_sint16(0),  // output type
                                    clipRect,
                                    aGdalBandStart,
@@ -1800,7 +1915,7 @@ void ossimGdalTileSource::loadIndexTo3BandTile(const ossimIrect& clipRect,
    }
    else if ( ( inScalar == OSSIM_FLOAT32 ) && ( outScalar == OSSIM_FLOAT32 ) )
    {
-      loadIndexTo3BandTileTemplate(ossim_float32(0.0), // input type
+      loadIndexTo3BandTileTemplate(ctx, ossim_float32(0.0), // input type
                                    ossim_float32(0.0),  // output type
                                    clipRect,
                                    aGdalBandStart,
@@ -1808,7 +1923,7 @@ void ossimGdalTileSource::loadIndexTo3BandTile(const ossimIrect& clipRect,
    }
    else if ( ( inScalar == OSSIM_FLOAT64 ) && ( outScalar == OSSIM_FLOAT64 ) )
    {
-      loadIndexTo3BandTileTemplate(ossim_float64(0.0), // input type
+      loadIndexTo3BandTileTemplate(ctx, ossim_float64(0.0), // input type
                                    ossim_float64(0.0),  // output type
                                    clipRect,
                                    aGdalBandStart,
@@ -1816,7 +1931,7 @@ void ossimGdalTileSource::loadIndexTo3BandTile(const ossimIrect& clipRect,
    }
    else if ( ( inScalar == OSSIM_FLOAT64 ) && ( outScalar == OSSIM_UINT8 ) )
    {
-      loadIndexTo3BandTileTemplate(ossim_float64(0.0), // input type
+      loadIndexTo3BandTileTemplate(ctx, ossim_float64(0.0), // input type
                                    ossim_uint8(0.0),  // output type
                                    clipRect,
                                    aGdalBandStart,
@@ -1834,15 +1949,16 @@ void ossimGdalTileSource::loadIndexTo3BandTile(const ossimIrect& clipRect,
 }
 
 template<class InputType, class OutputType>
-void ossimGdalTileSource::loadIndexTo3BandTileTemplate(InputType /* in */,
+void ossimGdalTileSource::loadIndexTo3BandTileTemplate(ReadContext& ctx,
+                                                       InputType /* in */,
                                                        OutputType /* out */,
                                                        const ossimIrect& clipRect,
                                                        ossim_uint32 aGdalBandStart,
                                                        ossim_uint32 anOssimBandStart)
 {
-   const InputType* s = reinterpret_cast<const InputType*>(theSingleBandTile->getBuf());
+   const InputType* s = reinterpret_cast<const InputType*>(ctx.m_singleBandTile->getBuf());
    GDALRasterBandH aBand=0;
-   aBand = GDALGetRasterBand(theDataset, aGdalBandStart);
+   aBand = GDALGetRasterBand(ctx.m_dataset, aGdalBandStart);
    GDALColorTableH table = GDALGetRasterColorTable(aBand);
    
    // ossim_uint32 rasterCount = GDALGetRasterCount(theDataset); 
@@ -1852,10 +1968,10 @@ void ossimGdalTileSource::loadIndexTo3BandTileTemplate(InputType /* in */,
       return;
    }
    // Get the width of the buffers.
-   ossim_uint32 s_width = theSingleBandTile->getWidth();
-   ossim_uint32 d_width = theTile->getWidth();
-   ossimIrect src_rect  = theSingleBandTile->getImageRectangle();
-   ossimIrect img_rect  = theTile->getImageRectangle();
+   ossim_uint32 s_width = ctx.m_singleBandTile->getWidth();
+   ossim_uint32 d_width = ctx.m_tile->getWidth();
+   ossimIrect src_rect  = ctx.m_singleBandTile->getImageRectangle();
+   ossimIrect img_rect  = ctx.m_tile->getImageRectangle();
    
    // Move the pointers to the first valid pixel.
    s += (clipRect.ul().y - src_rect.ul().y) * s_width +
@@ -1864,20 +1980,20 @@ void ossimGdalTileSource::loadIndexTo3BandTileTemplate(InputType /* in */,
    ossim_uint32 clipWidth  = clipRect.width();
 
    OutputType* d[3];
-   d[0]= static_cast<OutputType*>(theTile->getBuf(anOssimBandStart));
-   d[1]= static_cast<OutputType*>(theTile->getBuf(anOssimBandStart + 1));
-   d[2]= static_cast<OutputType*>(theTile->getBuf(anOssimBandStart + 2));
+   d[0]= static_cast<OutputType*>(ctx.m_tile->getBuf(anOssimBandStart));
+   d[1]= static_cast<OutputType*>(ctx.m_tile->getBuf(anOssimBandStart + 1));
+   d[2]= static_cast<OutputType*>(ctx.m_tile->getBuf(anOssimBandStart + 2));
 
 #if 0 /* Code shut off to treat all indexes as valid. */   
    OutputType np[3];
-   np[0] = (OutputType)theTile->getNullPix(0);
-   np[1] = (OutputType)theTile->getNullPix(1);
-   np[2] = (OutputType)theTile->getNullPix(2);
+   np[0] = (OutputType)ctx.m_tile->getNullPix(0);
+   np[1] = (OutputType)ctx.m_tile->getNullPix(1);
+   np[2] = (OutputType)ctx.m_tile->getNullPix(2);
    
    OutputType minp[3];
-   minp[0] = (OutputType)theTile->getMinPix(0);
-   minp[1] = (OutputType)theTile->getMinPix(1);
-   minp[2] = (OutputType)theTile->getMinPix(2);
+   minp[0] = (OutputType)ctx.m_tile->getMinPix(0);
+   minp[1] = (OutputType)ctx.m_tile->getMinPix(1);
+   minp[2] = (OutputType)ctx.m_tile->getMinPix(2);
 #endif
    
    ossim_uint32 offset = (clipRect.ul().y - img_rect.ul().y) * d_width +
@@ -2068,7 +2184,14 @@ void ossimGdalTileSource::getMaxSize(ossim_uint32 resLevel,
 GDALRasterBandH ossimGdalTileSource::resolveRasterBand( ossim_uint32 resLevel,
                                                         int aGdalBandIndex ) const
 {
-   GDALRasterBandH aBand = GDALGetRasterBand( theDataset, aGdalBandIndex );
+   return resolveRasterBand( theDataset, resLevel, aGdalBandIndex );
+}
+
+GDALRasterBandH ossimGdalTileSource::resolveRasterBand( GDALDatasetH dataset,
+                                                        ossim_uint32 resLevel,
+                                                        int aGdalBandIndex ) const
+{
+   GDALRasterBandH aBand = GDALGetRasterBand( dataset, aGdalBandIndex );
 
    if( resLevel > 0 )
    {
@@ -2084,6 +2207,151 @@ GDALRasterBandH ossimGdalTileSource::resolveRasterBand( ossim_uint32 resLevel,
    return aBand;
 }
 
+std::string ossimGdalTileSource::getGdalOpenName() const
+{
+   // Same string open() last handed to GDALOpen.
+   if ( theSubDatasets.size() && ( theEntryNumberToRender < theSubDatasets.size() ) )
+   {
+      return theSubDatasets[theEntryNumberToRender].string();
+   }
+   return theImageFile.string();
+}
+
+std::shared_ptr<ossimGdalTileSource::ReadContext> ossimGdalTileSource::getReadContext()
+{
+   //---
+   // Retires the calling thread's contexts when it exits.  Only moves them to
+   // the retired list; the dataset is closed later by a live thread.
+   //---
+   struct ThreadExitHook
+   {
+      ~ThreadExitHook()
+      {
+         std::thread::id threadId = std::this_thread::get_id();
+         for ( std::size_t i = 0; i < m_sets.size(); ++i )
+         {
+            std::shared_ptr<ReadContextSet> set = m_sets[i].lock();
+            if ( set )
+            {
+               std::unique_lock<std::mutex> lock(set->m_mutex);
+               std::map<std::thread::id, std::shared_ptr<ReadContext> >::iterator iter =
+                  set->m_contexts.find(threadId);
+               if ( iter != set->m_contexts.end() )
+               {
+                  set->m_retired.push_back(iter->second);
+                  set->m_contexts.erase(iter);
+               }
+            }
+         }
+      }
+      std::vector<std::weak_ptr<ReadContextSet> > m_sets;
+   };
+   static thread_local ThreadExitHook threadExitHook;
+
+   std::thread::id threadId = std::this_thread::get_id();
+   std::shared_ptr<ReadContextSet> set = m_readContexts;
+
+   std::vector<std::shared_ptr<ReadContext> > retired;
+   std::unique_lock<std::mutex> lock(set->m_mutex);
+   retired.swap(set->m_retired);
+   std::map<std::thread::id, std::shared_ptr<ReadContext> >::const_iterator iter =
+      set->m_contexts.find(threadId);
+   if ( iter != set->m_contexts.end() )
+   {
+      std::shared_ptr<ReadContext> ctx = iter->second;
+      lock.unlock();
+      retired.clear(); // Closes exited threads' datasets outside the lock.
+      return ctx;
+   }
+   lock.unlock();
+   retired.clear();
+
+   std::shared_ptr<ReadContext> ctx = std::make_shared<ReadContext>();
+   if ( threadId == m_openThreadId )
+   {
+      // The thread that opened the image reads through theDataset.
+      ctx->m_dataset        = theDataset;
+      ctx->m_ownsDataset    = false;
+      ctx->m_tile           = theTile;
+      ctx->m_singleBandTile = theSingleBandTile;
+   }
+   else
+   {
+      //---
+      // GDAL dataset handles must not be used by two threads at once so
+      // every other reader thread gets its own.  The GDAL block cache is
+      // process wide so decoded blocks are still shared.
+      //---
+      ctx->m_dataset = GDALOpen( getGdalOpenName().c_str(), GA_ReadOnly );
+      if ( !ctx->m_dataset )
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << "ossimGdalTileSource::getReadContext WARNING: Could not open "
+            << getGdalOpenName() << " for thread reads." << std::endl;
+         return std::shared_ptr<ReadContext>();
+      }
+      ctx->m_ownsDataset = true;
+      ctx->m_tile = ossimImageDataFactory::instance()->create(this, this);
+      ctx->m_singleBandTile = ossimImageDataFactory::instance()->create(
+         this, ( m_preservePaletteIndexesFlag ? getOutputScalarType() : getInputScalarType() ), 1);
+      if ( m_preservePaletteIndexesFlag )
+      {
+         ctx->m_tile->setIndexedFlag(true);
+         ctx->m_singleBandTile->setIndexedFlag(true);
+      }
+      ctx->m_tile->initialize();
+      ctx->m_singleBandTile->initialize();
+   }
+
+   if ( theIsComplexFlag )
+   {
+      ctx->m_gdalBuffer.resize( ctx->m_singleBandTile->getSizePerBandInBytes()*2 );
+   }
+
+   // Drop hooks of destroyed sources and register this one.
+   std::vector<std::weak_ptr<ReadContextSet> >& sets = threadExitHook.m_sets;
+   std::vector<std::weak_ptr<ReadContextSet> >::iterator setIter = sets.begin();
+   while ( setIter != sets.end() )
+   {
+      if ( setIter->expired() )
+      {
+         setIter = sets.erase(setIter);
+      }
+      else
+      {
+         ++setIter;
+      }
+   }
+   sets.push_back(set);
+
+   lock.lock();
+   set->m_contexts[threadId] = ctx;
+
+   if ( traceDebug() )
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossimGdalTileSource::getReadContext DEBUG: read contexts: "
+         << set->m_contexts.size() << std::endl;
+   }
+
+   return ctx;
+}
+
+void ossimGdalTileSource::clearReadContexts()
+{
+   //---
+   // Datasets close as the contexts are released.  A context still in use
+   // by a getTile on another thread closes when that call returns.
+   //---
+   std::map<std::thread::id, std::shared_ptr<ReadContext> > contexts;
+   std::vector<std::shared_ptr<ReadContext> > retired;
+   {
+      std::unique_lock<std::mutex> lock(m_readContexts->m_mutex);
+      contexts.swap(m_readContexts->m_contexts);
+      retired.swap(m_readContexts->m_retired);
+   }
+}
+
 ossimString ossimGdalTileSource::getShortName()const
 {
    ossimString result = "gdal";
@@ -2429,6 +2697,9 @@ void ossimGdalTileSource::setPreservePaletteIndexesFlag(bool flag)
       theSingleBandTile->setIndexedFlag(true);
       theSingleBandTile->initialize();
 
+      // Thread tiles were sized for the old band count and scalar type.
+      clearReadContexts();
+
       if ( m_preservePaletteIndexesFlag && theLut.valid() )
       {
          ossim_int32 nullIndex = theLut->getFirstNullAlphaIndex();
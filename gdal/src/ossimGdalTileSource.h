@@ -23,6 +23,11 @@
 #include <ossim/base/ossimString.h>
 #include <ossim/imaging/ossimImageData.h>
 #include <gdal.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 #include <ossim/imaging/ossimAppFixedTileCache.h>
 
@@ -269,12 +274,53 @@ public:
 private:
 
    /**
+    * @brief Per reader thread state.  GDAL dataset handles are not thread
+    * safe so each thread calling getTile reads through its own handle into
+    * its own tiles.
+    */
+   struct ReadContext
+   {
+      ReadContext()
+         : m_dataset(0), m_ownsDataset(false), m_tile(0), m_singleBandTile(0), m_gdalBuffer()
+      {}
+      ~ReadContext()
+      {
+         if ( m_dataset && m_ownsDataset )
+         {
+            GDALClose( m_dataset );
+         }
+         m_dataset = 0;
+      }
+      GDALDatasetH                m_dataset;
+      bool                        m_ownsDataset;
+      ossimRefPtr<ossimImageData> m_tile;
+      ossimRefPtr<ossimImageData> m_singleBandTile;
+      std::vector<ossim_uint8>    m_gdalBuffer;
+   };
+
+   /**
+    * @brief Read contexts keyed by thread.  Shared with the threads' exit
+    * hooks so a context can be retired after its thread is gone.
+    */
+   struct ReadContextSet
+   {
+      std::mutex m_mutex;
+      std::map<std::thread::id, std::shared_ptr<ReadContext> > m_contexts;
+
+      /** Contexts of exited threads, closed on the next call from a live thread. */
+      std::vector<std::shared_ptr<ReadContext> > m_retired;
+   };
+
+   /**
+    * @param ctx Read context of the calling thread.
+    *
     * @param clipRect The requested tile rectangle clipped  to the image
     * bounds.
     *
     * @param resLevel Reduced resolution level to load from.
     */
-   ossimRefPtr<ossimImageData> getTileBlockRead(const ossimIrect& tileRect,
+   ossimRefPtr<ossimImageData> getTileBlockRead(ReadContext& ctx,
+                                                const ossimIrect& tileRect,
                                                 ossim_uint32 resLevel);
 
    /**
@@ -285,11 +331,28 @@ private:
    ossimString filterSubDatasetsString(const ossimString& subString) const;
    
    void computeMinMax();
-   void loadIndexTo3BandTile(const ossimIrect& clipRect,
+
+   /**
+    * @return Read context of the calling thread, creating it on first use.
+    * The thread that called open() reuses theDataset, theTile and
+    * theSingleBandTile; other threads open their own handle and tiles.
+    * Null if that open fails.
+    */
+   std::shared_ptr<ReadContext> getReadContext();
+
+   /** Closes the per thread dataset handles and drops all read contexts. */
+   void clearReadContexts();
+
+   /** @return Name open() passed to GDALOpen. */
+   std::string getGdalOpenName() const;
+
+   void loadIndexTo3BandTile(ReadContext& ctx,
+                             const ossimIrect& clipRect,
                              ossim_uint32 aGdalBandStart = 1,
                              ossim_uint32 anOssimBandStart = 0);
    template<class InputType, class OutputType>
-   void loadIndexTo3BandTileTemplate(InputType in,
+   void loadIndexTo3BandTileTemplate(ReadContext& ctx,
+                                     InputType in,
                                      OutputType out,
                                      const ossimIrect& clipRect,
                                      ossim_uint32 aGdalBandStart = 1,
@@ -311,6 +374,23 @@ private:
     */
    GDALRasterBandH resolveRasterBand( ossim_uint32 resLevel,
                                       int gdalBandIndex ) const;
+   GDALRasterBandH resolveRasterBand( GDALDatasetH dataset,
+                                      ossim_uint32 resLevel,
+                                      int gdalBandIndex ) const;
+
+   /**
+    * @brief Reads all output bands of clipRect with one GDALDatasetRasterIO
+    * directly into theTile's band buffers.
+    *
+    * theTile's image rectangle must already be set.
+    *
+    * @return true on success, false if the source does not qualify (complex,
+    * indexed, alpha, overview level) or the read failed, in which case the
+    * caller falls back to per band reads.
+    */
+   bool loadTileInterleaved(ReadContext& ctx,
+                            const ossimIrect& clipRect,
+                            ossim_uint32 resLevel);
 
    ossimRefPtr<ossimImageGeometry> getExternalImageGeometryFromXml() const;
    void deleteRlevelCache();
@@ -323,7 +403,6 @@ private:
 
    ossimRefPtr<ossimImageData> theTile;
    ossimRefPtr<ossimImageData> theSingleBandTile;
-   std::vector<ossim_uint8>    theGdalBuffer;
    ossimIrect                  theImageBound;
    mutable GDALDataType        theGdtType;
    mutable GDALDataType        theOutputGdtType;
@@ -339,6 +418,14 @@ private:
    bool                        m_isBlocked;
 
    std::vector<ossimAppFixedTileCache::ossimAppFixedCacheId> m_rlevelBlockCache;
+
+   std::shared_ptr<ReadContextSet> m_readContexts;
+
+   /** Thread that called open(); its reads go through theDataset. */
+   std::thread::id m_openThreadId;
+
+   /** theOverview is not thread safe; held around its getTile. */
+   std::mutex m_overviewMutex;
   
 TYPE_DATA
 };
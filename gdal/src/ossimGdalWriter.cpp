@@ -17,21 +17,28 @@
 #include <ossim/base/ossimListener.h>
 #include <ossim/base/ossimNotify.h>
 #include <ossim/base/ossimNumericProperty.h>
+#include <ossim/base/ossimPreferences.h>
 #include <ossim/base/ossimRefPtr.h>
 #include <ossim/base/ossimStringProperty.h>
+#include <ossim/base/ossimTimer.h>
 #include <ossim/base/ossimTrace.h>
 #include <ossim/base/ossimXmlAttribute.h>
 #include <ossim/base/ossimXmlNode.h>
 #include <ossim/imaging/ossimImageChain.h>
 #include <ossim/imaging/ossimImageGeometry.h>
 #include <ossim/imaging/ossimImageHandler.h>
+#include <ossim/parallel/ossimMultiThreadSequencer.h>
 #include <ossim/projection/ossimMapProjection.h>
 #include <ossim/projection/ossimMapProjectionInfo.h>
 #include <ossim/projection/ossimProjectionFactoryRegistry.h>
 #include <ossim/vpfutil/set.h>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <iterator>
+#include <mutex>
 #include <sstream>
+#include <thread>
 using namespace std;
 
 static int CPL_STDCALL gdalProgressFunc(double percentComplete,
@@ -52,6 +59,9 @@ static int CPL_STDCALL gdalProgressFunc(double percentComplete,
 
 static ossimTrace traceDebug(ossimString("ossimGdalWriter:debug"));
 
+static const char WRITE_THREADS_KW[]     = "ossim.plugins.gdal.writer.threads";
+static const char WRITE_QUEUE_TILES_KW[] = "ossim.plugins.gdal.writer.queueTiles";
+
 RTTI_DEF1(ossimGdalWriter, "ossimGdalWriter", ossimImageFileWriter);
 
 static ossimOgcWktTranslator translator;
@@ -338,6 +348,8 @@ bool ossimGdalWriter::writeFile()
       close();
    }
 
+   useMultiThreadSequencer();
+
    checkColorLut();
 
    //---
@@ -431,9 +443,6 @@ bool ossimGdalWriter::writeFile()
             theInputConnection->setToStartOfSequence();
             ossimRefPtr<ossimImageData> currentTile =
                theInputConnection->getNextTile();
-            ossimRefPtr<ossimImageData> outputTile =
-               (ossimImageData*)currentTile->dup();
-            outputTile->initialize();
 
             //---
             // DRB 20081017
@@ -505,56 +514,9 @@ bool ossimGdalWriter::writeFile()
                }
             }
    
-            ossim_uint32 numberOfTiles =
-               (theInputConnection->getNumberOfTiles()*
-                theInputConnection->getNumberOfOutputBands());
-   
-            ossim_uint32 tileNumber = 0;
-            while(currentTile.valid()&&(!needsAborting()))
+            if ( currentTile.valid() && !writeTiles(currentTile, gdalType) )
             {
-               ossimIrect clipRect =
-                  currentTile->getImageRectangle().clipToRect(theAreaOfInterest);
-               outputTile->setImageRectangle(clipRect);
-               outputTile->loadTile(currentTile.get());
-               //ossimIpt offset = currentTile->getOrigin() -
-               //theAreaOfInterest.ul();
-               ossimIpt offset = clipRect.ul() - theAreaOfInterest.ul();
-      
-               for(ossim_uint32 band = 0;
-                   ((band < (currentTile->getNumberOfBands()))&&
-                    (!needsAborting()));
-                   ++band)
-               {
-                  GDALRasterBandH aBand=0;
-                  aBand = GDALGetRasterBand(theDataset, band+1);
-
-                  if(aBand)
-                  {
-                     GDALRasterIO( aBand,
-                        GF_Write,
-                        offset.x,
-                        offset.y,
-                        clipRect.width(),
-                        clipRect.height(),
-                        outputTile->getBuf(band),
-                        outputTile->getWidth(),
-                        outputTile->getHeight(),
-                        gdalType,
-                        0,
-                        0);
-                  }
-
-                  ++tileNumber;
-                  ossimProcessProgressEvent event(this,
-                                                  ((double)tileNumber/
-                                                   (double)numberOfTiles)*100.0,
-                                                  "",
-                                                  false);
-                  
-                  fireEvent(event);
-               }
-               currentTile = theInputConnection->getNextTile();
-               
+               result = false;
             }
             
             if(theDataset)
@@ -616,6 +578,262 @@ bool ossimGdalWriter::writeFile()
    
 } // End of: ossimGdalWriter::writeFile
 
+void ossimGdalWriter::useMultiThreadSequencer()
+{
+   //---
+   // Chains are not safe for concurrent getTile calls so parallel fetch and
+   // render is done by ossimMultiThreadSequencer, which runs a clone of the
+   // chain per thread and hands tiles back in raster order.
+   //---
+   ossim_uint32 threads = 1;
+   const char* lookup = ossimPreferences::instance()->findPreference(WRITE_THREADS_KW);
+   if ( lookup )
+   {
+      threads = ossimString(lookup).toUInt32();
+   }
+   if ( ( threads > 1 ) && theInputConnection.valid() &&
+        !dynamic_cast<ossimMultiThreadSequencer*>( theInputConnection.get() ) )
+   {
+      changeSequencer( new ossimMultiThreadSequencer(0, threads) );
+
+      if ( traceDebug() )
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossimGdalWriter::useMultiThreadSequencer DEBUG: threads: "
+            << threads << std::endl;
+      }
+   }
+}
+
+bool ossimGdalWriter::writeTiles(ossimRefPtr<ossimImageData> currentTile,
+                                 GDALDataType gdalType)
+{
+   //---
+   // Producer/consumer: this thread pulls tiles from the sequencer while a
+   // writer thread hands them to gdal (where compression happens) in raster
+   // order.  Tiles cycle between a free list and the write queue so at most
+   // queueTiles tiles are in memory.
+   //---
+   ossim_uint32 queueTiles = 16;
+   const char* lookup = ossimPreferences::instance()->findPreference(WRITE_QUEUE_TILES_KW);
+   if ( lookup )
+   {
+      queueTiles = ossimString(lookup).toUInt32();
+   }
+   if ( queueTiles < 2 )
+   {
+      queueTiles = 2;
+   }
+
+   const ossim_uint32 bandCount = currentTile->getNumberOfBands();
+   std::vector<int> bandMap(bandCount);
+   for ( ossim_uint32 band = 0; band < bandCount; ++band )
+   {
+      bandMap[band] = (int)band + 1;
+   }
+   const int typeSize = GDALGetDataTypeSize(gdalType) / 8;
+
+   std::mutex queueMutex;
+   std::condition_variable queueCondition;
+   std::deque< ossimRefPtr<ossimImageData> > writeQueue;
+   std::vector< ossimRefPtr<ossimImageData> > freeTiles;
+   ossim_uint32 allocatedTiles = 0;
+   bool producerDone = false;
+   bool stopWriting  = false;
+   bool writeFailed  = false;
+   ossim_uint64 tilesWritten = 0;
+   ossim_uint64 bytesWritten = 0;
+
+   GDALDatasetH dataset = theDataset;
+   std::thread writerThread;
+
+   //---
+   // Stops and joins the writer thread on every exit so an exception from
+   // the sequencer or a tile copy never destroys a joinable std::thread.
+   // Leaving by exception drops whatever is still queued.
+   //---
+   struct WriterGuard
+   {
+      WriterGuard( std::mutex& queueMutex,
+                   std::condition_variable& queueCondition,
+                   bool& producerDone,
+                   bool& stopWriting,
+                   std::thread& writerThread )
+         : m_queueMutex( queueMutex ),
+           m_queueCondition( queueCondition ),
+           m_producerDone( producerDone ),
+           m_stopWriting( stopWriting ),
+           m_writerThread( writerThread )
+      {}
+      ~WriterGuard()
+      {
+         join( true );
+      }
+      void join( bool stop )
+      {
+         {
+            std::unique_lock<std::mutex> lock( m_queueMutex );
+            m_producerDone = true;
+            if ( stop )
+            {
+               m_stopWriting = true;
+            }
+            m_queueCondition.notify_all();
+         }
+         if ( m_writerThread.joinable() )
+         {
+            m_writerThread.join();
+         }
+      }
+      std::mutex&              m_queueMutex;
+      std::condition_variable& m_queueCondition;
+      bool&                    m_producerDone;
+      bool&                    m_stopWriting;
+      std::thread&             m_writerThread;
+   };
+   WriterGuard writerGuard( queueMutex, queueCondition, producerDone,
+                            stopWriting, writerThread );
+
+   writerThread = std::thread( [&]()
+   {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      while ( true )
+      {
+         queueCondition.wait( lock, [&]()
+                              { return stopWriting || producerDone || !writeQueue.empty(); } );
+         if ( stopWriting || ( writeQueue.empty() && producerDone ) )
+         {
+            break;
+         }
+
+         ossimRefPtr<ossimImageData> tile = writeQueue.front();
+         writeQueue.pop_front();
+         lock.unlock();
+
+         ossimIrect clipRect = tile->getImageRectangle();
+         ossimIpt offset = clipRect.ul() - theAreaOfInterest.ul();
+         int width  = (int)clipRect.width();
+         int height = (int)clipRect.height();
+         CPLErr err = GDALDatasetRasterIO( dataset,
+                                           GF_Write,
+                                           offset.x,
+                                           offset.y,
+                                           width,
+                                           height,
+                                           tile->getBuf(),
+                                           width,
+                                           height,
+                                           gdalType,
+                                           (int)bandCount,
+                                           &bandMap.front(),
+                                           typeSize,
+                                           width * typeSize,
+                                           width * height * typeSize );
+
+         lock.lock();
+         if ( err != CE_None )
+         {
+            writeFailed = true;
+            stopWriting = true;
+         }
+         else
+         {
+            ++tilesWritten;
+            bytesWritten += (ossim_uint64)width * height * typeSize * bandCount;
+         }
+         freeTiles.push_back( tile );
+         queueCondition.notify_all();
+      }
+   } );
+
+   ossim_uint64 numberOfTiles = theInputConnection->getNumberOfTiles();
+   ossim_uint64 tileNumber = 0;
+   ossimTimer::Timer_t startTime = ossimTimer::instance()->tick();
+
+   while ( currentTile.valid() && !needsAborting() )
+   {
+      ossimRefPtr<ossimImageData> outputTile;
+      {
+         std::unique_lock<std::mutex> lock(queueMutex);
+         queueCondition.wait( lock, [&]()
+                              { return stopWriting || !freeTiles.empty() ||
+                                   ( allocatedTiles < queueTiles ); } );
+         if ( stopWriting )
+         {
+            break;
+         }
+         if ( !freeTiles.empty() )
+         {
+            outputTile = freeTiles.back();
+            freeTiles.pop_back();
+         }
+         else
+         {
+            ++allocatedTiles;
+         }
+      }
+      if ( !outputTile.valid() )
+      {
+         outputTile = (ossimImageData*)currentTile->dup();
+         outputTile->initialize();
+      }
+
+      ossimIrect clipRect =
+         currentTile->getImageRectangle().clipToRect(theAreaOfInterest);
+      outputTile->setImageRectangle(clipRect);
+      outputTile->loadTile(currentTile.get());
+
+      ossim_uint64 written = 0;
+      {
+         std::unique_lock<std::mutex> lock(queueMutex);
+         writeQueue.push_back( outputTile );
+         written = tilesWritten;
+         queueCondition.notify_all();
+      }
+
+      ++tileNumber;
+      ossimProcessProgressEvent event(this,
+                                      ((double)written/(double)numberOfTiles)*100.0,
+                                      "",
+                                      false);
+      fireEvent(event);
+
+      currentTile = theInputConnection->getNextTile();
+   }
+
+   // Drop whatever is still queued if aborting.
+   writerGuard.join( needsAborting() );
+
+   double seconds = ossimTimer::instance()->delta_s( startTime, ossimTimer::instance()->tick() );
+   if ( traceDebug() )
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossimGdalWriter::writeTiles DEBUG:"
+         << "\ntiles read:    " << tileNumber
+         << "\ntiles written: " << tilesWritten
+         << "\nqueue tiles:   " << queueTiles
+         << "\nseconds:       " << seconds
+         << "\ntiles/second:  " << ( seconds > 0.0 ? tilesWritten/seconds : 0.0 )
+         << "\nMB/second:     "
+         << ( seconds > 0.0 ? bytesWritten/(seconds*1024.0*1024.0) : 0.0 )
+         << std::endl;
+   }
+
+   if ( writeFailed )
+   {
+      ossimNotify(ossimNotifyLevel_WARN)
+         << "ossimGdalWriter::writeTiles WARNING: GDALDatasetRasterIO failed after "
+         << tilesWritten << " tiles." << std::endl;
+   }
+   else if ( !needsAborting() )
+   {
+      ossimProcessProgressEvent event(this, 100.0, "", false);
+      fireEvent(event);
+   }
+
+   return !writeFailed;
+}
+
 bool ossimGdalWriter::writeBlockFile()
 {
    theInputConnection->setAreaOfInterest(theAreaOfInterest);
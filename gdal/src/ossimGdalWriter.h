@@ -83,6 +83,25 @@ public:
 protected:
    virtual bool writeFile();
    virtual bool writeBlockFile();
+
+   /**
+    * @brief Writes currentTile and the rest of the sequence to theDataset.
+    *
+    * Tiles are fetched on the calling thread and written by a separate
+    * writer thread with one GDALDatasetRasterIO per tile, through a queue
+    * bounded by the ossim.plugins.gdal.writer.queueTiles preference.
+    *
+    * @param currentTile First tile of the sequence.
+    * @param gdalType Data type of theDataset.
+    * @return true on success, false if a gdal write failed.
+    */
+   bool writeTiles(ossimRefPtr<ossimImageData> currentTile, GDALDataType gdalType);
+
+   /**
+    * @brief Swaps in an ossimMultiThreadSequencer when the
+    * ossim.plugins.gdal.writer.threads preference is greater than one.
+    */
+   void useMultiThreadSequencer();
    virtual void writeProjectionInfo(GDALDatasetH dataset);
    
    virtual void writeColorMap(int bands);
@@ -14,7 +14,10 @@
 #include "ossimKmlSuperOverlayReader.h"
 
 //Std Includes
+#include <algorithm>
+#include <cmath>
 #include <cstring> /* strdup */
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -31,6 +34,11 @@
 #include <ossim/base/ossimFilename.h>
 #include <ossim/base/ossimKeywordlist.h>
 #include <ossim/base/ossimKeywordNames.h>
+#include <ossim/base/ossimPreferences.h>
+#include <ossim/imaging/ossimCodecBase.h>
+#include <ossim/imaging/ossimCodecFactoryRegistry.h>
+#include <ossim/imaging/ossimImageData.h>
+#include <ossim/imaging/ossimImageDataFactory.h>
 #include <ossim/imaging/ossimImageGeometry.h>
 #include <ossim/projection/ossimProjectionFactoryRegistry.h>
 #include <ossim/projection/ossimEquDistCylProjection.h>
@@ -39,14 +47,244 @@ RTTI_DEF1(ossimKmlSuperOverlayReader, "ossimKmlSuperOverlayReader", ossimImageHa
 
 static ossimTrace traceDebug("ossimKmlSuperOverlayReader:debug");
 
+static const char CACHE_IMAGES_KW[] = "ossim.plugins.kml.reader.cache_images";
+
+namespace
+{
+   // Tag without namespace prefix, e.g. "gx:LatLonQuad" -> "latlonquad".
+   ossimString localTag(const ossimRefPtr<ossimXmlNode>& node)
+   {
+      std::string tag = node->getTag().downcase().string();
+      std::string::size_type colon = tag.find(':');
+      return (colon == std::string::npos) ? ossimString(tag) : ossimString(tag.substr(colon+1));
+   }
+
+   // Finds the nodes named tag below node without descending into matches.
+   void findTagged(const ossimRefPtr<ossimXmlNode>& node,
+                   const ossimString& tag,
+                   std::vector<ossimRefPtr<ossimXmlNode> >& result)
+   {
+      const ossimXmlNode::ChildListType& children = node->getChildNodes();
+      for (ossim_uint32 i = 0; i < children.size(); ++i)
+      {
+         if (localTag(children[i]) == tag)
+         {
+            result.push_back(children[i]);
+         }
+         else
+         {
+            findTagged(children[i], tag, result);
+         }
+      }
+   }
+
+   ossimRefPtr<ossimXmlNode> findFirstTagged(const ossimRefPtr<ossimXmlNode>& node,
+                                             const ossimString& tag)
+   {
+      const ossimXmlNode::ChildListType& children = node->getChildNodes();
+      for (ossim_uint32 i = 0; i < children.size(); ++i)
+      {
+         if (localTag(children[i]) == tag)
+         {
+            return children[i];
+         }
+         ossimRefPtr<ossimXmlNode> found = findFirstTagged(children[i], tag);
+         if (found.valid())
+         {
+            return found;
+         }
+      }
+      return 0;
+   }
+
+   // Reads north, south, east and west children of a LatLonAltBox or LatLonBox.
+   bool readBox(const ossimRefPtr<ossimXmlNode>& node,
+                ossim_float64& north, ossim_float64& south,
+                ossim_float64& east, ossim_float64& west)
+   {
+      ossim_uint32 found = 0;
+      const ossimXmlNode::ChildListType& children = node->getChildNodes();
+      for (ossim_uint32 i = 0; i < children.size(); ++i)
+      {
+         ossimString tag = localTag(children[i]);
+         if (tag == "north")
+         {
+            north = children[i]->getText().toFloat64();
+            ++found;
+         }
+         else if (tag == "south")
+         {
+            south = children[i]->getText().toFloat64();
+            ++found;
+         }
+         else if (tag == "east")
+         {
+            east = children[i]->getText().toFloat64();
+            ++found;
+         }
+         else if (tag == "west")
+         {
+            west = children[i]->getText().toFloat64();
+            ++found;
+         }
+      }
+      return (found == 4) && (north > south) && (east > west);
+   }
+
+   // Bounding box of the "lon,lat[,alt]" tuples of a gx:LatLonQuad.
+   bool readQuad(const ossimRefPtr<ossimXmlNode>& node,
+                 ossim_float64& north, ossim_float64& south,
+                 ossim_float64& east, ossim_float64& west)
+   {
+      ossimRefPtr<ossimXmlNode> coordinates = findFirstTagged(node, "coordinates");
+      if (!coordinates.valid())
+      {
+         return false;
+      }
+      std::string text = coordinates->getText().string();
+      std::replace(text.begin(), text.end(), ',', ' ');
+      std::istringstream in(text);
+      ossim_uint32 points = 0;
+      ossim_float64 lon, lat, alt;
+      while (in >> lon >> lat >> alt)
+      {
+         if (points == 0)
+         {
+            north = south = lat;
+            east = west = lon;
+         }
+         north = std::max(north, lat);
+         south = std::min(south, lat);
+         east  = std::max(east, lon);
+         west  = std::min(west, lon);
+         ++points;
+      }
+      return (points >= 4) && (north > south) && (east > west);
+   }
+
+   // Resolves href against the directory of the document at base.
+   std::string resolvePath(const std::string& base, const std::string& href)
+   {
+      if (href.empty() || (href.find("://") != std::string::npos))
+      {
+         return std::string();
+      }
+
+      std::string path = href;
+      std::string::size_type slash = base.rfind('/');
+      if ((href[0] != '/') && (slash != std::string::npos))
+      {
+         path = base.substr(0, slash+1) + href;
+      }
+
+      std::vector<std::string> parts;
+      std::istringstream in(path);
+      std::string part;
+      while (std::getline(in, part, '/'))
+      {
+         if (part == "..")
+         {
+            if (parts.empty())
+            {
+               return std::string();
+            }
+            parts.pop_back();
+         }
+         else if (!part.empty() && (part != "."))
+         {
+            parts.push_back(part);
+         }
+      }
+
+      std::string result;
+      for (ossim_uint32 i = 0; i < parts.size(); ++i)
+      {
+         if (i) result += "/";
+         result += parts[i];
+      }
+      return result;
+   }
+
+   // Nearest neighbor copy of an overlay image covering box into tile.
+   template <class T>
+   void copyOverlay(const ossimImageData* image,
+                    ossim_float64 north, ossim_float64 south,
+                    ossim_float64 east, ossim_float64 west,
+                    ossim_float64 originNorth, ossim_float64 originWest,
+                    const ossimDpt& degreesPerPixel,
+                    ossimImageData* tile)
+   {
+      const ossimIrect rect = tile->getImageRectangle();
+      const ossim_int32 width = (ossim_int32)tile->getWidth();
+      const ossim_int32 height = (ossim_int32)tile->getHeight();
+      const ossim_int32 imageWidth = (ossim_int32)image->getWidth();
+      const ossim_int32 imageHeight = (ossim_int32)image->getHeight();
+      const ossim_uint32 bands = std::min(image->getNumberOfBands(), tile->getNumberOfBands());
+      const ossim_float64 xScale = imageWidth / (east - west);
+      const ossim_float64 yScale = imageHeight / (north - south);
+
+      std::vector<ossim_int32> columns(width, -1);
+      for (ossim_int32 x = 0; x < width; ++x)
+      {
+         ossim_float64 lon = originWest + (rect.ul().x + x + 0.5) * degreesPerPixel.x;
+         if ((lon >= west) && (lon < east))
+         {
+            columns[x] = std::min((ossim_int32)((lon - west) * xScale), imageWidth - 1);
+         }
+      }
+
+      for (ossim_int32 y = 0; y < height; ++y)
+      {
+         ossim_float64 lat = originNorth - (rect.ul().y + y + 0.5) * degreesPerPixel.y;
+         if ((lat > north) || (lat <= south))
+         {
+            continue;
+         }
+         ossim_int32 row = std::min((ossim_int32)((north - lat) * yScale), imageHeight - 1);
+         for (ossim_uint32 band = 0; band < bands; ++band)
+         {
+            const T* src = static_cast<const T*>(image->getBuf(band)) + row * imageWidth;
+            T* dest = static_cast<T*>(tile->getBuf(band)) + y * width;
+            for (ossim_int32 x = 0; x < width; ++x)
+            {
+               if (columns[x] >= 0)
+               {
+                  dest[x] = src[columns[x]];
+               }
+            }
+         }
+      }
+   }
+}
+
 //*******************************************************************
 // Public Constructor:
 //*******************************************************************
 ossimKmlSuperOverlayReader::ossimKmlSuperOverlayReader()
    :ossimImageHandler(),
    m_xmlDocument(0),
-   theImageBound()
+   theImageBound(),
+   m_unzipFile(0),
+   m_rootPath(),
+   m_nodes(),
+   m_maxDepth(-1),
+   m_north(0.0),
+   m_west(0.0),
+   m_degreesPerPixel(0.0, 0.0),
+   m_bands(0),
+   m_scalarType(OSSIM_SCALAR_UNKNOWN),
+   m_tile(0),
+   m_jpegCodec(0),
+   m_pngCodec(0),
+   m_imageLru(),
+   m_imageCache(),
+   m_maxCachedImages(64)
 {
+   const char* lookup = ossimPreferences::instance()->findPreference(CACHE_IMAGES_KW);
+   if (lookup)
+   {
+      m_maxCachedImages = ossimString(lookup).toUInt32();
+   }
 }
 
 //*******************************************************************
@@ -81,6 +319,7 @@ bool ossimKmlSuperOverlayReader::open()
    else
    {
       m_xmlDocument = new ossimXmlDocument(theImageFile);
+      m_rootPath = theImageFile.file().string();
    }
 
    if ( m_xmlDocument.valid() )
@@ -109,8 +348,21 @@ bool ossimKmlSuperOverlayReader::open()
 
          if (!theImageGeometry.valid())
          {
-            theImageGeometry = new ossimImageGeometry(0, createDefaultProj(north, south, east, west));
-            if (theImageGeometry.valid())
+            if (initializeLevels(north, south, east, west))
+            {
+               theImageGeometry = new ossimImageGeometry(
+                  0, createDefaultProj(north, south, east, west, m_degreesPerPixel));
+
+               ossim_int32 samples = (ossim_int32)std::ceil((east - west) / m_degreesPerPixel.x - 0.5);
+               ossim_int32 lines = (ossim_int32)std::ceil((north - south) / m_degreesPerPixel.y - 0.5);
+               theImageBound = ossimDrect(0, 0, std::max(samples, 1) - 1, std::max(lines, 1) - 1);
+            }
+            else
+            {
+               theImageGeometry = new ossimImageGeometry(0, createDefaultProj(north, south, east, west));
+            }
+
+            if (theImageGeometry.valid() && (m_maxDepth < 0))
             {
                result = true;
 
@@ -140,7 +392,7 @@ bool ossimKmlSuperOverlayReader::open()
             }
             else
             {
-               result = false;
+               result = theImageGeometry.valid();
             }
          }
       }
@@ -189,22 +441,116 @@ void ossimKmlSuperOverlayReader::close()
    {
       m_xmlDocument = 0;
    }
+   if (m_unzipFile)
+   {
+      unzClose(static_cast<unzFile>(m_unzipFile));
+      m_unzipFile = 0;
+   }
+   m_rootPath.clear();
+   m_nodes.clear();
+   m_maxDepth = -1;
+   m_bands = 0;
+   m_scalarType = OSSIM_SCALAR_UNKNOWN;
+   m_tile = 0;
+   m_imageLru.clear();
+   m_imageCache.clear();
 }
 
 ossimRefPtr<ossimImageData> ossimKmlSuperOverlayReader::getTile(
-   const ossimIrect& /* tileRect */, ossim_uint32 /* resLevel */)
+   const ossimIrect& tileRect, ossim_uint32 resLevel)
 {
-   return 0;
+   if (m_maxDepth < 0)
+   {
+      return 0;
+   }
+
+   if (!m_tile.valid())
+   {
+      m_tile = ossimImageDataFactory::instance()->create(this, this);
+      if (!m_tile.valid())
+      {
+         return 0;
+      }
+   }
+   m_tile->setImageRectangle(tileRect);
+   m_tile->initialize();
+   m_tile->makeBlank();
+
+   if (resLevel > (ossim_uint32)m_maxDepth)
+   {
+      return m_tile;
+   }
+
+   // Level of detail m_maxDepth is full resolution; each level up halves it.
+   ossimDpt degreesPerPixel = m_degreesPerPixel * (ossim_float64)(1 << resLevel);
+   Box box;
+   box.m_north = m_north - tileRect.ul().y * degreesPerPixel.y;
+   box.m_south = m_north - (tileRect.lr().y + 1) * degreesPerPixel.y;
+   box.m_west  = m_west + tileRect.ul().x * degreesPerPixel.x;
+   box.m_east  = m_west + (tileRect.lr().x + 1) * degreesPerPixel.x;
+
+   std::vector<ossim_uint32> nodes;
+   findNodes(0, m_maxDepth - (ossim_int32)resLevel, box, nodes);
+
+   for (ossim_uint32 i = 0; i < nodes.size(); ++i)
+   {
+      const OverlayNode& node = m_nodes[nodes[i]];
+      ossimRefPtr<ossimImageData> image = getOverlayImage(node.m_image);
+      if (!image.valid() || (image->getScalarType() != m_scalarType) ||
+          !image->getWidth() || !image->getHeight())
+      {
+         continue;
+      }
+
+      const Box& imageBox = node.m_imageBox;
+      switch (m_scalarType)
+      {
+         case OSSIM_UINT8:
+         {
+            copyOverlay<ossim_uint8>(image.get(),
+                                     imageBox.m_north, imageBox.m_south,
+                                     imageBox.m_east, imageBox.m_west,
+                                     m_north, m_west, degreesPerPixel, m_tile.get());
+            break;
+         }
+         case OSSIM_UINT16:
+         case OSSIM_USHORT11:
+         case OSSIM_USHORT12:
+         case OSSIM_USHORT13:
+         case OSSIM_USHORT14:
+         case OSSIM_USHORT15:
+         {
+            copyOverlay<ossim_uint16>(image.get(),
+                                      imageBox.m_north, imageBox.m_south,
+                                      imageBox.m_east, imageBox.m_west,
+                                      m_north, m_west, degreesPerPixel, m_tile.get());
+            break;
+         }
+         default:
+         {
+            break;
+         }
+      }
+   }
+
+   m_tile->validate();
+   return m_tile;
 }
 
 ossim_uint32 ossimKmlSuperOverlayReader::getNumberOfInputBands() const
 {
-   return 0;
+   return m_bands;
 }
 
 ossim_uint32 ossimKmlSuperOverlayReader::getNumberOfOutputBands() const
 {
-   return 0;
+   return m_bands;
+}
+
+ossim_uint32 ossimKmlSuperOverlayReader::getNumberOfDecimationLevels() const
+{
+   return (m_maxDepth < 0) ? ossimImageHandler::getNumberOfDecimationLevels() :
+      (ossim_uint32)(m_maxDepth + 1);
 }
 
 ossim_uint32 ossimKmlSuperOverlayReader::getImageTileHeight() const
@@ -217,19 +563,35 @@ ossim_uint32 ossimKmlSuperOverlayReader::getImageTileWidth() const
    return 0;
 }
 
-ossim_uint32 ossimKmlSuperOverlayReader::getNumberOfLines(ossim_uint32 /* reduced_res_level */ ) const
+ossim_uint32 ossimKmlSuperOverlayReader::getNumberOfLines(ossim_uint32 reduced_res_level) const
 {
-   return theImageBound.height();
+   if (m_maxDepth < 0)
+   {
+      return theImageBound.height();
+   }
+   ossim_uint32 lines = ossimIrect(theImageBound).height();
+   return (lines + (1 << reduced_res_level) - 1) >> reduced_res_level;
 }
 
-ossim_uint32 ossimKmlSuperOverlayReader::getNumberOfSamples(ossim_uint32 /* reduced_res_level */ ) const
+ossim_uint32 ossimKmlSuperOverlayReader::getNumberOfSamples(ossim_uint32 reduced_res_level) const
 { 
-   return theImageBound.width();
+   if (m_maxDepth < 0)
+   {
+      return theImageBound.width();
+   }
+   ossim_uint32 samples = ossimIrect(theImageBound).width();
+   return (samples + (1 << reduced_res_level) - 1) >> reduced_res_level;
 }
 
-ossimIrect ossimKmlSuperOverlayReader::getImageRectangle(ossim_uint32 /* reduced_res_level */ ) const
+ossimIrect ossimKmlSuperOverlayReader::getImageRectangle(ossim_uint32 reduced_res_level) const
 {
-   return theImageBound;
+   if (m_maxDepth < 0)
+   {
+      return theImageBound;
+   }
+   return ossimIrect(0, 0,
+                     getNumberOfSamples(reduced_res_level) - 1,
+                     getNumberOfLines(reduced_res_level) - 1);
 }
 
 ossimRefPtr<ossimImageGeometry> ossimKmlSuperOverlayReader::getImageGeometry()
@@ -239,7 +601,7 @@ ossimRefPtr<ossimImageGeometry> ossimKmlSuperOverlayReader::getImageGeometry()
 
 ossimScalarType ossimKmlSuperOverlayReader::getOutputScalarType() const
 {
-   return OSSIM_SCALAR_UNKNOWN;
+   return m_scalarType;
 }
 
 bool ossimKmlSuperOverlayReader::isOpen()const
@@ -362,77 +724,336 @@ ossimMapProjection* ossimKmlSuperOverlayReader::createDefaultProj(ossim_float64
    return proj;
 }
 
+ossimMapProjection* ossimKmlSuperOverlayReader::createDefaultProj(ossim_float64 north, 
+                                                                  ossim_float64 south, 
+                                                                  ossim_float64 east, 
+                                                                  ossim_float64 west,
+                                                                  const ossimDpt& degreesPerPixel)
+{
+   ossimEquDistCylProjection* proj = new ossimEquDistCylProjection;
+
+   ossimGpt origin((south + north) / 2.0, (west + east) / 2.0, 0.0);
+   proj->setOrigin(origin);
+
+   // Tie point is the center of the upper left pixel.
+   proj->setUlGpt( ossimGpt(north - degreesPerPixel.y / 2.0, west + degreesPerPixel.x / 2.0) );
+   proj->setDecimalDegreesPerPixel(degreesPerPixel);
+
+   return proj;
+}
+
 bool ossimKmlSuperOverlayReader::getTopLevelKmlFileInfo()
 {
-   theImageFile.rename(ossimString(theImageFile.noExtension() + ".zip"));
-   ossimFilename tmpZipfile = ossimString(theImageFile.noExtension() + ".zip");
-   unzFile unzipfile = unzOpen(tmpZipfile.c_str());
+   // The kmz stays open so overlay entries can be read as tiles are requested.
+   unzFile unzipfile = unzOpen(theImageFile.c_str());
    if (!unzipfile)
    {
       ossimSetError(getClassName(),
          ossimErrorCodes::OSSIM_ERROR,
          "Unable to open target zip file..");
+      return false;
+   }
+   m_unzipFile = unzipfile;
 
-      tmpZipfile.rename(ossimString(tmpZipfile.noExtension() + ".kmz"));//if open fails, rename the file back to .kmz
+   // The first entry is the top level kml, doc.kml by convention.
+   char name[1024] = {0};
+   if ( (unzGoToFirstFile(unzipfile) != UNZ_OK) ||
+        (unzGetCurrentFileInfo(unzipfile, 0, name, sizeof(name), 0, 0, 0, 0) != UNZ_OK) )
+   {
       return false;
    }
+   m_rootPath = name;
 
    std::string kmzStringBuffer;
+   if ( !readEntry(m_rootPath, kmzStringBuffer) )
+   {
+      return false;
+   }
 
-   if (unzGoToFirstFile(unzipfile) == UNZ_OK)
+   std::istringstream in(kmzStringBuffer);
+   m_xmlDocument = new ossimXmlDocument;
+   return m_xmlDocument->read( in );
+}
+
+bool ossimKmlSuperOverlayReader::readEntry(const std::string& path, std::string& data)
+{
+   data.clear();
+   if (path.empty())
    {
-      if (unzOpenCurrentFile(unzipfile) == UNZ_OK)
+      return false;
+   }
+
+   if (m_unzipFile)
+   {
+      unzFile unzipfile = static_cast<unzFile>(m_unzipFile);
+      if ( (unzLocateFile(unzipfile, path.c_str(), 1) != UNZ_OK) ||
+           (unzOpenCurrentFile(unzipfile) != UNZ_OK) )
       {
-         unsigned char buffer[4096] = {0};
-         int bytesRead = 0;
-         int read = 1;
-         while (read > 0)
-         {
-            read = unzReadCurrentFile(unzipfile, buffer, 4096);
-            bytesRead += read;
-         }
-         if ( bytesRead )
-         {
-            for (int i = 0; i < bytesRead; ++i)
-            {
-               // Copy to string casting to char.
-               kmzStringBuffer.push_back( static_cast<char>(buffer[i]) );
-            }
-         }
+         return false;
       }
-      else
+      unz_file_info info;
+      if (unzGetCurrentFileInfo(unzipfile, &info, 0, 0, 0, 0, 0, 0) == UNZ_OK)
       {
-         tmpZipfile.rename(ossimString(tmpZipfile.noExtension() + ".kmz"));//if read fails, rename the file back to .kmz
-         unzCloseCurrentFile(unzipfile);
-         unzClose(unzipfile);
-         return false;
+         data.reserve(info.uncompressed_size);
+      }
+      char buffer[65536];
+      int read = 0;
+      while ( (read = unzReadCurrentFile(unzipfile, buffer, sizeof(buffer))) > 0 )
+      {
+         data.append(buffer, read);
       }
+      return (unzCloseCurrentFile(unzipfile) == UNZ_OK) && (read == 0);
    }
-   else
+
+   ossimFilename dir = theImageFile.path();
+   ossimFilename file = dir.empty() ? ossimFilename(path) : dir.dirCat(ossimFilename(path));
+   std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+   if (!in.good())
    {
-      tmpZipfile.rename(ossimString(tmpZipfile.noExtension() + ".kmz"));
-      unzClose(unzipfile);
       return false;
    }
-   unzCloseCurrentFile(unzipfile);
-   unzClose(unzipfile);
+   std::ostringstream out;
+   out << in.rdbuf();
+   data = out.str();
+   return true;
+}
 
-   std::istringstream in(kmzStringBuffer);
-   if ( in.good() )
+bool ossimKmlSuperOverlayReader::loadNode(ossim_uint32 index)
+{
+   if (m_nodes[index].m_loaded)
+   {
+      return true;
+   }
+   m_nodes[index].m_loaded = true;
+
+   ossimRefPtr<ossimXmlDocument> doc;
+   if (index == 0)
    {
-      m_xmlDocument = new ossimXmlDocument;
-      m_xmlDocument->read( in );
+      doc = m_xmlDocument;
    }
    else
    {
-      tmpZipfile.rename(ossimString(tmpZipfile.noExtension() + ".kmz"));
+      std::string data;
+      if (!readEntry(m_nodes[index].m_path, data))
+      {
+         if (traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG)
+               << "ossimKmlSuperOverlayReader::loadNode DEBUG: could not read "
+               << m_nodes[index].m_path << std::endl;
+         }
+         return false;
+      }
+      std::istringstream in(data);
+      doc = new ossimXmlDocument;
+      if (!doc->read(in))
+      {
+         return false;
+      }
+   }
+
+   ossimRefPtr<ossimXmlNode> root = doc->getRoot();
+   if (!root.valid())
+   {
       return false;
    }
 
-   tmpZipfile.rename(ossimString(tmpZipfile.noExtension() + ".kmz"));
+   std::vector<ossimRefPtr<ossimXmlNode> > overlays;
+   findTagged(root, "groundoverlay", overlays);
+   if (!overlays.empty())
+   {
+      ossimRefPtr<ossimXmlNode> href = findFirstTagged(overlays[0], "href");
+      ossimRefPtr<ossimXmlNode> box = findFirstTagged(overlays[0], "latlonbox");
+      ossimRefPtr<ossimXmlNode> quad = findFirstTagged(overlays[0], "latlonquad");
+      Box& imageBox = m_nodes[index].m_imageBox;
+      bool haveBox = box.valid() ?
+         readBox(box, imageBox.m_north, imageBox.m_south, imageBox.m_east, imageBox.m_west) :
+         ( quad.valid() &&
+           readQuad(quad, imageBox.m_north, imageBox.m_south, imageBox.m_east, imageBox.m_west) );
+      if (href.valid() && haveBox)
+      {
+         m_nodes[index].m_image = resolvePath(m_nodes[index].m_path,
+                                              href->getText().trim().string());
+      }
+   }
+
+   std::vector<ossimRefPtr<ossimXmlNode> > links;
+   findTagged(root, "networklink", links);
+   for (ossim_uint32 i = 0; i < links.size(); ++i)
+   {
+      ossimRefPtr<ossimXmlNode> href = findFirstTagged(links[i], "href");
+      ossimRefPtr<ossimXmlNode> region = findFirstTagged(links[i], "latlonaltbox");
+      if (!href.valid() || !region.valid())
+      {
+         continue;
+      }
+
+      OverlayNode child;
+      child.m_path = resolvePath(m_nodes[index].m_path, href->getText().trim().string());
+      child.m_depth = m_nodes[index].m_depth + 1;
+      child.m_loaded = false;
+      if ( child.m_path.empty() ||
+           !readBox(region, child.m_box.m_north, child.m_box.m_south,
+                    child.m_box.m_east, child.m_box.m_west) )
+      {
+         continue;
+      }
+      child.m_imageBox = child.m_box;
+
+      // push_back may move m_nodes so no references are held across it.
+      ossim_uint32 childIndex = (ossim_uint32)m_nodes.size();
+      m_nodes.push_back(child);
+      m_nodes[index].m_children.push_back(childIndex);
+   }
 
    return true;
 }
 
+void ossimKmlSuperOverlayReader::findNodes(ossim_uint32 index,
+                                           ossim_int32 depth,
+                                           const Box& box,
+                                           std::vector<ossim_uint32>& result)
+{
+   if (m_nodes[index].m_depth >= 0)
+   {
+      const Box& region = m_nodes[index].m_box;
+      if ( (region.m_north <= box.m_south) || (region.m_south >= box.m_north) ||
+           (region.m_east <= box.m_west) || (region.m_west >= box.m_east) )
+      {
+         return;
+      }
+   }
+
+   if (!loadNode(index))
+   {
+      return;
+   }
+
+   if (m_nodes[index].m_depth == depth)
+   {
+      if (!m_nodes[index].m_image.empty())
+      {
+         result.push_back(index);
+      }
+      return;
+   }
+
+   // Copy as loading children may grow m_nodes.
+   std::vector<ossim_uint32> children = m_nodes[index].m_children;
+   for (ossim_uint32 i = 0; i < children.size(); ++i)
+   {
+      findNodes(children[i], depth, box, result);
+   }
+}
+
+ossimRefPtr<ossimImageData> ossimKmlSuperOverlayReader::getOverlayImage(const std::string& path)
+{
+   ImageCache::iterator cached = m_imageCache.find(path);
+   if (cached != m_imageCache.end())
+   {
+      m_imageLru.splice(m_imageLru.begin(), m_imageLru, cached->second.second);
+      return cached->second.first;
+   }
+
+   ossimRefPtr<ossimImageData> image = 0;
+   std::string data;
+   if (readEntry(path, data) && (data.size() > 4))
+   {
+      // Pick the codec from the signature rather than the extension.
+      ossimRefPtr<ossimCodecBase> codec = 0;
+      const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+      if ( (bytes[0] == 0xff) && (bytes[1] == 0xd8) )
+      {
+         if (!m_jpegCodec.valid())
+         {
+            m_jpegCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
+         }
+         codec = m_jpegCodec;
+      }
+      else if ( (bytes[0] == 0x89) && (bytes[1] == 'P') && (bytes[2] == 'N') && (bytes[3] == 'G') )
+      {
+         if (!m_pngCodec.valid())
+         {
+            m_pngCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("png"));
+         }
+         codec = m_pngCodec;
+      }
+
+      if (codec.valid())
+      {
+         std::vector<ossim_uint8> in(data.begin(), data.end());
+         if (!codec->decode(in, image))
+         {
+            image = 0;
+         }
+      }
+   }
+
+   if (image.valid() && m_maxCachedImages)
+   {
+      m_imageLru.push_front(path);
+      m_imageCache[path] = std::make_pair(image, m_imageLru.begin());
+      while (m_imageCache.size() > m_maxCachedImages)
+      {
+         m_imageCache.erase(m_imageLru.back());
+         m_imageLru.pop_back();
+      }
+   }
+
+   return image;
+}
+
+bool ossimKmlSuperOverlayReader::initializeLevels(ossim_float64 north,
+                                                  ossim_float64 south,
+                                                  ossim_float64 east,
+                                                  ossim_float64 west)
+{
+   // Node 0 is the top level document.  Its links are level of detail 0.
+   OverlayNode root;
+   root.m_path = m_rootPath;
+   root.m_depth = -1;
+   root.m_box.m_north = north;
+   root.m_box.m_south = south;
+   root.m_box.m_east = east;
+   root.m_box.m_west = west;
+   root.m_loaded = false;
+   root.m_imageBox = root.m_box;
+   m_nodes.push_back(root);
+
+   // Only the first link of each level is parsed here; the rest on demand.
+   ossim_uint32 index = 0;
+   while (loadNode(index) && !m_nodes[index].m_children.empty())
+   {
+      index = m_nodes[index].m_children[0];
+   }
+   if (m_nodes[index].m_image.empty())
+   {
+      return false;
+   }
+
+   ossimRefPtr<ossimImageData> image = getOverlayImage(m_nodes[index].m_image);
+   if (!image.valid() || !image->getWidth() || !image->getHeight())
+   {
+      return false;
+   }
+
+   const Box& box = m_nodes[index].m_imageBox;
+   m_maxDepth = m_nodes[index].m_depth;
+   m_north = north;
+   m_west = west;
+   m_degreesPerPixel.x = (box.m_east - box.m_west) / image->getWidth();
+   m_degreesPerPixel.y = (box.m_north - box.m_south) / image->getHeight();
+   m_bands = image->getNumberOfBands();
+   m_scalarType = image->getScalarType();
 
+   if (traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossimKmlSuperOverlayReader::initializeLevels DEBUG:"
+         << "\nlevels: " << (m_maxDepth + 1)
+         << "\ndegrees per pixel: " << m_degreesPerPixel
+         << "\nbands: " << m_bands << std::endl;
+   }
 
+   return true;
+}
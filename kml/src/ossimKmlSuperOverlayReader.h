@@ -24,7 +24,15 @@
 #include <ossim/imaging/ossimImageHandler.h>
 #include <ossim/base/ossimIrect.h>
 #include <ossim/base/ossimDrect.h>
+#include <ossim/base/ossimDpt.h>
 
+//Std Includes
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+class ossimCodecBase;
 class ossimProjection;
 class ossimMapProjection;
 class ossimXmlDocument;
@@ -50,24 +58,32 @@ public:
    virtual bool open();
 
    /*!
-    *  Returns a null pointer for kml super overlay.
+    *  Returns a tile assembled from the ground overlays of the level of
+    *  detail matching resLevel.  Only the overlays intersecting tileRect are
+    *  read and decoded.  Returns a null pointer if no overlay image could be
+    *  decoded at open time.
     *  Satisfies pure virtual from ImageHandler class.
-    * 
     */
    virtual ossimRefPtr<ossimImageData> getTile(const ossimIrect& tileRect,
                                                ossim_uint32 resLevel=0);
 
    /*!
-    *  Returns the number 0 for bands for kml super overlay
+    *  Returns the number of bands of the overlay images.
     *  Satisfies pure virtual from ImageHandler class.
     */
    virtual ossim_uint32 getNumberOfInputBands() const;
 
    /*!
-    *  Returns the number 0 for bands for kml super overlay
+    *  Returns the number of bands of the overlay images.
     *  Satisfies pure virtual from ImageHandler class.
     */
    virtual ossim_uint32 getNumberOfOutputBands() const;
+
+   /*!
+    * Returns the number of levels of detail in the super overlay.  Each
+    * level halves the resolution of the level below.
+    */
+   virtual ossim_uint32 getNumberOfDecimationLevels() const;
   
    /*!
     *  Returns the number of bands in the image.
@@ -129,8 +145,60 @@ public:
    
    ossimMapProjection* createDefaultProj(ossim_float64 north, ossim_float64 south, ossim_float64 east, ossim_float64 west);
 
+   /*!
+    * Returns an equidistant cylindrical projection whose upper left pixel
+    * covers (north, west) at the given decimal degrees per pixel.
+    */
+   ossimMapProjection* createDefaultProj(ossim_float64 north, ossim_float64 south,
+                                         ossim_float64 east, ossim_float64 west,
+                                         const ossimDpt& degreesPerPixel);
+
 private:
 
+   struct Box
+   {
+      ossim_float64 m_north;
+      ossim_float64 m_south;
+      ossim_float64 m_east;
+      ossim_float64 m_west;
+   };
+
+   /*!
+    * One kml document of the overlay hierarchy.  Documents are parsed only
+    * when a tile request reaches them; m_box is the Region of the
+    * NetworkLink pointing at the document until then.
+    */
+   struct OverlayNode
+   {
+      std::string                m_path;
+      ossim_int32                m_depth;
+      Box                        m_box;
+      bool                       m_loaded;
+      std::string                m_image;
+      Box                        m_imageBox;
+      std::vector<ossim_uint32>  m_children;
+   };
+
+   /** Reads a file of the overlay, relative to the kmz or kml directory. */
+   bool readEntry(const std::string& path, std::string& data);
+
+   /** Parses the document of node index if not already done. */
+   bool loadNode(ossim_uint32 index);
+
+   /** Collects the nodes at depth whose region intersects box. */
+   void findNodes(ossim_uint32 index, ossim_int32 depth, const Box& box,
+                  std::vector<ossim_uint32>& result);
+
+   /** Returns the decoded image at path, from the cache if possible. */
+   ossimRefPtr<ossimImageData> getOverlayImage(const std::string& path);
+
+   /**
+    * Walks down the first links to find the number of levels and decodes
+    * one image of the finest level for the resolution, bands and scalar type.
+    */
+   bool initializeLevels(ossim_float64 north, ossim_float64 south,
+                         ossim_float64 east, ossim_float64 west);
+
    bool getCoordinate(std::vector<ossimRefPtr<ossimXmlNode> > nodes,
                       ossim_float64& north,
                       ossim_float64& south,
@@ -147,6 +215,30 @@ private:
    ossimRefPtr<ossimImageGeometry>     theImageGeometry;
    ossimDrect                          theImageBound;
 
+   /** unzFile of a kmz kept open for reading overlay entries. */
+   void*                               m_unzipFile;
+   std::string                         m_rootPath;
+   std::vector<OverlayNode>            m_nodes;
+   ossim_int32                         m_maxDepth;
+
+   /** Upper left corner and degrees per pixel at level of detail m_maxDepth. */
+   ossim_float64                       m_north;
+   ossim_float64                       m_west;
+   ossimDpt                            m_degreesPerPixel;
+
+   ossim_uint32                        m_bands;
+   ossimScalarType                     m_scalarType;
+   ossimRefPtr<ossimImageData>         m_tile;
+   ossimRefPtr<ossimCodecBase>         m_jpegCodec;
+   ossimRefPtr<ossimCodecBase>         m_pngCodec;
+
+   /** Decoded overlay images by path, most recently used at the front. */
+   typedef std::list<std::string> LruList;
+   typedef std::map<std::string, std::pair<ossimRefPtr<ossimImageData>, LruList::iterator> > ImageCache;
+   LruList                             m_imageLru;
+   ImageCache                          m_imageCache;
+   ossim_uint32                        m_maxCachedImages;
+
 TYPE_DATA
 };
 
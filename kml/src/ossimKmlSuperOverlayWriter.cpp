@@ -15,21 +15,34 @@
 
 //OSSIM Includes
 #include <ossim/base/ossimDpt.h>
-#include <ossim/base/ossimDirectory.h>
 #include <ossim/base/ossimKeywordlist.h>
 #include <ossim/base/ossimKeywordNames.h>
+#include <ossim/base/ossimPreferences.h>
 #include <ossim/base/ossimTrace.h>
 #include <ossim/base/ossimVisitor.h> /* for ossimViewInterfaceVisitor */
 #include <ossim/projection/ossimMapProjection.h>
-#include <ossim/imaging/ossimImageDataFactory.h>
+#include <ossim/imaging/ossimCodecBase.h>
+#include <ossim/imaging/ossimCodecFactoryRegistry.h>
+#include <ossim/imaging/ossimImageData.h>
 #include <ossim/imaging/ossimImageGeometry.h>
-#include <ossim/imaging/ossimImageWriterFactoryRegistry.h>
+#include <ossim/imaging/ossimScalarRemapper.h>
+
+//minizip includes
+#include <minizip/zip.h>
 
 //STD Includes
 #include <cmath>
-#include <cstring> /* strdup */
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 
 RTTI_DEF1(ossimKmlSuperOverlayWriter, "ossimKmlSuperOverlayWriter", ossimImageFileWriter)
@@ -40,9 +53,39 @@ RTTI_DEF1(ossimKmlSuperOverlayWriter, "ossimKmlSuperOverlayWriter", ossimImageFi
    //---
    static ossimTrace traceDebug("ossimKmlSuperOverlayWriter:debug");
 
+static const char WRITE_THREADS_KW[] = "ossim.plugins.kml.writer.threads";
+
+// printf style append to a kml document.
+static void appendf(std::string& s, const char* format, ...)
+{
+   char buf[1024];
+   va_list args;
+   va_start(args, format);
+   va_list retryArgs;
+   va_copy(retryArgs, args);
+   int n = vsnprintf(buf, sizeof(buf), format, args);
+   va_end(args);
+   if (n > 0)
+   {
+      if (n < (int)sizeof(buf))
+      {
+         s.append(buf, n);
+      }
+      else
+      {
+         // Too long for the stack buffer, e.g. a long name; format again
+         // straight into the string.
+         std::string::size_type start = s.size();
+         s.resize(start + n + 1);
+         vsnprintf(&s[start], n + 1, format, retryArgs);
+         s.resize(start + n);
+      }
+   }
+   va_end(retryArgs);
+}
+
 ossimKmlSuperOverlayWriter::ossimKmlSuperOverlayWriter()
    : ossimImageFileWriter(),
-   m_imageWriter(0),
    m_mapProjection(0),
    m_isKmz(false),
    m_isPngFormat(false)
@@ -135,24 +178,24 @@ bool ossimKmlSuperOverlayWriter::writeStream()
    }
 
    ossimString fileExt = ".jpg";
-   ossimString ext = "jpg";
+   ossimString codecName = "jpeg";
    if (m_isPngFormat)
    {
       fileExt = ".png";
-      ext = "png";
-   }
-   m_imageWriter = ossimImageWriterFactoryRegistry::instance()->createWriterFromExtension(ext);
-   if (!m_imageWriter.valid())
-   {
-      return false;
+      codecName = "pnga"; // png with alpha channel
    }
-   if (m_isPngFormat)//add alpha channel for png
+
+   // Each encode thread gets its own codec.
+   const ossim_uint32 THREADS = getNumberOfThreads();
+   std::vector< ossimRefPtr<ossimCodecBase> > codecs(THREADS);
+   for (ossim_uint32 i = 0; i < THREADS; ++i)
    {
-      ossimKeywordlist kwl;
-      kwl.add("add_alpha_channel", "true", true);
-      m_imageWriter->loadState(kwl);
+      codecs[i] = ossimCodecFactoryRegistry::instance()->createCodec(codecName);
+      if (!codecs[i].valid())
+      {
+         return false;
+      }
    }
-   m_imageWriter->connectMyInputTo(theInputConnection.get());
    
    ossimString outDir = theFilename.path();
    if (outDir.empty())
@@ -249,26 +292,276 @@ bool ossimKmlSuperOverlayWriter::writeStream()
       zoomScaleY.push_back(scale.y * pow(2.0, (maxzoom - zoom)));
    }
 
-   ossimString tmpFileName; 
-   std::vector<ossimString> dirVector;
-   std::vector<ossimString> fileVector;
-   bool isKmlGenerated = false;
-   if (m_isKmz)
+   //---
+   // Codecs are eight bit only.  Put a scalar remapper between the
+   // sequencer and its input for the duration of the write if needed.
+   //---
+   ossimRefPtr<ossimConnectableObject> originalSequencerInput = 0;
+   if (theInputConnection->getOutputScalarType() != OSSIM_UINT8)
    {
-      tmpFileName = ossimString(outDir + "/" + "tmp.kml");
-      isKmlGenerated = generateRootKml(tmpFileName.c_str(), ulg.lat, lrg.lat, lrg.lon, ulg.lon, (ossim_int32)tilexsize);
-      fileVector.push_back(tmpFileName);
+      originalSequencerInput = theInputConnection->getInput(0);
+      ossimRefPtr<ossimImageSource> sr = new ossimScalarRemapper();
+      sr->connectMyInputTo(0, theInputConnection->getInput(0));
+      theInputConnection->connectMyInputTo(0, sr.get());
+      theInputConnection->initialize();
    }
-   else
+
+   //---
+   // Pipeline: this thread renders tiles and formats the kml, a pool of
+   // threads encodes the tiles and one writer thread streams every entry
+   // into the kmz (or the kml directory tree) in the order it arrives.
+   // Nothing is staged on disk.  The encode queue is bounded so at most a
+   // few tiles per thread are in memory.
+   //---
+   struct EncodeJob
    {
-      isKmlGenerated = generateRootKml(theFilename, ulg.lat, lrg.lat, lrg.lon, ulg.lon, (ossim_int32)tilexsize);
+      std::string                 m_name;
+      ossimRefPtr<ossimImageData> m_tile;
+   };
+   struct Entry
+   {
+      std::string m_name;     // Path relative to the output directory.
+      std::string m_data;
+      bool        m_compress; // Images are already compressed; store them.
+   };
+
+   const std::size_t QUEUE_TILES = THREADS * 4;
+   std::mutex queueMutex;
+   std::condition_variable queueCondition;
+   std::deque<EncodeJob> encodeQueue;
+   std::deque<Entry> writeQueue;
+   ossim_uint32 activeEncoders = THREADS;
+   bool producerDone = false;
+   bool writeFailed = false;
+   std::string errorMessage;
+
+   zipFile zipfile = 0;
+   std::vector<std::thread> encoders;
+   std::thread writerThread;
+
+   //---
+   // Undoes the write on every exit path, including exceptions from the
+   // chain: stops and joins the pipeline threads, closes the zip and puts
+   // the sequencer's original input back.
+   //---
+   struct WriteGuard
+   {
+      WriteGuard(std::mutex& queueMutex,
+                 std::condition_variable& queueCondition,
+                 bool& producerDone,
+                 bool& writeFailed,
+                 std::vector<std::thread>& encoders,
+                 std::thread& writerThread,
+                 zipFile& zipfile,
+                 ossimConnectableObject* sequencer,
+                 ossimRefPtr<ossimConnectableObject>& originalSequencerInput)
+         : m_queueMutex(queueMutex),
+           m_queueCondition(queueCondition),
+           m_producerDone(producerDone),
+           m_writeFailed(writeFailed),
+           m_encoders(encoders),
+           m_writerThread(writerThread),
+           m_zipfile(zipfile),
+           m_sequencer(sequencer),
+           m_originalSequencerInput(originalSequencerInput)
+      {}
+      ~WriteGuard()
+      {
+         // Leaving by exception; drain the queues without writing.
+         finish(true);
+      }
+      void finish(bool abandon)
+      {
+         {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_producerDone = true;
+            if (abandon)
+            {
+               m_writeFailed = true;
+            }
+            m_queueCondition.notify_all();
+         }
+         for (std::size_t i = 0; i < m_encoders.size(); ++i)
+         {
+            if (m_encoders[i].joinable())
+            {
+               m_encoders[i].join();
+            }
+         }
+         if (m_writerThread.joinable())
+         {
+            m_writerThread.join();
+         }
+         if (m_zipfile)
+         {
+            zipClose(m_zipfile, 0);
+            m_zipfile = 0;
+         }
+         if (m_originalSequencerInput.valid())
+         {
+            m_sequencer->connectMyInputTo(0, m_originalSequencerInput.get());
+            m_originalSequencerInput = 0;
+         }
+      }
+      std::mutex&                          m_queueMutex;
+      std::condition_variable&             m_queueCondition;
+      bool&                                m_producerDone;
+      bool&                                m_writeFailed;
+      std::vector<std::thread>&            m_encoders;
+      std::thread&                         m_writerThread;
+      zipFile&                             m_zipfile;
+      ossimConnectableObject*              m_sequencer;
+      ossimRefPtr<ossimConnectableObject>& m_originalSequencerInput;
+   };
+   WriteGuard writeGuard(queueMutex, queueCondition, producerDone, writeFailed,
+                         encoders, writerThread, zipfile,
+                         theInputConnection.get(), originalSequencerInput);
+
+   if (m_isKmz)
+   {
+      zipfile = zipOpen(theFilename.c_str(), APPEND_STATUS_CREATE);
+      if (!zipfile)
+      {
+         ossimSetError(getClassName(),
+            ossimErrorCodes::OSSIM_ERROR,
+            "Unable to open target zip file..");
+         writeGuard.finish(false);
+         return false;
+      }
    }
-   if (!isKmlGenerated)
+
+   for (ossim_uint32 i = 0; i < THREADS; ++i)
    {
-      return false;
+      encoders.push_back(std::thread([&, i]()
+      {
+         std::unique_lock<std::mutex> lock(queueMutex);
+         while (true)
+         {
+            queueCondition.wait(lock, [&]()
+                                { return producerDone || !encodeQueue.empty(); });
+            if (encodeQueue.empty())
+            {
+               break; // producerDone
+            }
+            EncodeJob job = encodeQueue.front();
+            encodeQueue.pop_front();
+            queueCondition.notify_all();
+            lock.unlock();
+
+            std::vector<ossim_uint8> buffer;
+            bool encoded = false;
+            try
+            {
+               if (m_isPngFormat)
+               {
+                  job.m_tile->computeAlphaChannel();
+               }
+               encoded = codecs[i]->encode(job.m_tile, buffer);
+            }
+            catch (const std::exception& e)
+            {
+               ossimNotify(ossimNotifyLevel_WARN) << e.what() << std::endl;
+               encoded = false;
+            }
+
+            lock.lock();
+            if (encoded && buffer.size())
+            {
+               Entry entry;
+               entry.m_name.swap(job.m_name);
+               entry.m_data.assign(buffer.begin(), buffer.end());
+               entry.m_compress = false;
+               writeQueue.push_back(std::move(entry));
+            }
+            else
+            {
+               writeFailed = true;
+               errorMessage = "Could not encode tile " + job.m_name;
+            }
+            queueCondition.notify_all();
+         }
+         --activeEncoders;
+         queueCondition.notify_all();
+      }));
    }
 
-   for (ossim_int32 zoom = maxzoom; zoom >= 0; --zoom)
+   ossimFilename outDirectory = outDir;
+   writerThread = std::thread([&]()
+   {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      while (true)
+      {
+         queueCondition.wait(lock, [&]()
+                             { return !writeQueue.empty() || (activeEncoders == 0); });
+         if (writeQueue.empty())
+         {
+            break; // All encoders are done.
+         }
+         Entry entry = std::move(writeQueue.front());
+         writeQueue.pop_front();
+         queueCondition.notify_all();
+         bool failed = writeFailed;
+         lock.unlock();
+
+         bool status = true;
+         if (failed)
+         {
+            // Drain without writing.
+         }
+         else if (zipfile)
+         {
+            int method = entry.m_compress ? Z_DEFLATED : 0;
+            int level  = entry.m_compress ? Z_DEFAULT_COMPRESSION : 0;
+            status = (zipOpenNewFileInZip(zipfile, entry.m_name.c_str(),
+                                          0, 0, 0, 0, 0, 0, method, level) == ZIP_OK);
+            if (status)
+            {
+               status = (zipWriteInFileInZip(zipfile,
+                                             static_cast<const void*>(entry.m_data.data()),
+                                             static_cast<unsigned int>(entry.m_data.size())) == ZIP_OK);
+               status = (zipCloseFileInZip(zipfile) == ZIP_OK) && status;
+            }
+         }
+         else
+         {
+            ossimFilename file = outDirectory.dirCat(entry.m_name);
+            ossimFilename dir = file.path();
+            if (dir.size() && !dir.exists())
+            {
+               dir.createDirectory();
+            }
+            std::ofstream os(file.c_str(), std::ios::out | std::ios::binary);
+            os.write(entry.m_data.data(), entry.m_data.size());
+            status = os.good();
+         }
+
+         lock.lock();
+         if (!status && !writeFailed)
+         {
+            writeFailed = true;
+            errorMessage = "Could not write " + entry.m_name;
+         }
+      }
+   });
+
+   // Queues an entry for the writer thread.
+   auto queueEntry = [&](const std::string& name, std::string& data)
+   {
+      Entry entry;
+      entry.m_name = name;
+      entry.m_data.swap(data);
+      entry.m_compress = true;
+      std::unique_lock<std::mutex> lock(queueMutex);
+      writeQueue.push_back(std::move(entry));
+      queueCondition.notify_all();
+   };
+
+   std::string kml;
+   generateRootKml(ulg.lat, lrg.lat, lrg.lon, ulg.lon, (ossim_int32)tilexsize, kml);
+   queueEntry(m_isKmz ? std::string("doc.kml") : theFilename.file().string(), kml);
+
+   bool status = true;
+   for (ossim_int32 zoom = maxzoom; (zoom >= 0) && status; --zoom)
    {
       ossim_int32 rmaxxsize = static_cast<ossim_int32>(pow(2.0, (maxzoom-zoom)) * tilexsize);
       ossim_int32 rmaxysize = static_cast<ossim_int32>(pow(2.0, (maxzoom-zoom)) * tileysize);
@@ -311,126 +604,63 @@ bool ossimKmlSuperOverlayWriter::writeStream()
          }
       }
 
-      for (ossim_int32 ix = 0; ix < xloop; ix++)
+      for (ossim_int32 ix = 0; (ix < xloop) && status; ix++)
       {
          ossim_int32 rxsize = (ossim_int32)(rmaxxsize);
-         // ossim_int32 rx = (ossim_int32)(ix * rmaxxsize);
 
          for (ossim_int32 iy = 0; iy < yloop; iy++)
          {
             ossim_int32 rysize = (ossim_int32)(rmaxysize);
-            // ossim_int32 ry = (ossim_int32)(ysize - (iy * rmaxysize)) - rysize;
 
             ossim_int32 dxsize = (ossim_int32)(rxsize/rmaxxsize * tilexsize);
             ossim_int32 dysize = (ossim_int32)(rysize/rmaxysize * tileysize);
 
-            std::stringstream zoomStr;
-            std::stringstream ixStr;
-            std::stringstream iyStr;
-
-            zoomStr << zoom;
-            ixStr << ix;
-            iyStr << iy;
-
-            ossimFilename zoomDir = ossimString(outDir + "/" + ossimString(zoomStr.str()));
-            zoomDir.createDirectory();
-
-            zoomDir = ossimString(zoomDir + "/") + ossimString::toString(ix);
-            zoomDir.createDirectory();
-
-            if (m_isKmz)
-            {
-               dirVector.push_back(zoomDir);
-            }
+            // zoom/ix/yIndex
+            std::ostringstream path;
+            path << zoom << "/" << ix << "/" << (yloop-iy-1);
 
-            ossimString filename = ossimString(zoomDir + "/" + ossimString::toString(yloop-iy-1) + fileExt);
-            if (m_isKmz)
+            ossimRefPtr<ossimImageData> tile = generateTile(ix, iy, dxsize, dysize);
             {
-               fileVector.push_back(filename);
+               std::unique_lock<std::mutex> lock(queueMutex);
+               queueCondition.wait(lock, [&]()
+                  { return writeFailed || ( ( encodeQueue.size() < QUEUE_TILES ) &&
+                                            ( writeQueue.size() < QUEUE_TILES ) ); });
+               if (writeFailed || !tile.valid())
+               {
+                  status = false;
+                  break;
+               }
+               EncodeJob job;
+               job.m_name = path.str() + fileExt.string();
+               job.m_tile = tile;
+               encodeQueue.push_back(job);
+               queueCondition.notify_all();
             }
 
-            generateTile(filename, ix, iy, dxsize, dysize);
+            generateChildKml(zoom, yloop, ix, iy, dxsize, dysize, xsize, ysize, maxzoom, projDup, fileExt, kml);
+            queueEntry(path.str() + ".kml", kml);
 
-            ossimString childKmlfile = ossimString(zoomDir + "/" + ossimString::toString(yloop-iy-1) + ".kml");
-            if (m_isKmz)
+            if (needsAborting())
             {
-               fileVector.push_back(childKmlfile);
-            }
-
-            isKmlGenerated = generateChildKml(childKmlfile, zoom, yloop, ix, iy, dxsize, dysize, xsize, ysize, maxzoom, projDup, fileExt);
-            if (!isKmlGenerated)
-            {
-               return false;
+               status = false;
+               break;
             }
          }
       }
    }
 
+   // Drain the queues, close the zip and reset the connection if needed.
+   writeGuard.finish(false);
 
-   if (m_isKmz)
+   if (writeFailed)
    {
-      if (zipWithMinizip(fileVector, outDir, theFilename) == false)
-      {
-         return false;
-      }
-
-      //remove sub-directories and the files under those directories
-      for (ossim_uint32 i = 0; i < dirVector.size(); ++i)
-      {
-         ossimFilename zoomDir = dirVector[i];
-
-         ossimDirectory dir;
-         std::vector<ossimFilename> filesInDir;
-         if(dir.open(zoomDir))
-         {
-            ossimFilename file;
-            //if (dir.getFirst(file, ossimDirectory::OSSIM_DIR_DEFAULT))
-            if (dir.getFirst(file, ossimDirectory::OSSIM_DIR_DEFAULT))
-            {
-               filesInDir.push_back(file);
-            }
-            do
-            {
-               filesInDir.push_back(file);
-            }while(dir.getNext(file));
-         }
-
-         for(ossim_uint32 j = 0; j < filesInDir.size(); ++j)
-         {
-            ossimFilename fi = filesInDir[j];
-            if (!fi.empty())
-            {
-               fi.remove();
-            }
-         }
-         if (zoomDir.exists())
-         {
-            ossimString cmd = "rmdir \"";
-            cmd += zoomDir + "\"";
-            std::system(cmd.c_str());
-         }
-      }
-
-      //remove the top directories
-      for (int zoom = maxzoom; zoom >= 0; --zoom)
-      {
-         std::stringstream zoomStr;
-         zoomStr << zoom;
-         ossimFilename zoomZipDir = ossimString(outDir + "/" + ossimString(zoomStr.str()));
-         if (zoomZipDir.exists())
-         {
-            ossimString cmd = "rmdir \"";
-            cmd += zoomZipDir + "\"";
-            std::system(cmd.c_str());
-         }
-      }
-      if (ossimFilename(tmpFileName).exists())
-      {
-         ossimFilename(tmpFileName).remove();
-      }
+      ossimSetError(getClassName(),
+         ossimErrorCodes::OSSIM_ERROR,
+         errorMessage.c_str());
+      status = false;
    }
 
-   return true;
+   return status;
 }
 
 bool ossimKmlSuperOverlayWriter::saveState(ossimKeywordlist& kwl,
@@ -477,10 +707,6 @@ bool ossimKmlSuperOverlayWriter::open()
 
 void ossimKmlSuperOverlayWriter::close()
 {
-   if (m_imageWriter.valid())
-   {
-      m_imageWriter = 0;
-   }
    if (m_mapProjection.valid())
    {
       m_mapProjection = 0;
@@ -540,84 +766,84 @@ void ossimKmlSuperOverlayWriter::getPropertyNames(
    ossimImageFileWriter::getPropertyNames(propertyNames);
 }
 
-void ossimKmlSuperOverlayWriter::generateTile(ossimString filename, 
+ossimRefPtr<ossimImageData> ossimKmlSuperOverlayWriter::generateTile(
    ossim_int32 ix, 
    ossim_int32 iy, 
    ossim_int32 dxsize, 
    ossim_int32 dysize)
 {
-   ossimFilename file = filename;
-   ossimIpt ul(dxsize*ix, dysize*(iy+1));
-   ossimIpt ur(dxsize*(ix+1), dysize*(iy+1));
-   ossimIpt lr(dxsize*(ix+1), dysize*iy);
-   ossimIpt ll(dxsize*ix, dysize*iy);
-   ossimIrect rect(ul, ur, lr, ll);
+   ossimRefPtr<ossimImageData> result = 0;
 
-   m_imageWriter->setFilename(file);
-   m_imageWriter->setAreaOfInterest(rect);
-   m_imageWriter->execute();
+   // Same area the image writer was given: corners inclusive.
+   ossimIrect rect(dxsize*ix, dysize*iy, dxsize*(ix+1), dysize*(iy+1));
+
+   ossimRefPtr<ossimImageData> tile = theInputConnection->getTile(rect);
+   if (tile.valid())
+   {
+      // The chain reuses its tile so hand the encoders a copy.
+      result = static_cast<ossimImageData*>(tile->dup());
+      if (result->getDataObjectStatus() == OSSIM_NULL)
+      {
+         // Null tiles have no buffer; encode them as blank.
+         result->initialize();
+         result->makeBlank();
+      }
+   }
+   return result;
 }
 
-bool ossimKmlSuperOverlayWriter::generateRootKml(ossimString filename, 
-   ossim_float64 north, 
+void ossimKmlSuperOverlayWriter::generateRootKml(ossim_float64 north, 
    ossim_float64 south, 
    ossim_float64 east, 
    ossim_float64 west, 
-   ossim_int32 tilesize)
+   ossim_int32 tilesize,
+   std::string& kml)
 {
-   FILE* fp = fopen(filename.c_str(), "wb");
-   if (fp == NULL)
-   {
-      return false;
-   }
+   kml.clear();
    ossim_int32 minlodpixels = tilesize/2;
 
    ossimString tmpfilename = theFilename.fileNoExtension();
    // If we haven't writen any features yet, output the layer's schema
-   fprintf(fp, "<kml xmlns=\"http://earth.google.com/kml/2.1\">\n");
-   fprintf(fp, "\t<Document>\n");
-   fprintf(fp, "\t\t<name>%s</name>\n", tmpfilename.c_str());
-   fprintf(fp, "\t\t<description></description>\n");
-   fprintf(fp, "\t\t<Style>\n");
-   fprintf(fp, "\t\t\t<ListStyle id=\"hideChildren\">\n");
-   fprintf(fp, "\t\t\t\t<listItemType>checkHideChildren</listItemType>\n");
-   fprintf(fp, "\t\t\t</ListStyle>\n");
-   fprintf(fp, "\t\t</Style>\n");
-   fprintf(fp, "\t\t<Region>\n \t\t<LatLonAltBox>\n");
-   fprintf(fp, "\t\t\t\t<north>%f</north>\n", north);
-   fprintf(fp, "\t\t\t\t<south>%f</south>\n", south);
-   fprintf(fp, "\t\t\t\t<east>%f</east>\n", east);
-   fprintf(fp, "\t\t\t\t<west>%f</west>\n", west);
-   fprintf(fp, "\t\t\t</LatLonAltBox>\n");
-   fprintf(fp, "\t\t</Region>\n");
-   fprintf(fp, "\t\t<NetworkLink>\n");
-   fprintf(fp, "\t\t\t<open>1</open>\n");
-   fprintf(fp, "\t\t\t<Region>\n");
-   fprintf(fp, "\t\t\t\t<Lod>\n");
-   fprintf(fp, "\t\t\t\t\t<minLodPixels>%d</minLodPixels>\n", minlodpixels);
-   fprintf(fp, "\t\t\t\t\t<maxLodPixels>-1</maxLodPixels>\n");
-   fprintf(fp, "\t\t\t\t</Lod>\n");
-   fprintf(fp, "\t\t\t\t<LatLonAltBox>\n");
-   fprintf(fp, "\t\t\t\t\t<north>%f</north>\n", north);
-   fprintf(fp, "\t\t\t\t\t<south>%f</south>\n", south);
-   fprintf(fp, "\t\t\t\t\t<east>%f</east>\n", east);
-   fprintf(fp, "\t\t\t\t\t<west>%f</west>\n", west);
-   fprintf(fp, "\t\t\t\t</LatLonAltBox>\n");
-   fprintf(fp, "\t\t\t</Region>\n");
-   fprintf(fp, "\t\t\t<Link>\n");
-   fprintf(fp, "\t\t\t\t<href>0/0/0.kml</href>\n");
-   fprintf(fp, "\t\t\t\t<viewRefreshMode>onRegion</viewRefreshMode>\n");
-   fprintf(fp, "\t\t\t</Link>\n");
-   fprintf(fp, "\t\t</NetworkLink>\n");
-   fprintf(fp, "\t</Document>\n");
-   fprintf(fp, "</kml>\n");
-
-   fclose(fp);
-   return true;
+   appendf(kml, "<kml xmlns=\"http://earth.google.com/kml/2.1\">\n");
+   appendf(kml, "\t<Document>\n");
+   appendf(kml, "\t\t<name>%s</name>\n", tmpfilename.c_str());
+   appendf(kml, "\t\t<description></description>\n");
+   appendf(kml, "\t\t<Style>\n");
+   appendf(kml, "\t\t\t<ListStyle id=\"hideChildren\">\n");
+   appendf(kml, "\t\t\t\t<listItemType>checkHideChildren</listItemType>\n");
+   appendf(kml, "\t\t\t</ListStyle>\n");
+   appendf(kml, "\t\t</Style>\n");
+   appendf(kml, "\t\t<Region>\n \t\t<LatLonAltBox>\n");
+   appendf(kml, "\t\t\t\t<north>%f</north>\n", north);
+   appendf(kml, "\t\t\t\t<south>%f</south>\n", south);
+   appendf(kml, "\t\t\t\t<east>%f</east>\n", east);
+   appendf(kml, "\t\t\t\t<west>%f</west>\n", west);
+   appendf(kml, "\t\t\t</LatLonAltBox>\n");
+   appendf(kml, "\t\t</Region>\n");
+   appendf(kml, "\t\t<NetworkLink>\n");
+   appendf(kml, "\t\t\t<open>1</open>\n");
+   appendf(kml, "\t\t\t<Region>\n");
+   appendf(kml, "\t\t\t\t<Lod>\n");
+   appendf(kml, "\t\t\t\t\t<minLodPixels>%d</minLodPixels>\n", minlodpixels);
+   appendf(kml, "\t\t\t\t\t<maxLodPixels>-1</maxLodPixels>\n");
+   appendf(kml, "\t\t\t\t</Lod>\n");
+   appendf(kml, "\t\t\t\t<LatLonAltBox>\n");
+   appendf(kml, "\t\t\t\t\t<north>%f</north>\n", north);
+   appendf(kml, "\t\t\t\t\t<south>%f</south>\n", south);
+   appendf(kml, "\t\t\t\t\t<east>%f</east>\n", east);
+   appendf(kml, "\t\t\t\t\t<west>%f</west>\n", west);
+   appendf(kml, "\t\t\t\t</LatLonAltBox>\n");
+   appendf(kml, "\t\t\t</Region>\n");
+   appendf(kml, "\t\t\t<Link>\n");
+   appendf(kml, "\t\t\t\t<href>0/0/0.kml</href>\n");
+   appendf(kml, "\t\t\t\t<viewRefreshMode>onRegion</viewRefreshMode>\n");
+   appendf(kml, "\t\t\t</Link>\n");
+   appendf(kml, "\t\t</NetworkLink>\n");
+   appendf(kml, "\t</Document>\n");
+   appendf(kml, "</kml>\n");
 }
 
-bool ossimKmlSuperOverlayWriter::generateChildKml(ossimString filename, 
-   ossim_int32 zoom, 
+void ossimKmlSuperOverlayWriter::generateChildKml(ossim_int32 zoom, 
    ossim_int32 yloop,
    ossim_int32 ix, 
    ossim_int32 iy, 
@@ -627,7 +853,8 @@ bool ossimKmlSuperOverlayWriter::generateChildKml(ossimString filename,
    ossim_int32 ysize, 
    ossim_int32 maxzoom,
    ossimRefPtr<ossimMapProjection> proj,
-   ossimString fileExt)
+   ossimString fileExt,
+   std::string& kml)
 {
    ossim_int32 yIndex = yloop-iy-1;
    ossimIpt ul(dxsize*ix, dysize*(iy+1));
@@ -718,46 +945,41 @@ bool ossimKmlSuperOverlayWriter::generateChildKml(ossimString filename,
       maxLodPix = 2048;
    }
 
-   FILE* fp = fopen(filename.c_str(), "wb");
-   if (fp == NULL)
-   {
-      return false;
-   }
-
-   fprintf(fp, "<kml xmlns=\"http://earth.google.com/kml/2.1\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n");
-   fprintf(fp, "\t<Document>\n");
-   fprintf(fp, "\t\t<name>%d/%d/%d.kml</name>\n", zoom, ix, yIndex);
-   fprintf(fp, "\t\t<Style>\n");
-   fprintf(fp, "\t\t\t<ListStyle id=\"hideChildren\">\n");
-   fprintf(fp, "\t\t\t\t<listItemType>checkHideChildren</listItemType>\n");
-   fprintf(fp, "\t\t\t</ListStyle>\n");
-   fprintf(fp, "\t\t</Style>\n");
-   fprintf(fp, "\t\t<Region>\n");
-   fprintf(fp, "\t\t\t<Lod>\n");
-   fprintf(fp, "\t\t\t\t<minLodPixels>%d</minLodPixels>\n", 128);
-   fprintf(fp, "\t\t\t\t<maxLodPixels>%d</maxLodPixels>\n", maxLodPix);
-   fprintf(fp, "\t\t\t</Lod>\n");
-   fprintf(fp, "\t\t\t<LatLonAltBox>\n");
-   fprintf(fp, "\t\t\t\t<north>%f</north>\n", tnorth);
-   fprintf(fp, "\t\t\t\t<south>%f</south>\n", tsouth);
-   fprintf(fp, "\t\t\t\t<east>%f</east>\n", teast);
-   fprintf(fp, "\t\t\t\t<west>%f</west>\n", twest);
-   fprintf(fp, "\t\t\t</LatLonAltBox>\n");
-   fprintf(fp, "\t\t</Region>\n");
-   fprintf(fp, "\t\t<GroundOverlay>\n");
-   fprintf(fp, "\t\t\t<drawOrder>%d</drawOrder>\n", zoom);
-   fprintf(fp, "\t\t\t<Icon>\n");
-   fprintf(fp, "\t\t\t\t<href>%d%s</href>\n", yIndex, fileExt.c_str());
-   fprintf(fp, "\t\t\t</Icon>\n");
-   fprintf(fp, "\t\t\t<gx:LatLonQuad>\n");
-   fprintf(fp, "\t\t\t\t<coordinates>\n");
-   fprintf(fp, "\t\t\t\t\t%f, %f, 0\n", lowerleftT, leftbottomT);
-   fprintf(fp, "\t\t\t\t\t%f, %f, 0\n", lowerrightT, rightbottomT);
-   fprintf(fp, "\t\t\t\t\t%f, %f, 0\n", upperrightT, righttopT);
-   fprintf(fp, "\t\t\t\t\t%f, %f, 0\n", upperleftT, lefttopT);
-   fprintf(fp, "\t\t\t\t</coordinates>\n");
-   fprintf(fp, "\t\t\t</gx:LatLonQuad>\n");
-   fprintf(fp, "\t\t</GroundOverlay>\n");
+   kml.clear();
+   appendf(kml, "<kml xmlns=\"http://earth.google.com/kml/2.1\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n");
+   appendf(kml, "\t<Document>\n");
+   appendf(kml, "\t\t<name>%d/%d/%d.kml</name>\n", zoom, ix, yIndex);
+   appendf(kml, "\t\t<Style>\n");
+   appendf(kml, "\t\t\t<ListStyle id=\"hideChildren\">\n");
+   appendf(kml, "\t\t\t\t<listItemType>checkHideChildren</listItemType>\n");
+   appendf(kml, "\t\t\t</ListStyle>\n");
+   appendf(kml, "\t\t</Style>\n");
+   appendf(kml, "\t\t<Region>\n");
+   appendf(kml, "\t\t\t<Lod>\n");
+   appendf(kml, "\t\t\t\t<minLodPixels>%d</minLodPixels>\n", 128);
+   appendf(kml, "\t\t\t\t<maxLodPixels>%d</maxLodPixels>\n", maxLodPix);
+   appendf(kml, "\t\t\t</Lod>\n");
+   appendf(kml, "\t\t\t<LatLonAltBox>\n");
+   appendf(kml, "\t\t\t\t<north>%f</north>\n", tnorth);
+   appendf(kml, "\t\t\t\t<south>%f</south>\n", tsouth);
+   appendf(kml, "\t\t\t\t<east>%f</east>\n", teast);
+   appendf(kml, "\t\t\t\t<west>%f</west>\n", twest);
+   appendf(kml, "\t\t\t</LatLonAltBox>\n");
+   appendf(kml, "\t\t</Region>\n");
+   appendf(kml, "\t\t<GroundOverlay>\n");
+   appendf(kml, "\t\t\t<drawOrder>%d</drawOrder>\n", zoom);
+   appendf(kml, "\t\t\t<Icon>\n");
+   appendf(kml, "\t\t\t\t<href>%d%s</href>\n", yIndex, fileExt.c_str());
+   appendf(kml, "\t\t\t</Icon>\n");
+   appendf(kml, "\t\t\t<gx:LatLonQuad>\n");
+   appendf(kml, "\t\t\t\t<coordinates>\n");
+   appendf(kml, "\t\t\t\t\t%f, %f, 0\n", lowerleftT, leftbottomT);
+   appendf(kml, "\t\t\t\t\t%f, %f, 0\n", lowerrightT, rightbottomT);
+   appendf(kml, "\t\t\t\t\t%f, %f, 0\n", upperrightT, righttopT);
+   appendf(kml, "\t\t\t\t\t%f, %f, 0\n", upperleftT, lefttopT);
+   appendf(kml, "\t\t\t\t</coordinates>\n");
+   appendf(kml, "\t\t\t</gx:LatLonQuad>\n");
+   appendf(kml, "\t\t</GroundOverlay>\n");
 
    //generate lat, lon info and links for the previous zoom of kml
    for (ossim_uint32 i = 0; i < xchildren.size(); i++)
@@ -793,131 +1015,42 @@ bool ossimKmlSuperOverlayWriter::generateChildKml(ossimString filename,
             cnorth = urg.lat;
          }
 
-         fprintf(fp, "\t\t<NetworkLink>\n");
-         fprintf(fp, "\t\t\t<name>%d/%d/%d%s</name>\n", zoom+1, cx, cyIndex, fileExt.c_str());
-         fprintf(fp, "\t\t\t<Region>\n");
-         fprintf(fp, "\t\t\t\t<Lod>\n");
-         fprintf(fp, "\t\t\t\t\t<minLodPixels>128</minLodPixels>\n");
-         fprintf(fp, "\t\t\t\t\t<maxLodPixels>-1</maxLodPixels>\n");
-         fprintf(fp, "\t\t\t\t</Lod>\n");
-         fprintf(fp, "\t\t\t\t<LatLonAltBox>\n");
-         fprintf(fp, "\t\t\t\t\t<north>%f</north>\n", cnorth);
-         fprintf(fp, "\t\t\t\t\t<south>%f</south>\n", csouth);
-         fprintf(fp, "\t\t\t\t\t<east>%f</east>\n", ceast);
-         fprintf(fp, "\t\t\t\t\t<west>%f</west>\n", cwest);
-         fprintf(fp, "\t\t\t\t</LatLonAltBox>\n");
-         fprintf(fp, "\t\t\t</Region>\n");
-         fprintf(fp, "\t\t\t<Link>\n");
-         fprintf(fp, "\t\t\t\t<href>../../%d/%d/%d.kml</href>\n", zoom+1, cx, cyIndex);
-         fprintf(fp, "\t\t\t\t<viewRefreshMode>onRegion</viewRefreshMode>\n");
-         fprintf(fp, "\t\t\t\t<viewFormat/>\n");
-         fprintf(fp, "\t\t\t</Link>\n");
-         fprintf(fp, "\t\t</NetworkLink>\n");
+         appendf(kml, "\t\t<NetworkLink>\n");
+         appendf(kml, "\t\t\t<name>%d/%d/%d%s</name>\n", zoom+1, cx, cyIndex, fileExt.c_str());
+         appendf(kml, "\t\t\t<Region>\n");
+         appendf(kml, "\t\t\t\t<Lod>\n");
+         appendf(kml, "\t\t\t\t\t<minLodPixels>128</minLodPixels>\n");
+         appendf(kml, "\t\t\t\t\t<maxLodPixels>-1</maxLodPixels>\n");
+         appendf(kml, "\t\t\t\t</Lod>\n");
+         appendf(kml, "\t\t\t\t<LatLonAltBox>\n");
+         appendf(kml, "\t\t\t\t\t<north>%f</north>\n", cnorth);
+         appendf(kml, "\t\t\t\t\t<south>%f</south>\n", csouth);
+         appendf(kml, "\t\t\t\t\t<east>%f</east>\n", ceast);
+         appendf(kml, "\t\t\t\t\t<west>%f</west>\n", cwest);
+         appendf(kml, "\t\t\t\t</LatLonAltBox>\n");
+         appendf(kml, "\t\t\t</Region>\n");
+         appendf(kml, "\t\t\t<Link>\n");
+         appendf(kml, "\t\t\t\t<href>../../%d/%d/%d.kml</href>\n", zoom+1, cx, cyIndex);
+         appendf(kml, "\t\t\t\t<viewRefreshMode>onRegion</viewRefreshMode>\n");
+         appendf(kml, "\t\t\t\t<viewFormat/>\n");
+         appendf(kml, "\t\t\t</Link>\n");
+         appendf(kml, "\t\t</NetworkLink>\n");
       }
    }
 
-   fprintf(fp, "\t</Document>\n");
-   fprintf(fp, "</kml>\n");
-   fclose(fp);
-   return true;
+   appendf(kml, "\t</Document>\n");
+   appendf(kml, "</kml>\n");
 }
 
-bool ossimKmlSuperOverlayWriter::zipWithMinizip(std::vector<ossimString> srcFiles, ossimString srcDirectory, ossimString targetFile)
+ossim_uint32 ossimKmlSuperOverlayWriter::getNumberOfThreads() const
 {
-   zipFile zipfile = zipOpen(targetFile.c_str(), 0);
-   if (!zipfile)
-   {
-      ossimSetError(getClassName(),
-         ossimErrorCodes::OSSIM_ERROR,
-         "Unable to open target zip file..");
-      return false;
-   }
-
-   std::vector<ossimString>::iterator v1_Iter;
-   for(v1_Iter = srcFiles.begin(); v1_Iter != srcFiles.end(); v1_Iter++)
+   ossim_uint32 threads = std::thread::hardware_concurrency();
+   const char* lookup = ossimPreferences::instance()->findPreference(WRITE_THREADS_KW);
+   if (lookup)
    {
-      ossimString fileRead = *v1_Iter;
-
-      // Find relative path and open new file with zip file
-      std::string relativeFileReadPath = fileRead;
-      ossim_int32 remNumChars = srcDirectory.size();
-      if(remNumChars > 0)
-      {
-         ossim_int32 f = fileRead.find(srcDirectory.string());
-         if( f >= 0 )
-         {
-            relativeFileReadPath.erase(f, remNumChars + 1); // 1 added for backslash at the end
-         }      
-      }
-
-      std::basic_string<char>::iterator iter1;
-      for (iter1 = relativeFileReadPath.begin(); iter1 != relativeFileReadPath.end(); iter1++)
-      {
-         int f = relativeFileReadPath.find("\\");
-         if (f >= 0)
-         {
-            relativeFileReadPath.replace(f, 1, "/");
-         }
-         else
-         {
-            break;
-         }
-      }
-      if (zipOpenNewFileInZip(zipfile, relativeFileReadPath.c_str(), 0, 0, 0, 0, 0, 0, Z_DEFLATED, Z_DEFAULT_COMPRESSION) != ZIP_OK)
-      {
-         ossimSetError(getClassName(),
-            ossimErrorCodes::OSSIM_ERROR,
-            "Unable to create file within the zip file..");
-         return false;
-      }
-
-      // Read source file and write to zip file
-      std::fstream inFile (fileRead.c_str(), std::ios::binary | std::ios::in);
-      if (!inFile.is_open())
-      {
-         ossimSetError(getClassName(),
-            ossimErrorCodes::OSSIM_ERROR,
-            "Could not open source file..");
-         return false;
-      }
-      if (!inFile.good())
-      {
-         ossimSetError(getClassName(),
-            ossimErrorCodes::OSSIM_ERROR,
-            "Error reading source file..");
-         return false;
-      }
-
-      // Read file in buffer
-      std::string fileData;
-      const unsigned int bufSize = 1024;
-      char buf[bufSize];
-      do 
-      {
-         inFile.read(buf, bufSize);
-         fileData.append(buf, inFile.gcount());
-      } while (!inFile.eof() && inFile.good());
-
-      if (zipWriteInFileInZip(zipfile, static_cast<const void*>(fileData.data()), static_cast<unsigned int>(fileData.size())) != ZIP_OK )
-      {
-         ossimSetError(getClassName(),
-            ossimErrorCodes::OSSIM_ERROR,
-            "Could not write to file within zip file..");
-         return false;
-      }
-
-      // Close one src file zipped completely
-      if ( zipCloseFileInZip(zipfile) != ZIP_OK )
-      {
-         ossimSetError(getClassName(),
-            ossimErrorCodes::OSSIM_ERROR,
-            "Could not close file written within zip file..");
-         return false;
-      }
+      threads = ossimString(lookup).toUInt32();
    }
-
-   zipClose(zipfile, 0);
-   return true;
+   return (threads ? threads : 1);
 }
 
 void ossimKmlSuperOverlayWriter::propagateViewChange()
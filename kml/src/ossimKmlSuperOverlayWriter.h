@@ -19,14 +19,13 @@
 #include <ossim/base/ossimRefPtr.h>
 #include <ossim/base/ossimString.h>
 
-//minizip includes
-#include <minizip/zip.h>
-
 //std includes
 #include <iosfwd>
+#include <string>
 #include <vector>
 
 class ossimKeywordlist;
+class ossimImageData;
 class ossimMapProjection;
 
 class ossimKmlSuperOverlayWriter : public ossimImageFileWriter
@@ -126,15 +125,22 @@ protected:
     */
    virtual bool writeFile(); 
 
-   bool generateRootKml(ossimString filename, 
-                       ossim_float64 north, 
-                       ossim_float64 south, 
-                       ossim_float64 east, 
-                       ossim_float64 west, 
-                       ossim_int32 tilesize);
+   /**
+    * @brief Formats the root kml document.
+    * @param kml Initialized to the document.
+    */
+   void generateRootKml(ossim_float64 north, 
+                        ossim_float64 south, 
+                        ossim_float64 east, 
+                        ossim_float64 west, 
+                        ossim_int32 tilesize,
+                        std::string& kml);
 
-   bool generateChildKml(ossimString filename, 
-                         ossim_int32 zoom, 
+   /**
+    * @brief Formats the kml document of tile ix, iy at zoom.
+    * @param kml Initialized to the document.
+    */
+   void generateChildKml(ossim_int32 zoom, 
                          ossim_int32 yloop,
                          ossim_int32 ix, 
                          ossim_int32 iy, 
@@ -144,17 +150,24 @@ protected:
                          ossim_int32 ysize, 
                          ossim_int32 maxzoom, 
                          ossimRefPtr<ossimMapProjection> proj,
-                         ossimString fileExt);
+                         ossimString fileExt,
+                         std::string& kml);
 
-   void generateTile(ossimString filename, 
-                     ossim_int32 ix, 
-                     ossim_int32 iy, 
-                     ossim_int32 dxsize, 
-                     ossim_int32 dysize);
+   /**
+    * @brief Renders the image of tile ix, iy at the current zoom.
+    * @return Copy of the tile or null on error.
+    */
+   ossimRefPtr<ossimImageData> generateTile(ossim_int32 ix, 
+                                            ossim_int32 iy, 
+                                            ossim_int32 dxsize, 
+                                            ossim_int32 dysize);
 
-   bool zipWithMinizip(std::vector<ossimString> srcFiles, 
-                       ossimString srcDirectory, 
-                       ossimString targetFile);
+   /**
+    * @return Number of threads encoding tiles from the
+    * ossim.plugins.kml.writer.threads preference, defaults to the number
+    * of cores.
+    */
+   ossim_uint32 getNumberOfThreads() const;
 
    /**
     * @brief Sends a view interface visitor to the input connetion.  This will
@@ -163,7 +176,6 @@ protected:
     */
    void propagateViewChange();
 
-   ossimRefPtr<ossimImageFileWriter> m_imageWriter;
    ossimRefPtr<ossimMapProjection>   m_mapProjection;
    bool m_isKmz;
    bool m_isPngFormat;
@@ -14,6 +14,7 @@
 
 #include <ossimOpjCommon.h>
 #include <ossimOpjColor.h>
+#include <ossimOpjDecoder.h>
 #include <ossim/base/ossimCommon.h>
 #include <ossim/base/ossimException.h>
 #include <ossim/base/ossimIrect.h>
@@ -24,24 +25,17 @@
 
 #include <openjpeg.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <istream>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <vector>
 
 static ossimTrace traceDebug(ossimString("ossimOpjCommon:degug"));
 
-/** To hold stream and offset. */
-class opj_user_istream
-{
-public:
-   opj_user_istream() : m_str(0), m_offset(0), m_length(0){}
-   ~opj_user_istream(){ m_str = 0; } // We don't own stream.
-   std::istream*   m_str;
-   std::streamoff  m_offset;
-   std::streamsize m_length;
-};
-
 /** Callback method for errors. */
 void ossim::opj_error_callback(const char* msg, void* /* client_data */)
 {
@@ -60,86 +54,6 @@ void ossim::opj_info_callback(const char* /* msg */ , void* /* client_data */)
     //ossimNotify(ossimNotifyLevel_NOTICE) << msg << std::endl;
 }
 
-/** Callback function prototype for read function */ 
-static OPJ_SIZE_T ossim_opj_istream_read( void * p_buffer,
-                                          OPJ_SIZE_T p_nb_bytes,
-                                          void * p_user_data )
-{
-   OPJ_SIZE_T count = 0;
-   opj_user_istream* usrStr = static_cast<opj_user_istream*>(p_user_data);
-   if ( usrStr )
-   {
-      if ( usrStr->m_str )
-      {
-         std::streamsize bytesToRead = ossim::min<std::streamsize>(
-            (std::streamsize)p_nb_bytes,
-            (std::streamsize)(usrStr->m_length - usrStr->m_str->tellg() ) );
-         // std::streamsize left = usrStr->m_str->tellg();
-         usrStr->m_str->read( (char*) p_buffer, bytesToRead );
-         count = usrStr->m_str->gcount();
-         
-         if ( usrStr->m_str->eof() )
-         {
-            // Set back to front:
-            usrStr->m_str->clear();
-            usrStr->m_str->seekg(usrStr->m_offset, std::ios_base::beg);
-         }
-         else if ( !usrStr->m_str->good() )
-         {
-            usrStr->m_str->clear();
-            usrStr->m_str->seekg(usrStr->m_offset, std::ios_base::beg);
-            count = -1;
-         }
-      }
-   }
-   return count;
-}
-
-/** Callback function prototype for skip function */
-static OPJ_OFF_T ossim_opj_istream_skip(OPJ_OFF_T p_nb_bytes, void * p_user_data)
-{
-   OPJ_OFF_T skipped = p_nb_bytes;
-   opj_user_istream* usrStr = static_cast<opj_user_istream*>(p_user_data);
-   if ( usrStr )
-   {
-      if ( usrStr->m_str )
-      {
-         std::streampos p1 = usrStr->m_str->tellg();
-         usrStr->m_str->seekg( p_nb_bytes, std::ios_base::cur );
-         std::streampos p2 = usrStr->m_str->tellg();
-         if ( ( p2 - p1 ) !=  p_nb_bytes )
-         {
-            skipped = -1;
-         }
-      }
-   }
-   return skipped;
-}
-
-/** Callback function prototype for seek function */
-static OPJ_BOOL ossim_opj_istream_seek(OPJ_OFF_T p_nb_bytes, void * p_user_data)
-{
-   opj_user_istream* usrStr = static_cast<opj_user_istream*>(p_user_data);
-   if ( usrStr )
-   {
-      if ( usrStr->m_str )
-      {
-         usrStr->m_str->seekg( p_nb_bytes, std::ios_base::cur );
-      }
-   }
-   return OPJ_TRUE;
-}
-
-static void ossim_opj_free_user_istream_data( void * p_user_data )
-{
-   opj_user_istream* usrStr = static_cast<opj_user_istream*>(p_user_data);
-   if ( usrStr )
-   {
-      delete usrStr;
-   }
-   usrStr = 0;
-}
-
 bool ossim::opj_decode( std::ifstream* in,
                         const ossimIrect& rect,
                         ossim_uint32 resLevel,
@@ -161,230 +75,120 @@ bool ossim::opj_decode( std::ifstream* in,
    // Need to check for NAN in rect
    if ( in && tile && !rect.hasNans())
    {
-      in->seekg( fileOffset, std::ios_base::beg );
-
-      opj_dparameters_t param;
-      opj_codec_t*      codec = 0;
-      opj_image_t*      image = 0;;
-      opj_stream_t*     stream = 0;
-
-      opj_user_istream* userStream = new opj_user_istream();
-      userStream->m_str = in;
-      userStream->m_offset = fileOffset;
-
-      /* Set the length to avoid an assert */
-      in->seekg(0, std::ios_base::end);
-
-      // Fix: length must be passed in for nift blocks.
-      userStream->m_length = in->tellg();
+      // One shot decode.  Readers decoding many tiles keep an ossimOpjDecoder.
+      ossimOpjDecoder decoder( in, format, fileOffset, resLevel );
+      opj_image_t* image = decoder.decodeRegion( rect );
+      status = ossim::copyOpjImage(image, tile);
 
-      // Set back to front:
-      in->clear();
-      in->seekg(fileOffset, std::ios_base::beg);
-      
-      stream = opj_stream_default_create(OPJ_TRUE);
-      if (!stream)
+      if ( in->eof() )
       {
-         opj_stream_destroy(stream);
-         std::string errMsg = MODULE;
-         errMsg += " ERROR: opj_setup_decoder failed!";
-         throw ossimException(errMsg);
+         in->clear();
       }
+      in->seekg(fileOffset, std::ios_base::beg );
       
-      opj_stream_set_read_function(stream, ossim_opj_istream_read);
-      opj_stream_set_skip_function(stream, ossim_opj_istream_skip);
-      opj_stream_set_seek_function(stream, ossim_opj_istream_seek);
-
-      // Fix: length must be passed in for nift blocks.
-      opj_stream_set_user_data_length(stream, userStream->m_length);
-      
-      opj_stream_set_user_data(stream, userStream,
-                               ossim_opj_free_user_istream_data);
-
-      opj_stream_set_user_data_length(stream, userStream->m_length);
-
-      
-      /* Set the default decoding parameters */
-      opj_set_default_decoder_parameters(&param);
-
-      param.decod_format = format;
-
-      /** you may here add custom decoding parameters */
-      /* do not use layer decoding limitations */
-      param.cp_layer = 0;
-
-      /* do not use resolutions reductions */
-      param.cp_reduce = resLevel;
-
-      codec = opj_create_decompress( (CODEC_FORMAT)format );
+   } // Matches: if ( in && tile )
 
-      // catch events using our callbacks and give a local context
-      //opj_set_info_handler   (codec, ossim::opj_info_callback,   00);
-      opj_set_info_handler   (codec, NULL,   00);
-      opj_set_warning_handler(codec, ossim::opj_warning_callback,00);
-      opj_set_error_handler  (codec, ossim::opj_error_callback,  00);
+   return status;
+   
+} // End: ossim::opj_decode( ... )
 
-      // Setup the decoder decoding parameters using user parameters
-      if ( opj_setup_decoder(codec, &param) == false )
+//---
+// Component conversion kernels.  Each converts a whole component in one
+// pass over contiguous memory with no branches in the loop body so the
+// compiler can vectorize it: clamp in int32 then narrow.
+//---
+namespace
+{
+   template <class T> void convertComponent( const OPJ_INT32* src,
+                                             T* dest,
+                                             ossim_uint32 count )
+   {
+      const OPJ_INT32 MIN_VALUE = (OPJ_INT32)std::numeric_limits<T>::min();
+      const OPJ_INT32 MAX_VALUE = (OPJ_INT32)std::numeric_limits<T>::max();
+      for ( ossim_uint32 i = 0; i < count; ++i )
       {
-         opj_stream_destroy(stream);
-         opj_destroy_codec(codec);
-         std::string errMsg = MODULE;
-         errMsg += " ERROR: opj_setup_decoder failed!";
-         throw ossimException(errMsg);
+         dest[i] = (T)std::min( std::max( src[i], MIN_VALUE ), MAX_VALUE );
       }
+   }
+
+   template <> void convertComponent( const OPJ_INT32* src,
+                                      ossim_sint32* dest,
+                                      ossim_uint32 count )
+   {
+      std::memcpy( dest, src, count * sizeof(ossim_sint32) );
+   }
 
-      // Read the main header of the codestream and if necessary the JP2 boxes.
-      if ( opj_read_header(stream, codec, &image) == false )
+   template <> void convertComponent( const OPJ_INT32* src,
+                                      ossim_uint32* dest,
+                                      ossim_uint32 count )
+   {
+      for ( ossim_uint32 i = 0; i < count; ++i )
       {
-         opj_stream_destroy(stream);
-         opj_destroy_codec(codec);
-         opj_image_destroy(image);         
-         std::string errMsg = MODULE;
-         errMsg += " ERROR: opj_read_header failed!";
-         throw ossimException(errMsg);
+         dest[i] = (ossim_uint32)std::max( src[i], 0 );
       }
+   }
 
-      // tmp drb:
-      // opj_stream_destroy(stream);
-      // return;
-      
-      if ( opj_set_decoded_resolution_factor(codec, resLevel) == false)
+   template <> void convertComponent( const OPJ_INT32* src,
+                                      ossim_float32* dest,
+                                      ossim_uint32 count )
+   {
+      for ( ossim_uint32 i = 0; i < count; ++i )
       {
-         opj_stream_destroy(stream);
-         opj_destroy_codec(codec);
-         opj_image_destroy(image);
-         std::string errMsg = MODULE;
-         errMsg += " ERROR:  opj_set_decoded_resolution_factor failed!";
-         throw ossimException(errMsg);
+         dest[i] = (ossim_float32)src[i];
       }
+   }
 
-      //ossim_float32 res = resLevel;
-      ossimIrect resRect = rect * (1 << resLevel);
-
-      //std::cout << "resRect.ul(): " << resRect.ul()
-      //          << "\nresRect.lr(): " << resRect.lr()
-      //          << std::endl;
+   //---
+   // The image belongs to the decoder, which may decode into it or serve it
+   // again, so the sycc to rgb conversion, which replaces the component
+   // buffers, is done on copies of the first three components.
+   //---
+   bool copyOpjSyccImage( const opj_image* image, ossimImageData* tile )
+   {
+      bool status = false;
 
-//      if ( opj_set_decode_area(codec, image, rect.ul().x, rect.ul().y,
-//                               rect.lr().x+1, rect.lr().y+1) == false )
-      if ( opj_set_decode_area(codec, image, resRect.ul().x, resRect.ul().y,
-                               resRect.lr().x+1, resRect.lr().y+1) == false )
-      {
-         opj_stream_destroy(stream);
-         opj_destroy_codec(codec);
-         opj_image_destroy(image);
-         std::string errMsg = MODULE;
-         errMsg += " ERROR: opj_set_decode_area failed!";
-         throw ossimException(errMsg);
-      }
+      opj_image_t rgbImage = *image;
+      std::vector<opj_image_comp_t> comps( image->comps, image->comps + image->numcomps );
+      rgbImage.comps = &comps.front();
 
-      // Get the decoded image:
-      if ( opj_decode(codec, stream, image) == false )
+      bool allocated = true;
+      for ( ossim_uint32 i = 0; i < 3; ++i )
       {
-         opj_stream_destroy(stream);
-         opj_destroy_codec(codec);
-         opj_image_destroy(image);
-         std::string errMsg = MODULE;
-         errMsg += " ERROR: opj_decode failed!";
-         throw ossimException(errMsg);
-      }
-      
-      // ossim::print(std::cout, *image);
-      if(image->icc_profile_buf) {
-#if defined(OPJ_HAVE_LIBLCMS1) || defined(OPJ_HAVE_LIBLCMS2)
-          color_apply_icc_profile(image); /* FIXME */
-#endif
-          free(image->icc_profile_buf);
-          image->icc_profile_buf = NULL; image->icc_profile_len = 0;
+         std::size_t size = (std::size_t)comps[i].w * comps[i].h * sizeof(OPJ_INT32);
+         comps[i].data = image->comps[i].data ? (OPJ_INT32*)std::malloc( size ) : 0;
+         if ( comps[i].data )
+         {
+            std::memcpy( comps[i].data, image->comps[i].data, size );
+         }
+         else
+         {
+            allocated = false;
+         }
       }
 
-      status = ossim::copyOpjImage(image, tile);
-      
-#if 0
-      ossim_uint32 tile_index      = 0;
-      ossim_uint32 data_size       = 0;
-      ossim_int32  current_tile_x0 = 0;
-      ossim_int32  current_tile_y0 = 0;
-      ossim_int32  current_tile_x1 = 0;
-      ossim_int32  current_tile_y1 = 0;
-      ossim_uint32 nb_comps        = 0;
-      OPJ_BOOL go_on = 1;
-
-      if ( opj_read_tile_header( codec,
-                                 stream,
-                                 &tile_index,
-                                 &data_size,
-                                 &current_tile_x0,
-                                 &current_tile_y0,
-                                 &current_tile_x1,
-                                 &current_tile_y1,
-                                 &nb_comps,
-                                 &go_on) == false )
+      if ( allocated )
       {
-         opj_stream_destroy(stream);
-         opj_destroy_codec(codec);
-         opj_image_destroy(image);
-         std::string errMsg = MODULE;
-         errMsg += " ERROR: opj_read_tile_header failed!";
-         throw ossimException(errMsg);
-      }
-#endif
-
-#if 0
-      std::cout << "tile_index:      " << tile_index
-                << "\ndata_size:       " << data_size
-                << "\ncurrent_tile_x0: " << current_tile_x0
-                << "\ncurrent_tile_y0: " << current_tile_y0
-                << "\ncurrent_tile_x1: " << current_tile_x1
-                << "\ncurrent_tile_y1: " << current_tile_y1
-                << "\nnb_comps:        " << nb_comps
-                << std::endl;
-#endif
-
-#if 0
-      if ( opj_decode_tile_data(codec, tile_index,l_data,l_data_size,l_stream) == false)
-      {
-         opj_stream_destroy(l_stream);
-         opj_destroy_codec(l_codec);
-         opj_image_destroy(l_image);
-         std::string errMsg = MODULE;
-         errMsg += " ERROR: opj_read_tile_header failed!";
-         throw ossimException(errMsg);
+         ossim::color_sycc_to_rgb( &rgbImage );
+         if ( rgbImage.color_space == OPJ_CLRSPC_SRGB )
+         {
+            status = ossim::copyOpjImage( &rgbImage, tile );
+         }
+         else
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << "ossim::copyOpjImage WARNING!\nUnhandled sycc subsampling.\n";
+         }
       }
-#endif
-
-#if 0
-      
-      if (opj_end_decompress(codec,stream) == false )
-      {
-         opj_stream_destroy(stream);
-         opj_destroy_codec(codec);
-         opj_image_destroy(image);
-         std::string errMsg = MODULE;
-         errMsg += " ERROR: opj_end_decompress failed!";
-         throw ossimException(errMsg);
-      } 
-
-#endif
-      
-      /* Free memory */
-      opj_stream_destroy(stream);
-      opj_destroy_codec(codec);
-      opj_image_destroy(image);
 
-      // Tmp drb:
-      if ( in->eof() )
+      // color_sycc_to_rgb mallocs the converted buffers.
+      for ( ossim_uint32 i = 0; i < 3; ++i )
       {
-         in->clear();
+         std::free( comps[i].data );
       }
-      in->seekg(fileOffset, std::ios_base::beg );
-      
-   } // Matches: if ( in && tile )
 
-   return status;
-   
-} // End: ossim::opj_decode( ... )
+      return status;
+   }
+}
 
 bool ossim::copyOpjImage( opj_image* image, ossimImageData* tile )
 {
@@ -392,18 +196,65 @@ bool ossim::copyOpjImage( opj_image* image, ossimImageData* tile )
    
    if ( image && tile )
    {
-      if ( image->color_space == OPJ_CLRSPC_SRGB )
+      if ( ( image->color_space == OPJ_CLRSPC_SYCC ) && ( image->numcomps >= 3 ) )
+      {
+         status = copyOpjSyccImage( image, tile );
+      }
+      else if ( ( image->color_space == OPJ_CLRSPC_SRGB ) ||
+                ( image->color_space == OPJ_CLRSPC_GRAY ) ||
+                ( image->color_space == OPJ_CLRSPC_SYCC ) || // One or two bands, gray.
+                ( image->color_space == OPJ_CLRSPC_UNSPECIFIED ) )
       {
          const ossimScalarType SCALAR = tile->getScalarType();
-         if ( SCALAR == OSSIM_UINT8 )
-         {
-            status = ossim::copyOpjSrgbImage( ossim_uint8(0), image, tile );
-         }
-         else
+         switch ( SCALAR )
          {
-            ossimNotify(ossimNotifyLevel_WARN)
-               << "ossim::copyOpjImage WARNING!\nUnhandle scalar: "
-               << SCALAR << "\n";
+            case OSSIM_UINT8:
+            {
+               status = ossim::copyOpjSrgbImage( ossim_uint8(0), image, tile );
+               break;
+            }
+            case OSSIM_SINT8:
+            {
+               status = ossim::copyOpjSrgbImage( ossim_sint8(0), image, tile );
+               break;
+            }
+            case OSSIM_UINT16:
+            case OSSIM_USHORT11:
+            case OSSIM_USHORT12:
+            case OSSIM_USHORT13:
+            case OSSIM_USHORT14:
+            case OSSIM_USHORT15:
+            {
+               status = ossim::copyOpjSrgbImage( ossim_uint16(0), image, tile );
+               break;
+            }
+            case OSSIM_SINT16:
+            {
+               status = ossim::copyOpjSrgbImage( ossim_sint16(0), image, tile );
+               break;
+            }
+            case OSSIM_UINT32:
+            {
+               status = ossim::copyOpjSrgbImage( ossim_uint32(0), image, tile );
+               break;
+            }
+            case OSSIM_SINT32:
+            {
+               status = ossim::copyOpjSrgbImage( ossim_sint32(0), image, tile );
+               break;
+            }
+            case OSSIM_FLOAT32:
+            {
+               status = ossim::copyOpjSrgbImage( ossim_float32(0), image, tile );
+               break;
+            }
+            default:
+            {
+               ossimNotify(ossimNotifyLevel_WARN)
+                  << "ossim::copyOpjImage WARNING!\nUnhandle scalar: "
+                  << SCALAR << "\n";
+               break;
+            }
          }
       }
       else
@@ -421,58 +272,39 @@ template <class T> bool ossim::copyOpjSrgbImage( T /* dummy */,
                                                  opj_image* image,
                                                  ossimImageData* tile )
 {
-   bool status = false;
-   
    const ossim_uint32 BANDS = tile->getNumberOfBands();
+   const ossim_uint32 LINES = tile->getHeight();
+   const ossim_uint32 SAMPS = tile->getWidth();
+
+   if ( image->numcomps != BANDS )
+   {
+      ossimNotify(ossimNotifyLevel_WARN)
+         << "ossim::copyOpjSrgbImage WARNING: band mismatch!\n";
+      return false;
+   }
 
-   if ( image->numcomps == BANDS )
+   // Check all components up front so nothing is copied on a mismatch.
+   for ( ossim_uint32 band = 0; band < BANDS; ++band )
    {
-      for ( ossim_uint32 band = 0; band < BANDS; ++band )
+      if ( !image->comps[band].data ||
+           ( image->comps[band].w != SAMPS ) ||
+           ( image->comps[band].h != LINES ) )
       {
-         T* buf = (T*)tile->getBuf(band);
-         const ossim_uint32 LINES = tile->getHeight();
-         
-         if ( image->comps[band].h == LINES )
-         {
-            ossim_uint32 offset = 0;
-            for ( ossim_uint32 line = 0; line < LINES; ++line )
-            {
-               const ossim_uint32 SAMPS = tile->getWidth();
-               if ( image->comps[band].w == SAMPS )
-               {
-                  for ( ossim_uint32 samp = 0; samp < SAMPS; ++samp )
-                  {
-                     buf[offset] = (T)(image->comps[band].data[offset]);
-                     ++offset;
-                  }
-
-                  //---
-                  // If we get here all the dimensions match and things sould
-                  // be good.
-                  //---
-                  status = true;
-               }
-               else
-               {
-                  ossimNotify(ossimNotifyLevel_WARN)
-                     << "ossim::copyOpjSrgbImage WARNING: sample mismatch!\n";
-               }
-            }
-         }
-         else
-         {
-            ossimNotify(ossimNotifyLevel_WARN)
-               << "ossim::copyOpjSrgbImage WARNING: line mismatch!\n";
-         } 
+         ossimNotify(ossimNotifyLevel_WARN)
+            << "ossim::copyOpjSrgbImage WARNING: size mismatch on band "
+            << band << "!\n";
+         return false;
       }
    }
-   else
+
+   // Components and tile bands are both contiguous so each is one pass.
+   const ossim_uint32 COUNT = LINES * SAMPS;
+   for ( ossim_uint32 band = 0; band < BANDS; ++band )
    {
-      ossimNotify(ossimNotifyLevel_WARN)
-               << "ossim::copyOpjSrgbImage WARNING: band mismatch!\n";
+      convertComponent( image->comps[band].data, (T*)tile->getBuf(band), COUNT );
    }
 
-   return status;
+   return ( COUNT > 0 );
    
 } // End: ossim::copyOpjSrgbImage( ... )
 
@@ -47,6 +47,12 @@ namespace ossim
                     ossimImageData* tile
                     );
    
+   /**
+    * @brief Copies decoded components into tile, converting to the tile
+    * scalar type with clamping.  Sycc is converted to rgb first, on a copy
+    * so image is left untouched.
+    * @return true on success, false if the image does not match the tile.
+    */
    bool copyOpjImage( opj_image* image, ossimImageData* tile );
    
    template <class T> bool copyOpjSrgbImage( T dummy,
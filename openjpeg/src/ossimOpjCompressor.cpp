@@ -246,6 +246,20 @@ void ossimOpjCompressor::create(std::ostream* os,
       throw ossimException(errMsg); 
    }
 
+   //---
+   // Code-blocks of a tile are encoded on m_threads threads.  Must be set
+   // after opj_setup_encoder and before opj_start_compress.  Encoder
+   // threading is only available from OpenJPEG 2.4.
+   //---
+#if (OPJ_VERSION_MAJOR > 2) || ( (OPJ_VERSION_MAJOR == 2) && (OPJ_VERSION_MINOR >= 4) )
+   if ( ( m_threads > 1 ) && !opj_codec_set_threads( m_codec, m_threads ) )
+   {
+      ossimNotify(ossimNotifyLevel_WARN)
+         << MODULE << " WARNING: opj_codec_set_threads failed for "
+         << m_threads << " threads.  Encoding on one thread.\n";
+   }
+#endif
+
    // openJp2Codestream();
    
    if ( traceDebug() )
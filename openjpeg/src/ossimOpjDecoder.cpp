@@ -0,0 +1,291 @@
+//----------------------------------------------------------------------------
+//
+// License:  See top level LICENSE.txt file
+//
+// Description: OpenJPEG decoder context.
+//
+//----------------------------------------------------------------------------
+// $Id$
+
+#include <ossimOpjDecoder.h>
+#include <ossimOpjColor.h>
+#include <ossimOpjCommon.h>
+#include <ossim/base/ossimCommon.h>
+#include <ossim/base/ossimException.h>
+#include <ossim/base/ossimIrect.h>
+#include <ossim/base/ossimNotify.h>
+#include <ossim/base/ossimString.h>
+#include <ossim/base/ossimTrace.h>
+
+#include <cstdlib>
+#include <istream>
+
+static ossimTrace traceDebug(ossimString("ossimOpjDecoder:debug"));
+
+/**
+ * To hold stream, offset and the read position.  The position is kept here
+ * and seeked to on every read since the std::istream may be shared by
+ * other decoders.
+ */
+class opj_user_istream
+{
+public:
+   opj_user_istream() : m_str(0), m_offset(0), m_length(0), m_pos(0){}
+   ~opj_user_istream(){ m_str = 0; } // We don't own stream.
+   std::istream*   m_str;
+   std::streamoff  m_offset;
+   std::streamsize m_length; // Bytes from m_offset to end of file.
+   std::streamoff  m_pos;    // Relative to m_offset.
+};
+
+/** Callback function prototype for read function */
+static OPJ_SIZE_T ossim_opj_istream_read( void * p_buffer,
+                                          OPJ_SIZE_T p_nb_bytes,
+                                          void * p_user_data )
+{
+   OPJ_SIZE_T count = (OPJ_SIZE_T)-1;
+   opj_user_istream* usrStr = static_cast<opj_user_istream*>(p_user_data);
+   if ( usrStr && usrStr->m_str )
+   {
+      std::streamsize bytesToRead = ossim::min<std::streamsize>(
+         (std::streamsize)p_nb_bytes,
+         (std::streamsize)(usrStr->m_length - usrStr->m_pos) );
+      if ( bytesToRead > 0 )
+      {
+         usrStr->m_str->clear();
+         usrStr->m_str->seekg( usrStr->m_offset + usrStr->m_pos, std::ios_base::beg );
+         usrStr->m_str->read( (char*) p_buffer, bytesToRead );
+         std::streamsize bytesRead = usrStr->m_str->gcount();
+         if ( bytesRead > 0 )
+         {
+            usrStr->m_pos += bytesRead;
+            count = (OPJ_SIZE_T)bytesRead;
+         }
+         if ( !usrStr->m_str->good() )
+         {
+            usrStr->m_str->clear();
+         }
+      }
+   }
+   return count; // (OPJ_SIZE_T)-1 signals end of stream.
+}
+
+/** Callback function prototype for skip function */
+static OPJ_OFF_T ossim_opj_istream_skip(OPJ_OFF_T p_nb_bytes, void * p_user_data)
+{
+   OPJ_OFF_T skipped = -1;
+   opj_user_istream* usrStr = static_cast<opj_user_istream*>(p_user_data);
+   if ( usrStr )
+   {
+      std::streamoff pos = usrStr->m_pos + p_nb_bytes;
+      if ( ( pos >= 0 ) && ( pos <= usrStr->m_length ) )
+      {
+         usrStr->m_pos = pos;
+         skipped = p_nb_bytes;
+      }
+   }
+   return skipped;
+}
+
+/** Callback function prototype for seek function.  p_nb_bytes is absolute. */
+static OPJ_BOOL ossim_opj_istream_seek(OPJ_OFF_T p_nb_bytes, void * p_user_data)
+{
+   OPJ_BOOL status = OPJ_FALSE;
+   opj_user_istream* usrStr = static_cast<opj_user_istream*>(p_user_data);
+   if ( usrStr && ( p_nb_bytes >= 0 ) && ( p_nb_bytes <= usrStr->m_length ) )
+   {
+      usrStr->m_pos = p_nb_bytes;
+      status = OPJ_TRUE;
+   }
+   return status;
+}
+
+static void ossim_opj_free_user_istream_data( void * p_user_data )
+{
+   opj_user_istream* usrStr = static_cast<opj_user_istream*>(p_user_data);
+   if ( usrStr )
+   {
+      delete usrStr;
+   }
+   usrStr = 0;
+}
+
+ossimOpjDecoder::ossimOpjDecoder( std::istream* in,
+                                  ossim_int32 format,
+                                  std::streamoff fileOffset,
+                                  ossim_uint32 resLevel )
+   :
+   m_resLevel(resLevel),
+   m_codec(0),
+   m_stream(0),
+   m_image(0)
+{
+   static const char MODULE[] = "ossimOpjDecoder::ossimOpjDecoder";
+
+   if ( !in )
+   {
+      std::string errMsg = MODULE;
+      errMsg += " ERROR: null stream!";
+      throw ossimException(errMsg);
+   }
+
+   opj_user_istream* userStream = new opj_user_istream();
+   userStream->m_str = in;
+   userStream->m_offset = fileOffset;
+
+   // Length is found once here rather than on every tile.
+   in->clear();
+   in->seekg(0, std::ios_base::end);
+   userStream->m_length = (std::streamsize)in->tellg() - fileOffset;
+   in->seekg(fileOffset, std::ios_base::beg);
+
+   m_stream = opj_stream_default_create(OPJ_TRUE);
+   if (!m_stream)
+   {
+      delete userStream;
+      std::string errMsg = MODULE;
+      errMsg += " ERROR: opj_stream_default_create failed!";
+      throw ossimException(errMsg);
+   }
+
+   opj_stream_set_read_function(m_stream, ossim_opj_istream_read);
+   opj_stream_set_skip_function(m_stream, ossim_opj_istream_skip);
+   opj_stream_set_seek_function(m_stream, ossim_opj_istream_seek);
+   opj_stream_set_user_data(m_stream, userStream,
+                            ossim_opj_free_user_istream_data);
+
+   // Fix: length must be passed in for nift blocks.
+   opj_stream_set_user_data_length(m_stream, userStream->m_length);
+
+   /* Set the default decoding parameters */
+   opj_dparameters_t param;
+   opj_set_default_decoder_parameters(&param);
+   param.decod_format = format;
+
+   /* do not use layer decoding limitations */
+   param.cp_layer = 0;
+   param.cp_reduce = resLevel;
+
+   m_codec = opj_create_decompress( (CODEC_FORMAT)format );
+
+   // catch events using our callbacks and give a local context
+   opj_set_info_handler   (m_codec, NULL,   00);
+   opj_set_warning_handler(m_codec, ossim::opj_warning_callback,00);
+   opj_set_error_handler  (m_codec, ossim::opj_error_callback,  00);
+
+   // Setup the decoder decoding parameters using user parameters
+   if ( opj_setup_decoder(m_codec, &param) == false )
+   {
+      destroy();
+      std::string errMsg = MODULE;
+      errMsg += " ERROR: opj_setup_decoder failed!";
+      throw ossimException(errMsg);
+   }
+
+   // Read the main header of the codestream and if necessary the JP2 boxes.
+   if ( opj_read_header(m_stream, m_codec, &m_image) == false )
+   {
+      destroy();
+      std::string errMsg = MODULE;
+      errMsg += " ERROR: opj_read_header failed!";
+      throw ossimException(errMsg);
+   }
+
+   if ( opj_set_decoded_resolution_factor(m_codec, resLevel) == false)
+   {
+      destroy();
+      std::string errMsg = MODULE;
+      errMsg += " ERROR:  opj_set_decoded_resolution_factor failed!";
+      throw ossimException(errMsg);
+   }
+
+   if ( traceDebug() )
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << MODULE << " DEBUG: opened resLevel " << resLevel << "\n";
+   }
+}
+
+ossimOpjDecoder::~ossimOpjDecoder()
+{
+   destroy();
+}
+
+opj_image_t* ossimOpjDecoder::decodeTile( ossim_uint32 tileIndex )
+{
+   static const char MODULE[] = "ossimOpjDecoder::decodeTile";
+
+   if ( opj_get_decoded_tile(m_codec, m_stream, m_image, tileIndex) == false )
+   {
+      std::string errMsg = MODULE;
+      errMsg += " ERROR: opj_get_decoded_tile failed!";
+      throw ossimException(errMsg);
+   }
+
+   applyIccProfile();
+
+   return m_image;
+}
+
+opj_image_t* ossimOpjDecoder::decodeRegion( const ossimIrect& rect )
+{
+   static const char MODULE[] = "ossimOpjDecoder::decodeRegion";
+
+   // Decode area is given in full resolution coordinates.
+   ossimIrect resRect = rect * (1 << m_resLevel);
+
+   if ( opj_set_decode_area(m_codec, m_image, resRect.ul().x, resRect.ul().y,
+                            resRect.lr().x+1, resRect.lr().y+1) == false )
+   {
+      std::string errMsg = MODULE;
+      errMsg += " ERROR: opj_set_decode_area failed!";
+      throw ossimException(errMsg);
+   }
+
+   if ( opj_decode(m_codec, m_stream, m_image) == false )
+   {
+      std::string errMsg = MODULE;
+      errMsg += " ERROR: opj_decode failed!";
+      throw ossimException(errMsg);
+   }
+
+   applyIccProfile();
+
+   return m_image;
+}
+
+ossim_uint32 ossimOpjDecoder::getResLevel() const
+{
+   return m_resLevel;
+}
+
+void ossimOpjDecoder::applyIccProfile()
+{
+   if(m_image->icc_profile_buf)
+   {
+#if defined(OPJ_HAVE_LIBLCMS1) || defined(OPJ_HAVE_LIBLCMS2)
+      ossim::color_apply_icc_profile(m_image); /* FIXME */
+#endif
+      free(m_image->icc_profile_buf);
+      m_image->icc_profile_buf = NULL; m_image->icc_profile_len = 0;
+   }
+}
+
+void ossimOpjDecoder::destroy()
+{
+   if ( m_stream )
+   {
+      opj_stream_destroy(m_stream);
+      m_stream = 0;
+   }
+   if ( m_codec )
+   {
+      opj_destroy_codec(m_codec);
+      m_codec = 0;
+   }
+   if ( m_image )
+   {
+      opj_image_destroy(m_image);
+      m_image = 0;
+   }
+}
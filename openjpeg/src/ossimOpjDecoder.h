@@ -0,0 +1,86 @@
+//----------------------------------------------------------------------------
+//
+// License:  See top level LICENSE.txt file
+//
+// Description: OpenJPEG decoder context.
+//
+// Holds an opened codec, stream and parsed main header for one reduced
+// resolution level so tiles can be decoded without reparsing the
+// codestream on every request.
+//
+//----------------------------------------------------------------------------
+// $Id$
+
+#ifndef ossimOpjDecoder_HEADER
+#define ossimOpjDecoder_HEADER 1
+
+#include <ossim/base/ossimConstants.h>
+#include <openjpeg.h>
+#include <iosfwd>
+
+class ossimIrect;
+
+class ossimOpjDecoder
+{
+public:
+
+   /**
+    * @brief Creates the codec and stream and reads the main header.
+    *
+    * Throws ossimException on error.
+    *
+    * @param in Stream to read.  Not owned.  The decoder seeks before every
+    * read so several decoders may share it.
+    * @param format OPJ_CODEC_FORMAT.
+    * @param fileOffset Offset of the codestream or jp2 file, e.g. for nitf.
+    * @param resLevel Reduced resolution level to decode.
+    */
+   ossimOpjDecoder( std::istream* in,
+                    ossim_int32 format,
+                    std::streamoff fileOffset,
+                    ossim_uint32 resLevel );
+
+   ~ossimOpjDecoder();
+
+   /**
+    * @brief Decodes one J2K tile.
+    *
+    * Throws ossimException on error.
+    *
+    * @param tileIndex Index of the tile in the codestream tile grid.
+    * @return Image owned by the decoder.  Component data and origin are
+    * valid until the next decode call.
+    */
+   opj_image_t* decodeTile( ossim_uint32 tileIndex );
+
+   /**
+    * @brief Decodes an area.
+    *
+    * OpenJPEG only supports a second call on the same decoder for single
+    * tiled codestreams and from version 2.3; otherwise use a new decoder
+    * per area.
+    *
+    * Throws ossimException on error.
+    *
+    * @param rect Area in codestream coordinates at the decoder's resLevel.
+    * @return Image owned by the decoder.  Component data and origin are
+    * valid until the next decode call.
+    */
+   opj_image_t* decodeRegion( const ossimIrect& rect );
+
+   ossim_uint32 getResLevel() const;
+
+private:
+
+   /** Applies and drops an embedded icc profile. */
+   void applyIccProfile();
+
+   void destroy();
+
+   ossim_uint32  m_resLevel;
+   opj_codec_t*  m_codec;
+   opj_stream_t* m_stream;
+   opj_image_t*  m_image;
+};
+
+#endif /* #ifndef ossimOpjDecoder_HEADER */
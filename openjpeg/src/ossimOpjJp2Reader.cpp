@@ -42,8 +42,14 @@
 #include <ossim/support_data/ossimTiffInfo.h>
 #include <ossim/support_data/ossimTiffWorld.h>
 
+#include <ossimOpjCommon.h>
+#include <ossimOpjDecoder.h>
+#include <ossim/base/ossimPreferences.h>
+
 #include <openjpeg.h>
+#include <opj_config.h>
 #include <fstream>
+#include <memory>
 
 RTTI_DEF1(ossimOpjJp2Reader, "ossimOpjJp2Reader", ossimImageHandler)
 
@@ -56,6 +62,14 @@ static ossimTrace traceDebug(ossimString("ossimOpjJp2Reader:degug"));
 static const ossim_uint16 SOC_MARKER = 0xff4f; // start of codestream marker
 static const ossim_uint16 SIZ_MARKER = 0xff51; // size maker
 
+static const char CACHE_TILES_KW[] = "ossim.plugins.openjpeg.reader.cache_tiles";
+
+//---
+// J2K tiles larger than this at the requested level are not decoded whole;
+// the request area is decoded instead.
+//---
+static const ossim_uint32 MAX_DECODED_TILE_DIM = 2048;
+
 
 ossimOpjJp2Reader::ossimOpjJp2Reader()
    :
@@ -63,8 +77,19 @@ ossimOpjJp2Reader::ossimOpjJp2Reader()
    m_sizRecord(),
    m_tile(0),
    m_str(0),
-   m_minDwtLevels(0)
+   m_minDwtLevels(0),
+   m_decoders(),
+   m_tileLru(),
+   m_tileCache(),
+   m_maxCachedTiles(16),
+   m_spareTile(0)
 {
+   const char* lookup = ossimPreferences::instance()->findPreference(CACHE_TILES_KW);
+   if ( lookup )
+   {
+      m_maxCachedTiles = ossimString(lookup).toUInt32();
+   }
+
    // Uncomment to enable trace for debug:
    // traceDebug.setTraceFlag(true); 
    
@@ -88,6 +113,9 @@ void ossimOpjJp2Reader::destroy()
 {
    m_tile      = 0;  // ossimRefPtr
    m_cacheTile = 0;  // ossimRefPtr   
+
+   // Decoders read from m_str so go first.
+   deleteDecoders();
    
    if ( m_str )
    {
@@ -261,21 +289,102 @@ bool ossimOpjJp2Reader::getOverviewTile(ossim_uint32 resLevel,
                << std::endl;
          }
 
-         m_cacheTile->setImageRectangle( clipRect );
-         
          try
          {
-            status = ossim::opj_decode( m_str,
-                                        shiftedRect,
-                                        resLevel,
-                                        m_format,
-                                        0,
-                                        m_cacheTile.get() );
+            //---
+            // Decode whole J2K tiles through the cache with the persistent
+            // decoder for resLevel.  Requests on images with J2K tiles too
+            // big to hold decode just the area.
+            //---
+            const ossim_uint32 TILE_W = m_sizRecord.m_XTsiz;
+            const ossim_uint32 TILE_H = m_sizRecord.m_YTsiz;
+            const ossim_uint32 REDUCED_W = (TILE_W + (1 << resLevel) - 1) >> resLevel;
+            const ossim_uint32 REDUCED_H = (TILE_H + (1 << resLevel) - 1) >> resLevel;
+
+            if ( clipRect.hasNans() || !clipRect.width() || !clipRect.height() )
+            {
+               status = false;
+            }
+            else if ( TILE_W && TILE_H && m_maxCachedTiles &&
+                      ( REDUCED_W <= MAX_DECODED_TILE_DIM ) &&
+                      ( REDUCED_H <= MAX_DECODED_TILE_DIM ) )
+            {
+               const ossim_int64 TILES_X =
+                  ( (ossim_int64)m_sizRecord.m_Xsiz - m_sizRecord.m_XTOsiz + TILE_W - 1 ) / TILE_W;
+               const ossim_int64 TILES_Y =
+                  ( (ossim_int64)m_sizRecord.m_Ysiz - m_sizRecord.m_YTOsiz + TILE_H - 1 ) / TILE_H;
+
+               // Full resolution codestream extents of the request.
+               const ossim_int64 X0 = (ossim_int64)shiftedRect.ul().x << resLevel;
+               const ossim_int64 Y0 = (ossim_int64)shiftedRect.ul().y << resLevel;
+               const ossim_int64 X1 = ( ( (ossim_int64)shiftedRect.lr().x + 1 ) << resLevel ) - 1;
+               const ossim_int64 Y1 = ( ( (ossim_int64)shiftedRect.lr().y + 1 ) << resLevel ) - 1;
+
+               ossim_int64 col0 = ossim::max<ossim_int64>( (X0 - m_sizRecord.m_XTOsiz) / TILE_W, 0 );
+               ossim_int64 col1 = ossim::min<ossim_int64>( (X1 - m_sizRecord.m_XTOsiz) / TILE_W, TILES_X-1 );
+               ossim_int64 row0 = ossim::max<ossim_int64>( (Y0 - m_sizRecord.m_YTOsiz) / TILE_H, 0 );
+               ossim_int64 row1 = ossim::min<ossim_int64>( (Y1 - m_sizRecord.m_YTOsiz) / TILE_H, TILES_Y-1 );
+
+               status = ( col0 <= col1 ) && ( row0 <= row1 );
+               for ( ossim_int64 row = row0; status && ( row <= row1 ); ++row )
+               {
+                  for ( ossim_int64 col = col0; status && ( col <= col1 ); ++col )
+                  {
+                     ossimRefPtr<ossimImageData> decoded =
+                        getDecodedTile( resLevel, (ossim_uint32)(row * TILES_X + col), offset );
+                     if ( decoded.valid() )
+                     {
+                        result->loadTile( decoded.get() );
+                     }
+                     else
+                     {
+                        status = false;
+                     }
+                  }
+               }
+            }
+            else
+            {
+               //---
+               // OpenJPEG only allows another area decode on a codec that has
+               // already decoded for single tiled codestreams, and only from
+               // 2.3.  Otherwise each request gets a fresh decoder.
+               //---
+               std::unique_ptr<ossimOpjDecoder> regionDecoder;
+               ossimOpjDecoder* decoder = 0;
+#if (OPJ_VERSION_MAJOR > 2) || ( (OPJ_VERSION_MAJOR == 2) && (OPJ_VERSION_MINOR >= 3) )
+               if ( TILE_W && TILE_H &&
+                    ( (ossim_int64)m_sizRecord.m_Xsiz - m_sizRecord.m_XTOsiz <= TILE_W ) &&
+                    ( (ossim_int64)m_sizRecord.m_Ysiz - m_sizRecord.m_YTOsiz <= TILE_H ) )
+               {
+                  decoder = getDecoder( resLevel );
+               }
+#endif
+               if ( !decoder )
+               {
+                  regionDecoder.reset( new ossimOpjDecoder( m_str, m_format, 0, resLevel ) );
+                  decoder = regionDecoder.get();
+               }
+
+               opj_image_t* image = decoder->decodeRegion( shiftedRect );
+               if ( clipRect == tileRect )
+               {
+                  // Whole tile inside the image; convert straight into it.
+                  status = ossim::copyOpjImage( image, result );
+               }
+               else
+               {
+                  m_cacheTile->setImageRectangle( clipRect );
+                  status = ossim::copyOpjImage( image, m_cacheTile.get() );
+                  if ( status )
+                  {
+                     result->loadTile(m_cacheTile->getBuf(), clipRect,  OSSIM_BSQ);
+                  }
+               }
+            }
 
             if ( status )
             {
-               
-               result->loadTile(m_cacheTile->getBuf(), clipRect,  OSSIM_BSQ);
                result->validate();
             }
          }
@@ -285,11 +394,18 @@ bool ossimOpjJp2Reader::getOverviewTile(ossim_uint32 resLevel,
                << __FILE__ << " " << __LINE__ << " caught exception\n"
                << e.what() << "\n File:" << this->theImageFile << "\n";
             status = false;
+
+            //---
+            // Codec state is unknown after a failure so reopen this level next
+            // time.  Tiles already decoded stay cached.
+            //---
+            deleteDecoder( resLevel );
          }
          catch( ... )
          {
             ossimNotify(ossimNotifyLevel_WARN)
                << __FILE__ << " " << __LINE__ << " caught unknown exception\n";
+            deleteDecoder( resLevel );
          }
             
          // result->setImageRectangle(originalTileRect);
@@ -1010,3 +1126,97 @@ void ossimOpjJp2Reader::allocate()
          << endl;
    }
 }
+
+ossimOpjDecoder* ossimOpjJp2Reader::getDecoder( ossim_uint32 resLevel )
+{
+   if ( resLevel >= m_decoders.size() )
+   {
+      m_decoders.resize( resLevel + 1, 0 );
+   }
+   if ( !m_decoders[resLevel] )
+   {
+      m_decoders[resLevel] = new ossimOpjDecoder( m_str, m_format, 0, resLevel );
+   }
+   return m_decoders[resLevel];
+}
+
+ossimRefPtr<ossimImageData> ossimOpjJp2Reader::getDecodedTile( ossim_uint32 resLevel,
+                                                               ossim_uint32 tileIndex,
+                                                               const ossimIpt& offset )
+{
+   TileKey key( resLevel, tileIndex );
+   TileCache::iterator cached = m_tileCache.find( key );
+   if ( cached != m_tileCache.end() )
+   {
+      m_tileLru.splice( m_tileLru.begin(), m_tileLru, cached->second.second );
+      return cached->second.first;
+   }
+
+   ossimRefPtr<ossimImageData> tile = 0;
+   opj_image_t* image = getDecoder( resLevel )->decodeTile( tileIndex );
+   if ( image && image->numcomps && image->comps[0].w && image->comps[0].h )
+   {
+      //---
+      // Reuse the buffer of the last evicted tile when it has the same size,
+      // which is every tile but the right and bottom edges.
+      //---
+      if ( m_spareTile.valid() &&
+           ( m_spareTile->getWidth() == image->comps[0].w ) &&
+           ( m_spareTile->getHeight() == image->comps[0].h ) )
+      {
+         tile = m_spareTile;
+         m_spareTile = 0;
+      }
+      else
+      {
+         tile = new ossimImageData( this,
+                                    getOutputScalarType(),
+                                    getNumberOfOutputBands(),
+                                    image->comps[0].w,
+                                    image->comps[0].h );
+      }
+      tile->setOrigin( ossimIpt( (ossim_int32)image->comps[0].x0 - offset.x,
+                                 (ossim_int32)image->comps[0].y0 - offset.y ) );
+      tile->initialize();
+      if ( !ossim::copyOpjImage( image, tile.get() ) )
+      {
+         tile = 0;
+      }
+   }
+
+   if ( tile.valid() )
+   {
+      m_tileLru.push_front( key );
+      m_tileCache[key] = std::make_pair( tile, m_tileLru.begin() );
+      while ( m_tileCache.size() > m_maxCachedTiles )
+      {
+         TileCache::iterator evicted = m_tileCache.find( m_tileLru.back() );
+         m_spareTile = evicted->second.first;
+         m_tileCache.erase( evicted );
+         m_tileLru.pop_back();
+      }
+   }
+
+   return tile;
+}
+
+void ossimOpjJp2Reader::deleteDecoder( ossim_uint32 resLevel )
+{
+   if ( resLevel < m_decoders.size() )
+   {
+      delete m_decoders[resLevel];
+      m_decoders[resLevel] = 0;
+   }
+}
+
+void ossimOpjJp2Reader::deleteDecoders()
+{
+   for ( ossim_uint32 i = 0; i < m_decoders.size(); ++i )
+   {
+      delete m_decoders[i];
+   }
+   m_decoders.clear();
+   m_tileLru.clear();
+   m_tileCache.clear();
+   m_spareTile = 0;
+}
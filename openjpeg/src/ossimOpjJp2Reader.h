@@ -16,11 +16,15 @@
 
 #include <ossim/imaging/ossimImageHandler.h>
 #include <ossim/support_data/ossimJ2kSizRecord.h>
+#include <list>
+#include <map>
+#include <utility>
 #include <vector>
 
 // Forward class declarations.
 class ossimImageData;
 class ossimJ2kCodRecord;
+class ossimOpjDecoder;
 
 class ossimOpjJp2Reader : public ossimImageHandler
 {
@@ -218,6 +222,28 @@ private:
     */ 
    void allocate();
 
+   /**
+    * @brief Gets the decoder for resLevel, opening it on first use.
+    * Throws ossimException on error.
+    */
+   ossimOpjDecoder* getDecoder( ossim_uint32 resLevel );
+
+   /**
+    * @brief Gets J2K tile tileIndex at resLevel from the cache or decodes it.
+    * Throws ossimException on error.
+    * @param offset Codestream origin subtracted to get image space.
+    * @return Tile with its image rectangle set in image space at resLevel.
+    */
+   ossimRefPtr<ossimImageData> getDecodedTile( ossim_uint32 resLevel,
+                                               ossim_uint32 tileIndex,
+                                               const ossimIpt& offset );
+
+   /** Deletes the decoder for resLevel.  The decoded tile cache is kept. */
+   void deleteDecoder( ossim_uint32 resLevel );
+
+   /** Deletes decoders and the decoded tile cache. */
+   void deleteDecoders();
+
    ossimJ2kSizRecord m_sizRecord;
    
    ossimRefPtr<ossimImageData>  m_tile;
@@ -225,6 +251,20 @@ private:
    std::ifstream*               m_str;
    ossim_uint32                 m_minDwtLevels;
    ossim_int32                  m_format; // OPJ_CODEC_FORMAT
+
+   /** Decoders by resLevel, opened on first use and kept until close. */
+   std::vector<ossimOpjDecoder*> m_decoders;
+
+   /** Decoded J2K tiles keyed by resLevel and tile index, LRU ordered. */
+   typedef std::pair<ossim_uint32, ossim_uint32> TileKey;
+   typedef std::list<TileKey> TileLru;
+   typedef std::map<TileKey, std::pair<ossimRefPtr<ossimImageData>, TileLru::iterator> > TileCache;
+   TileLru                      m_tileLru;
+   TileCache                    m_tileCache;
+   ossim_uint32                 m_maxCachedTiles;
+
+   /** Last tile evicted from m_tileCache, reused for the next decode. */
+   ossimRefPtr<ossimImageData>  m_spareTile;
    
 TYPE_DATA
 };
@@ -28,7 +28,13 @@
 #include <ossim/imaging/ossimScalarRemapper.h>
 #include <ossim/support_data/ossimJp2Info.h>
 
+#include <condition_variable>
 #include <ctime>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
 
 RTTI_DEF1(ossimOpjJp2Writer,
 	  "ossimOpjJp2Writer",
@@ -287,65 +293,171 @@ bool ossimOpjJp2Writer::writeStream()
       copyData( origJp2cBoxPos, 8, geotiffHdr );
 
       bool needAlpha = m_compressor->getAlphaChannelFlag();
-      ossim_uint32 tileIndex = 0;
-      
-      // Tile loop in the line direction.
-      for(ossim_uint32 y = 0; y < outputTilesHigh; ++y)
+
+      //---
+      // Tiles are fetched from the input (and alpha computed) on a separate
+      // thread while the previous tile is encoded here.  Only the fetch
+      // thread touches the chain and only this thread touches the codec.
+      //---
+      const std::size_t QUEUE_TILES = 2;
+      std::deque< ossimRefPtr<ossimImageData> > queue;
+      std::mutex queueMutex;
+      std::condition_variable queueCondition;
+      bool fetchDone = false;
+      bool stopFetch = false;
+      std::string fetchError;
+      std::thread fetchThread;
+
+      // Stops and joins the fetch thread on every exit path.
+      struct FetchGuard
+      {
+         FetchGuard( std::mutex& queueMutex,
+                     std::condition_variable& queueCondition,
+                     bool& stopFetch,
+                     std::thread& fetchThread )
+            : m_queueMutex( queueMutex ),
+              m_queueCondition( queueCondition ),
+              m_stopFetch( stopFetch ),
+              m_fetchThread( fetchThread )
+         {}
+         ~FetchGuard()
+         {
+            join();
+         }
+         void join()
+         {
+            {
+               std::lock_guard<std::mutex> lock( m_queueMutex );
+               m_stopFetch = true;
+               m_queueCondition.notify_all();
+            }
+            if ( m_fetchThread.joinable() )
+            {
+               m_fetchThread.join();
+            }
+         }
+         std::mutex&              m_queueMutex;
+         std::condition_variable& m_queueCondition;
+         bool&                    m_stopFetch;
+         std::thread&             m_fetchThread;
+      };
+      FetchGuard fetchGuard( queueMutex, queueCondition, stopFetch, fetchThread );
+
+      fetchThread = std::thread( [&]()
       {
-         // Tile loop in the sample (width) direction.
-         for(ossim_uint32 x = 0; x < outputTilesWide; ++x)
+         for ( ossim_uint32 i = 0; i < numberOfTiles; ++i )
          {
             // Grab the resampled tile.
-            ossimRefPtr<ossimImageData> t = theInputConnection->getNextTile();
-            if (t.valid() && ( t->getDataObjectStatus() != OSSIM_NULL ) )
+            ossimRefPtr<ossimImageData> copy = 0;
+            try
             {
-               if (needAlpha)
-               {
-                  t->computeAlphaChannel();
-               }
-               if ( ! m_compressor->writeTile( t.get(), tileIndex++) )
+               ossimRefPtr<ossimImageData> t = theInputConnection->getNextTile();
+               if ( t.valid() && ( t->getDataObjectStatus() != OSSIM_NULL ) )
                {
-                  ossimNotify(ossimNotifyLevel_WARN)
-                     << MODULE << " ERROR:"
-                     << "Error returned writing tile:  "
-                     << tileNumber
-                     << std::endl;
-                  result = false;
+                  // The input reuses its tile so queue a copy.
+                  copy = static_cast<ossimImageData*>( t->dup() );
+                  if (needAlpha)
+                  {
+                     copy->computeAlphaChannel();
+                  }
                }
             }
-            else
+            catch ( const std::exception& e )
+            {
+               // Hand the error to the encode loop and stop fetching.
+               std::lock_guard<std::mutex> lock(queueMutex);
+               fetchError = e.what();
+               break;
+            }
+
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait( lock, [&]()
+                                 { return stopFetch || ( queue.size() < QUEUE_TILES ); } );
+            if ( stopFetch )
+            {
+               break;
+            }
+            queue.push_back( copy );
+            queueCondition.notify_all();
+         }
+
+         std::lock_guard<std::mutex> lock(queueMutex);
+         fetchDone = true;
+         queueCondition.notify_all();
+      } );
+
+      ossim_uint32 tileIndex = 0;
+      
+      // Tiles come left to right, top to bottom.
+      for ( ; tileNumber < numberOfTiles; ++tileNumber )
+      {
+         ossimRefPtr<ossimImageData> t = 0;
+         bool haveTile = false;
+         {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait( lock, [&]() { return fetchDone || !queue.empty(); } );
+            if ( !queue.empty() )
+            {
+               t = queue.front();
+               queue.pop_front();
+               haveTile = true;
+               queueCondition.notify_all();
+            }
+         }
+
+         if ( !haveTile && fetchError.size() )
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << MODULE << " ERROR:"
+               << "Error fetching tile:  " << tileNumber
+               << "\n" << fetchError
+               << std::endl;
+            result = false;
+         }
+         else if ( haveTile && t.valid() )
+         {
+            if ( ! m_compressor->writeTile( t.get(), tileIndex++) )
             {
                ossimNotify(ossimNotifyLevel_WARN)
                   << MODULE << " ERROR:"
-                  << "Error returned writing tile:  " << tileNumber
+                  << "Error returned writing tile:  "
+                  << tileNumber
                   << std::endl;
                result = false;
             }
-            if (result == false)
-            {
-               // This will bust out of both loops.
-               x = outputTilesWide;
-               y = outputTilesHigh;
-            }
-            
-            // Increment tile number for percent complete.
-            ++tileNumber;
-            
-         } // End of tile loop in the sample (width) direction.
-         
-         if (needsAborting())
+         }
+         else
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << MODULE << " ERROR:"
+               << "Error returned writing tile:  " << tileNumber
+               << std::endl;
+            result = false;
+         }
+         if (result == false)
          {
-            setPercentComplete(100.0);
             break;
          }
-         else
+
+         // Percent complete at the end of each row of tiles.
+         if ( ( ( tileNumber + 1 ) % outputTilesWide ) == 0 )
          {
-            ossim_float64 tile = tileNumber;
-            ossim_float64 numTiles = numberOfTiles;
-            setPercentComplete(tile / numTiles * 100.0);
+            if (needsAborting())
+            {
+               setPercentComplete(100.0);
+               break;
+            }
+            else
+            {
+               ossim_float64 tile = tileNumber + 1;
+               ossim_float64 numTiles = numberOfTiles;
+               setPercentComplete(tile / numTiles * 100.0);
+            }
          }
          
-      } // End of tile loop in the line (height) direction.
+      } // End of tile loop.
+
+      fetchGuard.join();
 
       if (m_outputStream)      
       {
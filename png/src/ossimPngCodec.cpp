@@ -1,12 +1,149 @@
 #include "ossimPngCodec.h"
+#include <ossim/base/ossimBooleanProperty.h>
+#include <ossim/base/ossimCommon.h>
 #include <ossim/base/ossimConstants.h>
+#include <ossim/base/ossimKeywordlist.h>
+#include <ossim/base/ossimNumericProperty.h>
+#include <ossim/base/ossimStringProperty.h>
+#include <ossim/imaging/ossimImageData.h>
 #include <png.h>
 #include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <map>
+#include <thread>
 
 static const char ADD_ALPHA_CHANNEL_KW[] = "add_alpha_channel";
+static const char COMPRESSION_LEVEL_KW[] = "compression_level";
+static const char FILTER_KW[]            = "filter";
+static const char THREADS_KW[]           = "threads";
 
 RTTI_DEF1(ossimPngCodec, "ossimPngCodec", ossimCodecBase);
 
+#if PNG_LIBPNG_VER >= 10500
+typedef png_alloc_size_t ossimPngAllocSize;
+#else
+typedef png_size_t ossimPngAllocSize;
+#endif
+
+namespace
+{
+   //---
+   // Per thread encoder state.  The interleave buffer and row pointers are
+   // reused between tiles, and libpng's allocations (mostly the zlib deflate
+   // state) are recycled through a free list instead of malloc'ed per tile.
+   //---
+   class PngEncodeContext
+   {
+   public:
+      ~PngEncodeContext()
+      {
+         for(std::multimap<ossimPngAllocSize, void*>::iterator iter = m_free.begin();
+             iter != m_free.end(); ++iter)
+         {
+            free(iter->second);
+         }
+      }
+
+      static png_voidp allocate(png_structp p, ossimPngAllocSize size)
+      {
+         PngEncodeContext* ctx = (PngEncodeContext*)png_get_mem_ptr(p);
+         void* block = 0;
+         std::multimap<ossimPngAllocSize, void*>::iterator iter = ctx->m_free.find(size);
+         if(iter != ctx->m_free.end())
+         {
+            block = iter->second;
+            ctx->m_free.erase(iter);
+         }
+         else
+         {
+            // Size is kept in front of the block for release.
+            block = malloc(size + HEADER_SIZE);
+            if(!block) return 0;
+            *(ossimPngAllocSize*)block = size;
+         }
+         return (png_voidp)((ossim_uint8*)block + HEADER_SIZE);
+      }
+
+      static void release(png_structp p, png_voidp ptr)
+      {
+         if(!ptr) return;
+         PngEncodeContext* ctx = (PngEncodeContext*)png_get_mem_ptr(p);
+         void* block = (ossim_uint8*)ptr - HEADER_SIZE;
+         if(ctx->m_free.size() < MAX_FREE_BLOCKS)
+         {
+            ctx->m_free.insert(std::make_pair(*(ossimPngAllocSize*)block, block));
+         }
+         else
+         {
+            free(block);
+         }
+      }
+
+      static PngEncodeContext& instance()
+      {
+         static thread_local PngEncodeContext ctx;
+         return ctx;
+      }
+
+      std::vector<ossim_uint8> m_buffer;
+      std::vector<png_bytep>   m_rows;
+
+   private:
+      // Keeps the blocks handed to libpng 16 byte aligned.
+      static const size_t HEADER_SIZE = 16;
+      static const size_t MAX_FREE_BLOCKS = 64;
+
+      std::multimap<ossimPngAllocSize, void*> m_free;
+   };
+
+   struct PngWriteDestructor
+   {
+      png_structp m_png;
+      png_infop   m_info;
+      PngWriteDestructor() : m_png(0), m_info(0) {}
+      ~PngWriteDestructor() { if (m_png) { png_destroy_write_struct(&m_png, &m_info); } }
+   };
+
+   // Band separate to pixel interleaved.  Written for the auto-vectorizer.
+   template <class T>
+   void interleave3(const T* r, const T* g, const T* b, T* dst, ossim_uint32 count)
+   {
+      for(ossim_uint32 i = 0; i < count; ++i)
+      {
+         dst[3*i]   = r[i];
+         dst[3*i+1] = g[i];
+         dst[3*i+2] = b[i];
+      }
+   }
+
+   //---
+   // Picks filters for "auto".  Flat content (maps, masks, fills) compresses
+   // as well unfiltered and skips the per row filter trials; imagery gets the
+   // filters that pay off on it.
+   //---
+   int chooseAutoFilters(const ossimImageData* in)
+   {
+      const ossim_uint32 SIZE = in->getSizePerBand();
+      const ossim_uint32 SAMPLES = 4096;
+      const ossim_uint32 STEP = ossim::max<ossim_uint32>(1, SIZE / SAMPLES);
+      ossim_uint32 equal = 0;
+      ossim_uint32 total = 0;
+      for(ossim_uint32 idx = STEP; idx < SIZE; idx += STEP)
+      {
+         if(in->getPix(idx, 0) == in->getPix(idx - 1, 0))
+         {
+            ++equal;
+         }
+         ++total;
+      }
+      if(!total || (equal * 4 >= total * 3))
+      {
+         return PNG_FILTER_NONE;
+      }
+      return PNG_FILTER_SUB | PNG_FILTER_UP | PNG_FILTER_PAETH;
+   }
+}
 
 static void user_read_data (png_structp png_ptr, png_bytep data, png_size_t length)
 {
@@ -21,15 +158,16 @@ static void PngWriteCallback(png_structp  png_ptr, png_bytep data, png_size_t le
    std::vector<ossim_uint8> *p = (std::vector<ossim_uint8>*)png_get_io_ptr(png_ptr);
    p->insert(p->end(), data, data + length);
 }
- 
-struct TPngDestructor {
-   png_struct *p;
-   TPngDestructor(png_struct *p) : p(p)  {}
-   ~TPngDestructor() { if (p) {  png_destroy_write_struct(&p, NULL); } }
-};
+
+static void PngFlushCallback(png_structp /* png_ptr */)
+{
+}
 
 ossimPngCodec::ossimPngCodec(bool addAlpha)
-   :m_addAlphaChannel(addAlpha)
+   :m_addAlphaChannel(addAlpha),
+    m_compressionLevel(1),
+    m_filter("auto"),
+    m_threads(0)
 {
 
 }
@@ -45,7 +183,7 @@ bool ossimPngCodec::encode(const ossimRefPtr<ossimImageData>& in,
    out.clear();
    ossim_int32 colorType = -1;
    ossim_int32 bitDepth = 0;
-   if(!in->getBuf()) return false;
+   if(!in.valid() || !in->getBuf()) return false;
    if(in->getNumberOfBands() == 1)
    {
       if(m_addAlphaChannel)
@@ -89,152 +227,149 @@ bool ossimPngCodec::encode(const ossimRefPtr<ossimImageData>& in,
       }
    }
    if(bitDepth == 0) return false;
-   // std::cout << "bitDepth = " << bitDepth << ", BANDS = " << in->getNumberOfBands() << std::endl;
-   ossim_int32 w = in->getWidth();
-   ossim_int32 h = in->getHeight();
-   png_structp p = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-   TPngDestructor destroyPng(p);
-   png_infop info_ptr = png_create_info_struct(p);
-   setjmp(png_jmpbuf(p));
-
-   png_set_IHDR(p, info_ptr, w, h, bitDepth,
-                colorType,
-                PNG_INTERLACE_NONE,
-                PNG_COMPRESSION_TYPE_DEFAULT,
-                PNG_FILTER_TYPE_DEFAULT);
-   png_set_compression_level(p, 1);
 
+   const ossim_int32 w = in->getWidth();
+   const ossim_int32 h = in->getHeight();
+   const ossim_uint32 byteDepth = bitDepth / 8;
+   const ossim_uint32 size = in->getSizePerBand();
+   ossim_uint32 channels = 1;
    switch(colorType)
    {
-      case PNG_COLOR_TYPE_GRAY:
+      case PNG_COLOR_TYPE_GRAY_ALPHA: channels = 2; break;
+      case PNG_COLOR_TYPE_RGB:        channels = 3; break;
+      case PNG_COLOR_TYPE_RGB_ALPHA:  channels = 4; break;
+      default: break;
+   }
+   const ossim_uint32 rowBytes = w * channels * byteDepth;
+
+   PngEncodeContext& ctx = PngEncodeContext::instance();
+   ctx.m_rows.resize(h);
+
+   // Pixel interleaved source rows.  Gray goes straight from the tile.
+   ossim_uint8* pixels = 0;
+   if(colorType == PNG_COLOR_TYPE_GRAY)
+   {
+      pixels = (ossim_uint8*)in->getBuf();
+   }
+   else
+   {
+      ctx.m_buffer.resize(rowBytes * h);
+      pixels = &ctx.m_buffer.front();
+      if(colorType == PNG_COLOR_TYPE_RGB)
       {
          if(bitDepth == 8)
          {
-            ossim_uint8* buf = (ossim_uint8*)in->getBuf();
-            std::vector<ossim_uint8*> rows(h);
-            for(ossim_int32 y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(buf + y * w) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+            interleave3(in->getUcharBuf(0), in->getUcharBuf(1), in->getUcharBuf(2),
+                        pixels, size);
          }
-         else if(bitDepth == 16)
+         else
          {
-            ossim_uint16* buf = (ossim_uint16*)in->getBuf();
-            std::vector<ossim_uint8*> rows(h);
-            for(int y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(buf + y * w) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+            interleave3(in->getUshortBuf(0), in->getUshortBuf(1), in->getUshortBuf(2),
+                        (ossim_uint16*)pixels, size);
          }
-         break;
       }
-      case PNG_COLOR_TYPE_GRAY_ALPHA:
+      else
       {
-         if(bitDepth == 8)
-         {
-            std::vector<ossim_uint8> buf(w*h*2);
-            std::vector<ossim_uint8*> rows(h);
-            ossim_uint8* bufPtr = &buf.front();
-            in->unloadTileToBipAlpha(&buf.front(), in->getImageRectangle(), in->getImageRectangle());
-            for(int y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*2)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+         in->unloadTileToBipAlpha(pixels, in->getImageRectangle(), in->getImageRectangle());
+      }
+   }
+   for(ossim_int32 y = 0; y < h; ++y)
+   {
+      ctx.m_rows[y] = pixels + y * rowBytes;
+   }
 
-         }
-         else
-         {
-            std::vector<ossim_uint16> buf(w*h*2);
-            std::vector<ossim_uint8*> rows(h);
-            ossim_uint16* bufPtr = &buf.front();
-            in->unloadTileToBipAlpha(&buf.front(), in->getImageRectangle(), in->getImageRectangle());
-            for(ossim_int32 y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*2)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-         }
+   int filters = PNG_FILTER_NONE;
+   if(m_compressionLevel > 0)
+   {
+      if(m_filter == "none")         filters = PNG_FILTER_NONE;
+      else if(m_filter == "sub")     filters = PNG_FILTER_SUB;
+      else if(m_filter == "up")      filters = PNG_FILTER_UP;
+      else if(m_filter == "average") filters = PNG_FILTER_AVG;
+      else if(m_filter == "paeth")   filters = PNG_FILTER_PAETH;
+      else if(m_filter == "all")     filters = PNG_ALL_FILTERS;
+      else                           filters = chooseAutoFilters(in.get());
+   }
 
-         break;
-      }
-      case PNG_COLOR_TYPE_RGB:
+   // Rough guess to avoid regrowing the output while deflating.
+   out.reserve(rowBytes * h / 4 + 1024);
+
+   PngWriteDestructor destroyPng;
+   destroyPng.m_png = png_create_write_struct_2(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL,
+                                                (png_voidp)&ctx,
+                                                PngEncodeContext::allocate,
+                                                PngEncodeContext::release);
+   if(!destroyPng.m_png) return false;
+   destroyPng.m_info = png_create_info_struct(destroyPng.m_png);
+   if(!destroyPng.m_info) return false;
+
+   png_structp p = destroyPng.m_png;
+   png_infop info_ptr = destroyPng.m_info;
+   if(setjmp(png_jmpbuf(p)))
+   {
+      out.clear();
+      return false;
+   }
+
+   png_set_IHDR(p, info_ptr, w, h, bitDepth,
+                colorType,
+                PNG_INTERLACE_NONE,
+                PNG_COMPRESSION_TYPE_DEFAULT,
+                PNG_FILTER_TYPE_DEFAULT);
+   png_set_compression_level(p, m_compressionLevel);
+   png_set_filter(p, PNG_FILTER_TYPE_BASE, filters);
+   png_set_rows(p, info_ptr, &ctx.m_rows.front());
+   png_set_write_fn(p, &out, PngWriteCallback, PngFlushCallback);
+   png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+
+   return true;
+}
+
+bool ossimPngCodec::encode(const std::vector<ossimRefPtr<ossimImageData> >& in,
+                           std::vector< std::vector<ossim_uint8> >& out) const
+{
+   out.resize(in.size());
+
+   ossim_uint32 threads = m_threads;
+   if(!threads)
+   {
+      threads = std::thread::hardware_concurrency();
+   }
+   threads = ossim::min<ossim_uint32>(ossim::max<ossim_uint32>(threads, 1),
+                                      (ossim_uint32)in.size());
+
+   std::atomic<size_t> next(0);
+   std::atomic<bool> result(true);
+   auto worker = [&]()
+   {
+      size_t idx;
+      while((idx = next++) < in.size())
       {
-         if(bitDepth == 8)
-         {
-            std::vector<ossim_uint8> buf(w*h*3);
-            std::vector<ossim_uint8*> rows(h);
-            in->unloadTile(&buf.front(), in->getImageRectangle(), in->getImageRectangle(), OSSIM_BIP);
-            ossim_uint8* bufPtr = &buf.front();
-            for(ossim_int32 y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*3)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-         }
-         else
+         if(!encode(in[idx], out[idx]))
          {
-            std::vector<ossim_uint16> buf(w*h*3);
-            std::vector<ossim_uint8*> rows(h);
-            ossim_uint16* bufPtr = &buf.front();
-            in->unloadTile(&buf.front(), in->getImageRectangle(), in->getImageRectangle(),OSSIM_BIP);
-            for(ossim_int32 y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*3)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+            result = false;
          }
-         break;
       }
-      case PNG_COLOR_TYPE_RGB_ALPHA:
+   };
+
+   if(threads <= 1)
+   {
+      worker();
+   }
+   else
+   {
+      std::vector<std::thread> pool;
+      for(ossim_uint32 i = 1; i < threads; ++i)
       {
-         if(bitDepth == 8)
-         {
-            std::vector<ossim_uint8> buf(w*h*4);
-            std::vector<ossim_uint8*> rows(h);
-            in->unloadTileToBipAlpha(&buf.front(), in->getImageRectangle(), in->getImageRectangle());
-            ossim_uint8* bufPtr = &buf.front();
-            for(int y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*4)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-         }
-         else
-         {
-            std::vector<ossim_uint16> buf(w*h*4);
-            std::vector<ossim_uint8*> rows(h);
-            in->unloadTileToBipAlpha(&buf.front(), in->getImageRectangle(), in->getImageRectangle());
-            ossim_uint16* bufPtr = &buf.front();
-            for(ossim_int32 y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*4)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-         }
-         break;
+         pool.push_back(std::thread(worker));
+      }
+      worker();
+      for(size_t i = 0; i < pool.size(); ++i)
+      {
+         pool[i].join();
       }
    }
 
-   return true;
+   return result;
 }
 
 bool ossimPngCodec::decode(const std::vector<ossim_uint8>& in,
@@ -453,6 +588,18 @@ void ossimPngCodec::setProperty(ossimRefPtr<ossimProperty> property)
    {
       m_addAlphaChannel = property->valueToString().toBool();
    }
+   else if(property->getName() == COMPRESSION_LEVEL_KW)
+   {
+      setCompressionLevel(property->valueToString().toInt32());
+   }
+   else if(property->getName() == FILTER_KW)
+   {
+      m_filter = property->valueToString().downcase();
+   }
+   else if(property->getName() == THREADS_KW)
+   {
+      m_threads = property->valueToString().toUInt32();
+   }
    else
    {
       ossimCodecBase::setProperty(property);
@@ -465,7 +612,29 @@ ossimRefPtr<ossimProperty> ossimPngCodec::getProperty(const ossimString& name)co
 
    if(name == ADD_ALPHA_CHANNEL_KW)
    {
-
+      result = new ossimBooleanProperty(name, m_addAlphaChannel);
+   }
+   else if(name == COMPRESSION_LEVEL_KW)
+   {
+      result = new ossimNumericProperty(name,
+                                        ossimString::toString(m_compressionLevel),
+                                        0.0, 9.0);
+   }
+   else if(name == FILTER_KW)
+   {
+      ossimStringProperty* stringProp = new ossimStringProperty(name, m_filter, false);
+      stringProp->addConstraint(ossimString("auto"));
+      stringProp->addConstraint(ossimString("none"));
+      stringProp->addConstraint(ossimString("sub"));
+      stringProp->addConstraint(ossimString("up"));
+      stringProp->addConstraint(ossimString("average"));
+      stringProp->addConstraint(ossimString("paeth"));
+      stringProp->addConstraint(ossimString("all"));
+      result = stringProp;
+   }
+   else if(name == THREADS_KW)
+   {
+      result = new ossimNumericProperty(name, ossimString::toString(m_threads));
    }
    else
    {
@@ -478,6 +647,9 @@ ossimRefPtr<ossimProperty> ossimPngCodec::getProperty(const ossimString& name)co
 void ossimPngCodec::getPropertyNames(std::vector<ossimString>& propertyNames)const
 {
    propertyNames.push_back(ADD_ALPHA_CHANNEL_KW);
+   propertyNames.push_back(COMPRESSION_LEVEL_KW);
+   propertyNames.push_back(FILTER_KW);
+   propertyNames.push_back(THREADS_KW);
 }
 
 bool ossimPngCodec::loadState(const ossimKeywordlist& kwl, const char* prefix)
@@ -489,12 +661,38 @@ bool ossimPngCodec::loadState(const ossimKeywordlist& kwl, const char* prefix)
       m_addAlphaChannel = addAlphaChannel.toBool();
    }
 
+   ossimString compressionLevel = kwl.find(prefix, COMPRESSION_LEVEL_KW);
+   if(!compressionLevel.empty())
+   {
+      setCompressionLevel(compressionLevel.toInt32());
+   }
+
+   ossimString filter = kwl.find(prefix, FILTER_KW);
+   if(!filter.empty())
+   {
+      m_filter = filter.downcase();
+   }
+
+   ossimString threads = kwl.find(prefix, THREADS_KW);
+   if(!threads.empty())
+   {
+      m_threads = threads.toUInt32();
+   }
+
    return ossimCodecBase::loadState(kwl, prefix);
 }
 
 bool ossimPngCodec::saveState(ossimKeywordlist& kwl, const char* prefix)const
 {
    kwl.add(prefix, ADD_ALPHA_CHANNEL_KW, m_addAlphaChannel);
+   kwl.add(prefix, COMPRESSION_LEVEL_KW, m_compressionLevel);
+   kwl.add(prefix, FILTER_KW, m_filter);
+   kwl.add(prefix, THREADS_KW, m_threads);
 
    return ossimCodecBase::saveState(kwl, prefix);
 }
+
+void ossimPngCodec::setCompressionLevel(ossim_int32 level)
+{
+   m_compressionLevel = ossim::clamp<ossim_int32>(level, 0, 9);
+}
@@ -24,6 +24,21 @@ public:
    virtual bool encode( const ossimRefPtr<ossimImageData>& in,
                         std::vector<ossim_uint8>& out ) const;
 
+   /**
+    * @brief Encodes a batch of tiles across threads.
+    *
+    * Uses the "threads" property, or one thread per core if 0.  Each thread
+    * keeps its own encoder buffers so tiles of the same size reuse them.
+    *
+    * @param in Tiles to encode.
+    *
+    * @param out Encoded tiles, same order as in.
+    *
+    * @return true if every tile encoded, false otherwise.
+    */
+   bool encode( const std::vector<ossimRefPtr<ossimImageData> >& in,
+                std::vector< std::vector<ossim_uint8> >& out ) const;
+
    /**
     * @brief Decode png method.
     *
@@ -57,8 +72,9 @@ public:
    virtual ossimRefPtr<ossimProperty> getProperty(const ossimString& name)const; 
    
    /**
-   * Get a list of all supported property names.  Currently only "quality" property 
-   * is exposed
+   * Get a list of all supported property names: add_alpha_channel,
+   * compression_level (0-9, default 1), filter (auto, none, sub, up,
+   * average, paeth or all, default auto) and threads (batch encode).
    *
    * @param out proeprtyNames.  push the list of proeprty names to the list
    */
@@ -83,8 +99,19 @@ public:
    virtual bool saveState(ossimKeywordlist& kwl, const char* prefix=0)const;
 
 
+   /** @param level zlib level clamped to 0-9. */
+   void setCompressionLevel(ossim_int32 level);
+
 protected:
 	bool m_addAlphaChannel;
+   ossim_int32  m_compressionLevel;
+
+   /**
+    * png filter selection.  "auto" looks at the tile: flat content is left
+    * unfiltered, anything else tries sub, up and paeth per row.
+    */
+   ossimString  m_filter;
+   ossim_uint32 m_threads;
 
 
 TYPE_DATA;
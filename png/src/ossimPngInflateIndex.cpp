@@ -0,0 +1,657 @@
+//----------------------------------------------------------------------------
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Description: Random access row decoder for non-interlaced png images.
+//
+//----------------------------------------------------------------------------
+// $Id$
+
+#include "ossimPngInflateIndex.h"
+#include <ossim/base/ossimIoStream.h>
+#include <ossim/base/ossimNotifyContext.h>
+#include <ossim/base/ossimTrace.h>
+
+#include <algorithm>
+#include <cstdlib> /* for abs */
+#include <cstring> /* for memcpy */
+#include <fstream>
+
+static ossimTrace traceDebug("ossimPngInflateIndex:debug");
+
+static const ossim_uint32 WINDOW_SIZE = 32768;
+static const ossim_uint32 INPUT_SIZE  = 65536;
+
+// Sidecar header: magic, version and a byte order mark.
+static const char         SIDECAR_MAGIC[4] = { 'O', 'P', 'Z', 'I' };
+static const ossim_uint32 SIDECAR_VERSION  = 2;
+static const ossim_uint32 SIDECAR_BOM      = 0x01020304;
+
+static ossim_uint32 getBigEndian32(const ossim_uint8* buf)
+{
+   return ( (ossim_uint32)buf[0] << 24 ) | ( (ossim_uint32)buf[1] << 16 ) |
+          ( (ossim_uint32)buf[2] << 8 ) | (ossim_uint32)buf[3];
+}
+
+template <class T> static void writeValue(std::ostream& out, const T& value)
+{
+   out.write( (const char*)&value, sizeof(T) );
+}
+
+template <class T> static bool readValue(std::istream& in, T& value)
+{
+   in.read( (char*)&value, sizeof(T) );
+   return in.good();
+}
+
+static void writeBytes(std::ostream& out, const std::vector<ossim_uint8>& bytes)
+{
+   ossim_uint32 size = (ossim_uint32)bytes.size();
+   writeValue(out, size);
+   if ( size )
+   {
+      out.write( (const char*)&bytes.front(), size );
+   }
+}
+
+static bool readBytes(std::istream& in, std::vector<ossim_uint8>& bytes, ossim_uint32 maxSize)
+{
+   ossim_uint32 size = 0;
+   if ( !readValue(in, size) || (size > maxSize) )
+   {
+      return false;
+   }
+   bytes.resize(size);
+   if ( size )
+   {
+      in.read( (char*)&bytes.front(), size );
+   }
+   return in.good();
+}
+
+ossimPngInflateIndex::ossimPngInflateIndex()
+   :
+   m_str(),
+   m_chunks(),
+   m_streamLength(0),
+   m_zstream(),
+   m_inflating(false),
+   m_input(),
+   m_inputPos(0),
+   m_width(0),
+   m_height(0),
+   m_rowBytes(0),
+   m_bytesPerPixel(1),
+   m_bitDepth(8),
+   m_palette(),
+   m_filtered(),
+   m_filled(0),
+   m_row(),
+   m_prevRow(),
+   m_currentRow(0),
+   m_checkpoints(),
+   m_checkpointRows(0),
+   m_complete(false),
+   m_modified(false)
+{
+}
+
+ossimPngInflateIndex::~ossimPngInflateIndex()
+{
+   endInflate();
+}
+
+bool ossimPngInflateIndex::initialize( std::shared_ptr<ossim::istream> str,
+                                       ossim_uint32 width,
+                                       ossim_uint32 height,
+                                       ossim_uint32 bitDepth,
+                                       ossim_int32 colorType,
+                                       const std::vector<png_color>& palette,
+                                       ossim_uint32 checkpointRows )
+{
+   m_str            = str;
+   m_width          = width;
+   m_height         = height;
+   m_bitDepth       = bitDepth;
+   m_palette        = palette;
+   m_checkpointRows = checkpointRows;
+   m_checkpoints.clear();
+   m_complete       = false;
+   m_modified       = false;
+
+#if ZLIB_VERNUM < 0x1280
+   // Need inflateGetDictionary to capture the window.
+   m_checkpointRows = 0;
+#endif
+
+   ossim_uint32 channels = 0;
+   switch ( colorType )
+   {
+      case PNG_COLOR_TYPE_GRAY:
+      case PNG_COLOR_TYPE_PALETTE:
+         channels = 1;
+         break;
+      case PNG_COLOR_TYPE_GRAY_ALPHA:
+         channels = 2;
+         break;
+      case PNG_COLOR_TYPE_RGB:
+         channels = 3;
+         break;
+      case PNG_COLOR_TYPE_RGB_ALPHA:
+         channels = 4;
+         break;
+      default:
+         return false;
+   }
+   if ( (colorType == PNG_COLOR_TYPE_PALETTE) && m_palette.empty() )
+   {
+      return false;
+   }
+
+   ossim_uint64 bitsPerRow = (ossim_uint64)m_width * channels * m_bitDepth;
+   m_rowBytes      = (ossim_uint32)( (bitsPerRow + 7) / 8 );
+   m_bytesPerPixel = std::max<ossim_uint32>( 1, (channels * m_bitDepth) / 8 );
+
+   m_input.resize(INPUT_SIZE);
+   m_filtered.resize(m_rowBytes + 1);
+   m_row.resize(m_rowBytes);
+   m_prevRow.resize(m_rowBytes);
+
+   bool result = false;
+   if ( m_str && m_rowBytes && m_height && scanChunks() )
+   {
+      result = restart();
+   }
+
+   if (traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossimPngInflateIndex::initialize DEBUG:"
+         << "\nIDAT chunks:     " << m_chunks.size()
+         << "\nIDAT bytes:      " << m_streamLength
+         << "\nrow bytes:       " << m_rowBytes
+         << "\ncheckpoint rows: " << m_checkpointRows
+         << "\nstatus:          " << (result?"true":"false") << std::endl;
+   }
+
+   return result;
+}
+
+bool ossimPngInflateIndex::scanChunks()
+{
+   m_chunks.clear();
+   m_streamLength = 0;
+
+   // Walk the chunk headers after the 8 byte signature.
+   std::streamoff pos = 8;
+   ossim_uint8 header[8];
+   while ( true )
+   {
+      m_str->clear();
+      m_str->seekg( pos, std::ios_base::beg );
+      m_str->read( (char*)header, 8 );
+      if ( !m_str->good() )
+      {
+         break;
+      }
+      ossim_uint32 length = getBigEndian32(header);
+      if ( std::memcmp( header + 4, "IDAT", 4 ) == 0 )
+      {
+         Chunk chunk;
+         chunk.m_filePos   = pos + 8;
+         chunk.m_streamPos = m_streamLength;
+         chunk.m_length    = length;
+         m_chunks.push_back(chunk);
+         m_streamLength += length;
+      }
+      else if ( std::memcmp( header + 4, "IEND", 4 ) == 0 )
+      {
+         break;
+      }
+      pos += (std::streamoff)length + 12; // header, data and crc
+   }
+   m_str->clear();
+
+   return ( m_streamLength > 0 );
+}
+
+ossim_uint32 ossimPngInflateIndex::readInput( ossim_uint8* buf,
+                                              ossim_uint64 pos,
+                                              ossim_uint32 size )
+{
+   ossim_uint32 bytesRead = 0;
+
+   // Find the chunk holding pos; chunks are sorted by stream position.
+   std::vector<Chunk>::const_iterator chunk = m_chunks.begin();
+   while ( (chunk != m_chunks.end()) &&
+           (pos >= chunk->m_streamPos + chunk->m_length) )
+   {
+      ++chunk;
+   }
+
+   while ( (bytesRead < size) && (chunk != m_chunks.end()) )
+   {
+      ossim_uint64 offset = pos - chunk->m_streamPos;
+      ossim_uint32 count  = (ossim_uint32)std::min<ossim_uint64>(
+         chunk->m_length - offset, size - bytesRead );
+
+      m_str->clear();
+      m_str->seekg( chunk->m_filePos + (std::streamoff)offset, std::ios_base::beg );
+      m_str->read( (char*)buf + bytesRead, count );
+      if ( m_str->gcount() != (std::streamsize)count )
+      {
+         m_str->clear();
+         break;
+      }
+      bytesRead += count;
+      pos       += count;
+      ++chunk;
+   }
+
+   return bytesRead;
+}
+
+void ossimPngInflateIndex::endInflate()
+{
+   if ( m_inflating )
+   {
+      inflateEnd( &m_zstream );
+      m_inflating = false;
+   }
+}
+
+bool ossimPngInflateIndex::restart()
+{
+   endInflate();
+   std::memset( &m_zstream, 0, sizeof(z_stream) );
+   if ( inflateInit( &m_zstream ) != Z_OK )
+   {
+      return false;
+   }
+   m_inflating  = true;
+   m_inputPos   = 0;
+   m_filled     = 0;
+   m_currentRow = 0;
+   std::fill( m_prevRow.begin(), m_prevRow.end(), 0 );
+   return true;
+}
+
+bool ossimPngInflateIndex::restore( const Checkpoint& cp )
+{
+   endInflate();
+   std::memset( &m_zstream, 0, sizeof(z_stream) );
+
+   // Raw inflate; the zlib header is long gone.
+   if ( inflateInit2( &m_zstream, -15 ) != Z_OK )
+   {
+      return false;
+   }
+   m_inflating = true;
+
+   m_inputPos = cp.m_in;
+   if ( cp.m_bits )
+   {
+      // Feed the unused high bits of the last byte consumed.
+      ossim_uint8 byte = 0;
+      if ( readInput( &byte, cp.m_in - 1, 1 ) != 1 )
+      {
+         return false;
+      }
+      inflatePrime( &m_zstream, cp.m_bits, byte >> (8 - cp.m_bits) );
+   }
+   if ( cp.m_window.size() )
+   {
+      inflateSetDictionary( &m_zstream, &cp.m_window.front(),
+                            (uInt)cp.m_window.size() );
+   }
+
+   m_filled = (ossim_uint32)cp.m_partial.size();
+   if ( m_filled )
+   {
+      std::memcpy( &m_filtered.front(), &cp.m_partial.front(), m_filled );
+   }
+   m_prevRow    = cp.m_prevRow;
+   m_currentRow = cp.m_row;
+   return true;
+}
+
+bool ossimPngInflateIndex::inflateRow()
+{
+   const ossim_uint32 STRIDE = m_rowBytes + 1;
+   while ( m_filled < STRIDE )
+   {
+      if ( m_zstream.avail_in == 0 )
+      {
+         ossim_uint32 bytesRead = readInput( &m_input.front(), m_inputPos, INPUT_SIZE );
+         if ( bytesRead == 0 )
+         {
+            return false;
+         }
+         m_zstream.next_in  = &m_input.front();
+         m_zstream.avail_in = bytesRead;
+         m_inputPos += bytesRead;
+      }
+
+      m_zstream.next_out  = &m_filtered.front() + m_filled;
+      m_zstream.avail_out = STRIDE - m_filled;
+
+      // Z_BLOCK stops at deflate block boundaries, the only safe restart points.
+      int status = inflate( &m_zstream, Z_BLOCK );
+      m_filled = STRIDE - m_zstream.avail_out;
+
+      if ( (status == Z_NEED_DICT) || (status == Z_DATA_ERROR) ||
+           (status == Z_MEM_ERROR) || (status == Z_STREAM_ERROR) )
+      {
+         return false;
+      }
+      if ( status == Z_STREAM_END )
+      {
+         return ( m_filled == STRIDE );
+      }
+
+      if ( (m_zstream.data_type & 128) && !(m_zstream.data_type & 64) )
+      {
+         addCheckpoint();
+      }
+   }
+   return true;
+}
+
+void ossimPngInflateIndex::addCheckpoint()
+{
+#if ZLIB_VERNUM >= 0x1280
+   if ( m_checkpointRows == 0 )
+   {
+      return;
+   }
+
+   // Only extend the index at its frontier so it stays sorted.
+   ossim_uint32 lastRow = m_checkpoints.size() ? m_checkpoints.back().m_row : 0;
+   if ( m_currentRow < lastRow + m_checkpointRows )
+   {
+      return;
+   }
+
+   Checkpoint cp;
+   cp.m_row  = m_currentRow;
+   cp.m_in   = m_inputPos - m_zstream.avail_in;
+   cp.m_bits = m_zstream.data_type & 7;
+   cp.m_window.resize(WINDOW_SIZE);
+   uInt windowSize = 0;
+   inflateGetDictionary( &m_zstream, &cp.m_window.front(), &windowSize );
+   cp.m_window.resize(windowSize);
+   cp.m_partial.assign( m_filtered.begin(), m_filtered.begin() + m_filled );
+   cp.m_prevRow = m_prevRow;
+
+   m_checkpoints.push_back(cp);
+   m_modified = true;
+#endif
+}
+
+bool ossimPngInflateIndex::nextRow()
+{
+   if ( (m_currentRow >= m_height) || !inflateRow() )
+   {
+      return false;
+   }
+
+   // Undo the scan line filter into m_row.
+   const ossim_uint8* cur  = &m_filtered.front() + 1;
+   const ossim_uint8* prev = &m_prevRow.front();
+   ossim_uint8*       row  = &m_row.front();
+   const ossim_uint32 BPP  = m_bytesPerPixel;
+   ossim_uint32 i = 0;
+   switch ( m_filtered[0] )
+   {
+      case 0: // None
+      {
+         std::memcpy( row, cur, m_rowBytes );
+         break;
+      }
+      case 1: // Sub
+      {
+         for ( i = 0; i < m_rowBytes; ++i )
+         {
+            row[i] = cur[i] + ( (i >= BPP) ? row[i - BPP] : 0 );
+         }
+         break;
+      }
+      case 2: // Up
+      {
+         for ( i = 0; i < m_rowBytes; ++i )
+         {
+            row[i] = cur[i] + prev[i];
+         }
+         break;
+      }
+      case 3: // Average
+      {
+         for ( i = 0; i < m_rowBytes; ++i )
+         {
+            ossim_uint32 left = (i >= BPP) ? row[i - BPP] : 0;
+            row[i] = cur[i] + (ossim_uint8)( (left + prev[i]) >> 1 );
+         }
+         break;
+      }
+      case 4: // Paeth
+      {
+         for ( i = 0; i < m_rowBytes; ++i )
+         {
+            ossim_int32 a = (i >= BPP) ? row[i - BPP] : 0;
+            ossim_int32 b = prev[i];
+            ossim_int32 c = (i >= BPP) ? prev[i - BPP] : 0;
+            ossim_int32 pa = std::abs(b - c);
+            ossim_int32 pb = std::abs(a - c);
+            ossim_int32 pc = std::abs(a + b - 2*c);
+            ossim_int32 pred = ( (pa <= pb) && (pa <= pc) ) ? a : ( (pb <= pc) ? b : c );
+            row[i] = cur[i] + (ossim_uint8)pred;
+         }
+         break;
+      }
+      default:
+      {
+         return false;
+      }
+   }
+
+   m_row.swap(m_prevRow);
+   m_filled = 0;
+   ++m_currentRow;
+   if ( m_currentRow == m_height )
+   {
+      m_complete = true;
+   }
+   return true;
+}
+
+bool ossimPngInflateIndex::seekRow( ossim_uint32 row )
+{
+   if ( row >= m_height )
+   {
+      return false;
+   }
+   if ( row == m_currentRow )
+   {
+      return true;
+   }
+
+   // Last checkpoint at or before row.
+   const Checkpoint* cp = 0;
+   for ( std::vector<Checkpoint>::const_iterator iter = m_checkpoints.begin();
+         (iter != m_checkpoints.end()) && (iter->m_row <= row); ++iter )
+   {
+      cp = &(*iter);
+   }
+
+   bool status = true;
+   if ( cp && ( (row < m_currentRow) || (cp->m_row > m_currentRow) ) )
+   {
+      status = restore(*cp);
+   }
+   else if ( row < m_currentRow )
+   {
+      status = restart();
+   }
+
+   while ( status && (m_currentRow < row) )
+   {
+      status = nextRow();
+   }
+
+   return status;
+}
+
+bool ossimPngInflateIndex::readRow( ossim_uint8* buffer )
+{
+   if ( !buffer || !nextRow() )
+   {
+      return false;
+   }
+
+   if ( m_palette.empty() )
+   {
+      std::memcpy( buffer, &m_prevRow.front(), m_rowBytes );
+   }
+   else
+   {
+      // Expand 1, 2, 4 or 8 bit indexes, most significant bits first.
+      const ossim_uint32 MASK = (1 << m_bitDepth) - 1;
+      const ossim_uint32 PIXELS_PER_BYTE = 8 / m_bitDepth;
+      const ossim_uint32 ENTRIES = (ossim_uint32)m_palette.size();
+      ossim_uint8* dst = buffer;
+      for ( ossim_uint32 sample = 0; sample < m_width; ++sample )
+      {
+         ossim_uint8 byte = m_prevRow[sample / PIXELS_PER_BYTE];
+         ossim_uint32 shift = 8 - m_bitDepth * ( (sample % PIXELS_PER_BYTE) + 1 );
+         ossim_uint32 index = (byte >> shift) & MASK;
+         if ( index < ENTRIES )
+         {
+            dst[0] = m_palette[index].red;
+            dst[1] = m_palette[index].green;
+            dst[2] = m_palette[index].blue;
+         }
+         else
+         {
+            dst[0] = dst[1] = dst[2] = 0;
+         }
+         dst += 3;
+      }
+   }
+   return true;
+}
+
+ossim_uint32 ossimPngInflateIndex::getCurrentRow() const
+{
+   return m_currentRow;
+}
+
+bool ossimPngInflateIndex::isComplete() const
+{
+   return m_complete;
+}
+
+bool ossimPngInflateIndex::isModified() const
+{
+   return m_modified;
+}
+
+bool ossimPngInflateIndex::loadSidecar( const ossimFilename& file,
+                                        ossim_int64 sourceTime )
+{
+   std::ifstream in( file.c_str(), std::ios::in | std::ios::binary );
+   if ( !in )
+   {
+      return false;
+   }
+
+   char magic[4];
+   ossim_uint32 version = 0;
+   ossim_uint32 bom = 0;
+   ossim_int64  time = 0;
+   ossim_uint64 streamLength = 0;
+   ossim_uint32 width = 0;
+   ossim_uint32 height = 0;
+   ossim_uint32 rowBytes = 0;
+   ossim_uint32 count = 0;
+   in.read( magic, 4 );
+   if ( !in.good() || (std::memcmp( magic, SIDECAR_MAGIC, 4 ) != 0) ||
+        !readValue(in, version) || (version != SIDECAR_VERSION) ||
+        !readValue(in, bom) || (bom != SIDECAR_BOM) ||
+        !readValue(in, time) || (time != sourceTime) ||
+        !readValue(in, streamLength) || (streamLength != m_streamLength) ||
+        !readValue(in, width) || (width != m_width) ||
+        !readValue(in, height) || (height != m_height) ||
+        !readValue(in, rowBytes) || (rowBytes != m_rowBytes) ||
+        !readValue(in, count) )
+   {
+      return false;
+   }
+
+   std::vector<Checkpoint> checkpoints(count);
+   for ( ossim_uint32 i = 0; i < count; ++i )
+   {
+      Checkpoint& cp = checkpoints[i];
+      if ( !readValue(in, cp.m_row) || (cp.m_row >= m_height) ||
+           ( i && (cp.m_row <= checkpoints[i-1].m_row) ) ||
+           !readValue(in, cp.m_in) || (cp.m_in > m_streamLength) ||
+           !readValue(in, cp.m_bits) || (cp.m_bits < 0) || (cp.m_bits > 7) ||
+           !readBytes(in, cp.m_window, WINDOW_SIZE) ||
+           !readBytes(in, cp.m_partial, m_rowBytes + 1) ||
+           !readBytes(in, cp.m_prevRow, m_rowBytes) ||
+           (cp.m_prevRow.size() != m_rowBytes) )
+      {
+         return false;
+      }
+   }
+
+   m_checkpoints.swap(checkpoints);
+   m_complete = true;
+   m_modified = false;
+
+   if (traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossimPngInflateIndex::loadSidecar DEBUG: " << file
+         << " checkpoints: " << m_checkpoints.size() << std::endl;
+   }
+   return true;
+}
+
+bool ossimPngInflateIndex::saveSidecar( const ossimFilename& file,
+                                        ossim_int64 sourceTime )
+{
+   std::ofstream out( file.c_str(), std::ios::out | std::ios::binary );
+   if ( !out )
+   {
+      return false;
+   }
+
+   out.write( SIDECAR_MAGIC, 4 );
+   writeValue(out, SIDECAR_VERSION);
+   writeValue(out, SIDECAR_BOM);
+   writeValue(out, sourceTime);
+   writeValue(out, m_streamLength);
+   writeValue(out, m_width);
+   writeValue(out, m_height);
+   writeValue(out, m_rowBytes);
+   writeValue(out, (ossim_uint32)m_checkpoints.size());
+   for ( std::vector<Checkpoint>::const_iterator iter = m_checkpoints.begin();
+         iter != m_checkpoints.end(); ++iter )
+   {
+      writeValue(out, iter->m_row);
+      writeValue(out, iter->m_in);
+      writeValue(out, iter->m_bits);
+      writeBytes(out, iter->m_window);
+      writeBytes(out, iter->m_partial);
+      writeBytes(out, iter->m_prevRow);
+   }
+
+   bool result = out.good();
+   if ( result )
+   {
+      m_modified = false;
+   }
+   return result;
+}
@@ -0,0 +1,164 @@
+//----------------------------------------------------------------------------
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Description: Random access row decoder for non-interlaced png images.
+//
+// Inflates the IDAT stream directly and records inflate checkpoints (deflate
+// block boundary, 32K window and the surrounding scan line state) every so
+// many rows, the way zlib's examples/zran.c does for gzip files.  Decoding
+// can then resume from the nearest checkpoint instead of the start of the
+// image.  The index can be saved to and loaded from a sidecar file.
+//
+//----------------------------------------------------------------------------
+// $Id$
+#ifndef ossimPngInflateIndex_HEADER
+#define ossimPngInflateIndex_HEADER 1
+
+#include <ossim/base/ossimConstants.h>
+#include <ossim/base/ossimFilename.h>
+#include <ossim/base/ossimIosFwd.h>
+#include <png.h>
+#include <zlib.h>
+#include <memory>
+#include <vector>
+
+class ossimPngInflateIndex
+{
+public:
+
+   ossimPngInflateIndex();
+   ~ossimPngInflateIndex();
+
+   /**
+    * @brief Locates the IDAT chunks and positions the decoder on row 0.
+    *
+    * Only non-interlaced images whose rows need no libpng transform other
+    * than palette expansion are handled.  Callers check that before.
+    *
+    * @param str Stream to the png.
+    * @param width Image width.
+    * @param height Image height.
+    * @param bitDepth Bit depth from the IHDR.
+    * @param colorType Color type from the IHDR.
+    * @param palette Palette for PNG_COLOR_TYPE_PALETTE, expanded to rgb.
+    * @param checkpointRows Minimum rows between checkpoints.  0 disables
+    * checkpoints, leaving a forward only decoder.
+    * @return true on success, false on error.
+    */
+   bool initialize( std::shared_ptr<ossim::istream> str,
+                    ossim_uint32 width,
+                    ossim_uint32 height,
+                    ossim_uint32 bitDepth,
+                    ossim_int32 colorType,
+                    const std::vector<png_color>& palette,
+                    ossim_uint32 checkpointRows );
+
+   /**
+    * @brief Positions the decoder so the next readRow returns row.
+    * @return true on success, false on error.
+    */
+   bool seekRow( ossim_uint32 row );
+
+   /**
+    * @brief Decodes the next row into buffer laid out as png_read_row would
+    * with png_set_expand, i.e. palette indexes expanded to rgb.
+    * @return true on success, false on error or past the last row.
+    */
+   bool readRow( ossim_uint8* buffer );
+
+   /** @return Row the next readRow returns. */
+   ossim_uint32 getCurrentRow() const;
+
+   /** @return true once checkpoints cover the whole image. */
+   bool isComplete() const;
+
+   /** @return true if checkpoints were added since the last load or save. */
+   bool isModified() const;
+
+   /**
+    * @brief Loads checkpoints from a sidecar written by saveSidecar.  The
+    * sidecar is ignored if it does not match the image.
+    * @param sourceTime Modification time of the png.  Must match the time
+    * the sidecar was saved with.
+    * @return true on success, false on error.
+    */
+   bool loadSidecar( const ossimFilename& file, ossim_int64 sourceTime );
+
+   /**
+    * @brief Writes the checkpoints to file.
+    * @param sourceTime Modification time of the png.
+    * @return true on success, false on error.
+    */
+   bool saveSidecar( const ossimFilename& file, ossim_int64 sourceTime );
+
+private:
+
+   struct Chunk
+   {
+      std::streamoff m_filePos;   // Offset of the chunk data in the file.
+      ossim_uint64   m_streamPos; // Offset in the concatenated IDAT data.
+      ossim_uint32   m_length;
+   };
+
+   struct Checkpoint
+   {
+      ossim_uint32              m_row;     // Row being decoded.
+      ossim_uint64              m_in;      // Compressed bytes consumed.
+      ossim_int32               m_bits;    // Unused bits of byte m_in-1.
+      std::vector<ossim_uint8>  m_window;  // Last 32K of inflated data.
+      std::vector<ossim_uint8>  m_partial; // Filtered bytes of m_row so far.
+      std::vector<ossim_uint8>  m_prevRow; // Unfiltered row m_row-1.
+   };
+
+   bool scanChunks();
+   ossim_uint32 readInput( ossim_uint8* buf, ossim_uint64 pos, ossim_uint32 size );
+
+   /** Starts inflating from the top of the image. */
+   bool restart();
+
+   /** Resumes inflating at a checkpoint. */
+   bool restore( const Checkpoint& cp );
+
+   /** Inflates the rest of the current filtered row. */
+   bool inflateRow();
+
+   /** Records a checkpoint if at a block boundary far enough past the last. */
+   void addCheckpoint();
+
+   /** Unfilters the current row into m_prevRow and advances a row. */
+   bool nextRow();
+
+   void endInflate();
+
+   std::shared_ptr<ossim::istream> m_str;
+   std::vector<Chunk>              m_chunks;
+   ossim_uint64                    m_streamLength;
+
+   z_stream                        m_zstream;
+   bool                            m_inflating;
+   std::vector<ossim_uint8>        m_input;
+   ossim_uint64                    m_inputPos;
+
+   ossim_uint32                    m_width;
+   ossim_uint32                    m_height;
+   ossim_uint32                    m_rowBytes;
+   ossim_uint32                    m_bytesPerPixel;
+   ossim_uint32                    m_bitDepth;
+   std::vector<png_color>          m_palette;
+
+   std::vector<ossim_uint8>        m_filtered;
+   ossim_uint32                    m_filled;
+   std::vector<ossim_uint8>        m_row;
+   std::vector<ossim_uint8>        m_prevRow;
+   ossim_uint32                    m_currentRow;
+
+   std::vector<Checkpoint>         m_checkpoints;
+   ossim_uint32                    m_checkpointRows;
+   bool                            m_complete;
+   bool                            m_modified;
+};
+
+#endif /* #ifndef ossimPngInflateIndex_HEADER */
@@ -13,6 +13,7 @@
 
 
 #include "ossimPngReader.h"
+#include "ossimPngInflateIndex.h"
 #include <ossim/base/ossimBooleanProperty.h>
 #include <ossim/base/ossimConstants.h>
 #include <ossim/base/ossimEndian.h>
@@ -21,6 +22,7 @@
 #include <ossim/base/ossimIrect.h>
 #include <ossim/base/ossimKeywordlist.h>
 #include <ossim/base/ossimNotifyContext.h>
+#include <ossim/base/ossimPreferences.h>
 #include <ossim/base/ossimProperty.h>
 #include <ossim/base/ossimStreamFactoryRegistry.h>
 #include <ossim/base/ossimTrace.h>
@@ -30,11 +32,19 @@
 
 #include <cstddef> /* for NULL */
 #include <cmath>   /* for pow */
+#include <cstring> /* for memset */
 #include <fstream>
+#include <sys/stat.h>
 
 // If true alpha channel is passed as a layer.
 static const std::string USE_ALPHA_KW = "use_alpha"; // boolean
 
+// Rows between inflate checkpoints.  0 disables random access decoding.
+static const char CHECKPOINT_ROWS_KW[] = "ossim.plugins.png.checkpointRows";
+
+// If true the inflate checkpoints are saved to and loaded from a sidecar.
+static const char CHECKPOINT_SIDECAR_KW[] = "ossim.plugins.png.checkpointSidecar";
+
 RTTI_DEF1(ossimPngReader, "ossimPngReader", ossimImageHandler)
 
 #ifdef OSSIM_ID_ENABLED
@@ -43,6 +53,18 @@ RTTI_DEF1(ossimPngReader, "ossimPngReader", ossimImageHandler)
    
 static ossimTrace traceDebug("ossimPngReader:degug");  
 
+// Modification time of file in seconds, 0 if unknown.  Ties a sidecar
+// index to the version of the png it was built from.
+static ossim_int64 getModificationTime(const ossimFilename& file)
+{
+   struct stat info;
+   if ( stat( file.c_str(), &info ) == 0 )
+   {
+      return (ossim_int64)info.st_mtime;
+   }
+   return 0;
+}
+
 ossimPngReader::ossimPngReader()
    :
    ossimImageHandler(),
@@ -68,7 +90,9 @@ ossimPngReader::ossimPngReader()
    m_readMode(ossimPngReadUnknown),
    m_maxPixelValue(),
    m_swapFlag(false),
-   m_useAlphaChannelFlag(false)
+   m_useAlphaChannelFlag(false),
+   m_inflateIndex(0),
+   m_saveInflateIndexFlag(false)
 {
    if (traceDebug())
    {
@@ -117,6 +141,12 @@ void ossimPngReader::destroy()
       m_pngReadInfoPtr = 0;
    }
 
+   if (m_inflateIndex)
+   {
+      delete m_inflateIndex;
+      m_inflateIndex = 0;
+   }
+
    // Stream data member m_str is share pointer now:
    m_str = 0;
 }
@@ -307,18 +337,7 @@ void ossimPngReader::fillTile(const ossimIrect& clip_rect,
             m_cacheTile->makeBlank();
          }
 
-         if (startLine < m_currentRow)
-         {
-            // Must restart the compression process again.
-            restart();
-         }
-
-         // Gobble any not needed lines.
-         while(m_currentRow < startLine)
-         {
-            png_read_row(m_pngReadPtr, m_lineBuffer, NULL);
-            ++m_currentRow;
-         }
+         seekRow(startLine);
             
          switch (m_readMode)
          {
@@ -366,6 +385,17 @@ void ossimPngReader::fillTile(const ossimIrect& clip_rect,
          }
 
          m_cacheTile->validate();
+
+         if ( m_inflateIndex && m_saveInflateIndexFlag &&
+              m_inflateIndex->isComplete() && m_inflateIndex->isModified() )
+         {
+            // First full pass done; persist the checkpoints.
+            ossimFilename sidecar = getInflateIndexFile();
+            if ( sidecar.size() )
+            {
+               m_inflateIndex->saveSidecar( sidecar, getModificationTime(theImageFile) );
+            }
+         }
          
          tile->loadTile(m_cacheTile.get());
          
@@ -533,6 +563,7 @@ bool ossimPngReader::open( std::shared_ptr<ossim::istream>& str )
             result = initReader();
             if ( result )
             {
+               initInflateIndex();
                completeOpen();
             }
          }
@@ -765,6 +796,136 @@ void ossimPngReader::restart()
    }
 }
 
+void ossimPngReader::initInflateIndex()
+{
+   ossim_uint32 checkpointRows = 256;
+   const char* lookup = ossimPreferences::instance()->findPreference(CHECKPOINT_ROWS_KW);
+   if (lookup)
+   {
+      checkpointRows = ossimString(lookup).toUInt32();
+   }
+   lookup = ossimPreferences::instance()->findPreference(CHECKPOINT_SIDECAR_KW);
+   if (lookup)
+   {
+      m_saveInflateIndexFlag = ossimString(lookup).toBool();
+   }
+
+   //---
+   // Rows are decoded without libpng only when the sole transform set in
+   // initReader is palette expansion.  Interlaced images and those with a
+   // tRNS chunk or packed gray pixels stay on libpng.
+   //---
+   if ( (checkpointRows == 0) || (m_interlacePasses != 1) ||
+        png_get_valid(m_pngReadPtr, m_pngReadInfoPtr, PNG_INFO_tRNS) ||
+        ( (m_pngColorType == PNG_COLOR_TYPE_GRAY) && (m_bitDepth < 8) ) )
+   {
+      return;
+   }
+
+   std::vector<png_color> palette;
+   if ( m_pngColorType == PNG_COLOR_TYPE_PALETTE )
+   {
+      png_colorp colors = 0;
+      int numColors = 0;
+      if ( png_get_PLTE(m_pngReadPtr, m_pngReadInfoPtr, &colors, &numColors) && colors )
+      {
+         palette.assign( colors, colors + numColors );
+      }
+   }
+
+   //---
+   // Scanning the chunks moves the stream; put it back so libpng picks up
+   // where it left off if the index cannot be used.
+   //---
+   std::streamoff pos = m_str->tellg();
+
+   m_inflateIndex = new ossimPngInflateIndex();
+   if ( m_inflateIndex->initialize( m_str,
+                                    m_imageRect.width(),
+                                    m_imageRect.height(),
+                                    m_bitDepth,
+                                    m_pngColorType,
+                                    palette,
+                                    checkpointRows ) )
+   {
+      ossimFilename sidecar = getInflateIndexFile();
+      if ( m_saveInflateIndexFlag && sidecar.exists() )
+      {
+         m_inflateIndex->loadSidecar( sidecar, getModificationTime(theImageFile) );
+      }
+   }
+   else
+   {
+      delete m_inflateIndex;
+      m_inflateIndex = 0;
+      m_str->clear();
+      m_str->seekg( pos, std::ios_base::beg );
+   }
+
+   if (traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossimPngReader::initInflateIndex DEBUG:"
+         << "\ninflate index: " << (m_inflateIndex?"on":"off") << std::endl;
+   }
+}
+
+ossimFilename ossimPngReader::getInflateIndexFile() const
+{
+   ossimFilename result;
+   if ( theImageFile.size() && theImageFile.isFile() )
+   {
+      result = theImageFile;
+      result.setExtension("zidx");
+   }
+   return result;
+}
+
+void ossimPngReader::seekRow(ossim_uint32 row)
+{
+   if ( m_inflateIndex )
+   {
+      if ( !m_inflateIndex->seekRow(row) )
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << "ossimPngReader::seekRow WARN: Error while decoding row "
+            << row << " of " << theImageFile << std::endl;
+      }
+      m_currentRow = row;
+   }
+   else
+   {
+      if (row < m_currentRow)
+      {
+         // Must restart the compression process again.
+         restart();
+      }
+
+      // Gobble any not needed lines.
+      while(m_currentRow < row)
+      {
+         png_read_row(m_pngReadPtr, m_lineBuffer, NULL);
+         ++m_currentRow;
+      }
+   }
+}
+
+void ossimPngReader::readRow()
+{
+   if ( m_inflateIndex )
+   {
+      if ( !m_inflateIndex->readRow(m_lineBuffer) )
+      {
+         memset(m_lineBuffer, 0, m_lineBufferSizeInBytes);
+      }
+   }
+   else
+   {
+      png_read_row(m_pngReadPtr, m_lineBuffer, NULL);
+   }
+   ++m_currentRow;
+}
+
 bool ossimPngReader::checkSignature( std::istream& str )
 {
    bool result = false;
@@ -1200,9 +1361,8 @@ template <class T>  void ossimPngReader::copyLines(
    
    while (m_currentRow <= stopLine)
    {
-      // Read a line from the jpeg file.
-      png_read_row(m_pngReadPtr, m_lineBuffer, NULL);
-      ++m_currentRow;
+      // Read a line from the png file.
+      readRow();
 
       if(m_swapFlag)
       {
@@ -1263,9 +1423,8 @@ template <class T> void ossimPngReader::copyLinesWithAlpha(
    
    while (m_currentRow <= stopLine)
    {
-      // Read a line from the jpeg file.
-      png_read_row(m_pngReadPtr, m_lineBuffer, NULL);
-      ++m_currentRow;
+      // Read a line from the png file.
+      readRow();
 
       if(m_swapFlag)
       {
@@ -22,6 +22,7 @@
 #include <vector>
 
 class ossimImageData;
+class ossimPngInflateIndex;
 
 class ossimPngReader : public ossimImageHandler, public ossimStreamReaderInterface
 {
@@ -267,6 +268,26 @@ protected:
     */
    void restart();
 
+   /**
+    * @brief Sets up m_inflateIndex if the image rows can be decoded without
+    * libpng, i.e. not interlaced and no transform other than palette
+    * expansion.  Loads the sidecar index if enabled and present.
+    */
+   void initInflateIndex();
+
+   /** @return Sidecar for the inflate index, "<image>.zidx". */
+   ossimFilename getInflateIndexFile() const;
+
+   /**
+    * @brief Positions the reader so the next readRow returns row.  Resumes
+    * from the nearest inflate checkpoint if there is an index, else restarts
+    * libpng when backing up.
+    */
+   void seekRow(ossim_uint32 row);
+
+   /** @brief Reads the next row into m_lineBuffer. */
+   void readRow();
+
    /**
     * @note this method assumes that setImageRectangle has been called on
     * theTile.
@@ -317,6 +338,12 @@ protected:
 
    // If true the alpha channel will be passed on as a band.
    bool m_useAlphaChannelFlag;
+
+   // Random access row decoder.  Null if libpng reads rows.
+   ossimPngInflateIndex* m_inflateIndex;
+
+   // If true the inflate index is saved to a sidecar once complete.
+   bool m_saveInflateIndexFlag;
    
 TYPE_DATA
 };
@@ -42,7 +42,9 @@
 
 #include <sqlite3.h>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <sstream>
 
 RTTI_DEF1(ossimGpkgReader, "ossimGpkgReader", ossimImageHandler)
@@ -66,7 +68,10 @@ ossimGpkgReader::ossimGpkgReader()
    m_scalar(OSSIM_SCALAR_UNKNOWN),
    m_tileWidth(0),
    m_tileHeight(0),
-   m_entries(0)
+   m_entries(0),
+   m_statements(),
+   m_cacheIds(0),
+   m_tileRecord()
 {
    if (traceDebug())
    {
@@ -175,23 +180,128 @@ void ossimGpkgReader::fillTile( ossim_uint32 resLevel,
       // Get the tile indexes needed to fill the clipRect.
       std::vector<ossimIpt> tileIndexes;
       getTileIndexes( resLevel, clipRect, tileIndexes );
-      
+
+      // Unload what is in the tile cache and gather what is not.
+      std::vector<ossimIpt> missingIndexes;
+      ossimAppFixedTileCache::ossimAppFixedCacheId cacheId = getCacheId( resLevel );
       std::vector<ossimIpt>::const_iterator i = tileIndexes.begin();
       while ( i != tileIndexes.end() )
       {
-         ossimRefPtr<ossimImageData> id = getTile( resLevel, (*i) );
+         ossimRefPtr<ossimImageData> id = 0;
+         if ( cacheId != -1 )
+         {
+            id = ossimAppFixedTileCache::instance()->getTile(
+               cacheId, getTileOrigin( resLevel, (*i) ) );
+         }
          if ( id.valid() )
          {
             ossimIrect tileClipRect = clipRect.clipToRect( id->getImageRectangle() );
             id->unloadTile( tile->getBuf(), tileRect, tileClipRect, OSSIM_BSQ );
          }
+         else
+         {
+            missingIndexes.push_back( (*i) );
+         }
          ++i;
       }
+
+      if ( missingIndexes.size() == 1 )
+      {
+         ossimRefPtr<ossimImageData> id = getTile( resLevel, missingIndexes[0] );
+         if ( id.valid() )
+         {
+            ossimIrect tileClipRect = clipRect.clipToRect( id->getImageRectangle() );
+            id->unloadTile( tile->getBuf(), tileRect, tileClipRect, OSSIM_BSQ );
+         }
+      }
+      else if ( missingIndexes.size() > 1 )
+      {
+         fetchTileRange( resLevel, missingIndexes, tileRect, clipRect, tile );
+      }
       
       tile->validate();
    }
 }
 
+void ossimGpkgReader::fetchTileRange( ossim_uint32 resLevel,
+                                      const std::vector<ossimIpt>& tileIndexes,
+                                      const ossimIrect& tileRect,
+                                      const ossimIrect& clipRect,
+                                      ossimImageData* tile )
+{
+   static const char MODULE[] = "ossimGpkgReader::fetchTileRange";
+   
+   if ( m_db && tile && tileIndexes.size() && ( m_currentEntry < m_entries.size() ) )
+   {
+      if ( resLevel < m_entries[m_currentEntry].getTileMatrix().size() )
+      {
+         ossimIpt minIndex( std::numeric_limits<ossim_int32>::max(),
+                            std::numeric_limits<ossim_int32>::max() );
+         ossimIpt maxIndex( std::numeric_limits<ossim_int32>::min(),
+                            std::numeric_limits<ossim_int32>::min() );
+         std::vector<ossimIpt>::const_iterator i = tileIndexes.begin();
+         while ( i != tileIndexes.end() )
+         {
+            minIndex.x = std::min( minIndex.x, (*i).x );
+            minIndex.y = std::min( minIndex.y, (*i).y );
+            maxIndex.x = std::max( maxIndex.x, (*i).x );
+            maxIndex.y = std::max( maxIndex.y, (*i).y );
+            ++i;
+         }
+         
+         std::string tableName =
+            m_entries[m_currentEntry].getTileMatrix()[resLevel].m_table_name;
+         ossim_int32 zoomLevel =
+            m_entries[m_currentEntry].getTileMatrix()[resLevel].m_zoom_level;
+         
+         std::ostringstream sql;
+         sql << "SELECT id, zoom_level, tile_column, tile_row, tile_data from "
+             << tableName
+             << " WHERE zoom_level=?1 AND tile_row BETWEEN ?2 AND ?3"
+             << " AND tile_column BETWEEN ?4 AND ?5";
+
+         sqlite3_stmt* pStmt = getStatement( sql.str() );
+         if ( pStmt )
+         {
+            sqlite3_bind_int( pStmt, 1, zoomLevel );
+            sqlite3_bind_int( pStmt, 2, minIndex.y );
+            sqlite3_bind_int( pStmt, 3, maxIndex.y );
+            sqlite3_bind_int( pStmt, 4, minIndex.x );
+            sqlite3_bind_int( pStmt, 5, maxIndex.x );
+
+            while ( sqlite3_step( pStmt ) == SQLITE_ROW )
+            {
+               //---
+               // The range can take in tiles that were unloaded from the cache
+               // already.  Skip those before touching the blob.
+               //---
+               ossimIpt index( sqlite3_column_int( pStmt, 2 ),
+                               sqlite3_column_int( pStmt, 3 ) );
+               if ( std::find( tileIndexes.begin(), tileIndexes.end(), index ) !=
+                    tileIndexes.end() )
+               {
+                  ossimRefPtr<ossimImageData> id = decodeTile( resLevel, pStmt );
+                  if ( id.valid() )
+                  {
+                     ossimIrect tileClipRect = clipRect.clipToRect( id->getImageRectangle() );
+                     id->unloadTile( tile->getBuf(), tileRect, tileClipRect, OSSIM_BSQ );
+                  }
+               }
+            }
+
+            // Release the read transaction.
+            sqlite3_reset( pStmt );
+         }
+         else if (traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << MODULE << " WARNING: prepare failed for sql:\n" << sql.str() << "\n";
+         }
+      }
+   }
+   
+} // End: ossimGpkgReader::fetchTileRange( ... )
+
 void ossimGpkgReader::getTileIndexes( ossim_uint32 resLevel,
                                       const ossimIrect& clipRect,
                                       std::vector<ossimIpt>& tileIndexes ) const
@@ -477,6 +587,8 @@ void ossimGpkgReader::close()
    {
       ossimImageHandler::close();
    }
+   deleteCaches();
+   finalizeStatements();
    if ( m_db )
    {
       sqlite3_close( m_db );
@@ -526,6 +638,9 @@ bool ossimGpkgReader::setCurrentEntry(ossim_uint32 entryIdx )
          {
             // Zero out the tile to force an allocate() call.
             m_tile = 0;
+
+            // Cached tiles belong to the last entry's tile matrix.
+            deleteCaches();
             
             // Clear the geometry.
             theGeometry = 0;
@@ -795,124 +910,53 @@ ossimRefPtr<ossimImageData> ossimGpkgReader::getTile( ossim_uint32 resLevel,
       {
          if ( resLevel < m_entries[m_currentEntry].getTileMatrix().size() )
          {
-            std::string tableName =
-               m_entries[m_currentEntry].getTileMatrix()[resLevel].m_table_name;
-            ossim_int32 zoomLevel =
-               m_entries[m_currentEntry].getTileMatrix()[resLevel].m_zoom_level;
-            const char *zLeftover;   // Tail of unprocessed SQL
-            sqlite3_stmt *pStmt = 0; // The current SQL statement
-            std::ostringstream sql;
-            sql << "SELECT id, zoom_level, tile_column, tile_row, tile_data from "
-                << tableName
-                << " WHERE zoom_level=" << zoomLevel
-                << " AND tile_column=" << index.x
-                << " AND tile_row=" << index.y;
-
-            if (traceDebug())
+            ossimAppFixedTileCache::ossimAppFixedCacheId cacheId = getCacheId( resLevel );
+            if ( cacheId != -1 )
             {
-               ossimNotify(ossimNotifyLevel_DEBUG)
-                  << MODULE << " sql:\n" << sql.str() << "\n";
+               result = ossimAppFixedTileCache::instance()->getTile(
+                  cacheId, getTileOrigin( resLevel, index ) );
             }
-            
-            int rc = sqlite3_prepare_v2(
-               m_db,             // Database handle
-               sql.str().c_str(),// SQL statement, UTF-8 encoded
-               -1,               // Maximum length of zSql in bytes.
-               &pStmt,           // OUT: Statement handle
-               &zLeftover);      // OUT: Pointer to unused portion of zSql
-            if ( rc == SQLITE_OK )
+
+            if ( !result )
             {
-               int nCol = sqlite3_column_count( pStmt );
-               if ( nCol )
+               std::string tableName =
+                  m_entries[m_currentEntry].getTileMatrix()[resLevel].m_table_name;
+               ossim_int32 zoomLevel =
+                  m_entries[m_currentEntry].getTileMatrix()[resLevel].m_zoom_level;
+               std::ostringstream sql;
+               sql << "SELECT id, zoom_level, tile_column, tile_row, tile_data from "
+                   << tableName
+                   << " WHERE zoom_level=?1 AND tile_column=?2 AND tile_row=?3";
+               
+               if (traceDebug())
+               {
+                  ossimNotify(ossimNotifyLevel_DEBUG)
+                     << MODULE << " sql:\n" << sql.str() << "\n";
+               }
+               
+               sqlite3_stmt* pStmt = getStatement( sql.str() );
+               if ( pStmt )
                {
+                  sqlite3_bind_int( pStmt, 1, zoomLevel );
+                  sqlite3_bind_int( pStmt, 2, index.x );
+                  sqlite3_bind_int( pStmt, 3, index.y );
+                  
                   // Read the row:
-                  rc = sqlite3_step(pStmt);
-                  if (rc == SQLITE_ROW) //  || (rc == SQLITE_DONE) )
+                  if ( sqlite3_step(pStmt) == SQLITE_ROW )
                   {
-                     ossimGpkgTileRecord tile;
-                     tile.setCopyTileFlag(true);
-                     if (tile.init( pStmt ) )
-                     {
-                        ossimIpt tileSize;
-                        m_entries[m_currentEntry].getTileMatrix()[resLevel].getTileSize(tileSize);
-                        ossimRefPtr<ossimCodecBase> codec;
-                        switch ( tile.getTileType() )
-                        {
-                           case ossimGpkgTileRecord::OSSIM_GPKG_JPEG:
-                           {
-                              // we need to cache this instead of allocating a new codec every tile
-                              // for now just getting it to compile with registry implementation
-                              //
-                              if( !m_jpegCodec.valid() )
-                              {
-                                 m_jpegCodec = ossimCodecFactoryRegistry::instance()->
-                                    createCodec(ossimString("jpeg"));
-                              }
-                              
-                              codec = m_jpegCodec.get();
-                              break;
-                           }
-                           case ossimGpkgTileRecord::OSSIM_GPKG_PNG:
-                           {
-                              if( !m_pngCodec.valid() )
-                              {
-                                 m_pngCodec = ossimCodecFactoryRegistry::instance()->
-                                    createCodec(ossimString("png"));
-                              }
-                              codec = m_pngCodec.get();
-                              break;
-                           }
-                           default:
-                           {
-                              if (traceDebug())
-                              {
-                                 ossimNotify(ossimNotifyLevel_WARN)
-                                    << "Unhandled type: " << tile.getTileType() << endl;;
-                              }
-                              result = 0;
-                              break;
-                           }
-                        }
-                        
-                        if ( codec.valid() )
-                        {
-                           if ( codec->decode(tile.m_tile_data, m_cacheTile ) )
-                           {
-                              result = m_cacheTile;
-                           }
-                           else
-                           {
-                              ossimNotify(ossimNotifyLevel_WARN)
-                                 << "WARNING: decode failed...\n";
-                           }
-                        }
-                        
-                        if ( result.valid() )
-                        {
-                           // Set the tile origin in image space.
-                           ossimIpt origin( index.x*tileSize.x,
-                                            index.y*tileSize.y );
-                           
-                           // Subtract the sub image offset if any:
-                           ossimIpt subImageOffset(0,0);
-                           m_entries[m_currentEntry].getSubImageOffset( resLevel, subImageOffset );
-                           origin -= subImageOffset;
-                           
-                           result->setOrigin( origin );
-                        }
-                        else if (traceDebug())
-                        {
-                           ossimNotify(ossimNotifyLevel_WARN)
-                              << MODULE << " WARNING: result is null!\n";
-                        }
-                     }
+                     result = decodeTile( resLevel, pStmt );
                   }
                   
-               } // Matches: if ( nCol )
-               
-            } // Matches: if ( rc == SQLITE_OK )
-
-            sqlite3_finalize(pStmt);
+                  // Release the read transaction.
+                  sqlite3_reset( pStmt );
+               }
+            }
+            
+            if ( !result && traceDebug() )
+            {
+               ossimNotify(ossimNotifyLevel_WARN)
+                  << MODULE << " WARNING: result is null!\n";
+            }
             
          } // Matches: if(resLevel<m_entries[m_currentEntry].getTileMatrix().size())
          
@@ -930,6 +974,222 @@ ossimRefPtr<ossimImageData> ossimGpkgReader::getTile( ossim_uint32 resLevel,
    
 } // End: ossimGpkgReader::getTile( resLevel, index )
 
+ossimRefPtr<ossimImageData> ossimGpkgReader::decodeTile( ossim_uint32 resLevel,
+                                                         sqlite3_stmt* pStmt )
+{
+   ossimRefPtr<ossimImageData> result = 0;
+
+   if ( pStmt && ( m_currentEntry < m_entries.size() ) )
+   {
+      m_tileRecord.m_id          = sqlite3_column_int( pStmt, 0 );
+      m_tileRecord.m_zoom_level  = sqlite3_column_int( pStmt, 1 );
+      m_tileRecord.m_tile_column = sqlite3_column_int( pStmt, 2 );
+      m_tileRecord.m_tile_row    = sqlite3_column_int( pStmt, 3 );
+
+      //---
+      // The codecs take a vector so the blob is copied once into the record
+      // buffer, which keeps its capacity from tile to tile.
+      //---
+      const ossim_uint8* blob = (const ossim_uint8*)sqlite3_column_blob( pStmt, 4 );
+      int bytes = sqlite3_column_bytes( pStmt, 4 );
+      if ( blob && ( bytes > 0 ) )
+      {
+         m_tileRecord.m_tile_data.assign( blob, blob + bytes );
+      }
+      else
+      {
+         m_tileRecord.m_tile_data.clear();
+      }
+      
+      ossimRefPtr<ossimCodecBase> codec;
+      switch ( m_tileRecord.getTileType() )
+      {
+         case ossimGpkgTileRecord::OSSIM_GPKG_JPEG:
+         {
+            if( !m_jpegCodec.valid() )
+            {
+               m_jpegCodec = ossimCodecFactoryRegistry::instance()->
+                  createCodec(ossimString("jpeg"));
+            }
+            codec = m_jpegCodec.get();
+            break;
+         }
+         case ossimGpkgTileRecord::OSSIM_GPKG_PNG:
+         {
+            if( !m_pngCodec.valid() )
+            {
+               m_pngCodec = ossimCodecFactoryRegistry::instance()->
+                  createCodec(ossimString("png"));
+            }
+            codec = m_pngCodec.get();
+            break;
+         }
+         default:
+         {
+            if (traceDebug())
+            {
+               ossimNotify(ossimNotifyLevel_WARN)
+                  << "Unhandled type: " << m_tileRecord.getTileType() << endl;
+            }
+            break;
+         }
+      }
+      
+      if ( codec.valid() )
+      {
+         if ( codec->decode( m_tileRecord.m_tile_data, m_cacheTile ) )
+         {
+            result = m_cacheTile;
+         }
+         else
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << "WARNING: decode failed...\n";
+         }
+      }
+      
+      if ( result.valid() )
+      {
+         // Set the tile origin in image space.
+         result->setOrigin( getTileOrigin( resLevel,
+                                           ossimIpt( m_tileRecord.m_tile_column,
+                                                     m_tileRecord.m_tile_row ) ) );
+
+         // The cache keeps a copy as m_cacheTile is reused by the next decode.
+         ossimAppFixedTileCache::ossimAppFixedCacheId cacheId = getCacheId( resLevel );
+         if ( cacheId != -1 )
+         {
+            ossimAppFixedTileCache::instance()->addTile( cacheId, result );
+         }
+      }
+   }
+
+   return result;
+   
+} // End: ossimGpkgReader::decodeTile( resLevel, pStmt )
+
+sqlite3_stmt* ossimGpkgReader::getStatement( const std::string& sql )
+{
+   sqlite3_stmt* pStmt = 0;
+   if ( m_db )
+   {
+      std::map<std::string, sqlite3_stmt*>::iterator i = m_statements.find( sql );
+      if ( i != m_statements.end() )
+      {
+         pStmt = (*i).second;
+         sqlite3_reset( pStmt );
+         sqlite3_clear_bindings( pStmt );
+      }
+      else
+      {
+         int rc = sqlite3_prepare_v2(
+            m_db,        // Database handle
+            sql.c_str(), // SQL statement, UTF-8 encoded
+            -1,          // Maximum length of zSql in bytes.
+            &pStmt,      // OUT: Statement handle
+            0 );         // OUT: Pointer to unused portion of zSql
+         if ( rc == SQLITE_OK )
+         {
+            m_statements[sql] = pStmt;
+         }
+         else
+         {
+            sqlite3_finalize( pStmt );
+            pStmt = 0;
+         }
+      }
+   }
+   return pStmt;
+}
+
+void ossimGpkgReader::finalizeStatements()
+{
+   std::map<std::string, sqlite3_stmt*>::iterator i = m_statements.begin();
+   while ( i != m_statements.end() )
+   {
+      sqlite3_finalize( (*i).second );
+      ++i;
+   }
+   m_statements.clear();
+}
+
+ossimAppFixedTileCache::ossimAppFixedCacheId ossimGpkgReader::getCacheId(
+   ossim_uint32 resLevel )
+{
+   ossimAppFixedTileCache::ossimAppFixedCacheId result = -1;
+   if ( m_currentEntry < m_entries.size() )
+   {
+      const std::vector<ossimGpkgTileMatrixRecord>& matrix =
+         m_entries[m_currentEntry].getTileMatrix();
+      if ( resLevel < matrix.size() )
+      {
+         if ( m_cacheIds.size() != matrix.size() )
+         {
+            deleteCaches();
+            m_cacheIds.resize( matrix.size(), -1 );
+         }
+         if ( m_cacheIds[resLevel] == -1 )
+         {
+            //---
+            // Cover the whole tile matrix.  Tile origins are shifted by the
+            // sub image offset so the upper left can be negative.
+            //---
+            ossimIpt tileSize;
+            matrix[resLevel].getTileSize( tileSize );
+            if ( tileSize.x && tileSize.y )
+            {
+               ossimIpt ul = getTileOrigin( resLevel, ossimIpt(0,0) );
+               ossimIrect rect( ul.x,
+                                ul.y,
+                                ul.x + (ossim_int32)matrix[resLevel].m_matrix_width *
+                                tileSize.x - 1,
+                                ul.y + (ossim_int32)matrix[resLevel].m_matrix_height *
+                                tileSize.y - 1 );
+               m_cacheIds[resLevel] =
+                  ossimAppFixedTileCache::instance()->newTileCache( rect, tileSize );
+            }
+         }
+         result = m_cacheIds[resLevel];
+      }
+   }
+   return result;
+}
+
+void ossimGpkgReader::deleteCaches()
+{
+   std::vector<ossimAppFixedTileCache::ossimAppFixedCacheId>::const_iterator i =
+      m_cacheIds.begin();
+   while ( i != m_cacheIds.end() )
+   {
+      if ( (*i) != -1 )
+      {
+         ossimAppFixedTileCache::instance()->deleteCache( (*i) );
+      }
+      ++i;
+   }
+   m_cacheIds.clear();
+}
+
+ossimIpt ossimGpkgReader::getTileOrigin( ossim_uint32 resLevel, const ossimIpt& index ) const
+{
+   ossimIpt origin(0,0);
+   if ( m_currentEntry < m_entries.size() )
+   {
+      if ( resLevel < m_entries[m_currentEntry].getTileMatrix().size() )
+      {
+         ossimIpt tileSize;
+         m_entries[m_currentEntry].getTileMatrix()[resLevel].getTileSize(tileSize);
+         origin = ossimIpt( index.x*tileSize.x, index.y*tileSize.y );
+         
+         // Subtract the sub image offset if any:
+         ossimIpt subImageOffset(0,0);
+         m_entries[m_currentEntry].getSubImageOffset( resLevel, subImageOffset );
+         origin -= subImageOffset;
+      }
+   }
+   return origin;
+}
+
 ossimRefPtr<ossimImageData> ossimGpkgReader::uncompressPngTile( const ossimGpkgTileRecord& tile,
                                                                 const ossimIpt& tileSize )
 {
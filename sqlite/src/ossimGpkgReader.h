@@ -14,15 +14,19 @@
 #define ossimGpkgReader_HEADER 1
 
 #include <ossim/imaging/ossimImageHandler.h>
+#include <ossim/imaging/ossimAppFixedTileCache.h>
 #include <ossim/base/ossimRefPtr.h>
 #include "ossimGpkgTileEntry.h"
+#include "ossimGpkgTileRecord.h"
 #include <ossim/imaging/ossimCodecBase.h>
 
+#include <map>
+#include <string>
 #include <vector>
 
-class ossimGpkgTileRecord;
 class ossimImageData;
 struct sqlite3;
+struct sqlite3_stmt;
 
 class ossimGpkgReader : public ossimImageHandler
 {
@@ -250,6 +254,51 @@ private:
    ossimRefPtr<ossimImageData> getTile( ossim_uint32 resLevel,
                                         ossimIpt index );
 
+   /**
+    * @brief Fetches the tiles of a clip rect not already in the tile cache
+    * with one query over the range of rows and columns they span.
+    * @param resLevel Reduced resolution level.
+    * @param tileIndexes Indexes of tiles to fetch.
+    * @param tileRect Rectangle of tile.
+    * @param clipRect Clip rectangle.
+    * @param tile Tile to unload to.
+    */
+   void fetchTileRange( ossim_uint32 resLevel,
+                        const std::vector<ossimIpt>& tileIndexes,
+                        const ossimIrect& tileRect,
+                        const ossimIrect& clipRect,
+                        ossimImageData* tile );
+
+   /**
+    * @brief Decodes the tile at the current row of pStmt and adds it to the
+    * tile cache.
+    *
+    * pStmt columns must be id, zoom_level, tile_column, tile_row, tile_data.
+    * 
+    * @return Decoded tile with origin set, or null on error.
+    */
+   ossimRefPtr<ossimImageData> decodeTile( ossim_uint32 resLevel,
+                                           sqlite3_stmt* pStmt );
+
+   /**
+    * @brief Gets a prepared statement, reset with bindings cleared if it was
+    * used before.  Statements are kept until close.
+    * @return Statement or null on error.
+    */
+   sqlite3_stmt* getStatement( const std::string& sql );
+
+   /** @brief Finalizes all prepared statements. */
+   void finalizeStatements();
+
+   /** @return Tile cache id for resLevel, created on first call. */
+   ossimAppFixedTileCache::ossimAppFixedCacheId getCacheId( ossim_uint32 resLevel );
+
+   /** @brief Deletes the tile caches of the current entry. */
+   void deleteCaches();
+
+   /** @return Image space origin of tile index at resLevel. */
+   ossimIpt getTileOrigin( ossim_uint32 resLevel, const ossimIpt& index ) const;
+
    /**
     * @brief Uncompresses png tile to m_cacheTile.
     * @param tile Tile record.
@@ -286,6 +335,15 @@ private:
    mutable ossimRefPtr<ossimCodecBase> m_jpegCodec;
    mutable ossimRefPtr<ossimCodecBase> m_pngCodec;
 
+   /** Prepared statements keyed by sql. */
+   std::map<std::string, sqlite3_stmt*> m_statements;
+
+   /** Decoded tile cache ids indexed by res level, -1 if not created. */
+   std::vector<ossimAppFixedTileCache::ossimAppFixedCacheId> m_cacheIds;
+
+   /** Holds the blob being decoded; reused so its buffer is not reallocated. */
+   ossimGpkgTileRecord m_tileRecord;
+
 TYPE_DATA
 };
 
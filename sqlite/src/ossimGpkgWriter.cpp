@@ -49,6 +49,8 @@
 #include <ossim/imaging/ossimRectangleCutFilter.h>
 #include <ossim/imaging/ossimScalarRemapper.h>
 
+#include <ossim/parallel/ossimMultiThreadSequencer.h>
+
 #include <ossim/projection/ossimEquDistCylProjection.h>
 #include <ossim/projection/ossimEpsgProjectionFactory.h>
 #include <ossim/projection/ossimGoogleProjection.h>
@@ -60,7 +62,14 @@
 
 #include <algorithm> /* std::sort */
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 RTTI_DEF1(ossimGpkgWriter, "ossimGpkgWriter", ossimImageFileWriter)
 
@@ -76,6 +85,11 @@ static const std::string COMPRESSION_LEVEL_KW          = "compression_level";
 static const std::string DEFAULT_FILE_NAME             = "output.gpkg";
 static const std::string EPSG_KW                       = "epsg";
 static const std::string INCLUDE_BLANK_TILES_KW        = "include_blank_tiles";
+static const std::string JOURNAL_MODE_KW               = "journal_mode";
+static const std::string PAGE_SIZE_KW                  = "page_size";
+static const std::string PYRAMID_KW                    = "pyramid";
+static const std::string RENDER_THREADS_KW             = "render_threads";
+static const std::string THREADS_KW                    = "threads";
 static const std::string TILE_SIZE_KW                  = "tile_size";
 static const std::string TILE_TABLE_NAME_KW            = "tile_table_name";
 static const std::string TRUE_KW                       = "true";
@@ -89,6 +103,207 @@ static const std::string ZOOM_LEVELS_KW                = "zoom_levels";
 //---
 static ossimTrace traceDebug("ossimGpkgWriter:debug");
 
+namespace
+{
+   //---
+   // Averages the valid pixels of each 2x2 block of child into the quadrant
+   // (quadX, quadY) of parent.  Blocks with no valid pixels are set to null.
+   //---
+   template <class T> void downsample2x2( const ossimImageData* child,
+                                          ossimImageData* parent,
+                                          ossim_uint32 quadX,
+                                          ossim_uint32 quadY )
+   {
+      const ossim_uint32 W  = child->getWidth();
+      const ossim_uint32 HW = W / 2;
+      const ossim_uint32 HH = child->getHeight() / 2;
+      const ossim_uint32 X0 = quadX * HW;
+      const ossim_uint32 Y0 = quadY * HH;
+      const bool IS_INT = std::numeric_limits<T>::is_integer;
+      
+      for ( ossim_uint32 band = 0; band < child->getNumberOfBands(); ++band )
+      {
+         const T* s = static_cast<const T*>( child->getBuf( band ) );
+         T* d = static_cast<T*>( parent->getBuf( band ) );
+         const T NP = static_cast<T>( child->getNullPix( band ) );
+         
+         for ( ossim_uint32 y = 0; y < HH; ++y )
+         {
+            const T* s0 = s + (2 * y) * W;
+            const T* s1 = s0 + W;
+            T* dRow = d + (Y0 + y) * W + X0;
+            for ( ossim_uint32 x = 0; x < HW; ++x )
+            {
+               const T p[4] = { s0[2*x], s0[2*x+1], s1[2*x], s1[2*x+1] };
+               ossim_float64 sum = 0.0;
+               ossim_uint32 count = 0;
+               for ( ossim_uint32 i = 0; i < 4; ++i )
+               {
+                  if ( p[i] != NP )
+                  {
+                     sum += p[i];
+                     ++count;
+                  }
+               }
+               if ( count )
+               {
+                  ossim_float64 v = sum / count;
+                  dRow[x] = static_cast<T>( IS_INT ? std::floor( v + 0.5 ) : v );
+               }
+               else
+               {
+                  dRow[x] = NP;
+               }
+            }
+         }
+      }
+   }
+
+   //---
+   // Builds coarser zoom levels from the tiles of the level below.  Tiles
+   // must be added in raster order; each level holds one row of parent tiles
+   // until the next row starts, then hands it to emit and to the level above.
+   //---
+   class ossimGpkgPyramid
+   {
+   public:
+      typedef std::function<void( ossim_int32 zoomLevel,
+                                  ossim_int64 row,
+                                  ossim_int64 col,
+                                  ossimRefPtr<ossimImageData>& tile )> EmitFunction;
+      
+      /**
+       * @param writeBlanks If true empty parent tiles are emitted too, as
+       * for the "include_blank_tiles" option.
+       */
+      ossimGpkgPyramid( const std::vector<ossim_int32>& parentZoomLevels,
+                        bool writeBlanks,
+                        EmitFunction emit )
+         :
+         m_levels( parentZoomLevels.size() ),
+         m_writeBlanks( writeBlanks ),
+         m_emit( emit )
+      {
+         for ( std::size_t i = 0; i < parentZoomLevels.size(); ++i )
+         {
+            m_levels[i].m_zoomLevel = parentZoomLevels[i];
+            m_levels[i].m_row = -1;
+         }
+      }
+
+      void addTile( const ossimImageData* tile, ossim_int64 row, ossim_int64 col )
+      {
+         if ( m_levels.size() )
+         {
+            add( 0, tile, row, col );
+         }
+      }
+
+      /** Emits the partial rows left at the end of the sequence. */
+      void flush()
+      {
+         for ( std::size_t i = 0; i < m_levels.size(); ++i )
+         {
+            flushLevel( i );
+         }
+      }
+
+   private:
+      struct Level
+      {
+         ossim_int32 m_zoomLevel;
+         ossim_int64 m_row;
+         std::map<ossim_int64, ossimRefPtr<ossimImageData> > m_tiles;
+      };
+
+      void add( std::size_t level, const ossimImageData* tile,
+                ossim_int64 row, ossim_int64 col )
+      {
+         Level& l = m_levels[level];
+         if ( l.m_row != row / 2 )
+         {
+            flushLevel( level );
+            l.m_row = row / 2;
+         }
+
+         ossimRefPtr<ossimImageData>& parent = l.m_tiles[ col / 2 ];
+         if ( !parent.valid() )
+         {
+            parent = static_cast<ossimImageData*>( tile->dup() );
+            parent->makeBlank();
+         }
+
+         ossim_uint32 quadX = (ossim_uint32)( col % 2 );
+         ossim_uint32 quadY = (ossim_uint32)( row % 2 );
+         switch ( tile->getScalarType() )
+         {
+            case OSSIM_UINT8:
+               downsample2x2<ossim_uint8>( tile, parent.get(), quadX, quadY );
+               break;
+            case OSSIM_SINT8:
+               downsample2x2<ossim_sint8>( tile, parent.get(), quadX, quadY );
+               break;
+            case OSSIM_UINT9:
+            case OSSIM_UINT10:
+            case OSSIM_UINT11:
+            case OSSIM_UINT12:
+            case OSSIM_UINT13:
+            case OSSIM_UINT14:
+            case OSSIM_UINT15:
+            case OSSIM_UINT16:
+               downsample2x2<ossim_uint16>( tile, parent.get(), quadX, quadY );
+               break;
+            case OSSIM_SINT16:
+               downsample2x2<ossim_sint16>( tile, parent.get(), quadX, quadY );
+               break;
+            case OSSIM_UINT32:
+               downsample2x2<ossim_uint32>( tile, parent.get(), quadX, quadY );
+               break;
+            case OSSIM_SINT32:
+               downsample2x2<ossim_sint32>( tile, parent.get(), quadX, quadY );
+               break;
+            case OSSIM_FLOAT32:
+            case OSSIM_NORMALIZED_FLOAT:
+               downsample2x2<ossim_float32>( tile, parent.get(), quadX, quadY );
+               break;
+            case OSSIM_FLOAT64:
+            case OSSIM_NORMALIZED_DOUBLE:
+               downsample2x2<ossim_float64>( tile, parent.get(), quadX, quadY );
+               break;
+            default:
+               break;
+         }
+      }
+
+      void flushLevel( std::size_t level )
+      {
+         Level& l = m_levels[level];
+         std::map<ossim_int64, ossimRefPtr<ossimImageData> >::iterator i = l.m_tiles.begin();
+         while ( i != l.m_tiles.end() )
+         {
+            ossimRefPtr<ossimImageData> tile = (*i).second;
+            tile->validate();
+            if ( ( ( tile->getDataObjectStatus() != OSSIM_EMPTY ) || m_writeBlanks ) &&
+                 ( tile->getDataObjectStatus() != OSSIM_NULL ) )
+            {
+               // Feed the level above before the tile is handed off.
+               if ( level + 1 < m_levels.size() )
+               {
+                  add( level + 1, tile.get(), l.m_row, (*i).first );
+               }
+               m_emit( l.m_zoomLevel, l.m_row, (*i).first, tile );
+            }
+            ++i;
+         }
+         l.m_tiles.clear();
+      }
+
+      std::vector<Level> m_levels;
+      bool               m_writeBlanks;
+      EmitFunction       m_emit;
+   };
+}
+
 // For the "ident" program:
 #if OSSIM_ID_ENABLED
 static const char OSSIM_ID[] = "$Id: ossimGpkgWriter.cpp 22466 2013-10-24 18:23:51Z dburken $";
@@ -99,7 +314,7 @@ ossimGpkgWriter::ossimGpkgWriter()
    ossimImageFileWriter(),
    m_db(0),
    m_batchCount(0),
-   m_batchSize(32),
+   m_batchSize(1024),
    m_projectionBoundingRect(0.0, 0.0, 0.0, 0.0, OSSIM_RIGHT_HANDED),
    m_sceneBoundingRect(0.0, 0.0, 0.0, 0.0, OSSIM_RIGHT_HANDED),
    m_clipRect(0.0, 0.0, 0.0, 0.0, OSSIM_RIGHT_HANDED),
@@ -142,7 +357,7 @@ ossimGpkgWriter::ossimGpkgWriter()
    m_kwl->addPair( WRITER_MODE_KW, std::string("mixed") );
 
    // Note batch size dramatically effects speed.
-   m_kwl->addPair( BATCH_SIZE_KW, "32" );
+   m_kwl->addPair( BATCH_SIZE_KW, "1024" );
 }
 
 ossimGpkgWriter::~ossimGpkgWriter()
@@ -210,6 +425,23 @@ bool ossimGpkgWriter::open()
 
          if ( !append() )
          {
+            //---
+            // Page size only takes before the first table is created.  Large
+            // pages keep most tile blobs off overflow page chains.
+            //---
+            ossim_uint32 pageSize = 65536;
+            std::string value = m_kwl->findKey( PAGE_SIZE_KW );
+            if ( value.size() )
+            {
+               pageSize = ossimString(value).toUInt32();
+            }
+            if ( pageSize )
+            {
+               std::ostringstream pageSql;
+               pageSql << "PRAGMA page_size = " << pageSize;
+               sqlite3_exec( m_db, pageSql.str().c_str(), NULL, NULL, NULL );
+            }
+            
             //---
             // Set the application_id:
             // Requirement 2: Every GeoPackage must contain 0x47503130 ("GP10" in ACII)
@@ -223,7 +455,16 @@ bool ossimGpkgWriter::open()
             {
                status = false;
             }
-         }            
+         }
+
+         //---
+         // Only a new file may drop its journal; a failed append must not
+         // corrupt existing content, so existing files keep sqlite defaults.
+         //---
+         if ( status && !append() )
+         {
+            setBuildPragmas( m_db );
+         }
       }
       else
       {
@@ -521,6 +762,11 @@ void ossimGpkgWriter::close()
 {
    if ( m_db )
    {
+      // Fold a write ahead log back in so the gpkg is a single file.
+      if ( ossimString( m_kwl->findKey( JOURNAL_MODE_KW ) ).downcase() == "wal" )
+      {
+         sqlite3_exec( m_db, "PRAGMA journal_mode = DELETE", NULL, NULL, NULL );
+      }
       sqlite3_close( m_db );
       m_db = 0;
    }
@@ -582,6 +828,8 @@ bool ossimGpkgWriter::writeFile()
          // Note only the master process used for writing...
          if( theInputConnection->isMaster() )
          {
+            useMultiThreadSequencer();
+
             if (!isOpen())
             {
                open();
@@ -1061,6 +1309,23 @@ void ossimGpkgWriter::writeZoomLevels( sqlite3* db,
       ossim_float64 tilesWritten = 0.0;
       ossim_float64 totalTiles   = 0.0;
 
+      //---
+      // Pyramid mode renders only the last, highest resolution level from
+      // the input.  The levels before it are built from it by writeTiles.
+      //---
+      bool pyramid = false;
+      ossimIrect coarsestAoi;
+      if ( keyIsTrue( PYRAMID_KW ) && ( zoomLevels.size() > 1 ) )
+      {
+         pyramid = isQuadTree( proj, zoomLevels, coarsestAoi );
+         if ( !pyramid )
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << MODULE << " WARNING:\nTile matrices do not nest, "
+               << "ignoring pyramid option." << std::endl;
+         }
+      }
+
       std::vector<ossim_int32>::const_iterator zoomLevel = zoomLevels.begin();
       while ( zoomLevel != zoomLevels.end() )
       {
@@ -1075,6 +1340,13 @@ void ossimGpkgWriter::writeZoomLevels( sqlite3* db,
          // Expanded to tile boundaries:
          ossimIrect expandedAoi;
          getExpandedAoi( aoi, expandedAoi );
+
+         if ( pyramid )
+         {
+            // Grown to the coarsest level's footprint so parents nest.
+            expandedAoi = getPyramidAoi(
+               coarsestAoi, (ossim_uint32)( zoomLevel - zoomLevels.begin() ) );
+         }
          
          // Get the number of tiles:
          ossimIpt matrixSize;
@@ -1133,7 +1405,18 @@ void ossimGpkgWriter::writeZoomLevels( sqlite3* db,
             if ( writeGpkgNsgTileMatrixExtentTable( db, (*zoomLevel),
                                                     expandedAoi, clippedAoi ) )
             {
-               writeTiles( db, expandedAoi, (*zoomLevel), totalTiles, tilesWritten );
+               if ( !pyramid )
+               {
+                  writeTiles( db, expandedAoi, (*zoomLevel), totalTiles, tilesWritten );
+               }
+               else if ( (*zoomLevel) == zoomLevels.back() )
+               {
+                  // Coarser levels, next coarser first.
+                  std::vector<ossim_int32> parentZoomLevels( zoomLevels.rbegin() + 1,
+                                                             zoomLevels.rend() );
+                  writeTiles( db, expandedAoi, (*zoomLevel), totalTiles, tilesWritten,
+                              parentZoomLevels );
+               }
                // writeZoomLevel( db, expandedAoi, (*zoomLevel), totalTiles, tilesWritten );
             }
             else
@@ -1184,11 +1467,63 @@ void ossimGpkgWriter::writeZoomLevels( sqlite3* db,
    
 } // ossimGpkgWriter::writeZoomLevels( ... )
 
+bool ossimGpkgWriter::isQuadTree( const ossimMapProjection* proj,
+                                  const std::vector<ossim_int32>& zoomLevels,
+                                  ossimIrect& coarsestAoi )
+{
+   bool result = ( proj != 0 ) && alignToGrid() && zoomLevels.size();
+   if ( result )
+   {
+      // Work on a copy so the caller's view is untouched.
+      ossimRefPtr<ossimMapProjection> testProj =
+         static_cast<ossimMapProjection*>( proj->dup() );
+
+      for ( std::size_t i = 0; i < zoomLevels.size(); ++i )
+      {
+         if ( i )
+         {
+            ossimDpt scale( 0.5, 0.5 );
+            testProj->applyScale( scale, true );
+            testProj->update();
+         }
+
+         ossimIrect aoi;
+         getAoiFromRect( testProj.get(), m_outputRect, aoi );
+         ossimIrect expandedAoi;
+         getExpandedAoi( aoi, expandedAoi );
+
+         if ( i == 0 )
+         {
+            coarsestAoi = expandedAoi;
+         }
+         else if ( ( zoomLevels[i] != zoomLevels[i-1] + 1 ) ||
+                   !expandedAoi.completely_within(
+                      getPyramidAoi( coarsestAoi, (ossim_uint32)i ) ) )
+         {
+            result = false;
+            break;
+         }
+      }
+   }
+   return result;
+}
+
+ossimIrect ossimGpkgWriter::getPyramidAoi( const ossimIrect& coarsestAoi,
+                                           ossim_uint32 levelsBelow ) const
+{
+   ossim_int32 factor = 1 << levelsBelow;
+   ossimIpt ul( coarsestAoi.ul().x * factor, coarsestAoi.ul().y * factor );
+   ossimIpt lr( ( coarsestAoi.lr().x + 1 ) * factor - 1,
+                ( coarsestAoi.lr().y + 1 ) * factor - 1 );
+   return ossimIrect( ul, lr );
+}
+
 void ossimGpkgWriter::writeTiles( sqlite3* db,
                                   const ossimIrect& aoi,
                                   ossim_int32 zoomLevel,
                                   const ossim_float64& totalTiles,
-                                  ossim_float64& tilesWritten )
+                                  ossim_float64& tilesWritten,
+                                  const std::vector<ossim_int32>& parentZoomLevels )
 {
    if ( db )
    {
@@ -1199,7 +1534,6 @@ void ossimGpkgWriter::writeTiles( sqlite3* db,
       const ossim_int64 ROWS = (ossim_int64)(theInputConnection->getNumberOfTilesVertical());
       const ossim_int64 COLS = (ossim_int64)(theInputConnection->getNumberOfTilesHorizontal());
 
-      char * sErrMsg = 0;
       sqlite3_stmt* pStmt = 0; // The current SQL statement
       std::ostringstream sql;
       sql << "INSERT INTO " << m_tileTableName << "( zoom_level, tile_column, tile_row, tile_data ) VALUES ( "
@@ -1223,11 +1557,224 @@ void ossimGpkgWriter::writeTiles( sqlite3* db,
 
       bool writeBlanks = keyIsTrue( INCLUDE_BLANK_TILES_KW );
 
+      //---
+      // In pyramid mode each input tile also stands for its share of the
+      // parent tiles built from it, a quarter per level up, so percent
+      // complete reaches the total over all levels.
+      //---
+      ossim_float64 tileWeight = 1.0;
+      ossim_float64 parentShare = 1.0;
+      for ( std::size_t i = 0; i < parentZoomLevels.size(); ++i )
+      {
+         parentShare *= 0.25;
+         tileWeight += parentShare;
+      }
+
       if(rc == SQLITE_OK)
       {
-         for ( ossim_int64 row = 0; row < ROWS; ++row )
+         //---
+         // Pipeline: this thread pulls rendered tiles from the sequencer,
+         // encode threads compress them and one writer thread owns db.
+         // Tiles cycle between a free list and the encode queue so at most
+         // queueTiles rendered tiles are in memory; the insert queue is held
+         // to the same bound.
+         //---
+         const ossim_uint32 THREADS = getNumberOfThreads();
+         const std::size_t QUEUE_TILES = THREADS * 4;
+
+         // Codec instances keep state between calls so each thread has its own.
+         std::vector< ossimRefPtr<ossimCodecBase> > fullCodecs( THREADS );
+         std::vector< ossimRefPtr<ossimCodecBase> > partialCodecs( THREADS );
+         for ( ossim_uint32 i = 0; i < THREADS; ++i )
+         {
+            createCodecs( fullCodecs[i], partialCodecs[i] ); // Throws exception on error.
+         }
+
+         struct EncodeJob
+         {
+            ossimRefPtr<ossimImageData> m_tile;
+            ossim_int32 m_zoomLevel;
+            ossim_int64 m_row;
+            ossim_int64 m_col;
+            bool m_recycle; // Return tile to the free list when encoded.
+         };
+         struct InsertJob
+         {
+            std::vector<ossim_uint8> m_data;
+            ossim_int32 m_zoomLevel;
+            ossim_int64 m_row;
+            ossim_int64 m_col;
+         };
+         
+         std::mutex queueMutex;
+         std::condition_variable queueCondition;
+         std::deque<EncodeJob> encodeQueue;
+         std::deque<InsertJob> insertQueue;
+         std::vector< ossimRefPtr<ossimImageData> > freeTiles;
+         std::size_t allocatedTiles = 0;
+         ossim_uint32 activeEncoders = THREADS;
+         bool producerDone = false;
+
+         std::vector<std::thread> encoders;
+         std::thread writerThread;
+
+         //---
+         // Stops and joins the pipeline threads on every exit so an exception
+         // never destroys a joinable std::thread.  Queued tiles are drained
+         // first.
+         //---
+         struct PipelineGuard
+         {
+            PipelineGuard( std::mutex& queueMutex,
+                           std::condition_variable& queueCondition,
+                           bool& producerDone,
+                           std::vector<std::thread>& encoders,
+                           std::thread& writerThread )
+               : m_queueMutex( queueMutex ),
+                 m_queueCondition( queueCondition ),
+                 m_producerDone( producerDone ),
+                 m_encoders( encoders ),
+                 m_writerThread( writerThread )
+            {}
+            ~PipelineGuard()
+            {
+               join();
+            }
+            void join()
+            {
+               {
+                  std::unique_lock<std::mutex> lock( m_queueMutex );
+                  m_producerDone = true;
+                  m_queueCondition.notify_all();
+               }
+               for ( std::size_t i = 0; i < m_encoders.size(); ++i )
+               {
+                  if ( m_encoders[i].joinable() )
+                  {
+                     m_encoders[i].join();
+                  }
+               }
+               if ( m_writerThread.joinable() )
+               {
+                  m_writerThread.join();
+               }
+            }
+            std::mutex&               m_queueMutex;
+            std::condition_variable&  m_queueCondition;
+            bool&                     m_producerDone;
+            std::vector<std::thread>& m_encoders;
+            std::thread&              m_writerThread;
+         };
+         PipelineGuard pipeline( queueMutex, queueCondition, producerDone,
+                                 encoders, writerThread );
+
+         for ( ossim_uint32 i = 0; i < THREADS; ++i )
+         {
+            encoders.push_back( std::thread( [&, i]()
+            {
+               std::unique_lock<std::mutex> lock(queueMutex);
+               while ( true )
+               {
+                  queueCondition.wait( lock, [&]()
+                                       { return producerDone || !encodeQueue.empty(); } );
+                  if ( encodeQueue.empty() )
+                  {
+                     break; // producerDone
+                  }
+                  
+                  EncodeJob job = encodeQueue.front();
+                  encodeQueue.pop_front();
+                  lock.unlock();
+
+                  InsertJob insert;
+                  insert.m_zoomLevel = job.m_zoomLevel;
+                  insert.m_row = job.m_row;
+                  insert.m_col = job.m_col;
+                  bool encoded = encodeTile( job.m_tile.get(),
+                                             fullCodecs[i].get(),
+                                             partialCodecs[i].get(),
+                                             insert.m_data );
+                  lock.lock();
+                  if ( encoded && insert.m_data.size() )
+                  {
+                     insertQueue.push_back( std::move( insert ) );
+                  }
+                  if ( job.m_recycle )
+                  {
+                     freeTiles.push_back( job.m_tile );
+                  }
+                  queueCondition.notify_all();
+               }
+               --activeEncoders;
+               queueCondition.notify_all();
+            } ) );
+         }
+
+         writerThread = std::thread( [&]()
          {
-            for ( ossim_int64 col = 0; col < COLS; ++col )
+            char* sErrMsg = 0;
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while ( true )
+            {
+               queueCondition.wait( lock, [&]()
+                                    { return !insertQueue.empty() || ( activeEncoders == 0 ); } );
+               if ( insertQueue.empty() )
+               {
+                  break; // All encoders are done.
+               }
+
+               InsertJob job = std::move( insertQueue.front() );
+               insertQueue.pop_front();
+               queueCondition.notify_all();
+               lock.unlock();
+
+               if(m_batchCount == 0)
+               {
+                  sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, &sErrMsg);
+               }
+
+               writeCodecTile( pStmt, db, &job.m_data.front(), (ossim_int32)job.m_data.size(),
+                               job.m_zoomLevel, job.m_row, job.m_col );
+               ++m_batchCount;
+
+               if(m_batchCount == m_batchSize)
+               {
+                  sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &sErrMsg);
+                  m_batchCount = 0;
+               }
+
+               lock.lock();
+            }
+         } );
+
+         // Parent tiles are built on this thread and queued as they complete.
+         ossimGpkgPyramid pyramid( parentZoomLevels, writeBlanks,
+                                   [&]( ossim_int32 parentZoomLevel,
+                                        ossim_int64 parentRow,
+                                        ossim_int64 parentCol,
+                                        ossimRefPtr<ossimImageData>& parentTile )
+         {
+            EncodeJob job;
+            job.m_tile      = parentTile;
+            job.m_zoomLevel = parentZoomLevel;
+            job.m_row       = parentRow;
+            job.m_col       = parentCol;
+            job.m_recycle   = false;
+            
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait( lock, [&]()
+               { return ( insertQueue.size() < QUEUE_TILES ) &&
+                    ( encodeQueue.size() < QUEUE_TILES ); } );
+            encodeQueue.push_back( job );
+            queueCondition.notify_all();
+         } );
+
+         bool nullTile = false;
+         ossim_int64 row = 0;
+         ossim_int64 col = 0;
+         for ( row = 0; row < ROWS; ++row )
+         {
+            for ( col = 0; col < COLS; ++col )
             {
                // Grab the tile.
                ossimRefPtr<ossimImageData> tile = theInputConnection->getNextTile();
@@ -1238,39 +1785,66 @@ void ossimGpkgWriter::writeTiles( sqlite3* db,
                   {
                      if( (tile->getDataObjectStatus() != OSSIM_EMPTY) || writeBlanks )
                      {
-                        if(m_batchCount == 0)
+                        ossimRefPtr<ossimImageData> outputTile = 0;
                         {
-                           sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, &sErrMsg);
+                           std::unique_lock<std::mutex> lock(queueMutex);
+                           queueCondition.wait( lock, [&]()
+                              { return ( insertQueue.size() < QUEUE_TILES ) &&
+                                   ( !freeTiles.empty() || ( allocatedTiles < QUEUE_TILES ) ); } );
+                           if ( !freeTiles.empty() )
+                           {
+                              outputTile = freeTiles.back();
+                              freeTiles.pop_back();
+                           }
+                           else
+                           {
+                              ++allocatedTiles;
+                           }
                         }
 
-                        writeTile( pStmt, db, tile, zoomLevel, row, col);//, quality );
-                        ++m_batchCount;
+                        // The sequencer reuses its tile so hand the encoders a copy.
+                        if ( outputTile.valid() )
+                        {
+                           outputTile->setImageRectangle( tile->getImageRectangle() );
+                           outputTile->loadTile( tile.get() );
+                           outputTile->setDataObjectStatus( tile->getDataObjectStatus() );
+                        }
+                        else
+                        {
+                           outputTile = (ossimImageData*)tile->dup();
+                        }
 
-                        if(m_batchCount == m_batchSize)
+                        EncodeJob job;
+                        job.m_tile      = outputTile;
+                        job.m_zoomLevel = zoomLevel;
+                        job.m_row       = row;
+                        job.m_col       = col;
+                        job.m_recycle   = true;
                         {
-                           sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &sErrMsg);
-                           m_batchCount = 0;
+                           std::unique_lock<std::mutex> lock(queueMutex);
+                           encodeQueue.push_back( job );
+                           queueCondition.notify_all();
                         }
+
+                        pyramid.addTile( tile.get(), row, col );
                      }
                   }
                }
                else
                {
-                  std::ostringstream errMsg;
-                  errMsg << "ossimGpkgWriter::writeTiles ERROR: "
-                         << "Sequencer returned null tile pointer for ("
-                         << col << ", " << row << ")";
-                  
-                  throw ossimException( errMsg.str() );
+                  nullTile = true;
+                  break;
                }
 
                // Always increment the tiles written thing.
-               ++tilesWritten;
+               tilesWritten += tileWeight;
 
                if ( needsAborting() ) break;
                
             } // End: col loop
 
+            if ( nullTile ) break;
+
             setPercentComplete( (tilesWritten / totalTiles) * 100.0 );
 
             if ( needsAborting() )
@@ -1281,7 +1855,25 @@ void ossimGpkgWriter::writeTiles( sqlite3* db,
              
          } // End: row loop
 
+         if ( !nullTile && !needsAborting() )
+         {
+            pyramid.flush();
+         }
+
+         // Drain the queues.
+         pipeline.join();
+
          sqlite3_finalize(pStmt);
+
+         if ( nullTile )
+         {
+            std::ostringstream errMsg;
+            errMsg << "ossimGpkgWriter::writeTiles ERROR: "
+                   << "Sequencer returned null tile pointer for ("
+                   << col << ", " << row << ")";
+            
+            throw ossimException( errMsg.str() );
+         }
       }
       else
       {
@@ -1293,29 +1885,22 @@ void ossimGpkgWriter::writeTiles( sqlite3* db,
 
 } // End: ossimGpkgWriter::writeTiles( ... )
 
-void ossimGpkgWriter::writeTile( sqlite3_stmt* pStmt,
-                                 sqlite3* db,
-                                 ossimRefPtr<ossimImageData>& tile,
-                                 ossim_int32 zoomLevel,
-                                 ossim_int64 row,
-                                 ossim_int64 col )
+bool ossimGpkgWriter::encodeTile( ossimImageData* tile,
+                                  ossimCodecBase* fullTileCodec,
+                                  ossimCodecBase* partialTileCodec,
+                                  std::vector<ossim_uint8>& codecTile ) const
 {
-   if ( db && tile.valid() )
+   bool status = false;
+   if ( tile && fullTileCodec && partialTileCodec )
    {
-      std::vector<ossim_uint8> codecTile; // To hold the jpeg encoded tile.
-      bool encodeStatus;
-      std::string ext;
-      int mode = getWriterMode();
-
+      ossimRefPtr<ossimImageData> data = tile;
       if ( tile->getDataObjectStatus() == OSSIM_FULL )
       {
          if ( m_fullTileCodecAlpha )
          {
             tile->computeAlphaChannel();
          }
-         encodeStatus = m_fullTileCodec->encode(tile, codecTile);
-         if((mode == OSSIM_GPGK_WRITER_MODE_JPEG)||(mode == OSSIM_GPGK_WRITER_MODE_MIXED)) ext = ".jpg";
-         else ext = ".png";
+         status = fullTileCodec->encode(data, codecTile);
       }
       else
       {
@@ -1323,40 +1908,29 @@ void ossimGpkgWriter::writeTile( sqlite3_stmt* pStmt,
          {
             tile->computeAlphaChannel();
          }
-         encodeStatus = m_partialTileCodec->encode(tile, codecTile);
-         if(mode == OSSIM_GPGK_WRITER_MODE_JPEG) ext = ".jpg";
-         else ext = ".png";
-     }
-      
-      if ( encodeStatus )
-      {
-         // Insert into the database file(gpkg):
-         int rc = sqlite3_bind_int (pStmt, 1, zoomLevel);
-         rc |= sqlite3_bind_int (pStmt, 2, col);
-         rc |= sqlite3_bind_int (pStmt, 3, row);
-         rc |= sqlite3_bind_blob (pStmt,
-                                  4,
-                                  (void*)&codecTile.front(),
-                                  codecTile.size(),
-                                  SQLITE_TRANSIENT);
-         if (  rc == SQLITE_OK )
-         {
-            rc = sqlite3_step(pStmt);
-            if (  rc == SQLITE_OK )
-            {
-               ossimNotify(ossimNotifyLevel_WARN)
-                  << "sqlite3_step error: " << sqlite3_errmsg(db) << std::endl;
-            }
-            
-         }
-         else
-         {
-            ossimNotify(ossimNotifyLevel_WARN)
-               << "sqlite3_bind_blob error: " << sqlite3_errmsg(db) << std::endl;
-         }
-         
-         sqlite3_clear_bindings(pStmt);
-         sqlite3_reset(pStmt);
+         status = partialTileCodec->encode(data, codecTile);
+      }
+   }
+   return status;
+}
+
+void ossimGpkgWriter::writeTile( sqlite3_stmt* pStmt,
+                                 sqlite3* db,
+                                 ossimRefPtr<ossimImageData>& tile,
+                                 ossim_int32 zoomLevel,
+                                 ossim_int64 row,
+                                 ossim_int64 col )
+{
+   if ( db && tile.valid() )
+   {
+      std::vector<ossim_uint8> codecTile; // To hold the encoded tile.
+      if ( encodeTile( tile.get(),
+                       m_fullTileCodec.get(),
+                       m_partialTileCodec.get(),
+                       codecTile ) && codecTile.size() )
+      {
+         writeCodecTile( pStmt, db, &codecTile.front(), (ossim_int32)codecTile.size(),
+                         zoomLevel, row, col );
       }
       
    } // Matches:  if ( db && tile.valid() )
@@ -1384,7 +1958,7 @@ void ossimGpkgWriter::writeCodecTile( sqlite3_stmt* pStmt,
       if (  rc == SQLITE_OK )
       {
          rc = sqlite3_step(pStmt);
-         if (  rc == SQLITE_OK )
+         if (  rc != SQLITE_DONE )
          {
             ossimNotify(ossimNotifyLevel_WARN)
                << "sqlite3_step error: " << sqlite3_errmsg(db) << std::endl;
@@ -2234,7 +2808,7 @@ void ossimGpkgWriter::getTileSize( ossimIpt& tileSize ) const
 
 ossim_uint64 ossimGpkgWriter::getBatchSize() const
 {
-   ossim_uint64 size = 32; // ???
+   ossim_uint64 size = 1024;
    std::string value = m_kwl->findKey( BATCH_SIZE_KW );
    if ( value.size() )
    {
@@ -2917,43 +3491,46 @@ bool ossimGpkgWriter::getFilename( ossimFilename& file ) const
 }
 
 void ossimGpkgWriter::initializeCodec()
+{
+   createCodecs( m_fullTileCodec, m_partialTileCodec ); // Throws exception on error.
+   
+   ossimGpkgWriterMode mode = getWriterMode();
+   m_fullTileCodecAlpha = ( mode == OSSIM_GPGK_WRITER_MODE_PNGA );
+   m_partialTileCodecAlpha = ( ( mode == OSSIM_GPGK_WRITER_MODE_PNGA ) ||
+                               ( mode == OSSIM_GPGK_WRITER_MODE_MIXED ) );
+}
+
+void ossimGpkgWriter::createCodecs( ossimRefPtr<ossimCodecBase>& fullTileCodec,
+                                    ossimRefPtr<ossimCodecBase>& partialTileCodec ) const
 {
    ossimGpkgWriterMode mode = getWriterMode();
    if ( mode == OSSIM_GPGK_WRITER_MODE_JPEG )
    {
-      m_fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
-      m_partialTileCodec = m_fullTileCodec.get();
-      m_fullTileCodecAlpha = false;
-      m_partialTileCodecAlpha = false;
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
+      partialTileCodec = fullTileCodec.get();
    }
    else if(mode == OSSIM_GPGK_WRITER_MODE_PNG)
    {
-      m_fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("png"));
-      m_partialTileCodec = m_fullTileCodec.get();
-      m_fullTileCodecAlpha = false;
-      m_partialTileCodecAlpha = false;
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("png"));
+      partialTileCodec = fullTileCodec.get();
    }
    else if( mode == OSSIM_GPGK_WRITER_MODE_PNGA )
    {
-      m_fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("pnga"));
-      m_partialTileCodec = m_fullTileCodec.get();
-      m_fullTileCodecAlpha = true;
-      m_partialTileCodecAlpha = true;
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("pnga"));
+      partialTileCodec = fullTileCodec.get();
    }
    else if( mode == OSSIM_GPGK_WRITER_MODE_MIXED )
    {
-      m_fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
-      m_partialTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("pnga"));
-      m_fullTileCodecAlpha = false;
-      m_partialTileCodecAlpha = true;
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
+      partialTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("pnga"));
    }
    else
    {
-      m_fullTileCodec = 0;
-      m_partialTileCodec = 0;
+      fullTileCodec = 0;
+      partialTileCodec = 0;
    }
 
-   if ( m_fullTileCodec.valid() &&  m_partialTileCodec.valid() )
+   if ( fullTileCodec.valid() &&  partialTileCodec.valid() )
    {
       // Note: This will only take for jpeg.  Png uses compression_level and need to add.      
       ossim_uint32 quality = getCompressionQuality();
@@ -2961,8 +3538,8 @@ void ossimGpkgWriter::initializeCodec()
       {
          quality = (ossim_uint32)ossimGpkgWriter::DEFAULT_JPEG_QUALITY;
       }
-      m_fullTileCodec->setProperty("quality", ossimString::toString(quality));
-      m_partialTileCodec->setProperty("quality", ossimString::toString(quality));
+      fullTileCodec->setProperty("quality", ossimString::toString(quality));
+      partialTileCodec->setProperty("quality", ossimString::toString(quality));
    }
    else
    {
@@ -2975,6 +3552,63 @@ void ossimGpkgWriter::initializeCodec()
    }
 }
 
+ossim_uint32 ossimGpkgWriter::getNumberOfThreads() const
+{
+   ossim_uint32 threads = std::thread::hardware_concurrency();
+   std::string value = m_kwl->findKey( THREADS_KW );
+   if ( value.size() )
+   {
+      threads = ossimString(value).toUInt32();
+   }
+   return ( threads ? threads : 1 );
+}
+
+void ossimGpkgWriter::useMultiThreadSequencer()
+{
+   //---
+   // Chains are not safe for concurrent getTile calls so parallel render is
+   // done by ossimMultiThreadSequencer, which runs a clone of the chain per
+   // thread and hands tiles back in raster order.
+   //---
+   ossim_uint32 threads = 1;
+   std::string value = m_kwl->findKey( RENDER_THREADS_KW );
+   if ( value.size() )
+   {
+      threads = ossimString(value).toUInt32();
+   }
+   if ( ( threads > 1 ) && theInputConnection.valid() &&
+        !dynamic_cast<ossimMultiThreadSequencer*>( theInputConnection.get() ) )
+   {
+      changeSequencer( new ossimMultiThreadSequencer(0, threads) );
+
+      if ( traceDebug() )
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossimGpkgWriter::useMultiThreadSequencer DEBUG: threads: "
+            << threads << std::endl;
+      }
+   }
+}
+
+void ossimGpkgWriter::setBuildPragmas( sqlite3* db ) const
+{
+   if ( db )
+   {
+      //---
+      // A failed build is rewritten from scratch so there is nothing for a
+      // journal or fsync to protect.
+      //---
+      std::string journalMode = m_kwl->findKey( JOURNAL_MODE_KW );
+      if ( journalMode.empty() )
+      {
+         journalMode = "off";
+      }
+      std::string sql = "PRAGMA journal_mode = " + journalMode;
+      sqlite3_exec( db, sql.c_str(), NULL, NULL, NULL );
+      sqlite3_exec( db, "PRAGMA synchronous = OFF", NULL, NULL, NULL );
+   }
+}
+
 bool ossimGpkgWriter::getWmsCutBox( ossimDrect& rect ) const
 {
    const std::string KEY = "cut_wms_bbox";
@@ -316,11 +316,59 @@ private:
                          ossimMapProjection* proj,
                          const std::vector<ossim_int32>& zoomLevels );
 
+   /**
+    * @brief Checks if the levels can be built with the "pyramid" option,
+    * i.e. consecutive zoom levels on a grid aligned projection.  Does not
+    * change proj.
+    *
+    * The tile footprint of the coarsest level, scaled by two per level, is
+    * used as the area of every finer level so the tile matrices nest even
+    * when the individual expanded aois would not.
+    *
+    * @param coarsestAoi Initialized to the expanded aoi of the first
+    * (coarsest) zoom level.
+    * @return true if each level's aoi fits in the scaled footprint.
+    */
+   bool isQuadTree( const ossimMapProjection* proj,
+                    const std::vector<ossim_int32>& zoomLevels,
+                    ossimIrect& coarsestAoi );
+
+   /**
+    * @return coarsestAoi scaled to a level levelsBelow steps finer, on
+    * tile boundaries.
+    */
+   ossimIrect getPyramidAoi( const ossimIrect& coarsestAoi,
+                             ossim_uint32 levelsBelow ) const;
+
+   /**
+    * @brief Writes the tiles of aoi at zoomLevel.
+    *
+    * Tiles are pulled from theInputConnection on the calling thread,
+    * encoded by a pool of "threads" workers, each with its own codecs, and
+    * inserted by a single writer thread that owns db, batch_size inserts per
+    * transaction.
+    *
+    * If parentZoomLevels is not empty those levels, next coarser first, are
+    * built from the tiles of zoomLevel by 2x2 averaging instead of being
+    * rendered from the input.
+    */
    void writeTiles( sqlite3* db,
                     const ossimIrect& aoi,
                     ossim_int32 zoomLevel,
                     const ossim_float64& totalTiles,
-                    ossim_float64& tilesWritten );  
+                    ossim_float64& tilesWritten,
+                    const std::vector<ossim_int32>& parentZoomLevels =
+                    std::vector<ossim_int32>() );  
+
+   /**
+    * @brief Encodes tile with the full or partial codec depending on its
+    * data object status.  Computes the alpha channel first if needed.
+    * @return true on success, false on error.
+    */
+   bool encodeTile( ossimImageData* tile,
+                    ossimCodecBase* fullTileCodec,
+                    ossimCodecBase* partialTileCodec,
+                    std::vector<ossim_uint8>& codecTile ) const;
 
    void writeTile( sqlite3_stmt* pStmt,
                    sqlite3* db,
@@ -566,6 +614,33 @@ private:
     */
    void initializeCodec();
 
+   /**
+    * @brief Creates and sets the quality of a full and partial tile codec
+    * for the writer mode.  For modes using one codec both are the same
+    * instance.  Throws ossimException on error.
+    */
+   void createCodecs( ossimRefPtr<ossimCodecBase>& fullTileCodec,
+                      ossimRefPtr<ossimCodecBase>& partialTileCodec ) const;
+
+   /**
+    * @brief Looks for "threads" option key.
+    * @return Number of encode threads, defaults to the number of cores.
+    */
+   ossim_uint32 getNumberOfThreads() const;
+
+   /**
+    * @brief Swaps in an ossimMultiThreadSequencer when the "render_threads"
+    * option is greater than one.
+    */
+   void useMultiThreadSequencer();
+
+   /**
+    * @brief Sets the connection pragmas for a bulk build: synchronous off and
+    * "journal_mode" (default off).  Only applied to new files; appends keep
+    * the sqlite defaults so a failure cannot corrupt existing content.
+    */
+   void setBuildPragmas( sqlite3* db ) const;
+
    /**
     * @brief Initializes the output gpkg file.  This method is used for
     * non-connected writing, e.g. openFile(...), writeTile(...)
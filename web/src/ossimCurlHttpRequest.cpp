@@ -1,4 +1,7 @@
 #include "ossimCurlHttpRequest.h"
+#include "ossimCurlMultiEngine.h"
+#include <string>
+#include <vector>
 
 ossimWebResponse* ossimCurlHttpRequest::getResponse()
 {
@@ -12,49 +15,36 @@ ossimWebResponse* ossimCurlHttpRequest::getResponse()
       {
          m_response = new ossimCurlHttpResponse();
          
-         curl_easy_setopt(m_curl, CURLOPT_HEADERFUNCTION, curlWriteResponseHeader);
-         curl_easy_setopt(m_curl, CURLOPT_HEADERDATA, (void*)m_response.get());
-         curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, curlWriteResponseBody);
-         curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, (void*)m_response.get());
-         //curl_easy_setopt(m_curl, CURLOPT_CONNECT_ONLY, 1);
          ossimKeywordlist::KeywordMap& headerMap = m_headerOptions.getMap();
-         struct curl_slist *headers=0; /* init to NULL is important */
+         std::vector<std::string> headers;
          
          ossimKeywordlist::KeywordMap::iterator iter = headerMap.begin();
          while(iter != headerMap.end())
          {
-            //std::cout << ((*iter).first + ":"+(*iter).second).c_str() << std::endl;
-            headers = curl_slist_append(headers, ((*iter).first + ":"+(*iter).second).c_str());
+            headers.push_back(((*iter).first + ":"+(*iter).second).c_str());
             ++iter;
          }
          ossimString urlString = getUrl().toString();
-         curl_easy_setopt(m_curl, CURLOPT_URL, urlString.c_str());
          
+         // perform() blocks so the response outlives the transfer.
+         ossimCurlHttpResponse* response = m_response.get();
+         ossimCurlMultiEngine::Result result =
+            ossimCurlMultiEngine::instance()->perform(
+               urlString.string(), headers,
+               [response](const char* data, size_t size) -> size_t
+               {
+                  response->bodyStream().write(data, size);
+                  return size;
+               });
          
-         if(protocol == "https")
-         {
-            curl_easy_setopt(m_curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_SSLv3);//);
-            curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, 0L);
-         }
-         
-         
-         int rc = curl_easy_perform(m_curl);
-         
-         if(rc == CURLE_SSL_CONNECT_ERROR)
-         {
-            // try default if an error for SSL connect ocurred
-            curl_easy_setopt(m_curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_DEFAULT);
-            rc = curl_easy_perform(m_curl);
-         }
-         bool result = (rc < 1);
-         if(result)
+         if(result.m_code == CURLE_OK)
          {
+            m_response->headerStream().write(result.m_header.data(), result.m_header.size());
             m_response->convertHeaderStreamToKeywordlist();
          }
          else
          {
-            m_lastError = curl_easy_strerror((CURLcode)rc);
-            //std::cout << curl_easy_strerror((CURLcode)rc) << std::endl;
+            m_lastError = result.m_error;
             m_response = 0;
          }
          break;
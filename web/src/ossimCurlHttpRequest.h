@@ -14,18 +14,16 @@ class ossimCurlHttpRequest : public ossimHttpRequest
 {
 public:
    ossimCurlHttpRequest()
-   :m_curl(0)
    {
-      m_curl = curl_easy_init();
    }
    virtual ~ossimCurlHttpRequest()
    {
-      if(m_curl)
-      {
-         curl_easy_cleanup(m_curl);
-         m_curl = 0;
-      }
    }
+
+   /**
+    * Performs the request through the shared ossimCurlMultiEngine so
+    * connections are reused across requests.
+    */
    virtual ossimWebResponse* getResponse();
    virtual bool supportsProtocol(const ossimString& protocol)const;
    static int curlWriteResponseBody(void *buffer, size_t size, size_t nmemb, void *stream);
@@ -38,7 +36,6 @@ public:
    }
    
 protected:
-   CURL* m_curl;
    mutable ossimRefPtr<ossimCurlHttpResponse> m_response;
 };
 #endif
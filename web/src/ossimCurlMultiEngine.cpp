@@ -0,0 +1,332 @@
+//---
+//
+// License: MIT
+//
+// Description: Shared libcurl multi handle engine.
+//
+//---
+// $Id$
+
+#include "ossimCurlMultiEngine.h"
+#include <ossim/base/ossimPreferences.h>
+#include <ossim/base/ossimString.h>
+#include <ossim/base/ossimTrace.h>
+
+static ossimTrace traceDebug("ossimCurlMultiEngine:debug");
+
+ossimCurlMultiEngine* ossimCurlMultiEngine::m_instance = 0;
+
+static std::mutex instanceMutex;
+
+// Idle easy handles kept for reuse; they hold DNS and TLS session caches.
+static const std::size_t MAX_IDLE_EASY = 64;
+
+ossimCurlMultiEngine* ossimCurlMultiEngine::instance()
+{
+   std::unique_lock<std::mutex> lock(instanceMutex);
+   if(!m_instance)
+   {
+      m_instance = new ossimCurlMultiEngine();
+   }
+
+   return m_instance;
+}
+
+void ossimCurlMultiEngine::shutdown()
+{
+   std::unique_lock<std::mutex> lock(instanceMutex);
+   if(m_instance)
+   {
+      delete m_instance;
+      m_instance = 0;
+   }
+}
+
+ossimCurlMultiEngine::ossimCurlMultiEngine()
+   :
+   m_multi(curl_multi_init()),
+   m_queued(),
+   m_active(),
+   m_idleEasy(),
+   m_thread(),
+   m_shutdown(false),
+   m_maxHostConnections(8),
+   m_maxTotalConnections(64),
+   m_http2(true)
+{
+   const char* lookup = ossimPreferences::instance()->findPreference("ossim.plugins.web.maxHostConnections");
+   if(lookup)
+   {
+      m_maxHostConnections = ossimString(lookup).toLong();
+   }
+   lookup = ossimPreferences::instance()->findPreference("ossim.plugins.web.maxTotalConnections");
+   if(lookup)
+   {
+      m_maxTotalConnections = ossimString(lookup).toLong();
+   }
+   lookup = ossimPreferences::instance()->findPreference("ossim.plugins.web.http2");
+   if(lookup)
+   {
+      m_http2 = ossimString(lookup).toBool();
+   }
+
+   if(m_multi)
+   {
+#if LIBCURL_VERSION_NUM >= 0x072b00
+      if(m_http2)
+      {
+         curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+      }
+#endif
+#if LIBCURL_VERSION_NUM >= 0x071e00
+      if(m_maxHostConnections > 0)
+      {
+         curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS, m_maxHostConnections);
+      }
+      if(m_maxTotalConnections > 0)
+      {
+         curl_multi_setopt(m_multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, m_maxTotalConnections);
+      }
+#endif
+      m_thread = std::thread(&ossimCurlMultiEngine::run, this);
+   }
+
+   if(traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossimCurlMultiEngine DEBUG: maxHostConnections=" << m_maxHostConnections
+         << " maxTotalConnections=" << m_maxTotalConnections
+         << " http2=" << m_http2 << std::endl;
+   }
+}
+
+ossimCurlMultiEngine::~ossimCurlMultiEngine()
+{
+   stop();
+   if(m_multi)
+   {
+      curl_multi_cleanup(m_multi);
+      m_multi = 0;
+   }
+   for(std::size_t idx = 0; idx < m_idleEasy.size(); ++idx)
+   {
+      curl_easy_cleanup(m_idleEasy[idx]);
+   }
+   m_idleEasy.clear();
+}
+
+void ossimCurlMultiEngine::stop()
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_shutdown = true;
+   }
+#if LIBCURL_VERSION_NUM >= 0x074400
+   if(m_multi) curl_multi_wakeup(m_multi);
+#endif
+   if(m_thread.joinable())
+   {
+      m_thread.join();
+   }
+
+   // Fail anything left so no caller waits forever.
+   std::unique_lock<std::mutex> lock(m_mutex);
+   for(std::size_t idx = 0; idx < m_queued.size(); ++idx)
+   {
+      finish(m_queued[idx], CURLE_ABORTED_BY_CALLBACK);
+   }
+   m_queued.clear();
+   for(std::map<CURL*, Transfer_t>::iterator iter = m_active.begin();
+       iter != m_active.end(); ++iter)
+   {
+      curl_multi_remove_handle(m_multi, iter->first);
+      finish(iter->second, CURLE_ABORTED_BY_CALLBACK);
+   }
+   m_active.clear();
+}
+
+std::future<ossimCurlMultiEngine::Result> ossimCurlMultiEngine::get(
+   const std::string& url,
+   const std::vector<std::string>& headers,
+   const BodyCallback& bodyCallback)
+{
+   Transfer_t transfer = std::make_shared<Transfer>();
+   transfer->m_bodyCallback = bodyCallback;
+   std::future<Result> result = transfer->m_promise.get_future();
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   if(!m_multi || m_shutdown)
+   {
+      transfer->m_result.m_code = CURLE_FAILED_INIT;
+      transfer->m_result.m_error = "curl multi engine not running";
+      transfer->m_promise.set_value(transfer->m_result);
+      return result;
+   }
+
+   transfer->m_easy = acquireEasy();
+   for(std::size_t idx = 0; idx < headers.size(); ++idx)
+   {
+      transfer->m_headers = curl_slist_append(transfer->m_headers, headers[idx].c_str());
+   }
+
+   CURL* easy = transfer->m_easy;
+   curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+   curl_easy_setopt(easy, CURLOPT_HTTPGET, 1L);
+   curl_easy_setopt(easy, CURLOPT_HTTPHEADER, transfer->m_headers);
+   curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeBody);
+   curl_easy_setopt(easy, CURLOPT_WRITEDATA, (void*)transfer.get());
+   curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, writeHeader);
+   curl_easy_setopt(easy, CURLOPT_HEADERDATA, (void*)transfer.get());
+   curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+   curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+   curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, 0L);
+#if LIBCURL_VERSION_NUM >= 0x071900
+   curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072f00
+   if(m_http2)
+   {
+      // HTTP/2 over TLS when offered, and wait for a connection to
+      // multiplex on rather than opening another one.
+      curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+      curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+   }
+#endif
+
+   m_queued.push_back(transfer);
+#if LIBCURL_VERSION_NUM >= 0x074400
+   curl_multi_wakeup(m_multi);
+#endif
+
+   return result;
+}
+
+ossimCurlMultiEngine::Result ossimCurlMultiEngine::perform(
+   const std::string& url,
+   const std::vector<std::string>& headers,
+   const BodyCallback& bodyCallback)
+{
+   return get(url, headers, bodyCallback).get();
+}
+
+void ossimCurlMultiEngine::run()
+{
+   while(true)
+   {
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         if(m_shutdown) break;
+         for(std::size_t idx = 0; idx < m_queued.size(); ++idx)
+         {
+            curl_multi_add_handle(m_multi, m_queued[idx]->m_easy);
+            m_active.insert(std::make_pair(m_queued[idx]->m_easy, m_queued[idx]));
+         }
+         m_queued.clear();
+      }
+
+      int running = 0;
+      curl_multi_perform(m_multi, &running);
+
+      int msgsLeft = 0;
+      CURLMsg* msg = 0;
+      while((msg = curl_multi_info_read(m_multi, &msgsLeft)))
+      {
+         if(msg->msg == CURLMSG_DONE)
+         {
+            CURL* easy = msg->easy_handle;
+            CURLcode code = msg->data.result;
+            curl_multi_remove_handle(m_multi, easy);
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            std::map<CURL*, Transfer_t>::iterator iter = m_active.find(easy);
+            if(iter != m_active.end())
+            {
+               Transfer_t transfer = iter->second;
+               m_active.erase(iter);
+               finish(transfer, code);
+            }
+         }
+      }
+
+      // Sleep until there is socket activity (or a wakeup on newer curl).
+#if LIBCURL_VERSION_NUM >= 0x074400
+      curl_multi_poll(m_multi, 0, 0, 1000, 0);
+#else
+      int numfds = 0;
+      curl_multi_wait(m_multi, 0, 0, running ? 100 : 10, &numfds);
+#endif
+   }
+}
+
+void ossimCurlMultiEngine::finish(const Transfer_t& transfer, CURLcode code)
+{
+   transfer->m_result.m_code = code;
+   if(transfer->m_easy)
+   {
+      curl_easy_getinfo(transfer->m_easy, CURLINFO_RESPONSE_CODE, &transfer->m_result.m_responseCode);
+   }
+   if(code != CURLE_OK)
+   {
+      transfer->m_result.m_error = curl_easy_strerror(code);
+   }
+   if(transfer->m_headers)
+   {
+      curl_slist_free_all(transfer->m_headers);
+      transfer->m_headers = 0;
+   }
+   if(transfer->m_easy)
+   {
+      releaseEasy(transfer->m_easy);
+      transfer->m_easy = 0;
+   }
+   transfer->m_promise.set_value(transfer->m_result);
+}
+
+CURL* ossimCurlMultiEngine::acquireEasy()
+{
+   CURL* result = 0;
+   if(!m_idleEasy.empty())
+   {
+      result = m_idleEasy.back();
+      m_idleEasy.pop_back();
+   }
+   else
+   {
+      result = curl_easy_init();
+   }
+   return result;
+}
+
+void ossimCurlMultiEngine::releaseEasy(CURL* easy)
+{
+   if(m_idleEasy.size() < MAX_IDLE_EASY)
+   {
+      // Reset clears options but keeps connections and caches.
+      curl_easy_reset(easy);
+      m_idleEasy.push_back(easy);
+   }
+   else
+   {
+      curl_easy_cleanup(easy);
+   }
+}
+
+size_t ossimCurlMultiEngine::writeBody(char* buffer, size_t size, size_t nmemb, void* userp)
+{
+   Transfer* transfer = static_cast<Transfer*>(userp);
+   size_t bytes = size*nmemb;
+   if(transfer->m_bodyCallback)
+   {
+      return transfer->m_bodyCallback(buffer, bytes);
+   }
+   transfer->m_result.m_body.append(buffer, bytes);
+   return bytes;
+}
+
+size_t ossimCurlMultiEngine::writeHeader(char* buffer, size_t size, size_t nmemb, void* userp)
+{
+   Transfer* transfer = static_cast<Transfer*>(userp);
+   size_t bytes = size*nmemb;
+   transfer->m_result.m_header.append(buffer, bytes);
+   return bytes;
+}
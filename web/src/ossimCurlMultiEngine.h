@@ -0,0 +1,123 @@
+//---
+//
+// License: MIT
+//
+// Description: Shared libcurl multi handle engine.
+//
+// All transfers run on one background thread through a single curl multi
+// handle, so connections (and TLS sessions) are kept alive and reused across
+// requests, per host connections are pooled and HTTP/2 streams are
+// multiplexed over one connection when the server supports it.  Requests are
+// asynchronous; any number may be in flight at once.
+//
+//---
+// $Id$
+
+#ifndef ossimCurlMultiEngine_HEADER
+#define ossimCurlMultiEngine_HEADER 1
+
+#include <ossim/base/ossimConstants.h>
+#include <curl/curl.h>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ossimCurlMultiEngine
+{
+public:
+   /** Outcome of one transfer. */
+   struct Result
+   {
+      Result():m_code(CURLE_OK),m_responseCode(0){}
+
+      /** @return true if the transfer completed with a 2xx response. */
+      bool success()const
+      {
+         return (m_code == CURLE_OK) && (m_responseCode >= 200) && (m_responseCode < 300);
+      }
+
+      CURLcode    m_code;
+      long        m_responseCode;
+      std::string m_error;
+      std::string m_header;
+
+      /** Response body when no body callback was given. */
+      std::string m_body;
+   };
+
+   /**
+    * Receives body bytes on the engine thread.  Return the number of bytes
+    * consumed; anything else aborts the transfer.
+    */
+   typedef std::function<size_t(const char* data, size_t size)> BodyCallback;
+
+   static ossimCurlMultiEngine* instance();
+
+   /**
+    * @brief Stops the engine thread, failing anything still in flight.
+    * Called on plugin unload.
+    */
+   static void shutdown();
+
+   /**
+    * @brief Starts an asynchronous GET.
+    * @param url Url to get.
+    * @param headers "Name: value" request headers.
+    * @param bodyCallback Optional sink for the body.  If empty the body is
+    * returned in Result::m_body.
+    */
+   std::future<Result> get(const std::string& url,
+                           const std::vector<std::string>& headers=std::vector<std::string>(),
+                           const BodyCallback& bodyCallback=BodyCallback());
+
+   /** Blocking convenience wrapper of get(). */
+   Result perform(const std::string& url,
+                  const std::vector<std::string>& headers=std::vector<std::string>(),
+                  const BodyCallback& bodyCallback=BodyCallback());
+
+protected:
+   struct Transfer
+   {
+      Transfer():m_easy(0),m_headers(0){}
+
+      CURL*                m_easy;
+      curl_slist*          m_headers;
+      BodyCallback         m_bodyCallback;
+      Result               m_result;
+      std::promise<Result> m_promise;
+   };
+   typedef std::shared_ptr<Transfer> Transfer_t;
+
+   ossimCurlMultiEngine();
+   ~ossimCurlMultiEngine();
+
+   void run();
+   void stop();
+   CURL* acquireEasy();
+   void releaseEasy(CURL* easy);
+   void finish(const Transfer_t& transfer, CURLcode code);
+
+   static size_t writeBody(char* buffer, size_t size, size_t nmemb, void* userp);
+   static size_t writeHeader(char* buffer, size_t size, size_t nmemb, void* userp);
+
+   static ossimCurlMultiEngine* m_instance;
+
+   std::mutex                  m_mutex;
+   CURLM*                      m_multi;
+   std::vector<Transfer_t>     m_queued;
+   std::map<CURL*, Transfer_t> m_active;
+   std::vector<CURL*>          m_idleEasy;
+   std::thread                 m_thread;
+   bool                        m_shutdown;
+
+   long m_maxHostConnections;
+   long m_maxTotalConnections;
+   bool m_http2;
+};
+
+#endif
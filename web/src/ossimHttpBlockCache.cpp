@@ -0,0 +1,211 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Process wide, size bounded LRU cache of http blocks.
+//
+//---
+// $Id$
+
+#include "ossimHttpBlockCache.h"
+#include "ossimHttpStreamDefaults.h"
+#include <chrono>
+#include <sstream>
+
+std::shared_ptr<ossim::HttpBlockCache> ossim::HttpBlockCache::m_instance;
+
+// Caps outstanding read-ahead requests across all streams.
+static const std::size_t MAX_PENDING = 256;
+
+ossim::HttpBlockCache::HttpBlockCache()
+:m_cacheSize(0),
+ m_maxCacheSize(ossim::HttpStreamDefaults::m_readCacheSize)
+{
+}
+
+ossim::HttpBlockCache::~HttpBlockCache()
+{
+   m_cache.clear();
+   m_lru.clear();
+   m_pending.clear();
+}
+
+std::shared_ptr<ossim::HttpBlockCache> ossim::HttpBlockCache::instance()
+{
+   static std::mutex instanceMutex;
+   std::unique_lock<std::mutex> lock(instanceMutex);
+   if(!m_instance)
+   {
+      m_instance = std::make_shared<HttpBlockCache>();
+   }
+
+   return m_instance;
+}
+
+ossim::HttpBlockCache::Block_t ossim::HttpBlockCache::getBlock(const Key_t& key)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   PendingType::iterator pendingIter = m_pending.find(key);
+   if(pendingIter != m_pending.end())
+   {
+      // Wait for the read-ahead without holding the lock.
+      Pending pending = pendingIter->second;
+      lock.unlock();
+      pending.m_result.wait();
+      lock.lock();
+      pendingIter = m_pending.find(key);
+      if(pendingIter != m_pending.end())
+      {
+         m_pending.erase(pendingIter);
+         Block_t block = toBlock(pending);
+         if(block)
+         {
+            addBlockLocked(key, block);
+         }
+      }
+   }
+
+   Block_t result;
+   CacheType::iterator iter = m_cache.find(key);
+   if(iter != m_cache.end())
+   {
+      m_lru.splice(m_lru.begin(), m_lru, iter->second.m_lruIter);
+      result = iter->second.m_block;
+   }
+
+   return result;
+}
+
+void ossim::HttpBlockCache::addBlock(const Key_t& key, const Block_t& block)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   addBlockLocked(key, block);
+}
+
+void ossim::HttpBlockCache::addBlockLocked(const Key_t& key, const Block_t& block)
+{
+   if(!block || (m_maxCacheSize <= 0)) return;
+
+   CacheType::iterator iter = m_cache.find(key);
+   if(iter != m_cache.end())
+   {
+      m_cacheSize -= static_cast<ossim_int64>(iter->second.m_block->size());
+      iter->second.m_block = block;
+      m_lru.splice(m_lru.begin(), m_lru, iter->second.m_lruIter);
+   }
+   else
+   {
+      m_lru.push_front(key);
+      Node node;
+      node.m_block   = block;
+      node.m_lruIter = m_lru.begin();
+      m_cache.insert(std::make_pair(key, node));
+   }
+   m_cacheSize += static_cast<ossim_int64>(block->size());
+
+   shrinkEntries();
+}
+
+void ossim::HttpBlockCache::readAhead(const Key_t& key, const std::string& url,
+                                      ossim_int64 startRange, ossim_int64 endRange)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   if(m_maxCacheSize <= 0) return;
+
+   harvest();
+   if((m_cache.find(key) != m_cache.end()) ||
+      (m_pending.find(key) != m_pending.end()) ||
+      (m_pending.size() >= MAX_PENDING))
+   {
+      return;
+   }
+
+   m_pending.insert(std::make_pair(key, startRequest(url, startRange, endRange)));
+}
+
+ossim::HttpBlockCache::Block_t ossim::HttpBlockCache::fetch(const std::string& url,
+                                                            ossim_int64 startRange,
+                                                            ossim_int64 endRange)
+{
+   return toBlock(startRequest(url, startRange, endRange));
+}
+
+ossim::HttpBlockCache::Pending ossim::HttpBlockCache::startRequest(const std::string& url,
+                                                                  ossim_int64 startRange,
+                                                                  ossim_int64 endRange)
+{
+   Pending pending;
+   pending.m_expectedSize = endRange - startRange + 1;
+   pending.m_data = std::make_shared<std::vector<char> >();
+   pending.m_data->reserve(static_cast<std::size_t>(pending.m_expectedSize));
+
+   std::ostringstream range;
+   range << "Range: bytes=" << startRange << "-" << endRange;
+   std::vector<std::string> headers(1, range.str());
+   std::shared_ptr<std::vector<char> > data = pending.m_data;
+   std::size_t expectedSize = static_cast<std::size_t>(pending.m_expectedSize);
+   pending.m_result = ossimCurlMultiEngine::instance()->get(
+      url, headers,
+      [data, expectedSize](const char* buf, size_t size) -> size_t
+      {
+         // A server ignoring the Range would send the whole object.  Returning
+         // short aborts the transfer and toBlock rejects the result.
+         if(data->size() + size > expectedSize) return 0;
+         data->insert(data->end(), buf, buf+size);
+         return size;
+      }).share();
+
+   return pending;
+}
+
+ossim::HttpBlockCache::Block_t ossim::HttpBlockCache::toBlock(const Pending& pending)
+{
+   Block_t result;
+   const ossimCurlMultiEngine::Result& outcome = pending.m_result.get();
+
+   // 206 with exactly the range; a 200 means the server ignored the Range.
+   if((outcome.m_code == CURLE_OK) && (outcome.m_responseCode == 206) &&
+      (static_cast<ossim_int64>(pending.m_data->size()) == pending.m_expectedSize))
+   {
+      result = pending.m_data;
+   }
+   return result;
+}
+
+void ossim::HttpBlockCache::harvest()
+{
+   PendingType::iterator iter = m_pending.begin();
+   while(iter != m_pending.end())
+   {
+      if(iter->second.m_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+      {
+         Block_t block = toBlock(iter->second);
+         if(block)
+         {
+            addBlockLocked(iter->first, block);
+         }
+         m_pending.erase(iter++);
+      }
+      else
+      {
+         ++iter;
+      }
+   }
+}
+
+void ossim::HttpBlockCache::shrinkEntries()
+{
+   while((m_cacheSize > m_maxCacheSize) && !m_lru.empty())
+   {
+      CacheType::iterator iter = m_cache.find(m_lru.back());
+      if(iter != m_cache.end())
+      {
+         m_cacheSize -= static_cast<ossim_int64>(iter->second.m_block->size());
+         m_cache.erase(iter);
+      }
+      m_lru.pop_back();
+   }
+}
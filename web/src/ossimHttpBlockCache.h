@@ -0,0 +1,111 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Process wide, size bounded LRU cache of http blocks shared by all
+// HttpStreamBuffer instances.  Read-ahead requests are issued
+// asynchronously on the shared curl multi engine.
+//
+//---
+// $Id$
+
+#ifndef ossimHttpBlockCache_HEADER
+#define ossimHttpBlockCache_HEADER 1
+
+#include "ossimCurlMultiEngine.h"
+#include <ossim/base/ossimConstants.h>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ossim
+{
+   class HttpBlockCache
+   {
+   public:
+      typedef std::shared_ptr<const std::vector<char> > Block_t;
+
+      /** Object id (url, block size and ETag) plus block index. */
+      typedef std::pair<std::string, ossim_int64> Key_t;
+
+      HttpBlockCache();
+      virtual ~HttpBlockCache();
+
+      static std::shared_ptr<HttpBlockCache> instance();
+
+      /**
+       * @brief Gets block from cache, waiting on it if a read-ahead for it
+       * is in flight.
+       * @return block or null if not cached.
+       */
+      Block_t getBlock(const Key_t& key);
+
+      void addBlock(const Key_t& key, const Block_t& block);
+
+      /**
+       * @brief Requests bytes [startRange, endRange] of url in the background
+       * unless the block is cached or already requested.
+       */
+      void readAhead(const Key_t& key, const std::string& url,
+                     ossim_int64 startRange, ossim_int64 endRange);
+
+      /**
+       * @brief Blocking ranged GET of bytes [startRange, endRange].
+       * @return block or null if the server did not return exactly the range.
+       */
+      static Block_t fetch(const std::string& url, ossim_int64 startRange, ossim_int64 endRange);
+
+   protected:
+      struct KeyHash
+      {
+         std::size_t operator()(const Key_t& key)const
+         {
+            return std::hash<std::string>()(key.first) ^
+               (std::hash<ossim_int64>()(key.second) << 1);
+         }
+      };
+      typedef std::list<Key_t> LruListType;
+      struct Node
+      {
+         Block_t               m_block;
+         LruListType::iterator m_lruIter;
+      };
+      struct Pending
+      {
+         std::shared_ptr<std::vector<char> >                    m_data;
+         std::shared_future<ossimCurlMultiEngine::Result>      m_result;
+         ossim_int64                                           m_expectedSize;
+      };
+      typedef std::unordered_map<Key_t, Node, KeyHash> CacheType;
+      typedef std::map<Key_t, Pending> PendingType;
+
+      /** Assumes m_mutex is locked. */
+      void addBlockLocked(const Key_t& key, const Block_t& block);
+      void shrinkEntries();
+
+      /** Moves finished read-aheads into the cache.  Assumes m_mutex is locked. */
+      void harvest();
+      static Pending startRequest(const std::string& url,
+                                  ossim_int64 startRange, ossim_int64 endRange);
+      static Block_t toBlock(const Pending& pending);
+
+      static std::shared_ptr<HttpBlockCache> m_instance;
+      std::mutex m_mutex;
+
+      CacheType   m_cache;
+      LruListType m_lru;
+      ossim_int64 m_cacheSize;
+      ossim_int64 m_maxCacheSize;
+      PendingType m_pending;
+   };
+}
+
+#endif
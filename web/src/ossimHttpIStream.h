@@ -0,0 +1,37 @@
+#ifndef ossimHttpIStream_HEADER
+#define ossimHttpIStream_HEADER
+#include <ossim/base/ossimIoStream.h>
+#include "ossimHttpStreamBuffer.h"
+
+namespace ossim{
+
+   class HttpIStream : public ossim::istream
+   {
+   public:
+      HttpIStream():std::istream(&m_httpbuf)
+      {}
+
+      void open (const char* url,
+                 std::ios_base::openmode mode)
+      {
+         open(std::string(url), mode);
+      }
+      void open (const std::string& url,
+                 std::ios_base::openmode mode)
+      {
+        if(m_httpbuf.open(url, mode))
+        {
+            clear();
+        }
+        else
+        {
+            setstate(std::ios::failbit);
+        }
+      }
+   protected:
+     HttpStreamBuffer m_httpbuf;
+
+   };
+}
+
+#endif
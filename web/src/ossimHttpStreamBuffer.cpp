@@ -0,0 +1,331 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Random access, read only streambuf over an http/https url backed by
+// Range requests.
+//
+//---
+// $Id$
+
+#include "ossimHttpStreamBuffer.h"
+#include "ossimCurlMultiEngine.h"
+#include <ossim/base/ossimString.h>
+#include <ossim/base/ossimTrace.h>
+#include <ossim/base/ossimUrl.h>
+
+#include <algorithm>
+#include <cstdio> /* for EOF */
+#include <cstring> /* for memcpy */
+#include <sstream>
+#include <vector>
+
+static ossimTrace traceDebug("ossimHttpStreamBuffer:debug");
+
+//---
+// Returns the value of the last occurrence of a response header.  The last
+// one wins so redirects report the final response.
+//---
+static std::string findHeader(const std::string& headers, const std::string& name)
+{
+   std::string result;
+   ossimString lowerName = ossimString(name).downcase() + ":";
+   std::istringstream in(headers);
+   std::string line;
+   while(std::getline(in, line))
+   {
+      if(line.size() > lowerName.size())
+      {
+         ossimString prefix = ossimString(line.substr(0, lowerName.size())).downcase();
+         if(prefix == lowerName)
+         {
+            result = ossimString(line.substr(lowerName.size())).trim().string();
+         }
+      }
+   }
+   return result;
+}
+
+ossim::HttpStreamBuffer::HttpStreamBuffer(ossim_int64 blockSize)
+   :
+   m_url(""),
+   m_cacheId(""),
+   m_blockSize(blockSize > 0 ? blockSize : 65536),
+   m_fileSize(0),
+   m_block(),
+   m_blockStart(0),
+   m_position(0),
+   m_lastBlockIndex(-1),
+   m_wholeFile(),
+   m_opened(false)
+{
+   setg(0, 0, 0);
+}
+
+ossim::HttpStreamBuffer* ossim::HttpStreamBuffer::open(const char* url,
+                                                       std::ios_base::openmode mode)
+{
+   return open(std::string(url), mode);
+}
+
+ossim::HttpStreamBuffer* ossim::HttpStreamBuffer::open(const std::string& url,
+                                                       std::ios_base::openmode /* mode */)
+{
+   clearAll();
+
+   ossimUrl ossimurl(url);
+   ossimString protocol = ossimString(ossimurl.getProtocol()).downcase();
+   if((protocol != "http") && (protocol != "https"))
+   {
+      return 0;
+   }
+
+   //---
+   // The first block doubles as the probe: a 206 gives the size and ETag.
+   // A server ignoring Range is only accepted if the whole body fits in one
+   // block; otherwise the transfer is aborted rather than downloading it all.
+   //---
+   std::shared_ptr<std::vector<char> > data = std::make_shared<std::vector<char> >();
+   ossim_int64 maxBytes = m_blockSize;
+   std::ostringstream range;
+   range << "Range: bytes=0-" << (m_blockSize-1);
+   ossimCurlMultiEngine::Result result = ossimCurlMultiEngine::instance()->perform(
+      url, std::vector<std::string>(1, range.str()),
+      [data, maxBytes](const char* buf, size_t size) -> size_t
+      {
+         if(static_cast<ossim_int64>(data->size() + size) > maxBytes) return 0;
+         data->insert(data->end(), buf, buf+size);
+         return size;
+      });
+
+   std::string etag = findHeader(result.m_header, "ETag");
+   if((result.m_code == CURLE_OK) && (result.m_responseCode == 206))
+   {
+      // Content-Range: bytes 0-65535/123456
+      std::string contentRange = findHeader(result.m_header, "Content-Range");
+      std::string::size_type slash = contentRange.rfind('/');
+      if((slash != std::string::npos) && (contentRange.substr(slash+1) != "*"))
+      {
+         m_fileSize = ossimString(contentRange.substr(slash+1)).toInt64();
+         m_opened = (m_fileSize > 0);
+      }
+   }
+   else if((result.m_code == CURLE_OK) && (result.m_responseCode == 200))
+   {
+      m_wholeFile = data;
+      m_fileSize = static_cast<ossim_int64>(data->size());
+      m_opened = true;
+   }
+
+   if(m_opened)
+   {
+      m_url = url;
+      std::ostringstream cacheId;
+      cacheId << m_url << "#" << m_blockSize << "@" << etag;
+      m_cacheId = cacheId.str();
+      if(!m_wholeFile &&
+         (static_cast<ossim_int64>(data->size()) == std::min(m_blockSize, m_fileSize)))
+      {
+         ossim::HttpBlockCache::instance()->addBlock(
+            ossim::HttpBlockCache::Key_t(m_cacheId, 0), data);
+      }
+   }
+
+   if(traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossim::HttpStreamBuffer::open DEBUG: " << url
+         << " response=" << result.m_responseCode
+         << " size=" << m_fileSize
+         << " ranges=" << (m_wholeFile ? "no" : "yes")
+         << " opened=" << m_opened << std::endl;
+   }
+
+   return m_opened ? this : 0;
+}
+
+void ossim::HttpStreamBuffer::clearAll()
+{
+   m_url = "";
+   m_cacheId = "";
+   m_fileSize = 0;
+   m_block.reset();
+   m_blockStart = 0;
+   m_position = 0;
+   m_lastBlockIndex = -1;
+   m_wholeFile.reset();
+   m_opened = false;
+   setg(0, 0, 0);
+}
+
+ossim_int64 ossim::HttpStreamBuffer::getPosition()const
+{
+   return m_block ? (m_blockStart + (gptr()-eback())) : m_position;
+}
+
+bool ossim::HttpStreamBuffer::loadBlock(ossim_int64 absolutePosition)
+{
+   if(!m_opened || (absolutePosition < 0) || (absolutePosition >= m_fileSize))
+   {
+      return false;
+   }
+
+   ossim::HttpBlockCache::Block_t block;
+   ossim_int64 blockIndex = 0;
+   ossim_int64 startRange = 0;
+   if(m_wholeFile)
+   {
+      block = m_wholeFile;
+   }
+   else
+   {
+      blockIndex = absolutePosition/m_blockSize;
+      startRange = blockIndex*m_blockSize;
+      ossim_int64 endRange = std::min(startRange + m_blockSize, m_fileSize) - 1;
+      ossim::HttpBlockCache::Key_t key(m_cacheId, blockIndex);
+      block = ossim::HttpBlockCache::instance()->getBlock(key);
+      if(!block)
+      {
+         block = ossim::HttpBlockCache::fetch(m_url, startRange, endRange);
+         ossim::HttpBlockCache::instance()->addBlock(key, block);
+      }
+   }
+
+   if(!block || block->empty())
+   {
+      return false;
+   }
+
+   // Get area is never written so the const cast is safe.
+   m_block = block;
+   m_blockStart = startRange;
+   char* begin = const_cast<char*>(&m_block->front());
+   setg(begin, begin + (absolutePosition - startRange), begin + m_block->size());
+
+   if(!m_wholeFile)
+   {
+      readAhead(blockIndex);
+   }
+
+   return true;
+}
+
+void ossim::HttpStreamBuffer::readAhead(ossim_int64 blockIndex)
+{
+   bool sequential = (m_lastBlockIndex >= 0) && (blockIndex == m_lastBlockIndex + 1);
+   m_lastBlockIndex = blockIndex;
+
+   if(!sequential) return;
+
+   std::shared_ptr<ossim::HttpBlockCache> cache = ossim::HttpBlockCache::instance();
+   for(ossim_int64 idx = 1; idx <= ossim::HttpStreamDefaults::m_readAheadBlocks; ++idx)
+   {
+      ossim_int64 startRange = (blockIndex + idx)*m_blockSize;
+      if(startRange >= m_fileSize) break;
+      ossim_int64 endRange = std::min(startRange + m_blockSize, m_fileSize) - 1;
+      cache->readAhead(ossim::HttpBlockCache::Key_t(m_cacheId, blockIndex + idx),
+                       m_url, startRange, endRange);
+   }
+}
+
+ossim::HttpStreamBuffer::int_type ossim::HttpStreamBuffer::underflow()
+{
+   if(!m_opened) return EOF;
+   if(gptr() && (gptr() < egptr()))
+   {
+      return traits_type::to_int_type(*gptr());
+   }
+   if(!loadBlock(getPosition()))
+   {
+      return EOF;
+   }
+   return traits_type::to_int_type(*gptr());
+}
+
+ossim::HttpStreamBuffer::pos_type ossim::HttpStreamBuffer::seekoff(off_type offset,
+                                                                   std::ios_base::seekdir dir,
+                                                                   std::ios_base::openmode mode)
+{
+   pos_type result = pos_type(off_type(-1));
+   if(!m_opened || !(mode & std::ios_base::in) || (mode & std::ios_base::out))
+   {
+      return result;
+   }
+
+   ossim_int64 target = 0;
+   switch(dir)
+   {
+      case std::ios_base::beg:
+         target = offset;
+         break;
+      case std::ios_base::cur:
+         target = getPosition() + offset;
+         break;
+      case std::ios_base::end:
+         target = m_fileSize + offset;
+         break;
+      default:
+         return result;
+   }
+   if((target < 0) || (target > m_fileSize))
+   {
+      return result;
+   }
+
+   if(m_block && (target >= m_blockStart) &&
+      (target < m_blockStart + static_cast<ossim_int64>(m_block->size())))
+   {
+      setg(eback(), eback() + (target - m_blockStart), egptr());
+   }
+   else
+   {
+      // Defer the fetch to the next read.
+      m_block.reset();
+      m_position = target;
+      setg(0, 0, 0);
+   }
+
+   return pos_type(target);
+}
+
+ossim::HttpStreamBuffer::pos_type ossim::HttpStreamBuffer::seekpos(pos_type pos,
+                                                                   std::ios_base::openmode mode)
+{
+   return seekoff(off_type(pos), std::ios_base::beg, mode);
+}
+
+std::streamsize ossim::HttpStreamBuffer::xsgetn(char_type* s, std::streamsize n)
+{
+   std::streamsize bytesRead = 0;
+   if(!m_opened) return bytesRead;
+
+   while(bytesRead < n)
+   {
+      if(!gptr() || (gptr() >= egptr()))
+      {
+         if(!loadBlock(getPosition()))
+         {
+            break;
+         }
+      }
+      std::streamsize delta = std::min(static_cast<std::streamsize>(egptr()-gptr()),
+                                       n - bytesRead);
+      std::memcpy(s + bytesRead, gptr(), delta);
+      setg(eback(), gptr() + delta, egptr());
+      bytesRead += delta;
+   }
+
+   return bytesRead;
+}
+
+ossim_uint64 ossim::HttpStreamBuffer::getFileSize() const
+{
+   return static_cast<ossim_uint64>(m_fileSize);
+}
+
+ossim_uint64 ossim::HttpStreamBuffer::getBlockSize() const
+{
+   return static_cast<ossim_uint64>(m_blockSize);
+}
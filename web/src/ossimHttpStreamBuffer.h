@@ -0,0 +1,94 @@
+//---
+//
+// License: MIT
+//
+// Description:
+//
+// Random access, read only streambuf over an http/https url backed by
+// Range requests, the shared HttpBlockCache and sequential read-ahead.
+//
+//---
+// $Id$
+
+#ifndef ossimHttpStreamBuffer_HEADER
+#define ossimHttpStreamBuffer_HEADER 1
+
+#include "ossimHttpBlockCache.h"
+#include "ossimHttpStreamDefaults.h"
+#include <ossim/base/ossimConstants.h>
+#include <iostream>
+#include <string>
+
+namespace ossim
+{
+   class HttpStreamBuffer : public std::streambuf
+   {
+   public:
+      HttpStreamBuffer(ossim_int64 blockSize=ossim::HttpStreamDefaults::m_readBlocksize);
+
+      virtual ~HttpStreamBuffer()
+      {
+      }
+
+      HttpStreamBuffer* open(const char* url, std::ios_base::openmode mode);
+      HttpStreamBuffer* open(const std::string& url, std::ios_base::openmode mode);
+
+      bool is_open() const
+      {
+         return m_opened;
+      }
+
+      /**
+       * @return Size of file in bytes.
+       */
+      ossim_uint64 getFileSize() const;
+
+      /**
+       * @return Size of block buffer in bytes.
+       */
+      ossim_uint64 getBlockSize() const;
+
+   protected:
+      virtual pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+                               std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out);
+      virtual pos_type seekpos(pos_type pos,
+                               std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out);
+      virtual std::streamsize xsgetn(char_type* s, std::streamsize n);
+      virtual int_type underflow();
+
+      /** @return Current absolute read position. */
+      ossim_int64 getPosition()const;
+
+      /** Loads the block holding absolutePosition into the get area. */
+      bool loadBlock(ossim_int64 absolutePosition);
+
+      /** Requests the blocks after blockIndex when reads are sequential. */
+      void readAhead(ossim_int64 blockIndex);
+
+      void clearAll();
+
+      std::string m_url;
+
+      /** Id of the object in the shared block cache. */
+      std::string m_cacheId;
+      ossim_int64 m_blockSize;
+      ossim_int64 m_fileSize;
+
+      /** Block in the get area and its absolute start. */
+      ossim::HttpBlockCache::Block_t m_block;
+      ossim_int64 m_blockStart;
+
+      /** Position when no block is loaded. */
+      ossim_int64 m_position;
+      ossim_int64 m_lastBlockIndex;
+
+      /**
+       * Whole body when the server does not support Range requests, in which
+       * case it is the only block.
+       */
+      ossim::HttpBlockCache::Block_t m_wholeFile;
+      bool m_opened;
+   };
+}
+
+#endif
@@ -0,0 +1,82 @@
+//---
+//
+// License: MIT
+//
+// Description: Settings of the http/https range request streams.
+//
+//---
+// $Id$
+
+#include "ossimHttpStreamDefaults.h"
+#include <ossim/base/ossimPreferences.h>
+#include <ossim/base/ossimString.h>
+#include <ossim/base/ossimTrace.h>
+
+ossim_int64 ossim::HttpStreamDefaults::m_readBlocksize = 65536;
+ossim_int64 ossim::HttpStreamDefaults::m_readCacheSize = 67108864;
+ossim_int64 ossim::HttpStreamDefaults::m_readAheadBlocks = 4;
+static ossimTrace traceDebug("ossimHttpStreamDefaults:debug");
+
+//---
+// Converts a size string with an optional K, M or G suffix to bytes.
+// Returns false if the value is not greater than zero.
+//---
+static bool toByteSize(const ossimString& value, ossim_int64& bytes)
+{
+   bool result = false;
+   if(!value.empty())
+   {
+      ossim_int64 size = value.toInt64();
+      if(size > 0)
+      {
+         ossimString byteType(value.begin()+(value.size()-1), value.end());
+         byteType.upcase();
+         bytes = size;
+         if ( byteType == "K")
+         {
+            bytes *=static_cast<ossim_int64>(1024);
+         }
+         else if ( byteType == "M")
+         {
+            bytes *=static_cast<ossim_int64>(1048576);
+         }
+         else if ( byteType == "G")
+         {
+            bytes *=static_cast<ossim_int64>(1073741824);
+         }
+         result = true;
+      }
+   }
+   return result;
+}
+
+void ossim::HttpStreamDefaults::loadDefaults()
+{
+   ossimString readBlocksize = ossimPreferences::instance()->findPreference("ossim.plugins.web.readBlocksize");
+   toByteSize(readBlocksize, m_readBlocksize);
+
+   ossimString readCacheSize = ossimPreferences::instance()->findPreference("ossim.plugins.web.readCacheSize");
+   if(!readCacheSize.empty() && !toByteSize(readCacheSize, m_readCacheSize))
+   {
+      // Zero or negative disables the block cache.
+      m_readCacheSize = 0;
+   }
+
+   ossimString readAheadBlocks = ossimPreferences::instance()->findPreference("ossim.plugins.web.readAheadBlocks");
+   if(!readAheadBlocks.empty())
+   {
+      m_readAheadBlocks = readAheadBlocks.toInt64();
+      if(m_readAheadBlocks < 0)
+      {
+         m_readAheadBlocks = 0;
+      }
+   }
+
+   if(traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "m_readBlocksize: " << m_readBlocksize << "\n"
+         << "m_readCacheSize: " << m_readCacheSize << "\n"
+         << "m_readAheadBlocks: " << m_readAheadBlocks << "\n";
+   }
+}
@@ -0,0 +1,32 @@
+//---
+//
+// License: MIT
+//
+// Description: Settings of the http/https range request streams.
+//
+//---
+// $Id$
+
+#ifndef ossimHttpStreamDefaults_HEADER
+#define ossimHttpStreamDefaults_HEADER 1
+#include <ossim/base/ossimConstants.h>
+
+namespace ossim
+{
+   class HttpStreamDefaults
+   {
+   public:
+      static void loadDefaults();
+
+      /** Size of each Range request. */
+      static ossim_int64 m_readBlocksize;
+
+      /** Size in bytes of the block cache shared by all http streams. */
+      static ossim_int64 m_readCacheSize;
+
+      /** Number of blocks requested ahead once sequential reads are seen. */
+      static ossim_int64 m_readAheadBlocks;
+   };
+}
+
+#endif
@@ -16,10 +16,16 @@
 #include <ossim/base/ossimKeywordlist.h>
 #include <ossim/base/ossimWebRequestFactoryRegistry.h>
 #include "ossimWebPluginRequestFactory.h"
+#include "ossimCurlMultiEngine.h"
+#include "ossimHttpStreamDefaults.h"
+#include "ossimWebStreamFactory.h"
+#include <ossim/base/ossimStreamFactoryRegistry.h>
+#include <curl/curl.h>
 static void setDescription(ossimString& description)
 {
    description = "Web plugin\n";
    description += "\tsupport http, https web protocols\n";
+   description += "\thttp, https random access streams via Range requests\n";
 }
 
 
@@ -58,6 +64,7 @@ extern "C"
       myInfo.getClassName = getClassName;
       
       *info = &myInfo;
+      curl_global_init(CURL_GLOBAL_ALL);
       ossimKeywordlist kwl;
       kwl.parseString(ossimString(options));
       if(ossimString(kwl.find("reader_factory.location")).downcase() == "front")
@@ -72,11 +79,20 @@ extern "C"
          ossimWebRequestFactoryRegistry::instance()->
          registerFactory(ossimWebPluginRequestFactory::instance());
       }
+      ossim::HttpStreamDefaults::loadDefaults();
+      ossim::StreamFactoryRegistry::instance()->
+         registerFactory( ossim::WebStreamFactory::instance() );
+
       setDescription(theDescription);
    }
    
    /* Note symbols need to be exported on windoze... */ 
    OSSIM_PLUGINS_DLL void ossimSharedLibraryFinalize()
    {
+      ossim::StreamFactoryRegistry::instance()->
+         unregisterFactory( ossim::WebStreamFactory::instance() );
+
+      /* Engine thread must not outlive the library. */
+      ossimCurlMultiEngine::shutdown();
    }
 }
@@ -0,0 +1,81 @@
+//---
+//
+// License: MIT
+//
+// Description: OSSIM web plugin stream factory for http and https urls.
+//
+//---
+// $Id$
+
+#include "ossimWebStreamFactory.h"
+#include "ossimHttpIStream.h"
+#include <ossim/base/ossimString.h>
+#include <ossim/base/ossimTrace.h>
+
+static ossimTrace traceDebug("ossimWebStreamFactory:debug");
+
+ossim::WebStreamFactory* ossim::WebStreamFactory::m_instance = 0;
+
+ossim::WebStreamFactory::~WebStreamFactory()
+{
+}
+
+ossim::WebStreamFactory* ossim::WebStreamFactory::instance()
+{
+   if(!m_instance)
+   {
+      m_instance = new ossim::WebStreamFactory();
+   }
+
+   return m_instance;
+}
+
+std::shared_ptr<ossim::istream> ossim::WebStreamFactory::createIstream(
+   const std::string& connectionString, std::ios_base::openmode openMode) const
+{
+   std::shared_ptr<ossim::HttpIStream> result;
+
+   // Quick reject so every local file open does not go through curl.
+   ossimString lower = ossimString(connectionString.substr(0, 8)).downcase();
+   if(!lower.beginsWith("http://") && !lower.beginsWith("https://"))
+   {
+      return result;
+   }
+
+   if(traceDebug())
+   {
+     ossimNotify(ossimNotifyLevel_DEBUG)
+        << "ossim::WebStreamFactory::createIstream: " << connectionString << "\n";
+   }
+
+   result = std::make_shared<ossim::HttpIStream>();
+   result->open(connectionString, openMode);
+   if(!result->good())
+   {
+     result.reset();
+   }
+
+   return result;
+}
+
+std::shared_ptr<ossim::ostream> ossim::WebStreamFactory::createOstream(
+   const std::string& /*connectionString*/, std::ios_base::openmode /*openMode*/) const
+{
+   return std::shared_ptr<ossim::ostream>(0);
+}
+
+std::shared_ptr<ossim::iostream> ossim::WebStreamFactory::createIOstream(
+   const std::string& /*connectionString*/, std::ios_base::openmode /*openMode*/) const
+{
+   return std::shared_ptr<ossim::iostream>(0);
+}
+
+// Hidden from use:
+ossim::WebStreamFactory::WebStreamFactory()
+{
+}
+
+// Hidden from use:
+ossim::WebStreamFactory::WebStreamFactory(const ossim::WebStreamFactory& )
+{
+}
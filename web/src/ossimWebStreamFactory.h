@@ -0,0 +1,50 @@
+//---
+//
+// License: MIT
+//
+// Description: OSSIM web plugin stream factory for http and https urls.
+//
+//---
+// $Id$
+
+#ifndef ossimWebStreamFactory_HEADER
+#define ossimWebStreamFactory_HEADER 1
+
+#include <ossim/base/ossimStreamFactoryBase.h>
+#include <ossim/base/ossimIoStream.h>
+#include <memory>
+
+namespace ossim
+{
+   class WebStreamFactory : public StreamFactoryBase
+   {
+   public:
+      static WebStreamFactory* instance();
+
+      virtual ~WebStreamFactory();
+
+      /**
+       * @brief Opens a random access stream over an http/https url using
+       * Range requests.
+       */
+      virtual std::shared_ptr<ossim::istream>
+         createIstream(const std::string& connectionString,
+                       std::ios_base::openmode openMode) const;
+
+      virtual std::shared_ptr<ossim::ostream>
+         createOstream(const std::string& connectionString,
+                       std::ios_base::openmode openMode) const;
+
+      virtual std::shared_ptr<ossim::iostream>
+         createIOstream(const std::string& connectionString,
+                        std::ios_base::openmode openMode) const;
+
+   protected:
+      WebStreamFactory();
+      WebStreamFactory(const WebStreamFactory&);
+
+      static WebStreamFactory* m_instance;
+   };
+}
+
+#endif /* #ifndef ossimWebStreamFactory_HEADER */